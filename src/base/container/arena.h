@@ -31,6 +31,7 @@
 #define MOZC_BASE_CONTAINER_ARENA_H_
 
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -38,6 +39,7 @@
 
 #include "absl/base/nullability.h"
 #include "absl/log/check.h"
+#include "absl/strings/string_view.h"
 
 // A simple arena allocator for the given type T.
 template <class T>
@@ -133,6 +135,20 @@ class ObjectPool final {
     return std::construct_at(ptr, std::forward<Args>(args)...);
   }
 
+  // Returns a previously released object as is, without destroying and
+  // constructing it again, so that the object keeps its resources such as
+  // string buffers. The caller is responsible for resetting its state. If no
+  // object is released, constructs a new one with the given arguments.
+  template <class... Args>
+  [[nodiscard]] T* absl_nonnull AllocRecycled(Args&&... args) {
+    if (released_.empty()) {
+      return arena_.Alloc(std::forward<Args>(args)...);
+    }
+    T* ptr = released_.back();
+    released_.pop_back();
+    return ptr;
+  }
+
   // Returns the given object to the pool for reuse. Note that the destructor
   // won't run until the memory is actually reused.
   void Release(T* absl_nonnull ptr) { released_.push_back(ptr); }
@@ -151,4 +167,68 @@ class ObjectPool final {
   std::vector<T* absl_nonnull> released_;
 };
 
+// An arena for the bytes of strings. Copied strings are returned as views,
+// which stay valid until Clear() is called. Clear() keeps the first block so
+// that an arena cleared per conversion doesn't allocate memory again.
+class StringArena final {
+ public:
+  explicit StringArena(size_t block_size) : block_size_(block_size) {
+    CHECK_GT(block_size, 0);
+  }
+
+  StringArena(const StringArena&) = delete;
+  StringArena& operator=(const StringArena&) = delete;
+
+  // Copies `str` to the arena.
+  [[nodiscard]] absl::string_view Copy(absl::string_view str) {
+    if (str.empty()) {
+      return absl::string_view();
+    }
+    char* dst = Allocate(str.size());
+    std::memcpy(dst, str.data(), str.size());
+    return absl::string_view(dst, str.size());
+  }
+
+  // Frees all strings.
+  void Clear() {
+    if (blocks_.size() > 1) {
+      blocks_.resize(1);
+    }
+    large_blocks_.clear();
+    used_in_block_ = 0;
+  }
+
+  // Returns the number of bytes reserved by the arena.
+  size_t reserved_size() const {
+    size_t size = blocks_.size() * block_size_;
+    for (const auto& [block, block_size] : large_blocks_) {
+      size += block_size;
+    }
+    return size;
+  }
+
+ private:
+  char* absl_nonnull Allocate(size_t size) {
+    // Strings larger than a quarter of a block get their own block so that a
+    // block doesn't end with a large unused tail.
+    if (size > block_size_ / 4) [[unlikely]] {
+      large_blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(size),
+                                 size);
+      return large_blocks_.back().first.get();
+    }
+    if (blocks_.empty() || used_in_block_ + size > block_size_) [[unlikely]] {
+      blocks_.push_back(std::make_unique_for_overwrite<char[]>(block_size_));
+      used_in_block_ = 0;
+    }
+    char* ptr = blocks_.back().get() + used_in_block_;
+    used_in_block_ += size;
+    return ptr;
+  }
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  std::vector<std::pair<std::unique_ptr<char[]>, size_t>> large_blocks_;
+  size_t used_in_block_ = 0;
+  const size_t block_size_;
+};
+
 #endif  // MOZC_BASE_CONTAINER_ARENA_H_
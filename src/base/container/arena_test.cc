@@ -33,6 +33,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 
@@ -115,5 +116,54 @@ TEST(ObjectPoolTest, Reuse) {
   EXPECT_EQ(addr1, addr2);
 }
 
+TEST(ObjectPoolTest, AllocRecycled) {
+  ObjectPool<std::string> pool(10);
+
+  std::string* s1 = pool.AllocRecycled("hello");
+  EXPECT_EQ(*s1, "hello");
+  pool.Release(s1);
+  std::string* s2 = pool.AllocRecycled("world");
+
+  // The released object is returned without being constructed again.
+  EXPECT_EQ(s1, s2);
+  EXPECT_EQ(*s2, "hello");
+  EXPECT_EQ(pool.NumReusable(), 0);
+}
+
+TEST(StringArenaTest, Copy) {
+  StringArena arena(16);
+  std::string str = "hello";
+  const absl::string_view copied = arena.Copy(str);
+  str = "world";
+  EXPECT_EQ(copied, "hello");
+  EXPECT_TRUE(arena.Copy("").empty());
+
+  // Fills blocks and allocates a large string.
+  std::vector<absl::string_view> views;
+  for (int i = 0; i < 10; ++i) {
+    views.push_back(arena.Copy("abc"));
+  }
+  const std::string large(100, 'x');
+  const absl::string_view large_view = arena.Copy(large);
+  for (absl::string_view view : views) {
+    EXPECT_EQ(view, "abc");
+  }
+  EXPECT_EQ(large_view, large);
+}
+
+TEST(StringArenaTest, ClearKeepsFirstBlock) {
+  StringArena arena(16);
+  for (int i = 0; i < 10; ++i) {
+    static_cast<void>(arena.Copy("abc"));
+  }
+  static_cast<void>(arena.Copy(std::string(100, 'x')));
+  EXPECT_GT(arena.reserved_size(), 16);
+
+  arena.Clear();
+  EXPECT_EQ(arena.reserved_size(), 16);
+  EXPECT_EQ(arena.Copy("abc"), "abc");
+  EXPECT_EQ(arena.reserved_size(), 16);
+}
+
 }  // namespace
 }  // namespace mozc
@@ -0,0 +1,144 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/container/double_array_trie.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+
+class DoubleArrayTrie::Builder {
+ public:
+  Builder(absl::Span<const absl::string_view> keys,
+          absl::Span<const int32_t> values)
+      : keys_(keys), values_(values) {}
+
+  std::vector<Unit> Build() && {
+    units_.resize(1);
+    units_[kRoot].check = kRoot;  // Marks the root as used.
+    if (!keys_.empty()) {
+      BuildNode(kRoot, 0, keys_.size(), 0);
+    }
+    units_[kRoot].check = kUnused;
+    units_.shrink_to_fit();
+    return std::move(units_);
+  }
+
+ private:
+  // A child node as the pair of the label and the range of keys.
+  struct Child {
+    uint8_t label;
+    size_t begin;
+    size_t end;
+  };
+
+  // Builds the node `id` for keys_[begin, end), which share the first `depth`
+  // bytes.
+  void BuildNode(NodeId id, size_t begin, size_t end, size_t depth) {
+    if (keys_[begin].size() == depth) {
+      // The shortest key comes first as the keys are sorted.
+      DCHECK_GE(values_[begin], 0);
+      units_[id].value = values_[begin];
+      ++begin;
+    }
+    if (begin == end) {
+      return;
+    }
+
+    std::vector<Child> children;
+    for (size_t i = begin; i < end; ++i) {
+      const uint8_t label = static_cast<uint8_t>(keys_[i][depth]);
+      if (children.empty() || children.back().label != label) {
+        DCHECK(children.empty() || children.back().label < label)
+            << "keys must be sorted";
+        children.push_back({label, i, i});
+      }
+      children.back().end = i + 1;
+    }
+
+    const uint32_t base = FindBase(children);
+    units_[id].base = base;
+    for (const Child &child : children) {
+      units_[base + child.label + 1].check = id;
+    }
+    for (const Child &child : children) {
+      BuildNode(base + child.label + 1, child.begin, child.end, depth + 1);
+    }
+  }
+
+  // Returns the smallest base where all the units for `children` are unused.
+  uint32_t FindBase(absl::Span<const Child> children) {
+    const uint8_t first_label = children.front().label;
+    while (first_unused_ < units_.size() &&
+           units_[first_unused_].check != kUnused) {
+      ++first_unused_;
+    }
+    uint32_t base =
+        first_unused_ > first_label + 1u ? first_unused_ - first_label - 1 : 1;
+    for (;; ++base) {
+      bool fits = true;
+      for (const Child &child : children) {
+        const size_t pos = base + child.label + 1;
+        if (pos >= units_.size()) {
+          units_.resize(pos + 1);
+        }
+        if (units_[pos].check != kUnused) {
+          fits = false;
+          break;
+        }
+      }
+      if (fits) {
+        return base;
+      }
+    }
+  }
+
+  absl::Span<const absl::string_view> keys_;
+  absl::Span<const int32_t> values_;
+  std::vector<Unit> units_;
+  size_t first_unused_ = 1;
+};
+
+DoubleArrayTrie DoubleArrayTrie::Build(
+    absl::Span<const absl::string_view> keys,
+    absl::Span<const int32_t> values) {
+  DCHECK_EQ(keys.size(), values.size());
+  DoubleArrayTrie trie;
+  trie.units_ = Builder(keys, values).Build();
+  return trie;
+}
+
+}  // namespace mozc
@@ -0,0 +1,108 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Read-only byte-wise trie in the double-array representation.
+//
+// Each node is a unit of the array. The child of the node `s` for the byte `c`
+// is the unit `t = base(s) + c + 1` if `check(t) == s`. A traversal is only a
+// few array accesses per byte, without the pointer chasing of node-based
+// tries like Trie<T>.
+
+#ifndef MOZC_BASE_CONTAINER_DOUBLE_ARRAY_TRIE_H_
+#define MOZC_BASE_CONTAINER_DOUBLE_ARRAY_TRIE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace mozc {
+
+class DoubleArrayTrie {
+ public:
+  using NodeId = uint32_t;
+  static constexpr NodeId kRoot = 0;
+  static constexpr int32_t kNoValue = -1;
+
+  // Creates an empty trie that has only the root.
+  DoubleArrayTrie() : units_(1) {}
+
+  // Builds a trie from `keys` and their `values`. `keys` must be sorted and
+  // unique, and `values` must be non-negative.
+  static DoubleArrayTrie Build(absl::Span<const absl::string_view> keys,
+                               absl::Span<const int32_t> values);
+
+  // Moves `node` to its descendant by `bytes`. Returns false and leaves `node`
+  // untouched if there is no such node.
+  bool Traverse(absl::string_view bytes, NodeId *node) const {
+    NodeId current = *node;
+    for (const char c : bytes) {
+      const Unit &unit = units_[current];
+      if (unit.base == 0) {
+        return false;
+      }
+      const size_t next = unit.base + static_cast<uint8_t>(c) + 1;
+      if (next >= units_.size() || units_[next].check != current) {
+        return false;
+      }
+      current = next;
+    }
+    *node = current;
+    return true;
+  }
+
+  // Returns the value of `node`, or kNoValue if the node has no value.
+  int32_t GetValue(NodeId node) const { return units_[node].value; }
+
+  // Returns true if `node` has at least one child.
+  bool HasChildren(NodeId node) const { return units_[node].base != 0; }
+
+  // Returns the number of units, including unused ones.
+  size_t size() const { return units_.size(); }
+
+ private:
+  class Builder;
+
+  struct Unit {
+    // Offset of the children. 0 if the node has no child.
+    uint32_t base = 0;
+    // The parent of the node. kUnused if the unit is not used.
+    uint32_t check = kUnused;
+    int32_t value = kNoValue;
+  };
+  static constexpr uint32_t kUnused = 0xFFFFFFFF;
+
+  std::vector<Unit> units_;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_CONTAINER_DOUBLE_ARRAY_TRIE_H_
@@ -0,0 +1,141 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/container/double_array_trie.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/random/random.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+using NodeId = DoubleArrayTrie::NodeId;
+
+TEST(DoubleArrayTrieTest, Empty) {
+  const DoubleArrayTrie trie;
+  NodeId node = DoubleArrayTrie::kRoot;
+  EXPECT_TRUE(trie.Traverse("", &node));
+  EXPECT_EQ(node, DoubleArrayTrie::kRoot);
+  EXPECT_FALSE(trie.Traverse("a", &node));
+  EXPECT_EQ(trie.GetValue(node), DoubleArrayTrie::kNoValue);
+  EXPECT_FALSE(trie.HasChildren(node));
+}
+
+TEST(DoubleArrayTrieTest, Traverse) {
+  const std::vector<absl::string_view> keys = {"", "a", "abc", "abd", "b",
+                                               "\xff"};
+  const std::vector<int32_t> values = {0, 1, 2, 3, 4, 5};
+  const DoubleArrayTrie trie = DoubleArrayTrie::Build(keys, values);
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    NodeId node = DoubleArrayTrie::kRoot;
+    ASSERT_TRUE(trie.Traverse(keys[i], &node)) << keys[i];
+    EXPECT_EQ(trie.GetValue(node), values[i]) << keys[i];
+  }
+
+  NodeId node = DoubleArrayTrie::kRoot;
+  ASSERT_TRUE(trie.Traverse("ab", &node));
+  EXPECT_EQ(trie.GetValue(node), DoubleArrayTrie::kNoValue);
+  EXPECT_TRUE(trie.HasChildren(node));
+
+  // A failed traversal doesn't move the node.
+  const NodeId ab = node;
+  EXPECT_FALSE(trie.Traverse("e", &node));
+  EXPECT_EQ(node, ab);
+  EXPECT_FALSE(trie.Traverse("ce", &node));
+  EXPECT_EQ(node, ab);
+
+  ASSERT_TRUE(trie.Traverse("c", &node));
+  EXPECT_FALSE(trie.HasChildren(node));
+  EXPECT_FALSE(trie.Traverse("c", &node));
+
+  node = DoubleArrayTrie::kRoot;
+  EXPECT_FALSE(trie.Traverse("c", &node));
+  EXPECT_FALSE(trie.Traverse("ba", &node));
+}
+
+TEST(DoubleArrayTrieTest, RandomKeys) {
+  absl::BitGen gen;
+  std::vector<std::string> key_strings;
+  for (int i = 0; i < 3000; ++i) {
+    std::string key(absl::Uniform(gen, 1, 8), '\0');
+    for (char &c : key) {
+      // Use a small alphabet to have many shared prefixes.
+      c = static_cast<char>(absl::Uniform(gen, 0, 2) == 0
+                                ? absl::Uniform(gen, 'a', 'e')
+                                : absl::Uniform(gen, 0, 256));
+    }
+    key_strings.push_back(std::move(key));
+  }
+  absl::c_sort(key_strings);
+  key_strings.erase(std::unique(key_strings.begin(), key_strings.end()),
+                    key_strings.end());
+  const std::vector<absl::string_view> keys(key_strings.begin(),
+                                            key_strings.end());
+  std::vector<int32_t> values(keys.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = i;
+  }
+  const DoubleArrayTrie trie = DoubleArrayTrie::Build(keys, values);
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    NodeId node = DoubleArrayTrie::kRoot;
+    ASSERT_TRUE(trie.Traverse(keys[i], &node));
+    EXPECT_EQ(trie.GetValue(node), i);
+    // The node has children iff the next key extends this key.
+    const bool has_children =
+        i + 1 < keys.size() && absl::StartsWith(keys[i + 1], keys[i]);
+    EXPECT_EQ(trie.HasChildren(node), has_children);
+  }
+
+  // Keys that are not in the trie.
+  for (int i = 0; i < 3000; ++i) {
+    std::string key(absl::Uniform(gen, 1, 8), '\0');
+    for (char &c : key) {
+      c = static_cast<char>(absl::Uniform(gen, 0, 256));
+    }
+    NodeId node = DoubleArrayTrie::kRoot;
+    const bool found = trie.Traverse(key, &node) &&
+                       trie.GetValue(node) != DoubleArrayTrie::kNoValue;
+    EXPECT_EQ(found, absl::c_binary_search(keys, key));
+  }
+}
+
+}  // namespace
+}  // namespace mozc
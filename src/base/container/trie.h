@@ -169,19 +169,27 @@ class Trie final {
   void LookUpPredictiveAll(absl::string_view key,
                            std::vector<T> *data_list) const {
     DCHECK(data_list);
+    ForEachPredictive(
+        key, [data_list](const T &data) { data_list->push_back(data); });
+  }
+
+  // Same as LookUpPredictiveAll, but calls `callback` with each data instead
+  // of copying it to a vector.
+  template <typename Callback>
+  void ForEachPredictive(absl::string_view key, Callback &&callback) const {
     if (!key.empty()) {
       if (const FindResult res = FindSubTrie(key); res.trie != nullptr) {
-        res.trie->LookUpPredictiveAll(res.rest, data_list);
+        res.trie->ForEachPredictive(res.rest, callback);
       }
       return;
     }
 
     if (data_.has_value()) {
-      data_list->push_back(*data_);
+      callback(*data_);
     }
 
     for (auto &[unused, trie] : trie_) {
-      trie->LookUpPredictiveAll("", data_list);
+      trie->ForEachPredictive("", callback);
     }
   }
 
@@ -342,5 +342,21 @@ TEST(TrieTest, LookUpPredictiveAll) {
   }
 }
 
+TEST(TrieTest, ForEachPredictive) {
+  Trie<std::string> trie;
+  trie.AddEntry("abc", "[ABC]");
+  trie.AddEntry("abd", "[ABD]");
+  trie.AddEntry("a", "[A]");
+
+  for (absl::string_view key : {"", "a", "ab", "abc", "x"}) {
+    std::vector<std::string> expected;
+    trie.LookUpPredictiveAll(key, &expected);
+    std::vector<std::string> values;
+    trie.ForEachPredictive(
+        key, [&values](const std::string& data) { values.push_back(data); });
+    EXPECT_EQ(values, expected) << key;
+  }
+}
+
 }  // namespace
 }  // namespace mozc
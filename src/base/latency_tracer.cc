@@ -0,0 +1,220 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/latency_tracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "absl/base/no_destructor.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+namespace {
+
+using StageId = LatencyTracer::StageId;
+using StageStats = LatencyTracer::StageStats;
+
+struct RecordedEvent {
+  StageId stage = 0;
+  absl::Duration latency;
+};
+
+// The statistics recorded on one thread. |mutex| is only contended while a
+// snapshot is being taken.
+struct ThreadBuffer {
+  absl::Mutex mutex;
+  // Indexed by StageId. The names are filled in the snapshot.
+  std::vector<StageStats> stats ABSL_GUARDED_BY(mutex);
+  RecordedEvent events[LatencyTracer::kRingBufferSize] ABSL_GUARDED_BY(mutex);
+  // The total number of recorded events. The next event is stored at
+  // |num_events % kRingBufferSize|.
+  size_t num_events ABSL_GUARDED_BY(mutex) = 0;
+};
+
+void MergeStats(const StageStats& from, StageStats* to) {
+  to->count += from.count;
+  to->total += from.total;
+  to->max = std::max(to->max, from.max);
+  for (size_t i = 0; i < LatencyTracer::kNumBuckets; ++i) {
+    to->buckets[i] += from.buckets[i];
+  }
+}
+
+class Registry {
+ public:
+  StageId RegisterStage(absl::string_view name) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock l(mutex_);
+    if (const auto it = ids_.find(name); it != ids_.end()) {
+      return it->second;
+    }
+    CHECK_LT(names_.size(), 1 << (sizeof(StageId) * 8)) << "Too many stages";
+    const StageId id = names_.size();
+    // std::deque keeps the addresses of the elements, so the keys of |ids_|
+    // stay valid.
+    const std::string& stored_name = names_.emplace_back(name);
+    ids_.emplace(stored_name, id);
+    return id;
+  }
+
+  void AddThread(ThreadBuffer* buffer) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock l(mutex_);
+    threads_.push_back(buffer);
+  }
+
+  // Keeps the statistics of an exiting thread.
+  void RemoveThread(ThreadBuffer* buffer) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock l(mutex_);
+    threads_.erase(std::find(threads_.begin(), threads_.end(), buffer));
+    absl::MutexLock buffer_lock(buffer->mutex);
+    if (retired_.size() < buffer->stats.size()) {
+      retired_.resize(buffer->stats.size());
+    }
+    for (size_t i = 0; i < buffer->stats.size(); ++i) {
+      MergeStats(buffer->stats[i], &retired_[i]);
+    }
+  }
+
+  LatencyTracer::Snapshot GetSnapshot() ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock l(mutex_);
+    std::vector<StageStats> stats = retired_;
+    stats.resize(names_.size());
+    LatencyTracer::Snapshot snapshot;
+    for (ThreadBuffer* buffer : threads_) {
+      absl::MutexLock buffer_lock(buffer->mutex);
+      for (size_t i = 0; i < buffer->stats.size(); ++i) {
+        MergeStats(buffer->stats[i], &stats[i]);
+      }
+      const size_t num_events =
+          std::min(buffer->num_events, LatencyTracer::kRingBufferSize);
+      for (size_t i = buffer->num_events - num_events; i < buffer->num_events;
+           ++i) {
+        const RecordedEvent& event =
+            buffer->events[i % LatencyTracer::kRingBufferSize];
+        snapshot.recent_events.push_back({names_[event.stage], event.latency});
+      }
+    }
+    for (size_t i = 0; i < stats.size(); ++i) {
+      if (stats[i].count == 0) {
+        continue;
+      }
+      stats[i].name = names_[i];
+      snapshot.stages.push_back(stats[i]);
+    }
+    return snapshot;
+  }
+
+  void Reset() ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock l(mutex_);
+    retired_.clear();
+    for (ThreadBuffer* buffer : threads_) {
+      absl::MutexLock buffer_lock(buffer->mutex);
+      buffer->stats.clear();
+      buffer->num_events = 0;
+    }
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::deque<std::string> names_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<absl::string_view, StageId> ids_ ABSL_GUARDED_BY(mutex_);
+  std::vector<ThreadBuffer*> threads_ ABSL_GUARDED_BY(mutex_);
+  // The statistics of the exited threads.
+  std::vector<StageStats> retired_ ABSL_GUARDED_BY(mutex_);
+};
+
+Registry& GetRegistry() {
+  static absl::NoDestructor<Registry> registry;
+  return *registry;
+}
+
+// Registers the buffer of the current thread while the thread is alive.
+class ThreadBufferHolder {
+ public:
+  ThreadBufferHolder() { GetRegistry().AddThread(&buffer_); }
+  ~ThreadBufferHolder() { GetRegistry().RemoveThread(&buffer_); }
+
+  ThreadBuffer& buffer() { return buffer_; }
+
+ private:
+  ThreadBuffer buffer_;
+};
+
+ThreadBuffer& GetThreadBuffer() {
+  thread_local ThreadBufferHolder holder;
+  return holder.buffer();
+}
+
+}  // namespace
+
+StageId LatencyTracer::RegisterStage(absl::string_view name) {
+  return GetRegistry().RegisterStage(name);
+}
+
+void LatencyTracer::Record(StageId stage, absl::Duration latency) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  absl::MutexLock l(buffer.mutex);
+  if (buffer.stats.size() <= stage) {
+    buffer.stats.resize(stage + 1);
+  }
+  StageStats& stats = buffer.stats[stage];
+  ++stats.count;
+  stats.total += latency;
+  stats.max = std::max(stats.max, latency);
+  ++stats.buckets[GetBucketIndex(latency)];
+  buffer.events[buffer.num_events % kRingBufferSize] = {stage, latency};
+  ++buffer.num_events;
+}
+
+LatencyTracer::Snapshot LatencyTracer::GetSnapshot() {
+  return GetRegistry().GetSnapshot();
+}
+
+void LatencyTracer::Reset() { GetRegistry().Reset(); }
+
+size_t LatencyTracer::GetBucketIndex(absl::Duration latency) {
+  const int64_t micros = absl::ToInt64Microseconds(latency);
+  if (micros <= 0) {
+    return 0;
+  }
+  return std::min<size_t>(std::bit_width(static_cast<uint64_t>(micros)),
+                          kNumBuckets - 1);
+}
+
+}  // namespace mozc
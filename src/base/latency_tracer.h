@@ -0,0 +1,131 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_BASE_LATENCY_TRACER_H_
+#define MOZC_BASE_LATENCY_TRACER_H_
+
+#include <array>
+#include <chrono>  // NOLINT(build/c++11): steady_clock is needed here.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace mozc {
+
+// Lightweight latency tracing of the conversion pipeline.
+//
+// A scoped timer records the wall time spent in a stage into a buffer owned
+// by the current thread, so recording never contends with other threads.
+// The per-stage counters and histograms are merged across threads only when
+// a snapshot is taken, e.g. by the GET_LATENCY_STATS command.
+//
+// Usage:
+//   bool Converter::StartConversion(...) {
+//     static const LatencyTracer::StageId kStage =
+//         LatencyTracer::RegisterStage("converter/start_conversion");
+//     ScopedLatencyTimer timer(kStage);
+//     ...
+//   }
+class LatencyTracer {
+ public:
+  using StageId = uint16_t;
+
+  // Bucket i holds latencies in [2^(i-1), 2^i) microseconds, while bucket 0
+  // holds latencies under 1 microsecond. The last bucket holds everything
+  // longer.
+  static constexpr size_t kNumBuckets = 24;
+
+  // The number of recent events kept per thread.
+  static constexpr size_t kRingBufferSize = 256;
+
+  struct StageStats {
+    absl::string_view name;
+    uint64_t count = 0;
+    absl::Duration total;
+    absl::Duration max;
+    std::array<uint64_t, kNumBuckets> buckets = {};
+  };
+
+  struct Event {
+    absl::string_view stage;
+    absl::Duration latency;
+  };
+
+  struct Snapshot {
+    // Stages that have been recorded at least once, in registration order.
+    std::vector<StageStats> stages;
+    // Recent events of each live thread, from the oldest to the newest.
+    std::vector<Event> recent_events;
+  };
+
+  LatencyTracer() = delete;
+
+  // Returns the id of the stage named |name|, registering it if necessary.
+  // The same id is returned for the same name.
+  static StageId RegisterStage(absl::string_view name);
+
+  // Records one event of |stage| on the current thread.
+  static void Record(StageId stage, absl::Duration latency);
+
+  // Merges the statistics of all threads, including exited ones.
+  static Snapshot GetSnapshot();
+
+  // Clears the statistics and the recent events of all threads. Registered
+  // stages are kept.
+  static void Reset();
+
+  static size_t GetBucketIndex(absl::Duration latency);
+};
+
+// Records the time between the construction and the destruction to the
+// stage.
+class ScopedLatencyTimer {
+ public:
+  explicit ScopedLatencyTimer(LatencyTracer::StageId stage)
+      : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+  ScopedLatencyTimer(const ScopedLatencyTimer&) = delete;
+  ScopedLatencyTimer& operator=(const ScopedLatencyTimer&) = delete;
+
+  ~ScopedLatencyTimer() {
+    LatencyTracer::Record(
+        stage_, absl::FromChrono(std::chrono::steady_clock::now() - start_));
+  }
+
+ private:
+  const LatencyTracer::StageId stage_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_LATENCY_TRACER_H_
@@ -0,0 +1,153 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/latency_tracer.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "base/thread.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+const LatencyTracer::StageStats* FindStage(
+    const LatencyTracer::Snapshot& snapshot, absl::string_view name) {
+  for (const LatencyTracer::StageStats& stats : snapshot.stages) {
+    if (stats.name == name) {
+      return &stats;
+    }
+  }
+  return nullptr;
+}
+
+class LatencyTracerTest : public testing::Test {
+ protected:
+  void SetUp() override { LatencyTracer::Reset(); }
+  void TearDown() override { LatencyTracer::Reset(); }
+};
+
+TEST_F(LatencyTracerTest, RegisterStage) {
+  const LatencyTracer::StageId a = LatencyTracer::RegisterStage("test/a");
+  const LatencyTracer::StageId b = LatencyTracer::RegisterStage("test/b");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(LatencyTracer::RegisterStage("test/a"), a);
+}
+
+TEST_F(LatencyTracerTest, GetBucketIndex) {
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::ZeroDuration()), 0);
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::Nanoseconds(999)), 0);
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::Microseconds(1)), 1);
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::Microseconds(2)), 2);
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::Microseconds(3)), 2);
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::Microseconds(1024)), 11);
+  EXPECT_EQ(LatencyTracer::GetBucketIndex(absl::Hours(1)),
+            LatencyTracer::kNumBuckets - 1);
+}
+
+TEST_F(LatencyTracerTest, Record) {
+  const LatencyTracer::StageId stage = LatencyTracer::RegisterStage("test/a");
+  LatencyTracer::Record(stage, absl::Microseconds(10));
+  LatencyTracer::Record(stage, absl::Microseconds(30));
+
+  const LatencyTracer::Snapshot snapshot = LatencyTracer::GetSnapshot();
+  const LatencyTracer::StageStats* stats = FindStage(snapshot, "test/a");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->count, 2);
+  EXPECT_EQ(stats->total, absl::Microseconds(40));
+  EXPECT_EQ(stats->max, absl::Microseconds(30));
+  EXPECT_EQ(stats->buckets[4], 1);  // [8, 16)
+  EXPECT_EQ(stats->buckets[5], 1);  // [16, 32)
+  // Stages without events are omitted.
+  LatencyTracer::RegisterStage("test/b");
+  EXPECT_EQ(FindStage(snapshot, "test/b"), nullptr);
+
+  ASSERT_EQ(snapshot.recent_events.size(), 2);
+  EXPECT_EQ(snapshot.recent_events[0].stage, "test/a");
+  EXPECT_EQ(snapshot.recent_events[0].latency, absl::Microseconds(10));
+  EXPECT_EQ(snapshot.recent_events[1].latency, absl::Microseconds(30));
+
+  LatencyTracer::Reset();
+  EXPECT_TRUE(LatencyTracer::GetSnapshot().stages.empty());
+}
+
+TEST_F(LatencyTracerTest, RingBuffer) {
+  const LatencyTracer::StageId stage = LatencyTracer::RegisterStage("test/a");
+  constexpr size_t kNumEvents = LatencyTracer::kRingBufferSize + 10;
+  for (size_t i = 0; i < kNumEvents; ++i) {
+    LatencyTracer::Record(stage, absl::Microseconds(i));
+  }
+  const LatencyTracer::Snapshot snapshot = LatencyTracer::GetSnapshot();
+  EXPECT_EQ(FindStage(snapshot, "test/a")->count, kNumEvents);
+  ASSERT_EQ(snapshot.recent_events.size(), LatencyTracer::kRingBufferSize);
+  EXPECT_EQ(snapshot.recent_events.front().latency, absl::Microseconds(10));
+  EXPECT_EQ(snapshot.recent_events.back().latency,
+            absl::Microseconds(kNumEvents - 1));
+}
+
+TEST_F(LatencyTracerTest, MultipleThreads) {
+  const LatencyTracer::StageId stage = LatencyTracer::RegisterStage("test/a");
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 1000;
+  std::vector<Thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([stage] {
+      for (int j = 0; j < kNumEvents; ++j) {
+        LatencyTracer::Record(stage, absl::Microseconds(1));
+      }
+    });
+  }
+  for (Thread& thread : threads) {
+    thread.Join();
+  }
+  // The statistics of the exited threads are kept.
+  const LatencyTracer::Snapshot snapshot = LatencyTracer::GetSnapshot();
+  const LatencyTracer::StageStats* stats = FindStage(snapshot, "test/a");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->count, kNumThreads * kNumEvents);
+  EXPECT_EQ(stats->buckets[1], kNumThreads * kNumEvents);
+}
+
+TEST_F(LatencyTracerTest, ScopedLatencyTimer) {
+  const LatencyTracer::StageId stage = LatencyTracer::RegisterStage("test/a");
+  {
+    ScopedLatencyTimer timer(stage);
+  }
+  const LatencyTracer::Snapshot snapshot = LatencyTracer::GetSnapshot();
+  const LatencyTracer::StageStats* stats = FindStage(snapshot, "test/a");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->count, 1);
+  EXPECT_GE(stats->total, absl::ZeroDuration());
+}
+
+}  // namespace
+}  // namespace mozc
@@ -325,11 +325,11 @@ class CopyableAtomic : public std::atomic<T> {
  public:
   CopyableAtomic() = default;
   explicit CopyableAtomic(T val) : std::atomic<T>(val) {}
-  CopyableAtomic(const CopyableAtomic<T>& other) {
+  CopyableAtomic(const CopyableAtomic<T>& other) noexcept {
     std::atomic<T>::store(other.load(std::memory_order_relaxed),
                           std::memory_order_relaxed);
   }
-  CopyableAtomic& operator=(const CopyableAtomic<T>& other) {
+  CopyableAtomic& operator=(const CopyableAtomic<T>& other) noexcept {
     std::atomic<T>::store(other.load(std::memory_order_relaxed),
                           std::memory_order_relaxed);
     return *this;
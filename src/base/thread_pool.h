@@ -0,0 +1,149 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_BASE_THREAD_POOL_H_
+#define MOZC_BASE_THREAD_POOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "base/thread.h"
+
+namespace mozc {
+
+// A fixed-size pool of worker threads running scheduled tasks in FIFO order.
+//
+// The destructor runs all the pending tasks and then joins the workers, so
+// the objects referenced by a task only need to outlive the pool or the
+// completion of the task, whichever comes first.
+//
+// Example:
+//   ThreadPool pool(4);
+//   absl::BlockingCounter counter(2);
+//   pool.Schedule([&] { DoA(); counter.DecrementCount(); });
+//   pool.Schedule([&] { DoB(); counter.DecrementCount(); });
+//   counter.Wait();
+class ThreadPool {
+ public:
+  // Starts `num_threads` workers. `num_threads` must be positive.
+  explicit ThreadPool(int num_threads);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool();
+
+  // Enqueues `task`. The task runs on one of the workers.
+  void Schedule(absl::AnyInvocable<void() &&> task)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  void WorkerLoop() ABSL_LOCKS_EXCLUDED(mutex_);
+  bool HasTaskOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stopping_ || !queue_.empty();
+  }
+
+  absl::Mutex mutex_;
+  std::deque<absl::AnyInvocable<void() &&>> queue_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<Thread> workers_;
+};
+
+// Calls `func(i)` for each i in [0, n) and returns when all the calls finish.
+// The calls are distributed over `pool`, or made in order on the calling thread
+// if `pool` is nullptr. Must not be called from a task running on `pool`, as
+// the task would wait for the workers it occupies.
+template <typename Func>
+void ParallelFor(ThreadPool* pool, size_t n, Func&& func) {
+  if (pool == nullptr || n <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      func(i);
+    }
+    return;
+  }
+  absl::BlockingCounter counter(static_cast<int>(n));
+  for (size_t i = 0; i < n; ++i) {
+    pool->Schedule([&func, &counter, i] {
+      func(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+}
+
+// Same as std::stable_sort but sorts the chunks of the range on `pool` and
+// merges them. The result is identical to std::stable_sort, as the merges
+// keep the elements of the left chunk first.
+template <typename RandomIt, typename Compare>
+void ParallelStableSort(ThreadPool* pool, RandomIt first, RandomIt last,
+                        Compare comp) {
+  // Small ranges are not worth the synchronization.
+  constexpr size_t kMinChunkSize = 1 << 12;
+  const size_t size = std::distance(first, last);
+  const size_t num_chunks =
+      pool == nullptr ? 1
+                      : std::min<size_t>(pool->num_threads(),
+                                         size / kMinChunkSize);
+  if (num_chunks <= 1) {
+    std::stable_sort(first, last, comp);
+    return;
+  }
+
+  std::vector<RandomIt> bounds(num_chunks + 1);
+  for (size_t i = 0; i <= num_chunks; ++i) {
+    bounds[i] = first + size * i / num_chunks;
+  }
+  ParallelFor(pool, num_chunks, [&](size_t i) {
+    std::stable_sort(bounds[i], bounds[i + 1], comp);
+  });
+  for (size_t width = 1; width < num_chunks; width *= 2) {
+    const size_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+    ParallelFor(pool, num_merges, [&](size_t i) {
+      const size_t begin = 2 * i * width;
+      const size_t middle = std::min(begin + width, num_chunks);
+      const size_t end = std::min(begin + 2 * width, num_chunks);
+      if (middle < end) {
+        std::inplace_merge(bounds[begin], bounds[middle], bounds[end], comp);
+      }
+    });
+  }
+}
+
+}  // namespace mozc
+
+#endif  // MOZC_BASE_THREAD_POOL_H_
@@ -0,0 +1,145 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  constexpr int kNumTasks = 100;
+  std::atomic<int> sum = 0;
+  absl::BlockingCounter counter(kNumTasks);
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.num_threads(), 4);
+  for (int i = 1; i <= kNumTasks; ++i) {
+    pool.Schedule([&sum, &counter, i] {
+      sum.fetch_add(i);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  EXPECT_EQ(sum.load(), kNumTasks * (kNumTasks + 1) / 2);
+}
+
+TEST(ThreadPoolTest, RunsTasksConcurrently) {
+  ThreadPool pool(2);
+  absl::Notification first_started;
+  absl::Notification second_done;
+  pool.Schedule([&] {
+    first_started.Notify();
+    // Blocks until the other worker runs the second task.
+    second_done.WaitForNotification();
+  });
+  first_started.WaitForNotification();
+  pool.Schedule([&] { second_done.Notify(); });
+  second_done.WaitForNotification();
+}
+
+TEST(ThreadPoolTest, SingleWorkerRunsInFifoOrder) {
+  std::vector<int> order;
+  {
+    ThreadPool pool(1);
+    for (int i = 0; i < 10; ++i) {
+      pool.Schedule([&order, i] { order.push_back(i); });
+    }
+  }
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+TEST(ThreadPoolTest, DestructorDrainsPendingTasks) {
+  std::atomic<int> count = 0;
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 50; ++i) {
+      pool.Schedule([&count] { count.fetch_add(1); });
+    }
+  }
+  EXPECT_EQ(count.load(), 50);
+}
+
+TEST(ThreadPoolTest, AcceptsMoveOnlyTasks) {
+  auto value = std::make_unique<int>(42);
+  int result = 0;
+  {
+    ThreadPool pool(1);
+    pool.Schedule([value = std::move(value), &result] { result = *value; });
+  }
+  EXPECT_EQ(result, 42);
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+  std::vector<size_t> values(1000);
+  {
+    ThreadPool pool(4);
+    ParallelFor(&pool, values.size(), [&](size_t i) { values[i] = i * 2; });
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], i * 2);
+  }
+
+  // Runs in order on the calling thread without a pool.
+  std::vector<size_t> order;
+  ParallelFor(nullptr, 5, [&](size_t i) { order.push_back(i); });
+  EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2, 3, 4}));
+}
+
+TEST(ThreadPoolTest, ParallelStableSort) {
+  // Many equal keys to verify the stability.
+  std::vector<std::pair<int, int>> values;
+  for (int i = 0; i < 100000; ++i) {
+    values.emplace_back((i * 7919) % 101, i);
+  }
+  auto expected = values;
+  const auto by_first = [](const auto& l, const auto& r) {
+    return l.first < r.first;
+  };
+  std::stable_sort(expected.begin(), expected.end(), by_first);
+
+  for (const int num_threads : {1, 3, 4, 7}) {
+    auto actual = values;
+    ThreadPool pool(num_threads);
+    ParallelStableSort(&pool, actual.begin(), actual.end(), by_first);
+    EXPECT_EQ(actual, expected) << num_threads;
+  }
+}
+
+}  // namespace
+}  // namespace mozc
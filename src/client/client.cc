@@ -37,8 +37,10 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
@@ -72,6 +74,10 @@
 #include "base/mac/mac_process.h"
 #endif  // __APPLE__
 
+ABSL_FLAG(bool, persistent_ipc_connection, false,
+          "keep the IPC connection to the server open across commands. "
+          "Only Linux supports it.");
+
 namespace mozc {
 namespace client {
 
@@ -94,6 +100,22 @@ constexpr absl::Duration kDefaultTimeout = absl::Seconds(30);  // 30 sec for opt
 // called from Destructor. When an application calls DeleteSession
 // explicitly, the default timeout is used.
 constexpr absl::Duration kDeleteSessionOnDestructorTimeout = absl::Seconds(1);
+
+// Returns true if the server may run the command twice without changing the
+// result, so that it can be sent again after an unknown failure.
+bool IsIdempotentCommand(commands::Input::CommandType type) {
+  switch (type) {
+    case commands::Input::NO_OPERATION:
+    case commands::Input::GET_CONFIG:
+    case commands::Input::SET_CONFIG:
+    case commands::Input::SET_REQUEST:
+    case commands::Input::GET_SERVER_VERSION:
+    case commands::Input::GET_LATENCY_STATS:
+      return true;
+    default:
+      return false;
+  }
+}
 }  // namespace
 
 Client::Client()
@@ -625,28 +647,32 @@ bool Client::CallAndCheckVersion(const commands::Input &input,
   return true;
 }
 
-bool Client::Call(const commands::Input &input, commands::Output *output) {
-  MOZC_VLOG(2) << "commands::Input: " << std::endl << input;
-
-  // don't repeat Call() if the status is either
-  // SERVER_FATAL, SERVER_TIMEOUT, or SERVER_BROKEN_MESSAGE
-  if (server_status_ >= SERVER_TIMEOUT) {
-    LOG(ERROR) << "Don't repat the same status: " << server_status_;
-    return false;
-  }
-
-  if (client_factory_ == nullptr) {
-    return false;
-  }
-
-  // Serialize
-  std::string request;
-  if (!input.SerializeToString(&request)) {
-    LOG(ERROR) << "SerializeToString failed";
-    return false;
+bool Client::CallIPC(const commands::Input &input, absl::string_view request) {
+  // Reuses the connection kept by the previous call if any. The server closes
+  // it when it restarts. The request is sent again on a new connection only
+  // when the server has not received it, or when running it twice is
+  // harmless. Otherwise the failure is handled as a server crash.
+  if (ipc_client_ != nullptr) {
+    std::unique_ptr<IPCClientInterface> client = std::move(ipc_client_);
+    if (client->Call(request, &response_, timeout_)) {
+      ipc_client_ = std::move(client);
+      return true;
+    }
+    const IPCErrorType error = client->GetLastIPCError();
+    if (error == IPC_TIMEOUT_ERROR) {
+      LOG(ERROR) << "Call failure" << input.DebugString();
+      server_status_ = SERVER_TIMEOUT;
+      return false;
+    }
+    if (error != IPC_NO_CONNECTION && error != IPC_WRITE_ERROR &&
+        !IsIdempotentCommand(input.type())) {
+      LOG(ERROR) << "Call failure" << input.DebugString();
+      server_status_ = SERVER_SHUTDOWN;
+      return false;
+    }
+    MOZC_VLOG(1) << "The kept connection is closed. Reconnecting.";
   }
 
-  // Call IPC
   std::unique_ptr<IPCClientInterface> client(client_factory_->NewClient(
       kServerAddress, server_launcher_->server_program()));
 
@@ -686,6 +712,8 @@ bool Client::Call(const commands::Input &input, commands::Output *output) {
     return false;
   }
 
+  const bool persistent = absl::GetFlag(FLAGS_persistent_ipc_connection);
+  client->set_persistent_connection(persistent);
   if (!client->Call(request, &response_, timeout_)) {
     LOG(ERROR) << "Call failure" << input.DebugString();
     if (client->GetLastIPCError() == IPC_TIMEOUT_ERROR) {
@@ -697,6 +725,37 @@ bool Client::Call(const commands::Input &input, commands::Output *output) {
     return false;
   }
 
+  if (persistent) {
+    ipc_client_ = std::move(client);
+  }
+  return true;
+}
+
+bool Client::Call(const commands::Input &input, commands::Output *output) {
+  MOZC_VLOG(2) << "commands::Input: " << std::endl << input;
+
+  // don't repeat Call() if the status is either
+  // SERVER_FATAL, SERVER_TIMEOUT, or SERVER_BROKEN_MESSAGE
+  if (server_status_ >= SERVER_TIMEOUT) {
+    LOG(ERROR) << "Don't repat the same status: " << server_status_;
+    return false;
+  }
+
+  if (client_factory_ == nullptr) {
+    return false;
+  }
+
+  // Serialize
+  std::string request;
+  if (!input.SerializeToString(&request)) {
+    LOG(ERROR) << "SerializeToString failed";
+    return false;
+  }
+
+  if (!CallIPC(input, request)) {
+    return false;
+  }
+
   if (!output->ParseFromString(response_)) {
     LOG(ERROR) << "Parse failure of the result of the request:"
                << input.DebugString();
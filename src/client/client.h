@@ -96,6 +96,7 @@ class Client : public ClientInterface {
 
   void SetIPCClientFactory(IPCClientFactoryInterface* client_factory) override {
     client_factory_ = client_factory;
+    ipc_client_.reset();
   }
 
   // set ServerLauncher.
@@ -104,6 +105,7 @@ class Client : public ClientInterface {
   void SetServerLauncher(
       std::unique_ptr<ServerLauncherInterface> server_launcher) override {
     server_launcher_ = std::move(server_launcher);
+    ipc_client_.reset();
   }
 
   bool IsValidRunLevel() const override {
@@ -209,6 +211,10 @@ class Client : public ClientInterface {
   // just return false.
   bool Call(const commands::Input& input, commands::Output* output);
 
+  // Sends the serialized |input| to the server and stores the response in
+  // response_. Updates server_status_ on failure.
+  bool CallIPC(const commands::Input& input, absl::string_view request);
+
   // first invoke Call() command and check the
   // protocol_version. When protocol version mismatch,
   // client goes to FATAL state
@@ -241,6 +247,8 @@ class Client : public ClientInterface {
 
   uint64_t id_;
   IPCClientFactoryInterface* client_factory_;
+  // Connection kept across calls with --persistent_ipc_connection.
+  std::unique_ptr<IPCClientInterface> ipc_client_;
   std::unique_ptr<ServerLauncherInterface> server_launcher_;
   std::unique_ptr<config::Config> preferences_;
   std::unique_ptr<commands::Request> request_;
@@ -36,6 +36,9 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -55,6 +58,8 @@
 #include "testing/mozctest.h"
 #include "testing/test_peer.h"
 
+ABSL_DECLARE_FLAG(bool, persistent_ipc_connection);
+
 namespace mozc {
 namespace client {
 
@@ -278,6 +283,68 @@ TEST_F(ClientTest, SendKey) {
   EXPECT_EQ(input.type(), commands::Input::SEND_KEY);
 }
 
+TEST_F(ClientTest, PersistentConnection) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_persistent_ipc_connection, true);
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+
+  // New connections fail from now on, but the connection made by
+  // EnsureConnection() is kept and reused.
+  client_factory_->SetConnection(false);
+  server_launcher_->set_start_server_result(false);
+  server_launcher_->set_start_server_called(false);
+
+  commands::KeyEvent key_event;
+  key_event.set_special_key(commands::KeyEvent::ENTER);
+  for (int i = 0; i < 3; ++i) {
+    commands::Output output;
+    EXPECT_TRUE(client_->SendKey(key_event, &output));
+    commands::Input input;
+    GetGeneratedInput(&input);
+    EXPECT_EQ(input.type(), commands::Input::SEND_KEY);
+  }
+  EXPECT_FALSE(server_launcher_->start_server_called());
+}
+
+TEST_F(ClientTest, PersistentConnectionReconnectsBeforeSending) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_persistent_ipc_connection, true);
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+  server_launcher_->set_start_server_called(false);
+
+  // The server has closed the kept connection before the request is sent, so
+  // the request is sent again on a new connection.
+  client_factory_->SetNextCallError(IPC_NO_CONNECTION);
+  commands::KeyEvent key_event;
+  key_event.set_special_key(commands::KeyEvent::ENTER);
+  commands::Output output;
+  EXPECT_TRUE(client_->SendKey(key_event, &output));
+  commands::Input input;
+  GetGeneratedInput(&input);
+  EXPECT_EQ(input.type(), commands::Input::SEND_KEY);
+  EXPECT_FALSE(server_launcher_->start_server_called());
+}
+
+TEST_F(ClientTest, PersistentConnectionDoesNotResendKey) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_persistent_ipc_connection, true);
+  const int mock_id = 123;
+  EXPECT_TRUE(SetupConnection(mock_id));
+  server_launcher_->set_start_server_result(false);
+  server_launcher_->set_start_server_called(false);
+
+  // The server may have applied the key before the failure, so the client
+  // handles it as a server crash instead of sending the key again.
+  client_factory_->SetNextCallError(IPC_READ_ERROR);
+  commands::KeyEvent key_event;
+  key_event.set_special_key(commands::KeyEvent::ENTER);
+  commands::Output output;
+  EXPECT_FALSE(client_->SendKey(key_event, &output));
+  EXPECT_TRUE(server_launcher_->start_server_called());
+}
+
 TEST_F(ClientTest, SendKeyWithContext) {
   const int mock_id = 123;
   EXPECT_TRUE(SetupConnection(mock_id));
@@ -36,7 +36,10 @@
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/btree_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -60,6 +63,10 @@ using ::mozc::strings::FrontChar;
 // Max recursion count for looking up pending loop.
 constexpr int kMaxRecursion = 4;
 
+// Pending keys visited by GetFromPending(). They refer to the strings owned by
+// the table, and usually fit in the inlined storage.
+using PendingKeys = absl::InlinedVector<absl::string_view, 8>;
+
 // Get from pending rules recursively
 // The recursion will be stopped if recursion_count is 0.
 // When returns false, the caller doesn't append result entries.
@@ -78,22 +85,24 @@ constexpr int kMaxRecursion = 4;
 // '{*}い' -> '', '{*}ぃ'
 // Here, we want to get '{*}あ' <-> '{*}ぁ' loop from the input, 'あ'
 bool GetFromPending(const Table* table, const absl::string_view key,
-                    int recursion_count, absl::btree_set<std::string>* result) {
+                    int recursion_count, PendingKeys* result) {
   DCHECK(result);
   if (recursion_count == 0) {
     // Don't find the loop within the |recursion_count|.
     return false;
   }
-  if (result->find(key) != result->end()) {
+  if (absl::c_linear_search(*result, key)) {
     // Found the entry that is already looked up.
     // Return true because we found the loop.
     return true;
   }
-  result->emplace(key);
+  result->push_back(key);
 
-  std::vector<const Entry*> entries;
-  table->LookUpPredictiveAll(key, &entries);
-  for (const Entry* entry : entries) {
+  bool found = true;
+  table->ForEachPredictiveEntry(key, [&](const Entry* entry) {
+    if (!found) {
+      return;
+    }
     if (!entry->result().empty()) {
       // skip rules with result, because this causes too many results.
       // for example, if we have
@@ -101,13 +110,14 @@ bool GetFromPending(const Table* table, const absl::string_view key,
       //  'ka' -> 'か', ''
       // From the input 'k', this causes 'か', 'っ', 'っか', ...
       // So here we stop calling recursion.
-      return false;
+      found = false;
+      return;
     }
     if (!GetFromPending(table, entry->pending(), recursion_count - 1, result)) {
-      return false;
+      found = false;
     }
-  }
-  return true;
+  });
+  return found;
 }
 }  // namespace
 
@@ -229,32 +239,38 @@ void CharChunk::AppendFixedResult(Transliterators::Transliterator t12r,
 // Here, '{*}ぁ' -> '{*}あ' -> '{*}ぁ' is the loop.
 absl::btree_set<std::string> CharChunk::GetExpandedResults() const {
   absl::btree_set<std::string> results;
+  ForEachExpandedResult(
+      [&results](absl::string_view result) { results.emplace(result); });
+  return results;
+}
+
+void CharChunk::ForEachExpandedResult(
+    absl::FunctionRef<void(absl::string_view)> callback) const {
   if (pending_.empty()) {
-    return results;
+    return;
   }
+  // Holds the result only when special keys are deleted from it.
+  std::string buffer;
   // Append current pending string
   if (conversion_.empty()) {
-    results.insert(DeleteSpecialKeys(pending_));
+    callback(DeleteSpecialKeys(pending_, &buffer));
   }
-  std::vector<const Entry*> entries;
-  table_->LookUpPredictiveAll(pending_, &entries);
-  for (const Entry* entry : entries) {
+  table_->ForEachPredictiveEntry(pending_, [&](const Entry* entry) {
     if (!entry->result().empty()) {
-      results.insert(DeleteSpecialKeys(entry->result()));
+      callback(DeleteSpecialKeys(entry->result(), &buffer));
     }
     if (entry->pending().empty()) {
-      continue;
+      return;
     }
-    absl::btree_set<std::string> loop_result;
+    PendingKeys loop_result;
     if (!GetFromPending(table_.get(), entry->pending(), kMaxRecursion,
                         &loop_result)) {
-      continue;
+      return;
     }
     for (absl::string_view result : loop_result) {
-      results.insert(DeleteSpecialKeys(result));
+      callback(DeleteSpecialKeys(result, &buffer));
     }
-  }
-  return results;
+  });
 }
 
 bool CharChunk::IsFixed() const { return pending_.empty(); }
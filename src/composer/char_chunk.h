@@ -38,6 +38,7 @@
 
 #include "absl/base/attributes.h"
 #include "absl/container/btree_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
@@ -85,6 +86,12 @@ class CharChunk final {
 
   // Get possible results from current chunk
   absl::btree_set<std::string> GetExpandedResults() const;
+  // Same as GetExpandedResults, but calls |callback| for each result instead
+  // of building a set. The same result may be passed more than once. The
+  // string passed to |callback| is valid only during the call. Doesn't
+  // allocate unless a result with special keys is long.
+  void ForEachExpandedResult(
+      absl::FunctionRef<void(absl::string_view)> callback) const;
   bool IsFixed() const;
 
   // True if IsAppendable() is true and this object is fixed (|pending_|=="")
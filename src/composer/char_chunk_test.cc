@@ -40,6 +40,7 @@
 #include "composer/composition_input.h"
 #include "composer/table.h"
 #include "composer/transliterators.h"
+#include "testing/allocation_counter.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 
@@ -1789,6 +1790,50 @@ TEST(CharChunkTest, RomanGetExpandedResults) {
   }
 }
 
+TEST(CharChunkTest, ForEachExpandedResult) {
+  auto table = std::make_shared<Table>();
+  table->AddRule("kya", "きゃ", "");
+  table->AddRule("kk", "っ", "k");
+  table->AddRule("ka", "か", "");
+  table->AddRule("ki", "き", "");
+  table->AddRule("1", "", "あ");
+  table->AddRule("あ1", "", "い");
+  table->AddRule("い1", "", "あ");
+
+  for (absl::string_view input : {"k", "kk", "1", "11"}) {
+    CharChunk chunk(Transliterators::CONVERSION_STRING, table);
+    chunk.AddInputInternal(input);
+
+    absl::btree_set<std::string> results;
+    chunk.ForEachExpandedResult(
+        [&results](absl::string_view result) { results.emplace(result); });
+    EXPECT_EQ(results, chunk.GetExpandedResults()) << input;
+  }
+}
+
+TEST(CharChunkTest, ForEachExpandedResultDoesNotAllocate) {
+  auto table = std::make_shared<Table>();
+  table->AddRule("kya", "きゃ", "");
+  table->AddRule("kk", "っ", "k");
+  table->AddRule("ka", "か", "");
+  table->AddRule("ki", "き", "");
+  table->AddRule("1", "", "あ");
+  table->AddRule("あ1", "", "い");
+  table->AddRule("い1", "", "あ");
+
+  for (absl::string_view input : {"k", "1"}) {
+    CharChunk chunk(Transliterators::CONVERSION_STRING, table);
+    chunk.AddInputInternal(input);
+
+    size_t size = 0;
+    testing::AllocationCounter counter;
+    chunk.ForEachExpandedResult(
+        [&size](absl::string_view result) { size += result.size(); });
+    EXPECT_EQ(counter.num_allocations(), 0) << input;
+    EXPECT_GT(size, 0) << input;
+  }
+}
+
 TEST(CharChunkTest, KanaGetExpandedResults) {
   auto table = std::make_shared<Table>();
   table->AddRule("か゛", "が", "");
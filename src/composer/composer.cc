@@ -34,12 +34,14 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/no_destructor.h"
 #include "absl/container/btree_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
@@ -222,18 +224,17 @@ constexpr auto kModifierRemovalMap =
         {"ぽ", "ぼ"}, {"ゃ", "や"}, {"ゅ", "ゆ"}, {"ょ", "よ"}, {"ゎ", "わ"},
     });
 
-void RemoveExpandedCharsForModifier(absl::string_view asis,
-                                    absl::string_view base,
-                                    absl::btree_set<std::string>* expanded) {
+// Returns the pairs of `kModifierRemovalMap` whose values are removed from the
+// expansion of `base`.
+absl::Span<const std::pair<absl::string_view, absl::string_view>>
+GetExpandedCharsForModifier(absl::string_view asis, absl::string_view base) {
   if (!asis.starts_with(base)) {
     LOG(DFATAL) << "base is not a prefix of asis.";
-    return;
+    return {};
   }
 
   const absl::string_view trailing(asis.substr(base.size()));
-  for (auto [_, c] : kModifierRemovalMap.EqualSpan(trailing)) {
-    expanded->erase(c);
-  }
+  return kModifierRemovalMap.EqualSpan(trailing);
 }
 
 constexpr size_t kMaxPreeditLength = 256;
@@ -360,33 +361,53 @@ std::string GetQueryForPrediction(
   return japanese_util::FullWidthAsciiToHalfWidthAscii(*base_query);
 }
 
-std::pair<std::string, absl::btree_set<std::string>> GetQueriesForPrediction(
+std::string GetQueriesForPrediction(
     const Composition& composition,
-    const transliteration::TransliterationType input_mode) {
+    const transliteration::TransliterationType input_mode,
+    absl::FunctionRef<void(absl::string_view)> callback) {
   // In case of the Latin input modes, we don't perform expansion.
   switch (input_mode) {
     case transliteration::HALF_ASCII:
     case transliteration::FULL_ASCII: {
-      return std::make_pair(GetQueryForPrediction(composition, input_mode),
-                            absl::btree_set<std::string>());
+      return GetQueryForPrediction(composition, input_mode);
     }
     default: {
     }
   }
 
-  // auto = std::pair<std::string, absl::btree_set<std::string>>
-  auto [base_query, expanded] = composition.GetExpandedStrings();
-
-  // The above `GetExpandedStrings` generates expansion for modifier key as
-  // well, e.g., if the composition is "ざ", `expanded` contains "さ" too.
-  // However, "ざ" is usually composed by explicitly hitting the modifier key.
-  // So we don't want to generate prediction from "さ" in this case. The
-  // following code removes such unnecessary expansion.
+  // `GetExpandedStrings` generates expansion for modifier key as well, e.g.,
+  // if the composition is "ざ", the expansion contains "さ" too. However, "ざ"
+  // is usually composed by explicitly hitting the modifier key. So we don't
+  // want to generate prediction from "さ" in this case. The following code
+  // skips such unnecessary expansion.
   const std::string asis = composition.GetStringWithTrimMode(ASIS);
-  RemoveExpandedCharsForModifier(asis, base_query, &expanded);
+  std::string base_query;
+  std::optional<
+      absl::Span<const std::pair<absl::string_view, absl::string_view>>>
+      removed;
+  composition.GetExpandedStrings(&base_query, [&](absl::string_view expanded) {
+    if (!removed.has_value()) {
+      removed = GetExpandedCharsForModifier(asis, base_query);
+    }
+    for (auto [_, c] : *removed) {
+      if (c == expanded) {
+        return;
+      }
+    }
+    callback(expanded);
+  });
 
-  return std::make_pair(
-      japanese_util::FullWidthAsciiToHalfWidthAscii(base_query), expanded);
+  return japanese_util::FullWidthAsciiToHalfWidthAscii(base_query);
+}
+
+std::pair<std::string, absl::btree_set<std::string>> GetQueriesForPrediction(
+    const Composition& composition,
+    const transliteration::TransliterationType input_mode) {
+  absl::btree_set<std::string> expanded;
+  std::string base_query = GetQueriesForPrediction(
+      composition, input_mode,
+      [&expanded](absl::string_view query) { expanded.emplace(query); });
+  return std::make_pair(std::move(base_query), std::move(expanded));
 }
 
 std::string GetStringForTypeCorrection(const Composition& composition) {
@@ -493,6 +514,11 @@ ComposerData::GetQueriesForPrediction() const {
   return common::GetQueriesForPrediction(composition_, input_mode_);
 }
 
+std::string ComposerData::GetQueriesForPrediction(
+    absl::FunctionRef<void(absl::string_view)> callback) const {
+  return common::GetQueriesForPrediction(composition_, input_mode_, callback);
+}
+
 std::string ComposerData::GetStringForTypeCorrection() const {
   return common::GetStringForTypeCorrection(composition_);
 }
@@ -1046,6 +1072,11 @@ Composer::GetQueriesForPrediction() const {
   return common::GetQueriesForPrediction(composition_, input_mode_);
 }
 
+std::string Composer::GetQueriesForPrediction(
+    absl::FunctionRef<void(absl::string_view)> callback) const {
+  return common::GetQueriesForPrediction(composition_, input_mode_, callback);
+}
+
 std::string Composer::GetStringForTypeCorrection() const {
   return common::GetStringForTypeCorrection(composition_);
 }
@@ -41,6 +41,7 @@
 
 #include "absl/base/attributes.h"
 #include "absl/container/btree_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "composer/composition.h"
@@ -89,6 +90,11 @@ class ComposerData {
   // Returns a expanded prediction query.
   std::pair<std::string, absl::btree_set<std::string>> GetQueriesForPrediction()
       const;
+  // Same as above, but calls `callback` for each expanded query instead of
+  // building a set, and returns the base query. The same query may be passed
+  // more than once, and is valid only during the call.
+  std::string GetQueriesForPrediction(
+      absl::FunctionRef<void(absl::string_view)> callback) const;
 
   // Returns a string to be used for type correction.
   std::string GetStringForTypeCorrection() const;
@@ -240,6 +246,11 @@ class Composer final {
   // Returns a expanded prediction query.
   std::pair<std::string, absl::btree_set<std::string>> GetQueriesForPrediction()
       const;
+  // Same as above, but calls `callback` for each expanded query instead of
+  // building a set, and returns the base query. The same query may be passed
+  // more than once, and is valid only during the call.
+  std::string GetQueriesForPrediction(
+      absl::FunctionRef<void(absl::string_view)> callback) const;
 
   // Returns a string to be used for type correction.
   std::string GetStringForTypeCorrection() const;
@@ -549,6 +549,32 @@ TEST_F(ComposerTest, GetQueriesForPredictionMobile) {
   }
 }
 
+TEST_F(ComposerTest, GetQueriesForPredictionWithCallback) {
+  table_->AddRule("s", "", "さ");
+  table_->AddRule("さ*", "", "ざ");
+  table_->AddRule("ざ*", "", "さ");
+  table_->AddRule("u", "う", "");
+  table_->AddRule("sa", "さ", "");
+
+  for (absl::string_view input : {"us", "s", "s*"}) {
+    composer_->EditErase();
+    composer_->InsertCharacter(input);
+    absl::btree_set<std::string> expanded;
+    const std::string base = composer_->GetQueriesForPrediction(
+        [&expanded](absl::string_view query) { expanded.emplace(query); });
+    // auto = std::pair<std::string, absl::btree_set<std::string>>
+    const auto [expected_base, expected_expanded] =
+        composer_->GetQueriesForPrediction();
+    EXPECT_EQ(base, expected_base) << input;
+    EXPECT_EQ(expanded, expected_expanded) << input;
+  }
+
+  // "さ" is not expanded from "ざ" composed by the modifier key.
+  EXPECT_TRUE(composer_->GetQueriesForPrediction(
+                  [](absl::string_view query) { EXPECT_NE(query, "さ"); })
+                  .empty());
+}
+
 // TODO(yukiokamoto): This unit test currently fails due to a crash. (Please
 // note that this crash could only occur in a debug build.)
 // Once another issue in b/277163340 that an input "[][]" is not converted
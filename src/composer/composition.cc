@@ -37,6 +37,7 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/btree_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
@@ -73,33 +74,36 @@ size_t Composition::InsertInput(size_t pos, CompositionInput input) {
     return pos;
   }
 
-  CharChunkList::iterator right_chunk = MaybeSplitChunkAt(pos);
-  while (right_chunk != chunks_.end() &&
-         right_chunk->GetLength(input_t12r_) == 0) {
-    ++right_chunk;
+  size_t right_index = MaybeSplitChunkAt(pos);
+  while (right_index < chunks_.size() &&
+         chunks_[right_index].GetLength(input_t12r_) == 0) {
+    ++right_index;
   }
 
-  CharChunkList::iterator left_chunk = GetInsertionChunk(right_chunk);
-
-  CombinePendingChunks(left_chunk, input);
+  size_t left_index = GetInsertionChunk(right_index);
+  left_index = CombinePendingChunks(left_index, input);
 
+  // The left chunk is always followed by the right chunk.
   while (true) {
-    left_chunk->AddCompositionInput(&input);
+    chunks_[left_index].AddCompositionInput(&input);
     if (input.Empty()) {
       break;
     }
-    left_chunk = InsertChunk(right_chunk);
+    InsertChunk(++left_index);
     input.set_is_new_input(false);
   }
+  right_index = left_index + 1;
 
   // If the chunk is empty as the result of AddCompositionInput above, removes
   // the empty chunk.
-  if (left_chunk->raw().empty() && left_chunk->conversion().empty() &&
-      left_chunk->pending().empty()) {
-    chunks_.erase(left_chunk);
+  const CharChunk& left_chunk = chunks_[left_index];
+  if (left_chunk.raw().empty() && left_chunk.conversion().empty() &&
+      left_chunk.pending().empty()) {
+    chunks_.erase(chunks_.begin() + left_index);
+    right_index = left_index;
   }
 
-  return GetPosition(Transliterators::LOCAL, right_chunk);
+  return GetPosition(Transliterators::LOCAL, chunks_.begin() + right_index);
 }
 
 // Deletes a right-hand character of the composition at the position.
@@ -113,22 +117,23 @@ size_t Composition::DeleteAt(const size_t position) {
   // chunk1 : 'b'
   // And DeleteAt(0) is invoked, we have to delete both chunks.
   while (!chunks_.empty() && GetLength() == original_size) {
-    CharChunkList::iterator chunk_it = MaybeSplitChunkAt(position);
-    new_position = GetPosition(Transliterators::LOCAL, chunk_it);
-    if (chunk_it == chunks_.end()) {
+    const size_t index = MaybeSplitChunkAt(position);
+    new_position = GetPosition(Transliterators::LOCAL, chunks_.begin() + index);
+    if (index == chunks_.size()) {
       break;
     }
 
     // We have to consider 0-length chunk.
     // If a chunk contains only invisible characters,
     // the result of GetLength is 0.
-    if (chunk_it->GetLength(Transliterators::LOCAL) <= 1) {
-      chunks_.erase(chunk_it);
+    CharChunk& chunk = chunks_[index];
+    if (chunk.GetLength(Transliterators::LOCAL) <= 1) {
+      chunks_.erase(chunks_.begin() + index);
       continue;
     }
 
     absl::StatusOr<CharChunk> left_deleted_chunk =
-        chunk_it->SplitChunk(Transliterators::LOCAL, 1);
+        chunk.SplitChunk(Transliterators::LOCAL, 1);
     if (!left_deleted_chunk.ok()) {
       LOG(WARNING) << "SplitChunk: " << left_deleted_chunk.status();
     }
@@ -270,23 +275,32 @@ std::string Composition::GetStringWithModes(
 
 std::pair<std::string, absl::btree_set<std::string>>
 Composition::GetExpandedStrings() const {
-  Transliterators::Transliterator transliterator = Transliterators::LOCAL;
+  std::string base;
+  absl::btree_set<std::string> expanded;
+  GetExpandedStrings(&base, [&expanded](absl::string_view result) {
+    expanded.emplace(result);
+  });
+  return std::make_pair(std::move(base), std::move(expanded));
+}
+
+void Composition::GetExpandedStrings(
+    std::string* base,
+    absl::FunctionRef<void(absl::string_view)> callback) const {
+  base->clear();
   if (chunks_.empty()) {
     MOZC_VLOG(1) << "The composition size is zero.";
-    return std::make_pair(std::string(), absl::btree_set<std::string>());
+    return;
   }
 
-  std::string base;
+  Transliterators::Transliterator transliterator = Transliterators::LOCAL;
   CharChunkList::const_iterator it;
   for (it = chunks_.begin(); it != std::prev(chunks_.end()); ++it) {
-    it->AppendResult(transliterator, &base);
+    it->AppendResult(transliterator, base);
   }
 
-  chunks_.back().AppendTrimedResult(transliterator, &base);
+  chunks_.back().AppendTrimedResult(transliterator, base);
   // Get expanded from the last chunk
-  const absl::btree_set<std::string> expanded =
-      chunks_.back().GetExpandedResults();
-  return std::make_pair(base, expanded);
+  chunks_.back().ForEachExpandedResult(callback);
 }
 
 std::string Composition::GetString() const {
@@ -366,56 +380,66 @@ size_t Composition::GetPosition(Transliterators::Transliterator transliterator,
   return position;
 }
 
-// Return the iterator to the right side CharChunk at the `position`.
+// Return the index of the right side CharChunk at the `position`.
 // If the `position` is in the middle of a CharChunk, that CharChunk is split.
-CharChunkList::iterator Composition::MaybeSplitChunkAt(const size_t position) {
+size_t Composition::MaybeSplitChunkAt(const size_t position) {
   size_t inner_position;
-  CharChunkList::iterator it =
-      GetChunkAt(position, Transliterators::LOCAL, &inner_position);
-  if (it == chunks_.begin() && inner_position == 0) {
-    return it;
+  const size_t index =
+      GetChunkAt(position, Transliterators::LOCAL, &inner_position) -
+      chunks_.begin();
+  if (index == 0 && inner_position == 0) {
+    return index;
   }
 
-  CharChunk& chunk = *it;
+  CharChunk& chunk = chunks_[index];
   if (inner_position == chunk.GetLength(Transliterators::LOCAL)) {
-    return std::next(it);
+    return index + 1;
   }
 
   absl::StatusOr<CharChunk> left_chunk =
       chunk.SplitChunk(Transliterators::LOCAL, inner_position);
-  if (left_chunk.ok()) {
-    chunks_.insert(it, *std::move(left_chunk));
+  if (!left_chunk.ok()) {
+    return index;
   }
-  return it;
+  chunks_.insert(chunks_.begin() + index, *std::move(left_chunk));
+  return index + 1;
 }
 
-void Composition::CombinePendingChunks(CharChunkList::iterator it,
-                                       const CompositionInput& input) {
+size_t Composition::CombinePendingChunks(size_t index,
+                                         const CompositionInput& input) {
   // If the input is asis, pending chunks are not related with this input.
   if (input.is_asis()) {
-    return;
+    return index;
   }
-  // Combine |**it| and |**(--it)| into |**it| as long as possible.
+  // Combine |chunks_[index]| and |chunks_[index - 1]| into |chunks_[index]|
+  // as long as possible.
   const absl::string_view next_input =
       input.conversion().empty() ? input.raw() : input.conversion();
 
-  while (it != chunks_.begin()) {
-    CharChunkList::iterator left_it = it;
-    --left_it;
-    if (!left_it->IsConvertible(input_t12r_, *table_,
-                                absl::StrCat(it->pending(), next_input))) {
-      return;
+  // Combined chunks are erased at once after the loop so that the tail of
+  // |chunks_| is shifted only once.
+  size_t left_index = index;
+  while (left_index > 0) {
+    const CharChunk& left_chunk = chunks_[left_index - 1];
+    CharChunk& chunk = chunks_[index];
+    if (!left_chunk.IsConvertible(input_t12r_, *table_,
+                                  absl::StrCat(chunk.pending(), next_input))) {
+      break;
     }
-
-    it->Combine(*left_it);
-    chunks_.erase(left_it);
+    chunk.Combine(left_chunk);
+    --left_index;
+  }
+  if (left_index == index) {
+    return index;
   }
+  chunks_.erase(chunks_.begin() + left_index, chunks_.begin() + index);
+  return left_index;
 }
 
-// Insert a chunk to the prev of it.
-CharChunkList::iterator Composition::InsertChunk(
-    CharChunkList::const_iterator it) {
-  return chunks_.insert(it, CharChunk(input_t12r_, table_));
+// Insert a chunk to the prev of index.
+CharChunk& Composition::InsertChunk(size_t index) {
+  DCHECK_LE(index, chunks_.size());
+  return *chunks_.emplace(chunks_.begin() + index, input_t12r_, table_);
 }
 
 const CharChunkList& Composition::GetCharChunkList() const { return chunks_; }
@@ -425,18 +449,14 @@ bool Composition::ShouldCommit() const {
       chunks_, [](const CharChunk& chunk) { return chunk.ShouldCommit(); });
 }
 
-// Return charchunk to be inserted and iterator of the *next* char chunk.
-CharChunkList::iterator Composition::GetInsertionChunk(
-    CharChunkList::iterator it) {
-  if (it == chunks_.begin()) {
-    return InsertChunk(it);
-  }
-
-  const CharChunkList::iterator left_it = std::prev(it);
-  if (left_it->IsAppendable(input_t12r_, *table_)) {
-    return left_it;
+// Return the index of charchunk to be inserted, given the index of the *next*
+// char chunk.
+size_t Composition::GetInsertionChunk(size_t index) {
+  if (index > 0 && chunks_[index - 1].IsAppendable(input_t12r_, *table_)) {
+    return index - 1;
   }
-  return InsertChunk(it);
+  InsertChunk(index);
+  return index;
 }
 
 void Composition::SetInputMode(Transliterators::Transliterator transliterator) {
@@ -31,16 +31,18 @@
 #define MOZC_COMPOSER_COMPOSITION_H_
 
 #include <cstddef>
-#include <list>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/container/btree_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "composer/char_chunk.h"
 #include "composer/composition_input.h"
 #include "composer/table.h"
@@ -49,7 +51,12 @@
 namespace mozc {
 namespace composer {
 
-using CharChunkList = std::list<CharChunk>;
+// Chunks are stored contiguously. Compositions rarely exceed a few dozen
+// chunks, so shifting elements on insertion is cheaper than chasing list
+// nodes on every cursor move and position lookup. As insertions and removals
+// invalidate iterators, the mutating methods below take and return chunk
+// indices instead.
+using CharChunkList = std::vector<CharChunk>;
 
 enum TrimMode {
   TRIM,  // "かn" => "か"
@@ -137,6 +144,12 @@ class Composition final {
   // Get string with consideration for ambiguity from pending input
   std::pair<std::string, absl::btree_set<std::string>> GetExpandedStrings()
       const;
+  // Same as above, but calls `callback` for each expanded string instead of
+  // building a set. `base` is set before the first call. The same string may
+  // be passed more than once, and is valid only during the call.
+  void GetExpandedStrings(
+      std::string* base,
+      absl::FunctionRef<void(absl::string_view)> callback) const;
   void GetPreedit(size_t position, std::string* left, std::string* focused,
                   std::string* right) const;
 
@@ -164,22 +177,24 @@ class Composition final {
   size_t GetPosition(Transliterators::Transliterator transliterator,
                      CharChunkList::const_iterator it) const;
 
-  // Return CharChunk to be inserted a new character.
-  // The argument `it` is the focused CharChunk by the cursor.
-  CharChunkList::iterator GetInsertionChunk(CharChunkList::iterator it);
+  // Return the index of CharChunk to be inserted a new character.
+  // The argument `index` is the focused CharChunk by the cursor.
+  size_t GetInsertionChunk(size_t index);
 
-  CharChunkList::iterator InsertChunk(CharChunkList::const_iterator it);
+  // Insert a new chunk before `index` and return it. The new chunk is placed
+  // at `index`.
+  CharChunk& InsertChunk(size_t index);
 
-  // Return the iterator to the right side CharChunk at the `position`.
+  // Return the index of the right side CharChunk at the `position`.
   // If the `position` is in the middle of a CharChunk, that CharChunk is split.
   //
   // examples
   // # typical cases
-  // chunks: ["a", "bc", "d"], pos: 0 -> "a" (= begin)
+  // chunks: ["a", "bc", "d"], pos: 0 -> "a" (= 0)
   // chunks: ["a", "bc", "d"], pos: 1 -> "bc"
   // chunks: ["a", "bc", "d"], pos: 2 -> "c", chunks become ["a", "b", "c", "d"]
   // chunks: ["a", "bc", "d"], pos: 3 -> "d"
-  // chunks: ["a", "bc", "d"], pos: 4 -> end
+  // chunks: ["a", "bc", "d"], pos: 4 -> end (= chunks().size())
   // # {b} is an invisible character
   // chunks: ["a", "{b}c", "d"], pos: 1 -> "{b}c"
   // chunks: ["a", "{b}c", "d"], pos: 2 -> "d"
@@ -188,16 +203,16 @@ class Composition final {
   // chunks: ["a", "b{c}", "d"], pos: 1 -> "b{c}"
   // chunks: ["a", "b{c}", "d"], pos: 2 -> "d"
   // chunks: ["a", "b{c}", "d"], pos: 3 -> end
-  CharChunkList::iterator MaybeSplitChunkAt(size_t position);
+  size_t MaybeSplitChunkAt(size_t position);
 
-  // Combine |input| and chunks from |it| to left direction,
-  // which have pending data and can be combined.
+  // Combine |input| and chunks from |index| to left direction,
+  // which have pending data and can be combined, and return the new index of
+  // the combined chunk.
   // e.g. [pending='q']+[pending='k']+[pending='y']+[input='o'] are combined
   //      into [pending='q']+[pending='ky'] because [pending='ky']+[input='o']
   //      can turn to be a fixed chunk.
   // e.g. [pending='k']+[pending='y']+[input='q'] are not combined.
-  void CombinePendingChunks(CharChunkList::iterator it,
-                            const CompositionInput& input);
+  size_t CombinePendingChunks(size_t index, const CompositionInput& input);
   const CharChunkList& GetCharChunkList() const;
   std::shared_ptr<const Table> table_for_testing() const { return table_; }
   const CharChunkList& chunks() const { return chunks_; }
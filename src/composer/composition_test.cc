@@ -36,6 +36,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/btree_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "composer/char_chunk.h"
@@ -94,10 +95,10 @@ static int InitComposition(Composition& comp) {
       {"った", "", "tta"}, {"っ", "ty", "tty"},
   };
   static const int test_chunks_size = std::size(test_chunks);
-  CharChunkList::iterator it = comp.MaybeSplitChunkAt(0);
+  size_t index = comp.MaybeSplitChunkAt(0);
   for (int i = 0; i < test_chunks_size; ++i) {
     const TestCharChunk& data = test_chunks[i];
-    CharChunk& chunk = *comp.InsertChunk(it);
+    CharChunk& chunk = comp.InsertChunk(index++);
     chunk.set_conversion(data.conversion);
     chunk.set_pending(data.pending);
     chunk.set_raw(data.raw);
@@ -107,9 +108,9 @@ static int InitComposition(Composition& comp) {
 
 static CharChunk& AppendChunk(const char* conversion, const char* pending,
                               const char* raw, Composition& comp) {
-  CharChunkList::iterator it = comp.MaybeSplitChunkAt(comp.GetLength());
+  const size_t index = comp.MaybeSplitChunkAt(comp.GetLength());
 
-  CharChunk& chunk = *comp.InsertChunk(it);
+  CharChunk& chunk = comp.InsertChunk(index);
   chunk.set_conversion(conversion);
   chunk.set_pending(pending);
   chunk.set_raw(raw);
@@ -429,9 +430,9 @@ TEST_F(CompositionTest, DeleteAtInvisibleCharacter) {
   using ChunkData = std::vector<std::pair<std::string, std::string>>;
   auto init_chunk = [&](Composition& composition, const ChunkData& data) {
     composition.Erase();
-    CharChunkList::iterator it = composition.MaybeSplitChunkAt(0);
+    size_t index = composition.MaybeSplitChunkAt(0);
     for (const auto& item : data) {
-      CharChunk& chunk = *composition.InsertChunk(it);
+      CharChunk& chunk = composition.InsertChunk(index++);
       chunk.set_raw(table_->ParseSpecialKey(item.first));
       chunk.set_pending(table_->ParseSpecialKey(item.second));
     }
@@ -591,6 +592,25 @@ TEST_F(CompositionTest, GetExpandedStrings) {
   EXPECT_TRUE(expanded.find("ちゃ") != expanded.end());
 }
 
+TEST_F(CompositionTest, GetExpandedStringsWithCallback) {
+  InitTable(table_.get());
+  InitComposition(composition_);
+
+  std::string base;
+  absl::btree_set<std::string> expanded;
+  composition_.GetExpandedStrings(&base, [&expanded](absl::string_view str) {
+    expanded.emplace(str);
+  });
+  EXPECT_EQ(base, "あkyきったっ");
+  EXPECT_EQ(expanded, composition_.GetExpandedStrings().second);
+
+  // |base| is cleared for an empty composition.
+  Composition empty(table_);
+  empty.GetExpandedStrings(&base,
+                           [](absl::string_view) { FAIL() << "Unexpected"; });
+  EXPECT_EQ(base, "");
+}
+
 TEST_F(CompositionTest, ConvertPosition) {
   // Test against http://b/1550597
 
@@ -1142,16 +1162,17 @@ TEST_F(CompositionTest, CombinePendingChunks) {
 
     size_t pos = 0;
 
-    CharChunkList::iterator it = comp.MaybeSplitChunkAt(pos);
-    CharChunkList::iterator chunk_it = comp.GetInsertionChunk(it);
+    const size_t index = comp.MaybeSplitChunkAt(pos);
+    size_t chunk_index = comp.GetInsertionChunk(index);
 
     CompositionInput input;
     SetInput("n", "", false, &input);
-    comp.CombinePendingChunks(chunk_it, input);
-    EXPECT_EQ(chunk_it->pending(), "");
-    EXPECT_EQ(chunk_it->conversion(), "");
-    EXPECT_EQ(chunk_it->raw(), "");
-    EXPECT_EQ(chunk_it->ambiguous(), "");
+    chunk_index = comp.CombinePendingChunks(chunk_index, input);
+    const CharChunk& chunk = comp.chunks()[chunk_index];
+    EXPECT_EQ(chunk.pending(), "");
+    EXPECT_EQ(chunk.conversion(), "");
+    EXPECT_EQ(chunk.raw(), "");
+    EXPECT_EQ(chunk.ambiguous(), "");
   }
   {
     // [x] + "n" -> [x] + "n"
@@ -1162,16 +1183,17 @@ TEST_F(CompositionTest, CombinePendingChunks) {
     size_t pos = 0;
     pos = comp.InsertAt(pos, "x");
 
-    CharChunkList::iterator it = comp.MaybeSplitChunkAt(pos);
-    CharChunkList::iterator chunk_it = comp.GetInsertionChunk(it);
+    const size_t index = comp.MaybeSplitChunkAt(pos);
+    size_t chunk_index = comp.GetInsertionChunk(index);
     CompositionInput input;
     SetInput("n", "", false, &input);
 
-    comp.CombinePendingChunks(chunk_it, input);
-    EXPECT_EQ(chunk_it->pending(), "");
-    EXPECT_EQ(chunk_it->conversion(), "");
-    EXPECT_EQ(chunk_it->raw(), "");
-    EXPECT_EQ(chunk_it->ambiguous(), "");
+    chunk_index = comp.CombinePendingChunks(chunk_index, input);
+    const CharChunk& chunk = comp.chunks()[chunk_index];
+    EXPECT_EQ(chunk.pending(), "");
+    EXPECT_EQ(chunk.conversion(), "");
+    EXPECT_EQ(chunk.raw(), "");
+    EXPECT_EQ(chunk.ambiguous(), "");
   }
   {
     // Append "a" to [n][y] -> [ny] + "a"
@@ -1183,16 +1205,17 @@ TEST_F(CompositionTest, CombinePendingChunks) {
     pos = comp.InsertAt(pos, "y");
     pos = comp.InsertAt(0, "n");
 
-    CharChunkList::iterator it = comp.MaybeSplitChunkAt(2);
-    CharChunkList::iterator chunk_it = comp.GetInsertionChunk(it);
+    const size_t index = comp.MaybeSplitChunkAt(2);
+    size_t chunk_index = comp.GetInsertionChunk(index);
     CompositionInput input;
     SetInput("a", "", false, &input);
 
-    comp.CombinePendingChunks(chunk_it, input);
-    EXPECT_EQ(chunk_it->pending(), "ny");
-    EXPECT_EQ(chunk_it->conversion(), "");
-    EXPECT_EQ(chunk_it->raw(), "ny");
-    EXPECT_EQ(chunk_it->ambiguous(), "んy");
+    chunk_index = comp.CombinePendingChunks(chunk_index, input);
+    const CharChunk& chunk = comp.chunks()[chunk_index];
+    EXPECT_EQ(chunk.pending(), "ny");
+    EXPECT_EQ(chunk.conversion(), "");
+    EXPECT_EQ(chunk.raw(), "ny");
+    EXPECT_EQ(chunk.ambiguous(), "んy");
   }
   {
     // Append "a" to [x][n][y] -> [x][ny] + "a"
@@ -1205,16 +1228,17 @@ TEST_F(CompositionTest, CombinePendingChunks) {
     pos = comp.InsertAt(pos, "y");
     pos = comp.InsertAt(1, "n");
 
-    CharChunkList::iterator it = comp.MaybeSplitChunkAt(3);
-    CharChunkList::iterator chunk_it = comp.GetInsertionChunk(it);
+    const size_t index = comp.MaybeSplitChunkAt(3);
+    size_t chunk_index = comp.GetInsertionChunk(index);
     CompositionInput input;
     SetInput("a", "", false, &input);
 
-    comp.CombinePendingChunks(chunk_it, input);
-    EXPECT_EQ(chunk_it->pending(), "ny");
-    EXPECT_EQ(chunk_it->conversion(), "");
-    EXPECT_EQ(chunk_it->raw(), "ny");
-    EXPECT_EQ(chunk_it->ambiguous(), "んy");
+    chunk_index = comp.CombinePendingChunks(chunk_index, input);
+    const CharChunk& chunk = comp.chunks()[chunk_index];
+    EXPECT_EQ(chunk.pending(), "ny");
+    EXPECT_EQ(chunk.conversion(), "");
+    EXPECT_EQ(chunk.raw(), "ny");
+    EXPECT_EQ(chunk.ambiguous(), "んy");
   }
 
   {
@@ -1229,16 +1253,50 @@ TEST_F(CompositionTest, CombinePendingChunks) {
     pos = comp.InsertAt(pos, "y");
     pos = comp.InsertAt(1, "n");
 
-    CharChunkList::iterator it = comp.MaybeSplitChunkAt(3);
-    CharChunkList::iterator chunk_it = comp.GetInsertionChunk(it);
+    const size_t index = comp.MaybeSplitChunkAt(3);
+    size_t chunk_index = comp.GetInsertionChunk(index);
     CompositionInput input;
     SetInput("x", "a", false, &input);
 
-    comp.CombinePendingChunks(chunk_it, input);
-    EXPECT_EQ(chunk_it->pending(), "ny");
-    EXPECT_EQ(chunk_it->conversion(), "");
-    EXPECT_EQ(chunk_it->raw(), "ny");
+    chunk_index = comp.CombinePendingChunks(chunk_index, input);
+    const CharChunk& chunk = comp.chunks()[chunk_index];
+    EXPECT_EQ(chunk.pending(), "ny");
+    EXPECT_EQ(chunk.conversion(), "");
+    EXPECT_EQ(chunk.raw(), "ny");
+  }
+}
+
+TEST_F(CompositionTest, LongComposition) {
+  table_->AddRule("ka", "か", "");
+  table_->AddRule("n", "ん", "");
+  table_->AddRule("na", "な", "");
+  composition_.SetInputMode(Transliterators::HIRAGANA);
+
+  constexpr int kSize = 200;
+  size_t pos = 0;
+  for (int i = 0; i < kSize; ++i) {
+    pos = InsertCharacters("ka", pos, composition_);
   }
+  EXPECT_EQ(pos, kSize);
+  EXPECT_EQ(composition_.chunks().size(), kSize);
+
+  // Insert and delete in the middle so that the following chunks are moved.
+  pos = InsertCharacters("na", kSize / 2, composition_);
+  EXPECT_EQ(pos, kSize / 2 + 1);
+  EXPECT_EQ(composition_.chunks().size(), kSize + 1);
+  EXPECT_EQ(composition_.chunks()[kSize / 2].conversion(), "な");
+  EXPECT_EQ(composition_.GetLength(), kSize + 1);
+
+  EXPECT_EQ(composition_.DeleteAt(kSize / 2), kSize / 2);
+  EXPECT_EQ(composition_.chunks().size(), kSize);
+  std::string expected;
+  for (int i = 0; i < kSize; ++i) {
+    expected.append("か");
+  }
+  EXPECT_EQ(composition_.GetString(), expected);
+  EXPECT_EQ(composition_.ConvertPosition(kSize, Transliterators::LOCAL,
+                                         Transliterators::RAW_STRING),
+            kSize * 2);
 }
 
 TEST_F(CompositionTest, NewChunkBehaviors) {
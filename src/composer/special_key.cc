@@ -160,30 +160,70 @@ absl::string_view TrimLeadingSpecialKey(absl::string_view input) {
   return input.substr(close_pos + 1);
 }
 
-std::string DeleteSpecialKeys(absl::string_view input) {
-  std::string output;
-  while (!input.empty()) {
-    std::optional<Block> block =
-        FindBlock(input, kSpecialKeyOpen, kSpecialKeyClose);
-    if (!block) {
-      absl::StrAppend(&output, input);
-      break;
+namespace {
+
+// Returns true if `input` has a Unicode PUA character converted from a special
+// key before the first invalid UTF-8 sequence.
+bool HasSpecialKeyChar(absl::string_view input) {
+  char32_t c;
+  while (Util::SplitFirstChar32(input, &c, &input)) {
+    if (IsSpecialKey(c)) {
+      return true;
     }
+  }
+  return false;
+}
 
-    absl::StrAppend(&output, input.substr(0, block->open_pos));
-    // The size of kSpecialKeyClose is 1.
-    input = absl::ClippedSubstr(input, block->close_pos + 1);
+}  // namespace
+
+absl::string_view DeleteSpecialKeys(absl::string_view input,
+                                    std::string* buffer) {
+  absl::string_view output = input;
+  if (FindBlock(input, kSpecialKeyOpen, kSpecialKeyClose)) {
+    buffer->clear();
+    while (!input.empty()) {
+      std::optional<Block> block =
+          FindBlock(input, kSpecialKeyOpen, kSpecialKeyClose);
+      if (!block) {
+        absl::StrAppend(buffer, input);
+        break;
+      }
+      absl::StrAppend(buffer, input.substr(0, block->open_pos));
+      // The size of kSpecialKeyClose is 1.
+      input = absl::ClippedSubstr(input, block->close_pos + 1);
+    }
+    output = *buffer;
   }
 
-  // Delete Unicode PUA characters converted from special keys.
-  std::u32string codepoints = Util::Utf8ToUtf32(output);
-  auto last =
-      std::remove_if(codepoints.begin(), codepoints.end(), IsSpecialKey);
-  if (last == codepoints.end()) {
+  if (!HasSpecialKeyChar(output)) {
     return output;
   }
-  codepoints.erase(last, codepoints.end());
-  return Util::Utf32ToUtf8(codepoints);
+
+  // Delete Unicode PUA characters converted from special keys. Like
+  // Util::Utf8ToUtf32(), stops at the first invalid UTF-8 sequence. The
+  // characters are moved forward within `buffer`.
+  if (output.data() != buffer->data()) {
+    buffer->assign(output.data(), output.size());
+  }
+  absl::string_view rest = *buffer;
+  size_t size = 0;
+  char32_t c;
+  absl::string_view next;
+  while (Util::SplitFirstChar32(rest, &c, &next)) {
+    const size_t length = rest.size() - next.size();
+    if (!IsSpecialKey(c)) {
+      std::copy(rest.begin(), rest.begin() + length, buffer->begin() + size);
+      size += length;
+    }
+    rest = next;
+  }
+  buffer->resize(size);
+  return *buffer;
+}
+
+std::string DeleteSpecialKeys(absl::string_view input) {
+  std::string buffer;
+  return std::string(DeleteSpecialKeys(input, &buffer));
 }
 
 }  // namespace mozc::composer::internal
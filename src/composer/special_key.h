@@ -60,6 +60,12 @@ absl::string_view TrimLeadingSpecialKey(absl::string_view input);
 // trimmed visible string.
 std::string DeleteSpecialKeys(absl::string_view input);
 
+// Same as above, but returns `input` itself if it has no special keys, and
+// otherwise stores the visible string in `buffer` and returns it. Doesn't
+// allocate once `buffer` is large enough. `input` must not refer to `buffer`.
+absl::string_view DeleteSpecialKeys(absl::string_view input,
+                                    std::string* buffer);
+
 }  // namespace mozc::composer::internal
 
 #endif  // MOZC_COMPOSER_SPECIAL_KEY_H_
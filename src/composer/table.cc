@@ -31,6 +31,7 @@
 
 #include "composer/table.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <istream>  // NOLINT
@@ -43,6 +44,7 @@
 
 #include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
+#include "absl/functional/function_ref.h"
 #include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -50,6 +52,7 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "base/config_file_stream.h"
+#include "base/container/double_array_trie.h"
 #include "base/hash.h"
 #include "base/util.h"
 #include "composer/special_key.h"
@@ -214,6 +217,7 @@ bool Table::InitializeWithRequestAndConfig(const commands::Request& request,
         table_file_name = nullptr;
     }
     if (table_file_name && LoadFromFile(table_file_name)) {
+      CompileEntries();
       return true;
     }
   }
@@ -312,6 +316,7 @@ bool Table::InitializeWithRequestAndConfig(const commands::Request& request,
 
   // Load Kana combination rules.
   result = LoadFromFile(kKanaCombinationTableFile);
+  CompileEntries();
   return result;
 }
 
@@ -369,6 +374,7 @@ const Entry* absl_nullable Table::AddRuleWithAttributes(
 
   const std::string input = special_key_map_.Register(escaped_input);
   const std::string pending = special_key_map_.Register(escaped_pending);
+  use_compiled_entries_ = false;
   if (IsLoopingEntry(input, pending)) {
     LOG(WARNING) << "Entry " << input << " " << output << " " << pending
                  << " is removed, since the rule is looping";
@@ -414,6 +420,7 @@ void Table::DeleteRule(const absl::string_view input) {
     DeleteEntry(old_entry);
   }
   entries_.DeleteEntry(input);
+  use_compiled_entries_ = false;
 }
 
 bool Table::LoadFromString(absl::string_view str) {
@@ -490,7 +497,31 @@ bool Table::LoadFromStream(std::istream* is) {
   return true;
 }
 
+absl::string_view Table::NormalizeInput(const absl::string_view input,
+                                        std::string* buffer) const {
+  if (case_sensitive_) {
+    return input;
+  }
+  buffer->assign(input.data(), input.size());
+  Util::LowerString(buffer);
+  return *buffer;
+}
+
 const Entry* Table::LookUp(const absl::string_view input) const {
+  if (use_compiled_entries_) {
+    std::string buffer;
+    const absl::string_view normalized_input = NormalizeInput(input, &buffer);
+    size_t key_length = 0;
+    const DoubleArrayTrie::NodeId node =
+        TraverseCompiledEntries(normalized_input, &key_length);
+    const int32_t value = compiled_entries_.GetValue(node);
+    if (key_length < normalized_input.size() ||
+        value == DoubleArrayTrie::kNoValue) {
+      return nullptr;
+    }
+    return compiled_values_[value];
+  }
+
   const Entry* entry = nullptr;
   if (case_sensitive_) {
     entries_.LookUp(input, &entry);
@@ -504,6 +535,20 @@ const Entry* Table::LookUp(const absl::string_view input) const {
 
 const Entry* Table::LookUpPrefix(const absl::string_view input,
                                  size_t* key_length, bool* fixed) const {
+  if (use_compiled_entries_) {
+    std::string buffer;
+    const absl::string_view normalized_input = NormalizeInput(input, &buffer);
+    const DoubleArrayTrie::NodeId node =
+        TraverseCompiledEntries(normalized_input, key_length);
+    const int32_t value = compiled_entries_.GetValue(node);
+    if (value == DoubleArrayTrie::kNoValue) {
+      *fixed = true;
+      return nullptr;
+    }
+    *fixed = !compiled_entries_.HasChildren(node);
+    return compiled_values_[value];
+  }
+
   const Entry* entry = nullptr;
   if (case_sensitive_) {
     entries_.LookUpPrefix(input, &entry, key_length, fixed);
@@ -517,13 +562,15 @@ const Entry* Table::LookUpPrefix(const absl::string_view input,
 
 void Table::LookUpPredictiveAll(const absl::string_view input,
                                 std::vector<const Entry*>* results) const {
-  if (case_sensitive_) {
-    entries_.LookUpPredictiveAll(input, results);
-  } else {
-    std::string normalized_input(input);
-    Util::LowerString(&normalized_input);
-    entries_.LookUpPredictiveAll(normalized_input, results);
-  }
+  ForEachPredictiveEntry(
+      input, [results](const Entry* entry) { results->push_back(entry); });
+}
+
+void Table::ForEachPredictiveEntry(
+    const absl::string_view input,
+    absl::FunctionRef<void(const Entry*)> callback) const {
+  std::string buffer;
+  entries_.ForEachPredictive(NormalizeInput(input, &buffer), callback);
 }
 
 bool Table::HasNewChunkEntry(const absl::string_view input) const {
@@ -543,6 +590,17 @@ bool Table::HasNewChunkEntry(const absl::string_view input) const {
 }
 
 bool Table::HasSubRules(const absl::string_view input) const {
+  if (use_compiled_entries_) {
+    if (input.empty()) {
+      return false;
+    }
+    std::string buffer;
+    const absl::string_view normalized_input = NormalizeInput(input, &buffer);
+    size_t key_length = 0;
+    TraverseCompiledEntries(normalized_input, &key_length);
+    return key_length == normalized_input.size();
+  }
+
   if (case_sensitive_) {
     return entries_.HasSubTrie(input);
   } else {
@@ -554,6 +612,75 @@ bool Table::HasSubRules(const absl::string_view input) const {
 
 void Table::DeleteEntry(const Entry* entry) { entry_set_.erase(entry); }
 
+namespace {
+
+// Returns the byte length of the first character of `input` as Trie<T> splits
+// it. Trie<T> maps an invalid UTF-8 sequence to U+0000 and consumes the rest of
+// the input, so such a sequence is traversed as "\0" in the compiled trie.
+size_t SplitFirstCharForTrie(absl::string_view input,
+                             absl::string_view* label) {
+  absl::string_view rest;
+  if (!Util::SplitFirstChar32(input, nullptr, &rest)) {
+    *label = absl::string_view("\0", 1);
+    return input.size();
+  }
+  const size_t length = input.size() - rest.size();
+  *label = input.substr(0, length);
+  return length;
+}
+
+}  // namespace
+
+void Table::CompileEntries() {
+  std::vector<const Entry*> entries;
+  entries_.LookUpPredictiveAll("", &entries);
+
+  // Keys are the byte sequences of the characters as Trie<T> sees them.
+  std::vector<std::pair<std::string, const Entry*>> sorted_entries;
+  sorted_entries.reserve(entries.size());
+  for (const Entry* entry : entries) {
+    std::string key;
+    absl::string_view input = entry->input();
+    while (!input.empty()) {
+      absl::string_view label;
+      input.remove_prefix(SplitFirstCharForTrie(input, &label));
+      key.append(label.data(), label.size());
+    }
+    sorted_entries.emplace_back(std::move(key), entry);
+  }
+  std::sort(sorted_entries.begin(), sorted_entries.end());
+
+  std::vector<absl::string_view> keys;
+  std::vector<int32_t> values;
+  keys.reserve(sorted_entries.size());
+  values.reserve(sorted_entries.size());
+  compiled_values_.clear();
+  compiled_values_.reserve(sorted_entries.size());
+  for (const auto& [key, entry] : sorted_entries) {
+    keys.push_back(key);
+    values.push_back(compiled_values_.size());
+    compiled_values_.push_back(entry);
+  }
+  compiled_entries_ = DoubleArrayTrie::Build(keys, values);
+  use_compiled_entries_ = true;
+}
+
+DoubleArrayTrie::NodeId Table::TraverseCompiledEntries(
+    absl::string_view input, size_t* key_length) const {
+  DoubleArrayTrie::NodeId node = DoubleArrayTrie::kRoot;
+  *key_length = 0;
+  while (*key_length < input.size()) {
+    absl::string_view label;
+    const size_t length =
+        SplitFirstCharForTrie(input.substr(*key_length), &label);
+    if (!compiled_entries_.Traverse(label, &node)) {
+      break;
+    }
+    *key_length += length;
+  }
+  return node;
+}
+
 bool Table::case_sensitive() const { return case_sensitive_; }
 
 void Table::set_case_sensitive(const bool case_sensitive) {
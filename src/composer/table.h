@@ -42,7 +42,9 @@
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/strings/string_view.h"
+#include "base/container/double_array_trie.h"
 #include "base/container/trie.h"
 #include "composer/special_key.h"
 #include "protocol/commands.pb.h"
@@ -117,6 +119,11 @@ class Table final {
                             bool* fixed) const;
   void LookUpPredictiveAll(absl::string_view input,
                            std::vector<const Entry*>* results) const;
+  // Same as LookUpPredictiveAll, but calls `callback` with each entry instead
+  // of building a vector.
+  void ForEachPredictiveEntry(
+      absl::string_view input,
+      absl::FunctionRef<void(const Entry*)> callback) const;
   // TODO(komatsu): Delete this function.
   bool HasSubRules(absl::string_view input) const;
 
@@ -144,11 +151,32 @@ class Table final {
   bool LoadFromStream(std::istream* is);
   void DeleteEntry(const Entry* entry);
 
+  // Builds `compiled_entries_` from `entries_`. The compiled trie is used for
+  // look-ups until the rules are modified.
+  void CompileEntries();
+
+  // Returns `input` lowered into `buffer` unless the table is case sensitive,
+  // in which case `input` is returned as is without copying.
+  absl::string_view NormalizeInput(absl::string_view input,
+                                   std::string* buffer) const;
+
+  // Traverses `compiled_entries_` by `input` as far as possible and returns
+  // the reached node. `key_length` is set to the byte length of the input
+  // consumed.
+  DoubleArrayTrie::NodeId TraverseCompiledEntries(absl::string_view input,
+                                                  size_t* key_length) const;
+
   using EntryTrie = Trie<const Entry*>;
   EntryTrie entries_;
   using EntrySet = absl::flat_hash_set<std::unique_ptr<Entry>>;
   EntrySet entry_set_;
 
+  // Read-only snapshot of `entries_`. The values of the trie are the indices
+  // of `compiled_values_`.
+  DoubleArrayTrie compiled_entries_;
+  std::vector<const Entry*> compiled_values_;
+  bool use_compiled_entries_ = false;
+
   internal::SpecialKeyMap special_key_map_;
 
   // If false, input alphabet characters are normalized to lower
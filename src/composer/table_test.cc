@@ -35,7 +35,10 @@
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "base/container/trie.h"
+#include "base/util.h"
 #include "composer/special_key.h"
 #include "config/config_handler.h"
 #include "data_manager/testing/mock_data_manager.h"
@@ -988,6 +991,29 @@ TEST_F(TableTest, DeleteSpecialKey) {
   EXPECT_EQ(DeleteSpecialKeys("\u000Fab\u000E\u000E"), "\u000E");
 }
 
+TEST_F(TableTest, DeleteSpecialKeyWithBuffer) {
+  const Table table;
+  std::string buffer;
+
+  // The input itself is returned if it has no special keys.
+  constexpr absl::string_view kNoSpecialKey = "abc";
+  const absl::string_view result = DeleteSpecialKeys(kNoSpecialKey, &buffer);
+  EXPECT_EQ(result, "abc");
+  EXPECT_EQ(result.data(), kNoSpecialKey.data());
+
+  for (absl::string_view input :
+       {"{!}", "a{!}", "{!}a", "a{bcd}", "{!}a{bc}d", "{!}ab{cd}"}) {
+    const std::string parsed = table.ParseSpecialKey(input);
+    EXPECT_EQ(DeleteSpecialKeys(parsed, &buffer), DeleteSpecialKeys(parsed))
+        << input;
+  }
+  for (absl::string_view input : {"\u000Fab", "ab\u000E",
+                                  "\u000F\u000Fab\u000E",
+                                  "\u000Fab\u000E\u000E"}) {
+    EXPECT_EQ(DeleteSpecialKeys(input, &buffer), DeleteSpecialKeys(input));
+  }
+}
+
 TEST_F(TableTest, TableManager) {
   TableManager table_manager;
   absl::flat_hash_set<std::shared_ptr<const Table>> table_set;
@@ -1068,5 +1094,72 @@ TEST_F(TableTest, TableManager) {
   }
 }
 
+TEST_F(TableTest, CompiledEntriesMatchTrie) {
+  // The compiled trie built at the end of InitializeWithRequestAndConfig()
+  // should return the same results as Trie<T>.
+  constexpr Request::SpecialRomanjiTable kTables[] = {
+      Request::DEFAULT_TABLE,
+      Request::TWELVE_KEYS_TO_HIRAGANA,
+      Request::FLICK_TO_HIRAGANA,
+      Request::TOGGLE_FLICK_TO_HIRAGANA,
+      Request::QWERTY_MOBILE_TO_HIRAGANA,
+      Request::GODAN_TO_HIRAGANA,
+  };
+  for (const Request::SpecialRomanjiTable special_table : kTables) {
+    Request request;
+    request.set_special_romanji_table(special_table);
+    Table table;
+    ASSERT_TRUE(table.InitializeWithRequestAndConfig(request, config_));
+
+    std::vector<const Entry*> entries;
+    table.LookUpPredictiveAll("", &entries);
+    ASSERT_FALSE(entries.empty());
+    Trie<const Entry*> trie;
+    std::vector<std::string> queries = {"", "\xff", "a\xe3\x81"};
+    absl::flat_hash_set<std::string> first_chars;
+    for (const Entry* entry : entries) {
+      trie.AddEntry(entry->input(), entry);
+      const std::vector<std::string> chars =
+          Util::SplitStringToUtf8Chars(entry->input());
+      std::string prefix;
+      for (const std::string& c : chars) {
+        prefix += c;
+        queries.push_back(prefix);
+      }
+      if (!chars.empty()) {
+        first_chars.insert(chars[0]);
+      }
+    }
+    const size_t num_queries = queries.size();
+    for (size_t i = 0; i < num_queries; ++i) {
+      for (const std::string& c : first_chars) {
+        queries.push_back(absl::StrCat(queries[i], c));
+      }
+    }
+
+    for (std::string query : queries) {
+      if (!table.case_sensitive()) {
+        Util::LowerString(&query);
+      }
+      size_t key_length = 0, expected_key_length = 0;
+      bool fixed = false, expected_fixed = false;
+      const Entry* expected = nullptr;
+      if (!trie.LookUpPrefix(query, &expected, &expected_key_length,
+                             &expected_fixed)) {
+        expected = nullptr;
+      }
+      EXPECT_EQ(table.LookUpPrefix(query, &key_length, &fixed), expected)
+          << query;
+      EXPECT_EQ(key_length, expected_key_length) << query;
+      EXPECT_EQ(fixed, expected_fixed) << query;
+      EXPECT_EQ(table.HasSubRules(query), trie.HasSubTrie(query)) << query;
+
+      expected = nullptr;
+      trie.LookUp(query, &expected);
+      EXPECT_EQ(table.LookUp(query), expected) << query;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace mozc::composer
@@ -43,6 +43,7 @@
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "base/bits.h"
 #include "base/config_file_stream.h"
@@ -629,7 +630,8 @@ CharacterFormManager::CharacterFormManager() : data_(std::make_unique<Data>()) {
 }
 
 void CharacterFormManager::ReloadConfig(const Config& config) {
-  Clear();
+  absl::MutexLock lock(mutex_);
+  ClearLocked();
   if (config.character_form_rules_size() > 0) {
     for (size_t i = 0; i < config.character_form_rules_size(); ++i) {
       const absl::string_view group = config.character_form_rules(i).group();
@@ -637,11 +639,11 @@ void CharacterFormManager::ReloadConfig(const Config& config) {
           config.character_form_rules(i).preedit_character_form();
       const Config::CharacterForm conversion_form =
           config.character_form_rules(i).conversion_character_form();
-      AddPreeditRule(group, preedit_form);
-      AddConversionRule(group, conversion_form);
+      data_->GetPreeditManager()->AddRule(group, preedit_form);
+      data_->GetConversionManager()->AddRule(group, conversion_form);
     }
   } else {
-    SetDefaultRule();
+    SetDefaultRuleLocked();
   }
 }
 
@@ -659,17 +661,20 @@ std::string CharacterFormManager::ConvertWidth(std::string input,
 
 void CharacterFormManager::ConvertPreeditString(const absl::string_view input,
                                                 std::string* output) const {
+  absl::ReaderMutexLock lock(mutex_);
   data_->GetPreeditManager()->ConvertString(input, output);
 }
 
 void CharacterFormManager::ConvertConversionString(
     const absl::string_view input, std::string* output) const {
+  absl::ReaderMutexLock lock(mutex_);
   data_->GetConversionManager()->ConvertString(input, output);
 }
 
 bool CharacterFormManager::ConvertPreeditStringWithAlternative(
     const absl::string_view input, std::string* output,
     std::string* alternative_output) const {
+  absl::ReaderMutexLock lock(mutex_);
   return data_->GetPreeditManager()->ConvertStringWithAlternative(
       input, output, alternative_output);
 }
@@ -677,17 +682,20 @@ bool CharacterFormManager::ConvertPreeditStringWithAlternative(
 bool CharacterFormManager::ConvertConversionStringWithAlternative(
     const absl::string_view input, std::string* output,
     std::string* alternative_output) const {
+  absl::ReaderMutexLock lock(mutex_);
   return data_->GetConversionManager()->ConvertStringWithAlternative(
       input, output, alternative_output);
 }
 
 Config::CharacterForm CharacterFormManager::GetPreeditCharacterForm(
     const absl::string_view input) const {
+  absl::ReaderMutexLock lock(mutex_);
   return data_->GetPreeditManager()->GetCharacterForm(input);
 }
 
 Config::CharacterForm CharacterFormManager::GetConversionCharacterForm(
     const absl::string_view input) const {
+  absl::ReaderMutexLock lock(mutex_);
   return data_->GetConversionManager()->GetCharacterForm(input);
 }
 
@@ -695,11 +703,17 @@ void CharacterFormManager::ClearHistory() {
   // no need to call, as storage is shared
   // GetPreeditManager()->ClearHistory();
   MOZC_VLOG(1) << "CharacterFormManager::ClearHistory() is called";
+  absl::MutexLock lock(mutex_);
   data_->GetConversionManager()->ClearHistory();
 }
 
 void CharacterFormManager::Clear() {
   MOZC_VLOG(1) << "CharacterFormManager::Clear() is called";
+  absl::MutexLock lock(mutex_);
+  ClearLocked();
+}
+
+void CharacterFormManager::ClearLocked() {
   data_->GetConversionManager()->Clear();
   data_->GetPreeditManager()->Clear();
 }
@@ -708,6 +722,7 @@ void CharacterFormManager::SetCharacterForm(const absl::string_view input,
                                             Config::CharacterForm form) {
   // no need to call Preedit, as storage is shared
   // GetPreeditManager()->SetCharacterForm(input, form);
+  absl::MutexLock lock(mutex_);
   data_->GetConversionManager()->SetCharacterForm(input, form);
 }
 
@@ -715,30 +730,40 @@ void CharacterFormManager::GuessAndSetCharacterForm(
     const absl::string_view input) {
   // no need to call Preedit, as storage is shared
   // GetPreeditManager()->SetCharacterForm(input, form);
+  absl::MutexLock lock(mutex_);
   data_->GetConversionManager()->GuessAndSetCharacterForm(input);
 }
 
 void CharacterFormManager::SetLastNumberStyle(
     const NumberFormStyle& form_style) {
+  absl::MutexLock lock(mutex_);
   data_->GetNumberStyleManager()->SetNumberStyle(form_style);
 }
 
 std::optional<const CharacterFormManager::NumberFormStyle>
 CharacterFormManager::GetLastNumberStyle() const {
+  absl::ReaderMutexLock lock(mutex_);
   return data_->GetNumberStyleManager()->GetNumberStyle();
 }
 
 void CharacterFormManager::AddPreeditRule(const absl::string_view input,
                                           Config::CharacterForm form) {
+  absl::MutexLock lock(mutex_);
   data_->GetPreeditManager()->AddRule(input, form);
 }
 
 void CharacterFormManager::AddConversionRule(const absl::string_view input,
                                              Config::CharacterForm form) {
+  absl::MutexLock lock(mutex_);
   data_->GetConversionManager()->AddRule(input, form);
 }
 
 void CharacterFormManager::SetDefaultRule() {
+  absl::MutexLock lock(mutex_);
+  SetDefaultRuleLocked();
+}
+
+void CharacterFormManager::SetDefaultRuleLocked() {
   data_->GetPreeditManager()->SetDefaultRule();
   data_->GetConversionManager()->SetDefaultRule();
 }
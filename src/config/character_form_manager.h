@@ -34,7 +34,9 @@
 #include <optional>
 #include <string>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "base/number_util.h"
 #include "base/singleton.h"
 #include "protocol/config.pb.h"
@@ -147,7 +149,14 @@ class CharacterFormManager {
   CharacterFormManager();
   ~CharacterFormManager() = default;
 
-  std::unique_ptr<Data> data_;
+  void ClearLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void SetDefaultRuleLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // The manager is a process-wide singleton shared by all sessions.
+  // Conversions share the reader lock while learning and rule updates take
+  // the writer lock.
+  mutable absl::Mutex mutex_;
+  std::unique_ptr<Data> data_ ABSL_PT_GUARDED_BY(mutex_);
 };
 
 }  // namespace config
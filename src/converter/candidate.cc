@@ -62,6 +62,7 @@ void Candidate::Clear() {
   prefix.clear();
   suffix.clear();
   description.clear();
+  a11y_description.clear();
   display_value.clear();
   usage_title.clear();
   usage_description.clear();
@@ -72,9 +73,11 @@ void Candidate::Clear() {
   rid = 0;
   usage_id = 0;
   attributes = 0;
+  category = DEFAULT_CATEGORY;
   style = NumberUtil::NumberString::DEFAULT_STYLE;
   command = DEFAULT_COMMAND;
   inner_segment_boundary.clear();
+  cost_before_rescoring = 0;
 #ifdef MOZC_CANDIDATE_DEBUG
   log.clear();
 #endif  // MOZC_CANDIDATE_DEBUG
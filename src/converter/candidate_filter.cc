@@ -228,10 +228,9 @@ bool IsNoisyNumberCandidate(const dictionary::PosMatcher& pos_matcher,
 CandidateFilter::CandidateFilter(const UserDictionaryInterface& user_dictionary,
                                  const PosMatcher& pos_matcher,
                                  const SuggestionFilter& suggestion_filter)
-    : user_dictionary_(user_dictionary),
-      pos_matcher_(pos_matcher),
+    : pos_matcher_(pos_matcher),
       suggestion_filter_(suggestion_filter),
-      has_suppressed_entries_(user_dictionary_.HasSuppressedEntries()),
+      suppression_dictionary_(user_dictionary.GetSuppressionDictionary()),
       top_candidate_(nullptr) {}
 
 void CandidateFilter::Reset() {
@@ -347,12 +346,13 @@ CandidateFilter::ResultType CandidateFilter::FilterCandidateInternal(
   }
 
   // Remove "抑制単語" just in case.
-  if (has_suppressed_entries_ &&
-      (user_dictionary_.IsSuppressedEntry(candidate->key, candidate->value) ||
+  if (suppression_dictionary_ &&
+      (suppression_dictionary_->IsSuppressedEntry(candidate->key,
+                                                  candidate->value) ||
        (candidate->key != candidate->content_key &&
         candidate->value != candidate->content_value &&
-        user_dictionary_.IsSuppressedEntry(candidate->content_key,
-                                           candidate->content_value)))) {
+        suppression_dictionary_->IsSuppressedEntry(
+            candidate->content_key, candidate->content_value)))) {
     MOZC_CANDIDATE_LOG(candidate, "SuppressEntry");
     return CandidateFilter::BAD_CANDIDATE;
   }
@@ -33,6 +33,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "absl/container/flat_hash_set.h"
@@ -43,6 +44,7 @@
 #include "converter/node.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/pos_matcher.h"
+#include "dictionary/suppression_dictionary.h"
 #include "prediction/suggestion_filter.h"
 #include "request/conversion_request.h"
 
@@ -123,13 +125,13 @@ class CandidateFilter {
                                      absl::Span<const Node* const> top_nodes,
                                      absl::Span<const Node* const> nodes);
 
-  const dictionary::UserDictionaryInterface& user_dictionary_;
   const dictionary::PosMatcher& pos_matcher_;
   const SuggestionFilter& suggestion_filter_;
-  // cache the result of HasSuppressedEntries, because calling
-  // IsSuppressedEntry() has some latency because of mutex lock even when
-  // the entry is empty.
-  bool has_suppressed_entries_ = false;
+  // Snapshot of the suppression entries taken at construction, so that the
+  // check for each candidate doesn't go through the user dictionary. nullptr
+  // if there's no suppression entry.
+  const std::shared_ptr<const dictionary::SuppressionDictionary>
+      suppression_dictionary_;
 
   absl::flat_hash_set<candidate_filter_internal::CandidateId,
                       candidate_filter_internal::CandidateHasher,
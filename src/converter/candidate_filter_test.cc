@@ -46,6 +46,7 @@
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_mock.h"
 #include "dictionary/pos_matcher.h"
+#include "dictionary/suppression_dictionary.h"
 #include "prediction/suggestion_filter.h"
 #include "protocol/commands.pb.h"
 #include "request/conversion_request.h"
@@ -58,7 +59,7 @@ namespace {
 
 using ::mozc::dictionary::MockUserDictionary;
 using ::mozc::dictionary::PosMatcher;
-using ::testing::_;
+using ::mozc::dictionary::SuppressionDictionary;
 using ::testing::Return;
 using ::testing::WithParamInterface;
 
@@ -138,11 +139,11 @@ class CandidateFilterTest : public ::testing::Test {
 
   const PosMatcher& pos_matcher() const { return pos_matcher_; }
 
-  CandidateFilter* CreateCandidateFilter() const {
-    EXPECT_CALL(mock_user_dictionary_, IsSuppressedEntry(_, _))
-        .WillRepeatedly(Return(false));
-    EXPECT_CALL(mock_user_dictionary_, HasSuppressedEntries())
-        .WillRepeatedly(Return(true));
+  CandidateFilter* CreateCandidateFilter(
+      std::shared_ptr<const SuppressionDictionary> suppression_dictionary =
+          nullptr) const {
+    EXPECT_CALL(mock_user_dictionary_, GetSuppressionDictionary())
+        .WillRepeatedly(Return(suppression_dictionary));
     return new CandidateFilter(mock_user_dictionary_, pos_matcher_,
                                suggestion_filter_);
   }
@@ -560,15 +561,10 @@ TEST_P(CandidateFilterTestWithParam, Regression3437022) {
   const ConversionRequest convreq = ConvReq(type);
   EXPECT_EQ(filter->FilterCandidate(convreq, "test_key", c1, n, n),
             CandidateFilter::GOOD_CANDIDATE);
-  // Clear the internal set |seen_| to prevent "test_key" from being filtered by
-  // "seen" rule.
-  filter->Reset();
 
-  EXPECT_CALL(mock_user_dictionary_, IsSuppressedEntry(_, _))
-      .WillRepeatedly(Return(false));
-  EXPECT_CALL(mock_user_dictionary_,
-              IsSuppressedEntry("test_key", "test_value"))
-      .WillRepeatedly(Return(true));
+  auto suppression_dictionary = std::make_shared<SuppressionDictionary>();
+  suppression_dictionary->AddEntry("test_key", "test_value");
+  filter.reset(CreateCandidateFilter(suppression_dictionary));
 
   EXPECT_EQ(filter->FilterCandidate(convreq, c1->key, c1, n, n),
             CandidateFilter::BAD_CANDIDATE);
@@ -581,10 +577,13 @@ TEST_P(CandidateFilterTestWithParam, Regression3437022) {
   EXPECT_EQ(filter->FilterCandidate(convreq, "test_key_suffix", c1, n, n),
             CandidateFilter::BAD_CANDIDATE);
 
+  // The filter keeps the suppression entries taken at its construction.
   ::testing::Mock::VerifyAndClearExpectations(&mock_user_dictionary_);
-  EXPECT_CALL(mock_user_dictionary_, IsSuppressedEntry(_, _))
-      .WillRepeatedly(Return(false));
+  filter->Reset();
+  EXPECT_EQ(filter->FilterCandidate(convreq, "test_key_suffix", c1, n, n),
+            CandidateFilter::BAD_CANDIDATE);
 
+  filter.reset(CreateCandidateFilter());
   EXPECT_EQ(filter->FilterCandidate(convreq, "test_key_suffix", c1, n, n),
             CandidateFilter::GOOD_CANDIDATE);
 }
@@ -806,8 +805,8 @@ TEST_P(CandidateFilterTestWithParam, NotFilteringAntiPhraseNode) {
     EXPECT_NE(n2->lid, n2->rid);
 
     Candidate* c = NewCandidate();
-    c->key = n1->key + n2->key;
-    c->value = n1->value + n2->value;
+    c->key = absl::StrCat(n1->key, n2->key);
+    c->value = absl::StrCat(n1->value, n2->value);
     c->content_key = n1->key;
     c->content_value = n1->value;
     c->cost = 6000;
@@ -838,8 +837,8 @@ TEST_P(CandidateFilterTestWithParam, NotFilteringAntiPhraseNode) {
     EXPECT_NE(n2->lid, n2->rid);
 
     Candidate* c = NewCandidate();
-    c->key = n1->key + n2->key;
-    c->value = n1->value + n2->value;
+    c->key = absl::StrCat(n1->key, n2->key);
+    c->value = absl::StrCat(n1->value, n2->value);
     c->content_key = n1->key;
     c->content_value = n1->value;
     c->cost = 6000;
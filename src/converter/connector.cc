@@ -131,8 +131,12 @@ absl::StatusOr<Metadata> ParseMetadata(const char* connection_data,
 void Connector::Row::Init(const uint8_t* chunk_bits, size_t chunk_bits_size,
                           const uint8_t* compact_bits, size_t compact_bits_size,
                           const uint8_t* values, bool use_1byte_value) {
-  chunk_bits_index_.Init(chunk_bits, chunk_bits_size);
-  compact_bits_index_.Init(compact_bits, compact_bits_size);
+  // GetValue() only uses Rank1, which is O(1) with the rank9 index.
+  using storage::louds::SimpleSuccinctBitVectorIndex;
+  chunk_bits_index_.Init(chunk_bits, chunk_bits_size, 0, 0,
+                         SimpleSuccinctBitVectorIndex::RANK9_INDEX);
+  compact_bits_index_.Init(compact_bits, compact_bits_size, 0, 0,
+                           SimpleSuccinctBitVectorIndex::RANK9_INDEX);
   values_ = values;
   use_1byte_value_ = use_1byte_value;
 }
@@ -161,24 +165,25 @@ std::optional<uint16_t> Connector::Row::GetValue(uint16_t index) const {
   return value;
 }
 
-absl::StatusOr<Connector> Connector::Create(absl::string_view connection_data) {
+absl::StatusOr<Connector> Connector::Create(absl::string_view connection_data,
+                                            Layout layout) {
   Connector connector;
-  absl::Status status = connector.Init(connection_data);
+  absl::Status status = connector.Init(connection_data, layout);
   if (!status.ok()) {
     return status;
   }
   return connector;
 }
 
-absl::Status Connector::Init(absl::string_view connection_data) {
-  cache_ = std::make_unique<cache_t>(kCacheSize);
-
+absl::Status Connector::Init(absl::string_view connection_data,
+                             Layout layout) {
   absl::StatusOr<Metadata> metadata =
       ParseMetadata(connection_data.data(), connection_data.size());
   if (!metadata.ok()) {
     return std::move(metadata).status();
   }
   resolution_ = metadata->resolution;
+  lsize_ = metadata->lsize;
 
   // Set the read location to the metadata end.
   const char* ptr = connection_data.data() + Metadata::kByteSize;
@@ -267,18 +272,41 @@ absl::Status Connector::Init(absl::string_view connection_data) {
                   values, metadata->Use1ByteValue());
   }
   VALIDATE_SIZE(ptr, 0, "Data end");
+
+  if (layout == Layout::kDense) {
+    BuildDenseMatrix();
+  } else {
+    cache_ = std::make_unique<cache_t>(kCacheSize);
+  }
   return absl::Status();
 
 #undef VALIDATE_ALIGNMENT
 #undef VALIDATE_SIZE
 }
 
-int Connector::GetTransitionCost(uint16_t rid, uint16_t lid) const {
-  // Note:
-  // This function is called very frequently and has a significant impact on
-  // execution time. When making any modifications, please conduct a performance
-  // analysis.
+void Connector::BuildDenseMatrix() {
+  const size_t rsize = rows_.size();
+  dense_costs_.resize(rsize * lsize_);
+  uint16_t* cost = dense_costs_.data();
+  for (size_t rid = 0; rid < rsize; ++rid) {
+    for (size_t lid = 0; lid < lsize_; ++lid) {
+      const int value = LookupCost(rid, lid);
+      *cost++ = (value >= 0 && value < kDenseCostFallback)
+                    ? static_cast<uint16_t>(value)
+                    : kDenseCostFallback;
+    }
+  }
+}
+
+size_t Connector::GetAllocatedBytes() const {
+  size_t bytes = dense_costs_.capacity() * sizeof(uint16_t);
+  if (cache_) {
+    bytes += cache_->size() * sizeof(cache_t::value_type);
+  }
+  return bytes;
+}
 
+int Connector::GetCachedTransitionCost(uint16_t rid, uint16_t lid) const {
   const uint32_t index = (static_cast<uint32_t>(rid) << 16) | lid;
   const uint32_t bucket =
       (3 * static_cast<uint32_t>(rid) + lid) & kCacheHashMask;
@@ -33,6 +33,7 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -48,21 +49,55 @@ class Connector final {
  public:
   static constexpr int16_t kInvalidCost = 30000;
 
-  static absl::StatusOr<Connector> Create(absl::string_view connection_data);
-
+  // How transition costs are looked up at runtime.
+  enum class Layout {
+    // Costs are decoded from the compressed rows in the connection data on
+    // demand, with a small hash cache in front. No extra memory is used except
+    // for the cache.
+    kCompressed,
+    // All the costs are expanded into a dense rsize x lsize matrix when the
+    // connector is created. This takes 2 * rsize * lsize bytes of heap, e.g.,
+    // about 15MB for the OSS data set, but a lookup is a single load.
+    kDense,
+  };
+
+  static absl::StatusOr<Connector> Create(
+      absl::string_view connection_data, Layout layout = Layout::kCompressed);
+
+  // Defined inline so that the dense layout is a plain array read in the
+  // Viterbi inner loop.
   int GetTransitionCost(uint16_t rid, uint16_t lid) const;
   int GetResolution() const { return resolution_; }
+  Layout GetLayout() const {
+    return dense_costs_.empty() ? Layout::kCompressed : Layout::kDense;
+  }
+
+  // Returns the size of heap memory used for the lookup tables (the cache or
+  // the dense matrix), excluding the connection data itself.
+  size_t GetAllocatedBytes() const;
 
  private:
   class Row;
 
-  absl::Status Init(absl::string_view connection_data);
+  // Marker in the dense matrix for the costs that don't fit in uint16_t, i.e.,
+  // kInvalidCost multiplied by the resolution. Such entries are looked up from
+  // the compressed rows instead.
+  static constexpr uint16_t kDenseCostFallback =
+      std::numeric_limits<uint16_t>::max();
+
+  absl::Status Init(absl::string_view connection_data, Layout layout);
+  void BuildDenseMatrix();
 
   int LookupCost(uint16_t rid, uint16_t lid) const;
+  int GetCachedTransitionCost(uint16_t rid, uint16_t lid) const;
 
   std::vector<Row> rows_;
   const uint16_t* default_cost_ = nullptr;
   int resolution_ = 0;
+  uint16_t lsize_ = 0;
+  // Row-major matrix of the final costs used in the dense layout. Empty in the
+  // compressed layout.
+  std::vector<uint16_t> dense_costs_;
   // Cache for transition cost.
   using cache_t = std::vector<std::atomic<uint64_t>>;
   mutable std::unique_ptr<cache_t> cache_;
@@ -87,6 +122,22 @@ class Connector::Row final {
   bool use_1byte_value_ = false;
 };
 
+inline int Connector::GetTransitionCost(uint16_t rid, uint16_t lid) const {
+  // Note:
+  // This function is called very frequently and has a significant impact on
+  // execution time. When making any modifications, please conduct a performance
+  // analysis.
+  if (!dense_costs_.empty()) {
+    const uint16_t cost =
+        dense_costs_[static_cast<size_t>(rid) * lsize_ + lid];
+    if (cost != kDenseCostFallback) [[likely]] {
+      return cost;
+    }
+    return LookupCost(rid, lid);
+  }
+  return GetCachedTransitionCost(rid, lid);
+}
+
 }  // namespace mozc
 
 #endif  // MOZC_CONVERTER_CONNECTOR_H_
@@ -0,0 +1,156 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Microbenchmarks comparing the compressed and the dense layouts of Connector
+// on the OSS dataset.
+//
+// BM_Create reports the construction time and the heap memory used by the
+// lookup tables. BM_TransitionCost* replay (rid, lid) pairs in the order
+// ImmutableConverter::Viterbi issues them (one right node against many left
+// nodes) and in uniformly random order, and report the time per lookup.
+//
+// Example:
+//   bazel run -c opt //converter:connector_benchmark --
+//     --benchmark_filter=TransitionCost
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/random/random.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/bits.h"
+#include "benchmark/benchmark.h"
+#include "converter/connector.h"
+#include "data_manager/oss/oss_data_manager.h"
+
+namespace mozc {
+namespace {
+
+// Number of (rid, lid) pairs replayed per iteration.
+constexpr size_t kNumPairs = 1 << 16;
+
+// Frequent PoS ids are small, so the lattice mostly hits the low range.
+constexpr uint16_t kHotIdRange = 512;
+
+absl::string_view GetConnectionData() {
+  static const oss::OssDataManager* data_manager = new oss::OssDataManager();
+  return data_manager->GetConnectorData();
+}
+
+// The matrix size (rsize == lsize) is stored at offset 4 of the header.
+uint16_t GetMatrixSize() {
+  return LoadUnaligned<uint16_t>(GetConnectionData().data() + 4);
+}
+
+Connector::Layout ToLayout(int64_t arg) {
+  return arg == 0 ? Connector::Layout::kCompressed : Connector::Layout::kDense;
+}
+
+// Pairs grouped by the right node as in Viterbi: every left node ending at a
+// position is connected to each right node starting there.
+std::vector<std::pair<uint16_t, uint16_t>> MakeViterbiPairs(uint16_t size) {
+  absl::BitGen gen;
+  std::vector<std::pair<uint16_t, uint16_t>> pairs;
+  pairs.reserve(kNumPairs);
+  while (pairs.size() < kNumPairs) {
+    const uint16_t lid = absl::Uniform<uint16_t>(gen, 0, kHotIdRange);
+    std::vector<uint16_t> rids(32);
+    for (uint16_t& rid : rids) {
+      rid = absl::Uniform<uint16_t>(gen, 0, kHotIdRange);
+    }
+    for (int i = 0; i < 8 && pairs.size() < kNumPairs; ++i) {
+      for (uint16_t rid : rids) {
+        pairs.emplace_back(rid % size, lid % size);
+      }
+    }
+  }
+  pairs.resize(kNumPairs);
+  return pairs;
+}
+
+std::vector<std::pair<uint16_t, uint16_t>> MakeRandomPairs(uint16_t size) {
+  absl::BitGen gen;
+  std::vector<std::pair<uint16_t, uint16_t>> pairs(kNumPairs);
+  for (auto& [rid, lid] : pairs) {
+    rid = absl::Uniform<uint16_t>(gen, 0, size);
+    lid = absl::Uniform<uint16_t>(gen, 0, size);
+  }
+  return pairs;
+}
+
+void RunTransitionCost(
+    benchmark::State& state,
+    absl::Span<const std::pair<uint16_t, uint16_t>> pairs) {
+  const absl::StatusOr<Connector> connector =
+      Connector::Create(GetConnectionData(), ToLayout(state.range(0)));
+  CHECK_OK(connector);
+  for (auto _ : state) {
+    for (const auto& [rid, lid] : pairs) {
+      benchmark::DoNotOptimize(connector->GetTransitionCost(rid, lid));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+  state.counters["lookup_time"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * pairs.size()),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["table_bytes"] =
+      static_cast<double>(connector->GetAllocatedBytes());
+}
+
+void BM_Create(benchmark::State& state) {
+  const Connector::Layout layout = ToLayout(state.range(0));
+  size_t table_bytes = 0;
+  for (auto _ : state) {
+    absl::StatusOr<Connector> connector =
+        Connector::Create(GetConnectionData(), layout);
+    CHECK_OK(connector);
+    table_bytes = connector->GetAllocatedBytes();
+    benchmark::DoNotOptimize(connector);
+  }
+  state.counters["table_bytes"] = static_cast<double>(table_bytes);
+}
+BENCHMARK(BM_Create)->ArgName("dense")->Arg(0)->Arg(1);
+
+void BM_TransitionCostViterbi(benchmark::State& state) {
+  RunTransitionCost(state, MakeViterbiPairs(GetMatrixSize()));
+}
+BENCHMARK(BM_TransitionCostViterbi)->ArgName("dense")->Arg(0)->Arg(1);
+
+void BM_TransitionCostRandom(benchmark::State& state) {
+  RunTransitionCost(state, MakeRandomPairs(GetMatrixSize()));
+}
+BENCHMARK(BM_TransitionCostRandom)->ArgName("dense")->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mozc
@@ -93,6 +93,31 @@ TEST(ConnectorTest, CompareWithRawData) {
   }
 }
 
+TEST(ConnectorTest, DenseLayoutMatchesCompressedLayout) {
+  const std::string path = testing::GetSourceFileOrDie(
+      {"data_manager", "testing", "connection.data"});
+  absl::StatusOr<Mmap> cmmap = Mmap::Map(path);
+  ASSERT_OK(cmmap) << cmmap.status();
+  absl::StatusOr<Connector> compressed =
+      Connector::Create(cmmap->string_view(), Connector::Layout::kCompressed);
+  ASSERT_OK(compressed);
+  absl::StatusOr<Connector> dense =
+      Connector::Create(cmmap->string_view(), Connector::Layout::kDense);
+  ASSERT_OK(dense);
+  EXPECT_EQ(compressed->GetLayout(), Connector::Layout::kCompressed);
+  EXPECT_EQ(dense->GetLayout(), Connector::Layout::kDense);
+  EXPECT_GT(dense->GetAllocatedBytes(), compressed->GetAllocatedBytes());
+
+  const uint16_t size = LoadUnaligned<uint16_t>(cmmap->begin() + 4);
+  for (uint16_t rid = 0; rid < size; ++rid) {
+    for (uint16_t lid = 0; lid < size; ++lid) {
+      ASSERT_EQ(dense->GetTransitionCost(rid, lid),
+                compressed->GetTransitionCost(rid, lid))
+          << "rid=" << rid << ", lid=" << lid;
+    }
+  }
+}
+
 TEST(ConnectorTest, BrokenData) {
   const std::string path = testing::GetSourceFileOrDie(
       {"data_manager", "testing", "connection.data"});
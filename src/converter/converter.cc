@@ -42,6 +42,7 @@
 #include <vector>
 
 #include "absl/base/optimization.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/random/random.h"
@@ -49,6 +50,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/latency_tracer.h"
 #include "base/strings/assign.h"
 #include "base/util.h"
 #include "base/vlog.h"
@@ -61,11 +63,13 @@
 #include "converter/reverse_converter.h"
 #include "converter/segments.h"
 #include "dictionary/pos_matcher.h"
+#include "dictionary/suppression_dictionary.h"
 #include "engine/modules.h"
 #include "prediction/predictor_interface.h"
 #include "prediction/result.h"
 #include "protocol/commands.pb.h"
 #include "request/conversion_request.h"
+#include "request/request_fingerprint.h"
 #include "rewriter/rewriter_interface.h"
 #include "transliteration/transliteration.h"
 
@@ -128,6 +132,30 @@ bool IsValidSegments(const ConversionRequest& request,
   return true;
 }
 
+bool IsConversionCacheEnabled(const ConversionRequest& request) {
+  return request.request()
+      .decoder_experiment_params()
+      .enable_conversion_result_cache();
+}
+
+// Returns a fingerprint of the history segments as read by
+// ImmutableConverter.
+uint64_t HistorySegmentsFingerprint(const Segments& segments) {
+  uint64_t fp = 0;
+  for (const Segment& segment : segments.history_segments()) {
+    fp = absl::HashOf(fp, static_cast<int>(segment.segment_type()),
+                      segment.key(), segment.candidates_size());
+    if (segment.candidates_size() == 0) {
+      continue;
+    }
+    const Candidate& candidate = segment.candidate(0);
+    fp = absl::HashOf(fp, candidate.key, candidate.value,
+                      candidate.content_key, candidate.content_value,
+                      candidate.lid, candidate.rid);
+  }
+  return fp;
+}
+
 }  // namespace
 
 Converter::Converter(
@@ -141,7 +169,8 @@ Converter::Converter(
       user_dictionary_(modules_->GetUserDictionary()),
       history_reconstructor_(modules_->GetPosMatcher()),
       reverse_converter_(*immutable_converter_),
-      general_noun_id_(pos_matcher_.GetGeneralNounId()) {
+      general_noun_id_(pos_matcher_.GetGeneralNounId()),
+      conversion_cache_(kConversionCacheSize) {
   DCHECK(immutable_converter_);
   predictor_ = predictor_factory(*modules_, *this, *immutable_converter_);
   rewriter_ = rewriter_factory(*modules_);
@@ -151,6 +180,9 @@ Converter::Converter(
 
 bool Converter::StartConversion(const ConversionRequest& request,
                                 Segments* segments) const {
+  static const LatencyTracer::StageId kLatencyStage =
+      LatencyTracer::RegisterStage("converter/start_conversion");
+  ScopedLatencyTimer latency_timer(kLatencyStage);
   DCHECK_EQ(request.request_type(), ConversionRequest::CONVERSION);
 
   absl::string_view key = request.key();
@@ -159,10 +191,51 @@ bool Converter::StartConversion(const ConversionRequest& request,
   }
 
   segments->InitForConvert(key);
-  ApplyConversion(segments, request);
+  if (!ConvertWithCache(request, segments)) {
+    // Not an error. See ApplyConversion().
+    MOZC_VLOG(1) << "Convert failed for key: " << key;
+  }
+  ApplyPostProcessing(request, segments);
   return IsValidSegments(request, *segments);
 }
 
+bool Converter::ConvertWithCache(const ConversionRequest& request,
+                                 Segments* segments) const {
+  if (!IsConversionCacheEnabled(request)) {
+    return immutable_converter_->Convert(request, segments);
+  }
+
+  static const LatencyTracer::StageId kHitStage =
+      LatencyTracer::RegisterStage("converter/conversion_cache_hit");
+  static const LatencyTracer::StageId kMissStage =
+      LatencyTracer::RegisterStage("converter/conversion_cache_miss");
+
+  const uint64_t cache_key = absl::HashOf(
+      ConversionRequestFingerprint(request), user_dictionary_.GetGeneration(),
+      HistorySegmentsFingerprint(*segments));
+
+  CachedSegments cached;
+  if (conversion_cache_.Lookup(cache_key, &cached)) {
+    ScopedLatencyTimer latency_timer(kHitStage);
+    // Restores the segments only, keeping the other states, e.g. revert id.
+    segments->clear_segments();
+    for (const Segment& segment : *cached) {
+      *segments->add_segment() = segment;
+    }
+    return true;
+  }
+
+  ScopedLatencyTimer latency_timer(kMissStage);
+  if (!immutable_converter_->Convert(request, segments)) {
+    return false;
+  }
+  // ImmutableConverter may also normalize the history segments, so all the
+  // segments are cached.
+  conversion_cache_.Insert(cache_key, std::make_shared<std::vector<Segment>>(
+                                          segments->begin(), segments->end()));
+  return true;
+}
+
 bool Converter::StartReverseConversion(Segments* segments,
                                        const absl::string_view key) const {
   segments->Clear();
@@ -610,7 +683,9 @@ void Converter::RewriteAndSuppressCandidates(const ConversionRequest& request,
   // 3. Suppress candidates in each segment.
   // Optimization for common use case: Since most of users don't use suppression
   // dictionary and we can skip the subsequent check.
-  if (!user_dictionary_.HasSuppressedEntries()) {
+  const std::shared_ptr<const dictionary::SuppressionDictionary>
+      suppression_dictionary = user_dictionary_.GetSuppressionDictionary();
+  if (!suppression_dictionary) {
     return;
   }
   // Although the suppression dictionary is applied at node-level in dictionary
@@ -620,7 +695,7 @@ void Converter::RewriteAndSuppressCandidates(const ConversionRequest& request,
   for (Segment& segment : segments->conversion_segments()) {
     for (size_t j = 0; j < segment.candidates_size();) {
       const Candidate& cand = segment.candidate(j);
-      if (user_dictionary_.IsSuppressedEntry(cand.key, cand.value)) {
+      if (suppression_dictionary->IsSuppressedEntry(cand.key, cand.value)) {
         segment.erase_candidate(j);
       } else {
         ++j;
@@ -651,6 +726,7 @@ void Converter::TrimCandidates(const ConversionRequest& request,
 }
 
 bool Converter::Reload() {
+  conversion_cache_.Clear();
   modules().GetUserDictionary().Reload();
   return rewriter().Reload() && predictor().Reload();
 }
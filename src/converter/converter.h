@@ -42,6 +42,7 @@
 #include "absl/log/check.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/container/flat_concurrent_cache.h"
 #include "converter/candidate.h"
 #include "converter/converter_interface.h"
 #include "converter/history_reconstructor.h"
@@ -242,6 +243,12 @@ class Converter final : public ConverterInterface {
   void ApplyPostProcessing(const ConversionRequest& request,
                            Segments* segments) const;
 
+  // Runs ImmutableConverter, reusing the result of the same request if
+  // `enable_conversion_result_cache` is set. Rewriters are not cached as they
+  // depend on the user history.
+  bool ConvertWithCache(const ConversionRequest& request,
+                        Segments* segments) const;
+
   std::unique_ptr<engine::Modules> modules_;
   std::unique_ptr<const ImmutableConverterInterface> immutable_converter_;
   std::unique_ptr<prediction::PredictorInterface> predictor_;
@@ -252,6 +259,14 @@ class Converter final : public ConverterInterface {
   const HistoryReconstructor history_reconstructor_;
   const ReverseConverter reverse_converter_;
   const uint16_t general_noun_id_ = std::numeric_limits<uint16_t>::max();
+
+  // Segments converted by ImmutableConverter in StartConversion. The key is
+  // the fingerprint of the request, the history segments and the user
+  // dictionary generation. Hit and miss counts are reported to
+  // LatencyTracer.
+  static constexpr size_t kConversionCacheSize = 32;
+  using CachedSegments = std::shared_ptr<const std::vector<Segment>>;
+  mutable FlatConcurrentCache<uint64_t, CachedSegments> conversion_cache_;
 };
 }  // namespace converter
 }  // namespace mozc
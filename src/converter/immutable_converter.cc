@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <climits>
 #include <cstddef>
 #include <cstdint>
@@ -38,6 +39,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -81,6 +83,7 @@ using ::mozc::converter::Attribute;
 using ::mozc::converter::Candidate;
 using ::mozc::dictionary::DictionaryInterface;
 using ::mozc::dictionary::Token;
+using ::mozc::dictionary::TokenView;
 
 constexpr size_t kMaxSegmentsSize = 256;
 constexpr size_t kMaxCharLength = 1024;
@@ -100,15 +103,16 @@ class KeyCorrectedNodeListBuilder : public BaseNodeListBuilder {
         original_lookup_key_(original_lookup_key),
         key_corrector_(key_corrector) {}
 
-  ResultType OnToken(absl::string_view key, absl::string_view actual_key,
-                     const Token& token) override {
+  ResultType OnTokenView(absl::string_view key, absl::string_view actual_key,
+                         const TokenView& token) override {
     const size_t offset =
         key_corrector_.GetOriginalOffset(pos_, token.key.size());
     if (!KeyCorrector::IsValidPosition(offset) || offset == 0) {
       return TRAVERSE_NEXT_KEY;
     }
     Node* node = NewNodeFromToken(token);
-    node->key.assign(original_lookup_key_.data() + pos_, offset);
+    node->key =
+        allocator()->CopyString(original_lookup_key_.substr(pos_, offset));
     node->wcost += KeyCorrector::GetCorrectedCostPenalty(node->key);
     AppendToResult(node);
     return TRAVERSE_CONTINUE;
@@ -295,7 +299,11 @@ ImmutableConverter::ImmutableConverter(const engine::Modules& modules)
       number_id_(pos_matcher_.GetNumberId()),
       unknown_id_(pos_matcher_.GetUnknownId()),
       last_to_first_name_transition_cost_(
-          connector_.GetTransitionCost(last_name_id_, first_name_id_)) {}
+          connector_.GetTransitionCost(last_name_id_, first_name_id_)),
+      instance_id_([] {
+        static std::atomic<uint64_t> next_instance_id = 0;
+        return next_instance_id.fetch_add(1, std::memory_order_relaxed);
+      }()) {}
 
 void ImmutableConverter::InsertDummyCandidates(Segment* segment,
                                                size_t expand_size) const {
@@ -580,7 +588,7 @@ bool ImmutableConverter::ResegmentPersonalName(size_t pos,
              lattice->begin_nodes(pos + lnode->key.size())) {
           if ((lnode->value.size() + rnode->value.size()) ==
                   compound_node->value.size() &&
-              (lnode->value + rnode->value) == compound_node->value &&
+              compound_node->value.ends_with(rnode->value) &&
               segmenter_.IsBoundary(*lnode, *rnode, false)) {  // Constraint 3.
             const int32_t cost = lnode->wcost + GetCost(lnode, rnode);
             if (cost < best_cost) {  // choose the smallest ones
@@ -698,8 +706,8 @@ void ImmutableConverter::AddCharacterTypeBasedNodes(
     }
 
     new_node->wcost = kMaxCost;
-    new_node->value.assign(it.view());
-    new_node->key.assign(it.view());
+    new_node->key = lattice->CopyString(it.view());
+    new_node->value = new_node->key;
     new_node->node_type = Node::NOR_NODE;
     builder->AppendToResult(new_node);
 
@@ -737,8 +745,8 @@ void ImmutableConverter::AddCharacterTypeBasedNodes(
     new_node->wcost = kMaxCost / 2;
     const absl::string_view key_substr_up_to_it =
         key_substr.substr(0, it.to_address() - key_substr.data());
-    new_node->value.assign(key_substr_up_to_it);
-    new_node->key.assign(key_substr_up_to_it);
+    new_node->key = lattice->CopyString(key_substr_up_to_it);
+    new_node->value = new_node->key;
     new_node->node_type = Node::NOR_NODE;
     builder->AppendToResult(new_node);
   }
@@ -812,13 +820,40 @@ class CachingConnector final {
 // calculated based on kVeryBigCost.
 constexpr int kVeryBigCost = (INT_MAX >> 2);
 
+// Scratch buffers reused across positions in one Viterbi search.
+struct ViterbiBuffers {
+  LatticeColumn column;
+  std::vector<int32_t> transition_costs;
+};
+
+// Finds a valid node in `buffers.column` which connects to a node of `lid`
+// with minimum cost.
+template <typename ConnectorType>
+Node* FindBestLeftNode(ConnectorType& conn, uint16_t lid,
+                       ViterbiBuffers& buffers, int32_t* best_cost) {
+  const LatticeColumn& column = buffers.column;
+  absl::Span<const uint16_t> rids = column.rids();
+  buffers.transition_costs.resize(column.size());
+  for (size_t i = 0; i < rids.size(); ++i) {
+    buffers.transition_costs[i] = conn.GetTransitionCost(rids[i], lid);
+  }
+  return buffers.column.FindBest(buffers.transition_costs, kVeryBigCost,
+                                 best_cost);
+}
+
 // Runs viterbi algorithm at position |pos|. The left_boundary/right_boundary
 // are the next boundary looked from pos. (If pos is on the boundary,
 // left_boundary should be the previous one, and right_boundary should be
 // the next).
-inline void ViterbiInternal(const Connector& connector, size_t pos,
-                            size_t right_boundary, Lattice* lattice) {
-  CachingConnector conn(connector);
+//
+// `ConnectorType` is either CachingConnector or, for the dense layout where a
+// lookup is already a single array read, `const Connector` itself.
+template <typename ConnectorType>
+void ViterbiInternalImpl(ConnectorType& conn, size_t pos,
+                         size_t right_boundary, Lattice* lattice,
+                         ViterbiBuffers& buffers) {
+  // All the nodes ending at `pos` are already settled.
+  buffers.column.Assign(lattice->end_nodes(pos));
   for (Node* rnode : lattice->begin_nodes(pos)) {
     if (rnode->end_pos > right_boundary) {
       // Invalid rnode.
@@ -826,7 +861,9 @@ inline void ViterbiInternal(const Connector& connector, size_t pos,
       continue;
     }
 
-    conn.ResetCacheIfNecessary(rnode->lid);
+    if constexpr (std::is_same_v<ConnectorType, CachingConnector>) {
+      conn.ResetCacheIfNecessary(rnode->lid);
+    }
 
     if (rnode->constrained_prev != nullptr) {
       // Constrained node.
@@ -840,26 +877,22 @@ inline void ViterbiInternal(const Connector& connector, size_t pos,
       continue;
     }
 
-    // Find a valid node which connects to the rnode with minimum cost.
-    int best_cost = kVeryBigCost;
-    Node* best_node = nullptr;
-    for (Node* lnode : lattice->end_nodes(pos)) {
-      if (lnode->prev == nullptr) {
-        // Invalid lnode.
-        continue;
-      }
-
-      int cost = lnode->cost + conn.GetTransitionCost(lnode->rid, rnode->lid);
-      if (cost < best_cost) {
-        best_cost = cost;
-        best_node = lnode;
-      }
-    }
-
-    rnode->prev = best_node;
+    int32_t best_cost = kVeryBigCost;
+    rnode->prev = FindBestLeftNode(conn, rnode->lid, buffers, &best_cost);
     rnode->cost = best_cost + rnode->wcost;
   }
 }
+
+inline void ViterbiInternal(const Connector& connector, size_t pos,
+                            size_t right_boundary, Lattice* lattice,
+                            ViterbiBuffers& buffers) {
+  if (connector.GetLayout() == Connector::Layout::kDense) {
+    ViterbiInternalImpl(connector, pos, right_boundary, lattice, buffers);
+    return;
+  }
+  CachingConnector conn(connector);
+  ViterbiInternalImpl(conn, pos, right_boundary, lattice, buffers);
+}
 }  // namespace
 
 bool ImmutableConverter::Viterbi(const Segments& segments,
@@ -888,6 +921,7 @@ bool ImmutableConverter::Viterbi(const Segments& segments,
   }
 
   size_t left_boundary = 0;
+  ViterbiBuffers buffers;
 
   // Specialization for the first segment.
   // Don't run on the left boundary (the connection with BOS node),
@@ -896,7 +930,7 @@ bool ImmutableConverter::Viterbi(const Segments& segments,
     const size_t right_boundary =
         left_boundary + segments.segment(0).key().size();
     for (size_t pos = left_boundary + 1; pos < right_boundary; ++pos) {
-      ViterbiInternal(connector_, pos, right_boundary, lattice);
+      ViterbiInternal(connector_, pos, right_boundary, lattice, buffers);
     }
     left_boundary = right_boundary;
   }
@@ -906,7 +940,7 @@ bool ImmutableConverter::Viterbi(const Segments& segments,
     // Run Viterbi for each position the segment.
     const size_t right_boundary = left_boundary + segment.key().size();
     for (size_t pos = left_boundary; pos < right_boundary; ++pos) {
-      ViterbiInternal(connector_, pos, right_boundary, lattice);
+      ViterbiInternal(connector_, pos, right_boundary, lattice, buffers);
     }
     left_boundary = right_boundary;
   }
@@ -922,24 +956,10 @@ bool ImmutableConverter::Viterbi(const Segments& segments,
     DCHECK(eos_node->constrained_prev == nullptr);
 
     left_boundary = key.size() - segments.all().back().key().size();
-    // Find a valid node which connects to the rnode with minimum cost.
-    int best_cost = kVeryBigCost;
-    Node* best_node = nullptr;
-    for (Node* lnode : lattice->end_nodes(key.size())) {
-      if (lnode->prev == nullptr) {
-        // Invalid lnode.
-        continue;
-      }
-
-      int cost =
-          lnode->cost + connector_.GetTransitionCost(lnode->rid, eos_node->lid);
-      if (cost < best_cost) {
-        best_cost = cost;
-        best_node = lnode;
-      }
-    }
-
-    eos_node->prev = best_node;
+    buffers.column.Assign(lattice->end_nodes(key.size()));
+    int32_t best_cost = kVeryBigCost;
+    eos_node->prev =
+        FindBestLeftNode(connector_, eos_node->lid, buffers, &best_cost);
     eos_node->cost = best_cost + eos_node->wcost;
   }
 
@@ -988,8 +1008,14 @@ bool ImmutableConverter::PredictionViterbi(const Segments& segments,
   for (const Segment& segment : segments.history_segments()) {
     history_length += segment.key().size();
   }
-  PredictionViterbiInternal(0, history_length, lattice);
-  PredictionViterbiInternal(history_length, key_length, lattice);
+  // Costs of the nodes beginning before dirty_pos() are kept from the last
+  // search when the lattice has been extended incrementally.
+  const size_t dirty_pos = lattice->dirty_pos();
+  if (dirty_pos < history_length) {
+    PredictionViterbiInternal(dirty_pos, history_length, lattice);
+  }
+  PredictionViterbiInternal(std::max(dirty_pos, history_length), key_length,
+                            lattice);
 
   Node* absl_nonnull node = lattice->eos_node();
   Node* prev = nullptr;
@@ -1167,6 +1193,17 @@ bool ImmutableConverter::MakeLattice(const ConversionRequest& request,
     history_key.clear();
   }
 
+  // Realtime conversion is requested on every key stroke, so the lattice for
+  // the previous key is extended when possible.
+  std::string context;
+  if (is_prediction) {
+    context = MakeLatticeContext(request, *segments);
+    if (ExtendLattice(request, context, history_key, conversion_key,
+                      lattice)) {
+      return true;
+    }
+  }
+
   {
     std::string key = absl::StrCat(history_key, conversion_key);
     lattice->SetKey(std::move(key), request.options().bos_id);
@@ -1213,6 +1250,147 @@ bool ImmutableConverter::MakeLattice(const ConversionRequest& request,
     Resegment(*segments, history_key, conversion_key, lattice);
   }
 
+  if (!context.empty()) {
+    // Any looked-up position may have a word crossing the end of the key.
+    std::vector<size_t>* open_positions = lattice->mutable_open_positions();
+    for (size_t pos = history_key.size(); pos < lattice->key().size(); ++pos) {
+      if (!lattice->end_nodes(pos).empty()) {
+        open_positions->push_back(pos);
+      }
+    }
+    lattice->set_context(std::move(context));
+  }
+
+  return true;
+}
+
+std::string ImmutableConverter::MakeLatticeContext(
+    const ConversionRequest& request, const Segments& segments) const {
+  // Options changing the looked-up nodes or their costs.
+  const config::Config& config = request.config();
+  const int flags = (request.incognito_mode() << 0) |
+                    (request.IsKanaModifierInsensitiveConversion() << 1) |
+                    (request.options().disable_prefix_penalty << 2) |
+                    (config.use_spelling_correction() << 3) |
+                    (config.use_zip_code_conversion() << 4) |
+                    (config.use_t13n_conversion() << 5);
+  // The generation changes when the user dictionary or its suppression
+  // entries are reloaded, which invalidates the looked-up nodes.
+  std::string context = absl::StrCat(
+      instance_id_, "\t", user_dictionary_.GetGeneration(), "\t",
+      static_cast<int>(request.request_type()), "\t",
+      request.options().bos_id, "\t", flags);
+  for (const Segment& segment : segments.history_segments()) {
+    if (segment.candidates_size() == 0) {
+      return "";
+    }
+    const Candidate& candidate = segment.candidate(0);
+    absl::StrAppend(&context, "\t", static_cast<int>(segment.segment_type()),
+                    "\t", segment.key(), "\t", candidate.value, "\t",
+                    candidate.lid, "\t", candidate.rid);
+  }
+  return context;
+}
+
+bool ImmutableConverter::ExtendLattice(const ConversionRequest& request,
+                                       absl::string_view context,
+                                       absl::string_view history_key,
+                                       absl::string_view conversion_key,
+                                       Lattice* lattice) const {
+  if (context.empty() || lattice->context() != context) {
+    return false;
+  }
+  const absl::string_view old_key = lattice->key();
+  const size_t old_size = old_key.size();
+  // The context includes the history key.
+  DCHECK(old_key.starts_with(history_key));
+  if (old_size <= history_key.size() ||
+      history_key.size() + conversion_key.size() <= old_size ||
+      !conversion_key.starts_with(old_key.substr(history_key.size()))) {
+    return false;
+  }
+  // A character type based node for a run of alphabets or katakana grows with
+  // the key, so it has to be replaced rather than extended.
+  const Util::ScriptType last_script_type =
+      Util::GetScriptType(Utf8AsChars32(old_key).back());
+  if (last_script_type == Util::ALPHABET ||
+      last_script_type == Util::KATAKANA) {
+    return false;
+  }
+
+  // Clears the links of the last best path, which are set only along the path.
+  for (Node* node = lattice->eos_node(); node != nullptr; node = node->prev) {
+    node->next = nullptr;
+  }
+
+  lattice->AppendKey(conversion_key.substr(old_size - history_key.size()));
+  const absl::string_view key = lattice->key();
+  const size_t first_char_end = old_size + strings::OneCharLen(key[old_size]);
+
+  // The nodes at the old end of the key are no longer at the end.
+  size_t dirty_pos = old_size;
+  for (Node* node : lattice->end_nodes(old_size)) {
+    node->wcost -= segmenter_.GetSuffixPenalty(node->rid);
+    dirty_pos = std::min<size_t>(dirty_pos, node->begin_pos);
+  }
+
+  // Looks up the open positions again to add the words crossing the old end.
+  // A position is closed for good once no key can start with the characters
+  // from it to the first new character. Kana modifier insensitive lookup finds
+  // keys differing from the prefix, so positions are not closed in that case.
+  const bool can_close_positions =
+      !request.IsKanaModifierInsensitiveConversion();
+  std::vector<size_t>* open_positions = lattice->mutable_open_positions();
+  size_t num_open_positions = 0;
+  for (const size_t pos : *open_positions) {
+    if (can_close_positions &&
+        !dictionary_.MayHaveKeyWithPrefix(
+            key.substr(pos, first_char_end - pos))) {
+      continue;
+    }
+    (*open_positions)[num_open_positions++] = pos;
+
+    std::vector<Node*> rnodes = Lookup(pos, request, false, lattice);
+    // Nodes ending before the old end have been inserted already.
+    std::erase_if(rnodes, [pos, old_size](const Node* node) {
+      return pos + node->key.size() <= old_size;
+    });
+    if (rnodes.empty()) {
+      continue;
+    }
+    if (pos == history_key.size()) {
+      for (Node* node : rnodes) {
+        if (!history_key.empty() &&
+            pos_matcher_.IsAcceptableParticleAtBeginOfSegment(node->lid) &&
+            node->lid == node->rid) {
+          node->attributes |= Node::STARTS_WITH_PARTICLE;
+        }
+        if (!request.options().disable_prefix_penalty) {
+          node->wcost += segmenter_.GetPrefixPenalty(node->lid);
+        }
+      }
+    }
+    lattice->Insert(pos, rnodes);
+    dirty_pos = std::min(dirty_pos, pos);
+  }
+  open_positions->resize(num_open_positions);
+
+  for (size_t pos = old_size; pos < key.size(); ++pos) {
+    if (lattice->end_nodes(pos).empty()) {
+      continue;
+    }
+    lattice->Insert(pos, Lookup(pos, request, false, lattice));
+    open_positions->push_back(pos);
+  }
+
+  if (lattice->end_nodes(key.size()).empty()) {
+    // Rebuilds the lattice to report the error.
+    return false;
+  }
+  for (Node* node : lattice->end_nodes(key.size())) {
+    node->wcost += segmenter_.GetSuffixPenalty(node->rid);
+  }
+  lattice->set_dirty_pos(dirty_pos);
   return true;
 }
 
@@ -1244,8 +1422,8 @@ bool ImmutableConverter::MakeLatticeNodesForHistorySegments(
     rnode->lid = candidate.lid;
     rnode->rid = candidate.rid;
     rnode->wcost = 0;
-    rnode->value = candidate.value;
-    rnode->key = segment.key();
+    rnode->value = lattice->CopyString(candidate.value);
+    rnode->key = lattice->CopyString(segment.key());
     rnode->node_type = Node::HIS_NODE;
     lattice->Insert(segments_pos, rnode);
 
@@ -1266,8 +1444,8 @@ bool ImmutableConverter::MakeLatticeNodesForHistorySegments(
       // TODO(team): Figure out a better way to set the cost using
       // boundary.def-like approach.
       rnode2->wcost = 0;
-      rnode2->value = candidate.value;
-      rnode2->key = segment.key();
+      rnode2->value = rnode->value;
+      rnode2->key = rnode->key;
       rnode2->node_type = Node::HIS_NODE;
       lattice->Insert(segments_pos, rnode2);
     }
@@ -1311,11 +1489,8 @@ bool ImmutableConverter::MakeLatticeNodesForHistorySegments(
         Node* absl_nonnull new_node = lattice->NewNode();
 
         // get the suffix part ("たくや/卓也")
-        new_node->key.assign(compound_node->key, rnode->key.size(),
-                             compound_node->key.size() - rnode->key.size());
-        new_node->value.assign(
-            compound_node->value, rnode->value.size(),
-            compound_node->value.size() - rnode->value.size());
+        new_node->key = compound_node->key.substr(rnode->key.size());
+        new_node->value = compound_node->value.substr(rnode->value.size());
 
         // rid/lid are derived from the compound.
         // lid is just an approximation
@@ -1443,8 +1618,8 @@ void ImmutableConverter::Resegment(const Segments& segments,
       rnode->lid = candidate.lid;
       rnode->rid = candidate.rid;
       rnode->wcost = kMinCost;
-      rnode->value = candidate.value;
-      rnode->key = segment.key();
+      rnode->value = lattice->CopyString(candidate.value);
+      rnode->key = lattice->CopyString(segment.key());
       rnode->node_type = Node::CON_NODE;
       lattice->Insert(segments_pos, rnode);
     }
@@ -1854,6 +2029,14 @@ bool ImmutableConverter::Convert(const ConversionRequest& request,
 
 bool ImmutableConverter::Convert(const ConversionRequest& request,
                                  Segments* segments) const {
+  if (request.request_type() == ConversionRequest::PREDICTION ||
+      request.request_type() == ConversionRequest::SUGGESTION) {
+    // Realtime conversion keeps the lattice per thread so that the lattice for
+    // the previous key stroke can be extended. See MakeLattice().
+    thread_local Lattice prediction_lattice;
+    return Convert(request, segments, &prediction_lattice);
+  }
+
 #if defined(__ANDROID__) || defined(_WIN32) || defined(__APPLE__)
   // These platforms run the converter persistently on the same thread. Using
   // thread_local allows the Lattice to be reused, which improves the
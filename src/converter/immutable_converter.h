@@ -32,6 +32,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -102,6 +103,18 @@ class ImmutableConverter : public ImmutableConverterInterface {
 
   bool MakeLattice(const ConversionRequest& request, Segments* segments,
                    Lattice* lattice) const;
+  // Returns a string identifying the request and the history segments a
+  // lattice is built for, or an empty string if the lattice is not
+  // extendable.
+  std::string MakeLatticeContext(const ConversionRequest& request,
+                                 const Segments& segments) const;
+  // Extends the lattice built for the previous key when the conversion key
+  // extends it under the same `context`. Looks up only the positions that can
+  // have a word crossing the old end of the key and the new positions.
+  // Returns false if the lattice needs to be rebuilt.
+  bool ExtendLattice(const ConversionRequest& request,
+                     absl::string_view context, absl::string_view history_key,
+                     absl::string_view conversion_key, Lattice* lattice) const;
   bool MakeLatticeNodesForHistorySegments(const Segments& segments,
                                           const ConversionRequest& request,
                                           Lattice* lattice) const;
@@ -199,6 +212,10 @@ class ImmutableConverter : public ImmutableConverterInterface {
 
   // Cache for transition cost.
   const int32_t last_to_first_name_transition_cost_;
+
+  // Unique ID of this instance, which is a part of the lattice context. A
+  // thread_local lattice may be extended only by the converter that built it.
+  const uint64_t instance_id_;
 };
 
 }  // namespace mozc
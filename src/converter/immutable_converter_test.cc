@@ -37,7 +37,9 @@
 #include <vector>
 
 #include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "base/strings/unicode.h"
 #include "base/util.h"
 #include "converter/attribute.h"
 #include "converter/candidate.h"
@@ -50,6 +52,7 @@
 #include "dictionary/dictionary_interface.h"
 #include "engine/modules.h"
 #include "protocol/commands.pb.h"
+#include "protocol/user_dictionary_storage.pb.h"
 #include "request/conversion_request.h"
 #include "request/request_test_util.h"
 #include "testing/gmock.h"
@@ -121,6 +124,7 @@ class MockDataAndImmutableConverter {
   }
 
   ImmutableConverter* GetConverter() { return immutable_converter_.get(); }
+  engine::Modules& GetModules() { return *modules_; }
   ImmutableConverterTestPeer GetConverterTestPeer() {
     return ImmutableConverterTestPeer(*immutable_converter_);
   }
@@ -614,4 +618,94 @@ TEST(ImmutableConverterTest, T13nConversionTwice) {
             -1);
 }
 
+namespace {
+
+// Converts `key` after the history "わたし/私" and returns the candidates.
+std::vector<std::string> ConvertForPrediction(
+    const ImmutableConverter& converter, const ConversionRequest& request,
+    absl::string_view key, Lattice* lattice) {
+  Segments segments;
+  Segment* segment = segments.add_segment();
+  SetCandidate("わたし", "私", segment);
+  segment->set_segment_type(Segment::HISTORY);
+  segments.add_segment()->set_key(key);
+  if (!converter.Convert(request, &segments, lattice)) {
+    return {};
+  }
+  std::vector<std::string> results;
+  for (const Candidate* candidate :
+       segments.conversion_segment(0).candidates()) {
+    results.push_back(absl::StrCat(candidate->value, ":", candidate->cost, ":",
+                                   candidate->wcost));
+  }
+  return results;
+}
+
+}  // namespace
+
+TEST(ImmutableConverterTest, IncrementalLatticeForPrediction) {
+  std::unique_ptr<MockDataAndImmutableConverter> data_and_converter =
+      std::make_unique<MockDataAndImmutableConverter>();
+  const ImmutableConverter& converter = *data_and_converter->GetConverter();
+  const ConversionRequest request =
+      ConversionRequestBuilder()
+          .SetOptions({.request_type = ConversionRequest::PREDICTION,
+                       .max_conversion_candidates_size = 10,
+                       .kana_modifier_insensitive_conversion = false})
+          .Build();
+
+  // The lattice for each prefix is extended from the previous one, and the
+  // results must be the same as the ones from a new lattice.
+  const std::string kKey = "のなまえはなかのです";
+  Lattice lattice;
+  bool extended = false;
+  size_t len = 0;
+  for (const absl::string_view ch : Utf8AsChars(kKey)) {
+    len += ch.size();
+    const absl::string_view key = absl::string_view(kKey).substr(0, len);
+    const std::string old_key(lattice.key());
+    const std::vector<std::string> results =
+        ConvertForPrediction(converter, request, key, &lattice);
+    extended |= !old_key.empty() && lattice.dirty_pos() > 0;
+    EXPECT_FALSE(lattice.context().empty());
+
+    Lattice new_lattice;
+    EXPECT_EQ(results,
+              ConvertForPrediction(converter, request, key, &new_lattice))
+        << key;
+    EXPECT_FALSE(results.empty()) << key;
+  }
+  EXPECT_TRUE(extended);
+
+  // A conversion request rebuilds the lattice.
+  Segments segments;
+  segments.add_segment()->set_key(kKey);
+  const ConversionRequest conversion_request;
+  EXPECT_TRUE(converter.Convert(conversion_request, &segments, &lattice));
+  EXPECT_TRUE(lattice.context().empty());
+}
+
+TEST(ImmutableConverterTest, IncrementalLatticeAfterUserDictionaryReload) {
+  std::unique_ptr<MockDataAndImmutableConverter> data_and_converter =
+      std::make_unique<MockDataAndImmutableConverter>();
+  const ImmutableConverter& converter = *data_and_converter->GetConverter();
+  const ConversionRequest request =
+      ConversionRequestBuilder()
+          .SetOptions({.request_type = ConversionRequest::PREDICTION,
+                       .max_conversion_candidates_size = 10})
+          .Build();
+
+  Lattice lattice;
+  ConvertForPrediction(converter, request, "なかの", &lattice);
+  const std::string context(lattice.context());
+  EXPECT_FALSE(context.empty());
+
+  // The nodes looked up before the reload must not be reused.
+  data_and_converter->GetModules().GetUserDictionary().Load(
+      user_dictionary::UserDictionaryStorage());
+  ConvertForPrediction(converter, request, "なかので", &lattice);
+  EXPECT_NE(lattice.context(), context);
+  EXPECT_EQ(lattice.dirty_pos(), 0);
+}
+
 }  // namespace mozc
@@ -48,6 +48,12 @@
 #include "converter/node.h"
 #include "converter/node_allocator.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif  // __SSE2__
+
 namespace mozc {
 namespace {
 
@@ -55,7 +61,7 @@ Node* InitBOSNode(Node* bos_node, uint16_t position, uint16_t bos_id) {
   DCHECK(bos_node);
   bos_node->rid = bos_id;  // 0 is reserved for EOS/BOS
   bos_node->lid = 0;
-  bos_node->key.clear();
+  bos_node->key = absl::string_view();
   bos_node->value = "BOS";
   bos_node->node_type = Node::BOS_NODE;
   bos_node->wcost = 0;
@@ -69,7 +75,7 @@ Node* InitEOSNode(Node* eos_node, uint16_t position) {
   DCHECK(eos_node);
   eos_node->rid = 0;  // 0 is reserved for EOS/BOS
   eos_node->lid = 0;
-  eos_node->key.clear();
+  eos_node->key = absl::string_view();
   eos_node->value = "EOS";
   eos_node->node_type = Node::EOS_NODE;
   eos_node->wcost = 0;
@@ -79,8 +85,76 @@ Node* InitEOSNode(Node* eos_node, uint16_t position) {
   return eos_node;
 }
 
+// Returns the minimum of `values`, or `init` if it is smaller.
+int32_t MinValue(absl::Span<const int32_t> values, int32_t init) {
+  int32_t result = init;
+  size_t i = 0;
+#if defined(__SSE2__)
+  if (values.size() >= 4) {
+    __m128i min4 = _mm_set1_epi32(init);
+    for (; i + 4 <= values.size(); i += 4) {
+      const __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(values.data() + i));
+      // SSE2 has no _mm_min_epi32.
+      const __m128i lt = _mm_cmplt_epi32(v, min4);
+      min4 = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, min4));
+    }
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), min4);
+    result = std::min({lanes[0], lanes[1], lanes[2], lanes[3]});
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  if (values.size() >= 4) {
+    int32x4_t min4 = vdupq_n_s32(init);
+    for (; i + 4 <= values.size(); i += 4) {
+      min4 = vminq_s32(min4, vld1q_s32(values.data() + i));
+    }
+    result = vminvq_s32(min4);
+  }
+#endif  // __SSE2__
+  for (; i < values.size(); ++i) {
+    result = std::min(result, values[i]);
+  }
+  return result;
+}
+
 }  // namespace
 
+void LatticeColumn::Assign(absl::Span<Node* const> end_nodes) {
+  nodes_.clear();
+  rids_.clear();
+  costs_.clear();
+  for (Node* node : end_nodes) {
+    if (node->prev == nullptr) {
+      // Invalid node.
+      continue;
+    }
+    nodes_.push_back(node);
+    rids_.push_back(node->rid);
+    costs_.push_back(node->cost);
+  }
+  totals_.resize(nodes_.size());
+}
+
+Node* LatticeColumn::FindBest(absl::Span<const int32_t> transition_costs,
+                              int32_t max_cost, int32_t* best_cost) {
+  DCHECK_EQ(transition_costs.size(), nodes_.size());
+  const size_t size = nodes_.size();
+  // Written as plain loops over arrays so that the compiler vectorizes them.
+  for (size_t i = 0; i < size; ++i) {
+    totals_[i] = costs_[i] + transition_costs[i];
+  }
+  const int32_t min_cost = MinValue(totals_, max_cost);
+  if (min_cost >= max_cost) {
+    *best_cost = max_cost;
+    return nullptr;
+  }
+  *best_cost = min_cost;
+  const size_t index =
+      std::find(totals_.begin(), totals_.end(), min_cost) - totals_.begin();
+  return nodes_[index];
+}
+
 void Lattice::SetKey(std::string key, uint16_t bos_id) {
   Clear();
   key_ = std::move(key);
@@ -104,6 +178,26 @@ void Lattice::SetKey(std::string key, uint16_t bos_id) {
   begin_nodes_[key_.size()].push_back(eos_node);
 }
 
+void Lattice::AppendKey(absl::string_view suffix) {
+  DCHECK(has_lattice());
+  const size_t old_size = key_.size();
+  Node* eos_node = this->eos_node();
+  begin_nodes_[old_size].clear();
+
+  key_.append(suffix);
+  begin_nodes_.resize(key_.size() + 1);
+  end_nodes_.resize(key_.size() + 1);
+  for (size_t pos = old_size + 1; pos <= key_.size(); ++pos) {
+    begin_nodes_[pos].clear();
+    end_nodes_[pos].clear();
+  }
+
+  InitEOSNode(eos_node, static_cast<uint16_t>(key_.size()));
+  eos_node->prev = nullptr;
+  eos_node->next = nullptr;
+  begin_nodes_[key_.size()].push_back(eos_node);
+}
+
 void Lattice::Insert(size_t pos, Node* node) {
   const size_t end_pos = std::min(node->key.size() + pos, key_.size());
   node->begin_pos = static_cast<uint16_t>(pos);
@@ -127,6 +221,9 @@ void Lattice::Clear() {
   key_.clear();
   begin_nodes_.clear();
   end_nodes_.clear();
+  context_.clear();
+  open_positions_.clear();
+  dirty_pos_ = 0;
   node_allocator_->Free();
 }
 
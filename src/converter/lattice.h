@@ -31,8 +31,10 @@
 #define MOZC_CONVERTER_LATTICE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
@@ -60,6 +62,12 @@ class Lattice {
   // allocate new node.
   Node* NewNode() { return node_allocator_->NewNode(); }
 
+  // copy `str` to the lattice. The result lives as long as the nodes, so it
+  // can be used for Node::key and Node::value.
+  absl::string_view CopyString(absl::string_view str) {
+    return node_allocator_->CopyString(str);
+  }
+
   // return the array of nodes starting with `pos`.
   absl::Span<Node* const> begin_nodes(size_t pos) const {
     DCHECK_LE(pos, key_.size());
@@ -102,6 +110,35 @@ class Lattice {
   // return true if this instance has a valid lattice.
   bool has_lattice() const { return !begin_nodes_.empty(); }
 
+  // Incremental construction.
+  //
+  // When the key of the next request extends the current key, e.g. realtime
+  // conversion on each key stroke, the lattice can be extended with
+  // AppendKey() instead of being rebuilt with SetKey(). The inserted nodes and
+  // their Viterbi costs are kept; only the nodes around the end of the key need
+  // to be added or updated. The state below is maintained by the builder of
+  // the lattice and is reset by SetKey().
+
+  // Appends `suffix` to the key keeping the inserted nodes. The EOS node is
+  // moved to the new end of the key. Nodes ending at the old end of the key
+  // are kept as they are.
+  void AppendKey(absl::string_view suffix);
+
+  // Describes the request the nodes were built for. Empty if the lattice
+  // cannot be extended.
+  absl::string_view context() const { return context_; }
+  void set_context(std::string context) { context_ = std::move(context); }
+
+  // Positions from which a dictionary lookup may still find a word crossing
+  // the end of the key.
+  const std::vector<size_t>& open_positions() const { return open_positions_; }
+  std::vector<size_t>* mutable_open_positions() { return &open_positions_; }
+
+  // The smallest position whose nodes have been inserted or modified since
+  // the last Viterbi search. Nodes beginning before it have final costs.
+  size_t dirty_pos() const { return dirty_pos_; }
+  void set_dirty_pos(size_t pos) { dirty_pos_ = pos; }
+
   // Dump the best path and the path that contains the designated string.
   std::string DebugString() const;
 
@@ -114,6 +151,45 @@ class Lattice {
   std::vector<std::vector<Node*>> begin_nodes_;
   std::vector<std::vector<Node*>> end_nodes_;
   std::unique_ptr<NodeAllocator> node_allocator_;
+  std::string context_;
+  std::vector<size_t> open_positions_;
+  size_t dirty_pos_ = 0;
+};
+
+// Structure-of-arrays copy of the nodes ending at a position, used by the
+// Viterbi search. Every node starting at the position is compared against all
+// of them, so the fields read in the inner loop are packed into contiguous
+// arrays once per position instead of being loaded from each Node.
+//
+// LatticeColumn column;
+// column.Assign(lattice.end_nodes(pos));
+// for (size_t i = 0; i < column.size(); ++i) {
+//   transition_costs[i] = connector.GetTransitionCost(column.rids()[i], lid);
+// }
+// Node* best = column.FindBest(transition_costs, kVeryBigCost, &best_cost);
+class LatticeColumn {
+ public:
+  // Packs the nodes in `end_nodes` that have a best path, i.e., prev is not
+  // nullptr. The nodes must not be modified until the next Assign().
+  void Assign(absl::Span<Node* const> end_nodes);
+
+  size_t size() const { return nodes_.size(); }
+  bool empty() const { return nodes_.empty(); }
+  absl::Span<const uint16_t> rids() const { return rids_; }
+  absl::Span<const int32_t> costs() const { return costs_; }
+
+  // Returns the node minimizing `cost + transition_costs[i]` and stores the
+  // sum to `best_cost`. The first node wins a tie. Returns nullptr and stores
+  // `max_cost` if no sum is smaller than `max_cost`. The size of
+  // `transition_costs` must be size().
+  Node* FindBest(absl::Span<const int32_t> transition_costs, int32_t max_cost,
+                 int32_t* best_cost);
+
+ private:
+  std::vector<Node*> nodes_;
+  std::vector<uint16_t> rids_;
+  std::vector<int32_t> costs_;
+  std::vector<int32_t> totals_;
 };
 
 // RAII class to insert nodes in detractor.
@@ -29,9 +29,14 @@
 
 #include "converter/lattice.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "converter/node.h"
+#include "dictionary/dictionary_token.h"
 #include "testing/gunit.h"
 
 namespace mozc {
@@ -57,6 +62,38 @@ TEST(LatticeTest, NewNodeTest) {
   EXPECT_EQ(node->rid, 0);
 }
 
+TEST(LatticeTest, NewNodeFromTokenTest) {
+  Lattice lattice;
+  std::string key = "key";
+  std::string value = "value";
+  Node* node1 = lattice.node_allocator()->NewNodeFromToken(
+      dictionary::TokenView(key, value, 100, 1, 2, dictionary::Token::NONE));
+  value = "key";
+  Node* node2 = lattice.node_allocator()->NewNodeFromToken(
+      dictionary::TokenView(key, value, 200, 3, 4, dictionary::Token::NONE));
+  key = "xxx";
+  value = "yyy";
+
+  // The strings are copied to the lattice, and the key is shared.
+  EXPECT_EQ(node1->key, "key");
+  EXPECT_EQ(node1->value, "value");
+  EXPECT_EQ(node1->wcost, 100);
+  EXPECT_EQ(node2->key, "key");
+  EXPECT_EQ(node2->value, "key");
+  EXPECT_EQ(node1->key.data(), node2->key.data());
+  EXPECT_EQ(node2->key.data(), node2->value.data());
+}
+
+TEST(LatticeTest, CopyStringTest) {
+  Lattice lattice;
+  lattice.SetKey("test");
+  std::string str = "str";
+  const absl::string_view copied = lattice.CopyString(str);
+  str = "xxx";
+  lattice.AppendKey("ing");
+  EXPECT_EQ(copied, "str");
+}
+
 TEST(LatticeTest, InsertTest) {
   Lattice lattice;
 
@@ -86,4 +123,89 @@ TEST(LatticeTest, InsertTest) {
     EXPECT_EQ(lattice.end_nodes(3).size(), 2);
   }
 }
+
+TEST(LatticeTest, AppendKeyTest) {
+  Lattice lattice;
+  lattice.SetKey("tes");
+  lattice.set_context("context");
+  lattice.mutable_open_positions()->push_back(1);
+
+  Node* node = lattice.NewNode();
+  node->value = "ES";
+  node->key = "es";
+  lattice.Insert(1, node);
+  Node* eos_node = lattice.eos_node();
+  eos_node->prev = node;
+
+  lattice.AppendKey("ting");
+  EXPECT_EQ(lattice.key(), "testing");
+  EXPECT_EQ(lattice.context(), "context");
+  EXPECT_EQ(lattice.open_positions(), std::vector<size_t>{1});
+
+  // The inserted nodes are kept and the EOS node is moved to the new end.
+  ASSERT_EQ(lattice.begin_nodes(1).size(), 1);
+  EXPECT_EQ(lattice.begin_nodes(1).front(), node);
+  ASSERT_EQ(lattice.end_nodes(3).size(), 1);
+  EXPECT_EQ(lattice.end_nodes(3).front(), node);
+  EXPECT_TRUE(lattice.begin_nodes(3).empty());
+  EXPECT_EQ(lattice.eos_node(), eos_node);
+  EXPECT_EQ(eos_node->begin_pos, 7);
+  EXPECT_EQ(eos_node->end_pos, 7);
+  EXPECT_EQ(eos_node->prev, nullptr);
+
+  Node* node2 = lattice.NewNode();
+  node2->value = "TING";
+  node2->key = "ting";
+  lattice.Insert(3, node2);
+  ASSERT_EQ(lattice.end_nodes(7).size(), 1);
+  EXPECT_EQ(lattice.end_nodes(7).front(), node2);
+
+  // SetKey() resets the state for incremental construction.
+  lattice.SetKey("test");
+  EXPECT_TRUE(lattice.context().empty());
+  EXPECT_TRUE(lattice.open_positions().empty());
+}
+
+TEST(LatticeColumnTest, FindBest) {
+  Lattice lattice;
+  lattice.SetKey("test");
+
+  // Enough nodes to run the vectorized loop and its remainder.
+  std::vector<Node*> nodes;
+  for (int i = 0; i < 11; ++i) {
+    Node* node = lattice.NewNode();
+    node->rid = i;
+    node->cost = 100 - i;
+    // Every third node has no best path.
+    node->prev = (i % 3 == 0) ? nullptr : lattice.bos_node();
+    nodes.push_back(node);
+  }
+
+  LatticeColumn column;
+  column.Assign(nodes);
+  ASSERT_EQ(column.size(), 7);
+  EXPECT_EQ(column.rids()[0], 1);
+  EXPECT_EQ(column.costs()[0], 99);
+
+  // Costs are {99, 98, 96, 95, 93, 92, 90} for rids {1, 2, 4, 5, 7, 8, 10}.
+  int32_t best_cost = 0;
+  std::vector<int32_t> transition_costs = {10, 10, 10, 10, 10, 10, 10};
+  EXPECT_EQ(column.FindBest(transition_costs, 1000, &best_cost), nodes[10]);
+  EXPECT_EQ(best_cost, 100);
+
+  // The first node wins a tie.
+  transition_costs = {0, 1, 3, 4, 6, 7, 9};
+  EXPECT_EQ(column.FindBest(transition_costs, 1000, &best_cost), nodes[1]);
+  EXPECT_EQ(best_cost, 99);
+
+  // No sum is smaller than the max cost.
+  EXPECT_EQ(column.FindBest(transition_costs, 99, &best_cost), nullptr);
+  EXPECT_EQ(best_cost, 99);
+
+  column.Assign({});
+  EXPECT_TRUE(column.empty());
+  EXPECT_EQ(column.FindBest({}, 1000, &best_cost), nullptr);
+  EXPECT_EQ(best_cost, 1000);
+}
+
 }  // namespace mozc
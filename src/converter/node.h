@@ -31,8 +31,8 @@
 #define MOZC_CONVERTER_NODE_H_
 
 #include <cstdint>
-#include <string>
 
+#include "absl/strings/string_view.h"
 #include "dictionary/dictionary_token.h"
 
 namespace mozc {
@@ -100,8 +100,11 @@ struct Node {
 
   // key: The user input.
   // value: The surface form of the word.
-  std::string key;
-  std::string value;
+  // The strings are not owned by the node. Nodes in a lattice refer to the
+  // strings copied to the lattice by Lattice::CopyString(), which live as long
+  // as the nodes.
+  absl::string_view key;
+  absl::string_view value;
 
   Node() { Init(); }
 
@@ -117,11 +120,12 @@ struct Node {
     wcost = 0;
     cost = 0;
     attributes = 0;
-    key.clear();
-    value.clear();
+    key = absl::string_view();
+    value = absl::string_view();
   }
 
-  inline void InitFromToken(const dictionary::Token& token) {
+  // The key and value refer to the strings of `token`.
+  inline void InitFromToken(const dictionary::TokenView& token) {
     prev = nullptr;
     next = nullptr;
     constrained_prev = nullptr;
@@ -31,6 +31,7 @@
 #define MOZC_CONVERTER_NODE_ALLOCATOR_H_
 
 #include "absl/log/check.h"
+#include "absl/strings/string_view.h"
 #include "base/container/arena.h"
 #include "converter/node.h"
 
@@ -38,7 +39,7 @@ namespace mozc {
 
 class NodeAllocator {
  public:
-  NodeAllocator() : node_arena_(1024) {}
+  NodeAllocator() : node_arena_(1024), string_arena_(16 * 1024) {}
   NodeAllocator(const NodeAllocator&) = delete;
   NodeAllocator& operator=(const NodeAllocator&) = delete;
 
@@ -49,11 +50,37 @@ class NodeAllocator {
     return node;
   }
 
-  // Frees all nodes allocateed by NewNode().
-  void Free() { node_arena_.Clear(); }
+  // Allocates a new node whose key and value are copied to the arena.
+  // Consecutive tokens of the same key share the copy of the key.
+  Node* NewNodeFromToken(const dictionary::TokenView& token) {
+    Node* node = NewNode();
+    node->InitFromToken(token);
+    if (token.key != last_key_) {
+      last_key_ = string_arena_.Copy(token.key);
+    }
+    node->key = last_key_;
+    node->value =
+        token.value == token.key ? last_key_ : string_arena_.Copy(token.value);
+    return node;
+  }
+
+  // Copies `str` to the arena. The result is valid until Free() is called.
+  absl::string_view CopyString(absl::string_view str) {
+    return string_arena_.Copy(str);
+  }
+
+  // Frees all nodes allocateed by NewNode() and all strings.
+  void Free() {
+    node_arena_.Clear();
+    string_arena_.Clear();
+    last_key_ = absl::string_view();
+  }
 
  private:
   Arena<Node> node_arena_;
+  StringArena string_arena_;
+  // The last key copied by NewNodeFromToken().
+  absl::string_view last_key_;
 };
 
 }  // namespace mozc
@@ -80,9 +80,15 @@ class BaseNodeListBuilder : public dictionary::DictionaryInterface::Callback {
     return TRAVERSE_CONTINUE;
   }
 
-  // Creates a new node and prepends it to the current list.
   ResultType OnToken(absl::string_view key, absl::string_view actual_key,
                      const dictionary::Token& token) override {
+    return OnTokenView(key, actual_key, token);
+  }
+
+  // Creates a new node and prepends it to the current list. The strings of
+  // `token` are copied to the arena of the allocator.
+  ResultType OnTokenView(absl::string_view key, absl::string_view actual_key,
+                         const dictionary::TokenView& token) override {
     Node* new_node = NewNodeFromToken(token);
     DCHECK(new_node);
     AppendToResult(new_node);
@@ -98,9 +104,8 @@ class BaseNodeListBuilder : public dictionary::DictionaryInterface::Callback {
   }
   std::vector<Node*> result() { return result_; }
 
-  Node* NewNodeFromToken(const dictionary::Token& token) {
-    Node* new_node = allocator_->NewNode();
-    new_node->InitFromToken(token);
+  Node* NewNodeFromToken(const dictionary::TokenView& token) {
+    Node* new_node = allocator_->NewNodeFromToken(token);
     new_node->wcost += penalty_;
     if (penalty_ > 0) new_node->attributes |= Node::KEY_EXPANDED;
     return new_node;
@@ -81,22 +81,37 @@ Segment& Segment::operator=(const Segment& x) {
 }
 
 void Segment::clear_candidates() {
+  // Keeps at most kCandidatesPoolSize candidates so that a long candidate
+  // list does not stay allocated for the lifetime of the segment.
+  for (std::unique_ptr<Candidate>& candidate : pool_) {
+    if (candidate != nullptr &&
+        recycled_candidates_.size() < kCandidatesPoolSize) {
+      recycled_candidates_.push_back(std::move(candidate));
+    }
+  }
   pool_.clear();
   candidates_.clear();
 }
 
+Candidate* Segment::NewCandidate() {
+  if (recycled_candidates_.empty()) {
+    return pool_.emplace_back(std::make_unique<Candidate>()).get();
+  }
+  Candidate* candidate =
+      pool_.emplace_back(std::move(recycled_candidates_.back())).get();
+  recycled_candidates_.pop_back();
+  candidate->Clear();
+  return candidate;
+}
+
 Candidate* Segment::push_back_candidate() {
-  auto candidate = std::make_unique<Candidate>();
-  Candidate* ptr = candidate.get();
-  pool_.push_back(std::move(candidate));
+  Candidate* ptr = NewCandidate();
   candidates_.push_back(ptr);
   return ptr;
 }
 
 Candidate* Segment::push_front_candidate() {
-  auto candidate = std::make_unique<Candidate>();
-  Candidate* ptr = candidate.get();
-  pool_.push_back(std::move(candidate));
+  Candidate* ptr = NewCandidate();
   candidates_.push_front(ptr);
   return ptr;
 }
@@ -112,8 +127,7 @@ Candidate* Segment::insert_candidate(int i) {
                 << candidates_.size();
     i = static_cast<int>(candidates_.size());
   }
-  Candidate* candidate =
-      pool_.emplace_back(std::make_unique<Candidate>()).get();
+  Candidate* candidate = NewCandidate();
   candidates_.insert(candidates_.begin() + i, candidate);
   return candidate;
 }
@@ -238,15 +252,24 @@ void Segment::Clear() {
   key_len_ = 0;
   meta_candidates_.clear();
   segment_type_ = FREE;
+  removed_candidates_for_debug_.clear();
 }
 
 void Segment::DeepCopyCandidates(const std::deque<Candidate*>& candidates) {
   DCHECK(pool_.empty());
   pool_.reserve(candidates.size());
   for (const Candidate* cand : candidates) {
-    auto new_cand = std::make_unique<Candidate>(*cand);
-    candidates_.push_back(new_cand.get());
-    pool_.push_back(std::move(new_cand));
+    if (recycled_candidates_.empty()) {
+      candidates_.push_back(
+          pool_.emplace_back(std::make_unique<Candidate>(*cand)).get());
+      continue;
+    }
+    // Copy assignment reuses the string buffers of the recycled candidate.
+    Candidate* new_cand =
+        pool_.emplace_back(std::move(recycled_candidates_.back())).get();
+    recycled_candidates_.pop_back();
+    *new_cand = *cand;
+    candidates_.push_back(new_cand);
   }
 }
 
@@ -291,23 +314,27 @@ Segments& Segments::operator=(const Segments& x) {
   return *this;
 }
 
-Segment* Segments::insert_segment(size_t i) {
-  Segment* segment = pool_.Alloc();
+Segment* Segments::NewSegment() {
+  Segment* segment =
+      recycling_enabled_ ? pool_.AllocRecycled() : pool_.Alloc();
   segment->Clear();
+  return segment;
+}
+
+Segment* Segments::insert_segment(size_t i) {
+  Segment* segment = NewSegment();
   segments_.insert(segments_.begin() + i, segment);
   return segment;
 }
 
 Segment* Segments::push_back_segment() {
-  Segment* segment = pool_.Alloc();
-  segment->Clear();
+  Segment* segment = NewSegment();
   segments_.push_back(segment);
   return segment;
 }
 
 Segment* Segments::push_front_segment() {
-  Segment* segment = pool_.Alloc();
-  segment->Clear();
+  Segment* segment = NewSegment();
   segments_.push_front(segment);
   return segment;
 }
@@ -516,7 +543,13 @@ bool Segments::Resize(size_t start_index, absl::Span<const uint8_t> new_sizes) {
 }
 
 void Segments::clear_segments() {
-  pool_.Clear();
+  if (recycling_enabled_) {
+    for (Segment* segment : segments_) {
+      pool_.Release(segment);
+    }
+  } else {
+    pool_.Clear();
+  }
   resized_ = false;
   segments_.clear();
 }
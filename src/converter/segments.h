@@ -67,7 +67,7 @@ class Segment final {
   // Using ::mozc::converter::Candidate is preferred.
   using Candidate = ::mozc::converter::Candidate;
 
-  Segment() : segment_type_(FREE), pool_(kCandidatesPoolSize) {}
+  Segment() : segment_type_(FREE) { pool_.reserve(kCandidatesPoolSize); }
 
   Segment(const Segment& x);
   Segment& operator=(const Segment& x);
@@ -119,6 +119,8 @@ class Segment final {
 
   // erase all candidates
   // do not erase meta candidates
+  // The erased candidates are kept and reused by the methods above adding
+  // candidates, so that their string buffers are reused.
   void clear_candidates();
 
   // meta candidates
@@ -157,6 +159,10 @@ class Segment final {
  private:
   void DeepCopyCandidates(const std::deque<Candidate*>& candidates);
 
+  // Returns a new candidate owned by `pool_`, reusing a candidate in
+  // `recycled_candidates_` if available.
+  Candidate* NewCandidate();
+
   static constexpr int kCandidatesPoolSize = 16;
 
   // LINT.IfChange
@@ -174,6 +180,10 @@ class Segment final {
   std::vector<Candidate> meta_candidates_;
   std::vector<std::unique_ptr<Candidate>> pool_;
   // LINT.ThenChange(//converter/segments_matchers.h)
+
+  // Candidates erased by clear_candidates(). Their states are not cleared
+  // until they are reused. At most kCandidatesPoolSize candidates are kept.
+  std::vector<std::unique_ptr<Candidate>> recycled_candidates_;
 };
 
 // Segments is basically an array of Segment.
@@ -447,12 +457,22 @@ class Segments final {
   void set_revert_id(uint64_t revert_id) { revert_id_ = revert_id; }
   uint64_t revert_id() const { return revert_id_; }
 
+  // Recycling mode. When enabled, removed segments are kept with their
+  // candidates, and reused for the segments added later without reallocating
+  // their strings. Useful for long-lived Segments updated on every key stroke.
+  // Clear() keeps the memory in this mode.
+  void set_recycling_enabled(bool enabled) { recycling_enabled_ = enabled; }
+  bool recycling_enabled() const { return recycling_enabled_; }
+
  private:
   friend class SegmentsPoolAccessorTestPeer;
 
   iterator history_segments_end();
   const_iterator history_segments_end() const;
 
+  // Returns a cleared segment from `pool_`.
+  Segment* NewSegment();
+
   // LINT.IfChange
   size_t max_history_segments_size_;
   bool resized_;
@@ -461,6 +481,8 @@ class Segments final {
   std::deque<Segment*> segments_;
   uint64_t revert_id_ = 0;
   // LINT.ThenChange(//converter/segments_matchers.h)
+
+  bool recycling_enabled_ = false;
 };
 
 inline bool Segment::is_valid_index(int i) const {
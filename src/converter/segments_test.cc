@@ -42,6 +42,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "converter/candidate.h"
+#include "testing/allocation_counter.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/test_peer.h"
@@ -662,6 +663,96 @@ TEST(SegmentTest, Copy) {
   EXPECT_EQ(dest.meta_candidate(0).key, src.meta_candidate(0).key);
 }
 
+TEST(SegmentTest, RecycleCandidates) {
+  Segment segment;
+  Candidate* candidate1 = segment.add_candidate();
+  candidate1->key = "key1";
+  candidate1->cost = 100;
+  candidate1->attributes = Attribute::REALTIME_CONVERSION;
+  Candidate* candidate2 = segment.add_candidate();
+  candidate2->key = "key2";
+
+  segment.clear_candidates();
+  EXPECT_EQ(segment.candidates_size(), 0);
+
+  // The cleared candidates are reused with the default values.
+  Candidate* candidate3 = segment.add_candidate();
+  Candidate* candidate4 = segment.push_front_candidate();
+  EXPECT_THAT((std::vector<Candidate*>{candidate3, candidate4}),
+              ::testing::UnorderedElementsAre(candidate1, candidate2));
+  EXPECT_TRUE(candidate3->key.empty());
+  EXPECT_EQ(candidate3->cost, 0);
+  EXPECT_EQ(candidate3->attributes, 0);
+  EXPECT_TRUE(candidate4->key.empty());
+  EXPECT_EQ(segment.candidates_size(), 2);
+
+  // A new candidate is allocated when no candidate is recycled.
+  Candidate* candidate5 = segment.add_candidate();
+  EXPECT_NE(candidate5, candidate1);
+  EXPECT_NE(candidate5, candidate2);
+}
+
+TEST(SegmentsTest, RecyclingMode) {
+  Segments segments;
+  segments.set_recycling_enabled(true);
+  Segment previous_segment;
+
+  // Emulates key strokes in suggestion mode: the conversion segment is
+  // rebuilt with candidates of similar sizes, and the result is copied.
+  const std::string long_string(64, 'x');
+  auto type_key = [&] {
+    segments.clear_conversion_segments();
+    Segment* segment = segments.add_segment();
+    segment->set_key(long_string);
+    for (int i = 0; i < 10; ++i) {
+      Candidate* candidate = segment->add_candidate();
+      candidate->key = long_string;
+      candidate->value = long_string;
+      candidate->content_key = long_string;
+      candidate->content_value = long_string;
+      candidate->cost = i;
+    }
+    previous_segment = segments.conversion_segment(0);
+  };
+
+  // Warm up.
+  type_key();
+  type_key();
+
+  testing::AllocationCounter counter;
+  for (int i = 0; i < 10; ++i) {
+    type_key();
+  }
+  EXPECT_EQ(counter.num_allocations(), 0);
+  EXPECT_EQ(segments.conversion_segment(0).candidates_size(), 10);
+  EXPECT_EQ(previous_segment.candidate(9).cost, 9);
+
+  // Clear() keeps the memory in recycling mode.
+  segments.Clear();
+  counter.Reset();
+  type_key();
+  EXPECT_EQ(counter.num_allocations(), 0);
+}
+
+TEST(SegmentTest, RecycledCandidatesAreCapped) {
+  Segment segment;
+  auto add_candidates = [&segment](int size) {
+    segment.clear_candidates();
+    for (int i = 0; i < size; ++i) {
+      segment.add_candidate();
+    }
+  };
+
+  // Only a limited number of candidates are kept after a long candidate list.
+  add_candidates(100);
+  add_candidates(100);
+  testing::AllocationCounter counter;
+  add_candidates(1);
+  EXPECT_EQ(counter.num_allocations(), 0);
+  add_candidates(100);
+  EXPECT_GE(counter.num_allocations(), 50);
+}
+
 TEST(SegmentTest, MetaCandidateTest) {
   Segment segment;
 
@@ -312,6 +312,16 @@ absl::Status DataManager::InitFromReader(const DataSetReader& reader) {
                                         symbol_string_array_data_)) {
     return absl::DataLossError("Symbol dictionary data is broken");
   }
+  if (!reader.Get("symbol_key_index", &symbol_key_index_data_)) {
+    MOZC_VLOG(2) << "Symbol dictionary's key index is not provided";
+    symbol_key_index_data_ = "";
+    // The key index is optional, so don't return false here.
+  }
+  if (!symbol_key_index_data_.empty() &&
+      !SerializedDictionary::VerifyKeyIndex(symbol_key_index_data_,
+                                            symbol_token_array_data_)) {
+    return absl::DataLossError("Symbol dictionary key index is broken");
+  }
   if (!reader.Get("emoticon_token", &emoticon_token_array_data_)) {
     return absl::NotFoundError("Cannot find an emoticon token array");
   }
@@ -323,6 +333,16 @@ absl::Status DataManager::InitFromReader(const DataSetReader& reader) {
                                         emoticon_string_array_data_)) {
     return absl::DataLossError("Emoticon dictionary data is broken");
   }
+  if (!reader.Get("emoticon_key_index", &emoticon_key_index_data_)) {
+    MOZC_VLOG(2) << "Emoticon dictionary's key index is not provided";
+    emoticon_key_index_data_ = "";
+    // The key index is optional, so don't return false here.
+  }
+  if (!emoticon_key_index_data_.empty() &&
+      !SerializedDictionary::VerifyKeyIndex(emoticon_key_index_data_,
+                                            emoticon_token_array_data_)) {
+    return absl::DataLossError("Emoticon dictionary key index is broken");
+  }
   if (!reader.Get("emoji_token", &emoji_token_array_data_)) {
     return absl::NotFoundError("Cannot find an emoji token array");
   }
@@ -520,12 +540,14 @@ std::array<absl::string_view, 3> DataManager::GetReadingCorrectionData() const {
           reading_correction_correction_array_data_};
 }
 
-std::array<absl::string_view, 2> DataManager::GetSymbolRewriterData() const {
-  return {symbol_token_array_data_, symbol_string_array_data_};
+std::array<absl::string_view, 3> DataManager::GetSymbolRewriterData() const {
+  return {symbol_token_array_data_, symbol_string_array_data_,
+          symbol_key_index_data_};
 }
 
-std::array<absl::string_view, 2> DataManager::GetEmoticonRewriterData() const {
-  return {emoticon_token_array_data_, emoticon_string_array_data_};
+std::array<absl::string_view, 3> DataManager::GetEmoticonRewriterData() const {
+  return {emoticon_token_array_data_, emoticon_string_array_data_,
+          emoticon_key_index_data_};
 }
 
 std::array<absl::string_view, 2> DataManager::GetEmojiRewriterData() const {
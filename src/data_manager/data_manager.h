@@ -114,11 +114,13 @@ class DataManager {
   // [value_array_data, error_array_data, correction_array_data]
   virtual std::array<absl::string_view, 3> GetReadingCorrectionData() const;
 
-  // [token_array_data, string_array_data]
-  virtual std::array<absl::string_view, 2> GetSymbolRewriterData() const;
+  // [token_array_data, string_array_data, key_index_data]
+  // key_index_data is empty if the data set doesn't have it.
+  virtual std::array<absl::string_view, 3> GetSymbolRewriterData() const;
 
-  // [token_array_data, string_array_data]
-  virtual std::array<absl::string_view, 2> GetEmoticonRewriterData() const;
+  // [token_array_data, string_array_data, key_index_data]
+  // key_index_data is empty if the data set doesn't have it.
+  virtual std::array<absl::string_view, 3> GetEmoticonRewriterData() const;
 
   // [token_array_data, string_array_data]
   virtual std::array<absl::string_view, 2> GetEmojiRewriterData() const;
@@ -204,8 +206,10 @@ class DataManager {
   absl::string_view reading_correction_correction_array_data_;
   absl::string_view symbol_token_array_data_;
   absl::string_view symbol_string_array_data_;
+  absl::string_view symbol_key_index_data_;
   absl::string_view emoticon_token_array_data_;
   absl::string_view emoticon_string_array_data_;
+  absl::string_view emoticon_key_index_data_;
   absl::string_view emoji_token_array_data_;
   absl::string_view emoji_string_array_data_;
   absl::string_view single_kanji_token_array_data_;
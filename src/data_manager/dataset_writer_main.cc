@@ -43,21 +43,29 @@
 // 32, 64, ...). Each packed file can be retrieved by DataSetReader through its
 // name.
 
+#include <algorithm>
+#include <cstddef>
 #include <ios>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "base/file_stream.h"
 #include "base/file_util.h"
 #include "base/init_mozc.h"
 #include "base/number_util.h"
+#include "base/thread_pool.h"
 #include "base/vlog.h"
 #include "data_manager/dataset_writer.h"
 
@@ -96,17 +104,35 @@ int main(int argc, char** argv) {
 
   CHECK(!absl::GetFlag(FLAGS_output).empty()) << "--output is required";
 
+  // Reads the input files concurrently. They are still packed in the order of
+  // the arguments, so the output doesn't depend on the number of threads.
+  const absl::Time start = absl::Now();
+  std::vector<std::string> contents(inputs.size());
+  {
+    mozc::ThreadPool pool(std::max<size_t>(
+        1, std::min<size_t>(std::thread::hardware_concurrency(),
+                            inputs.size())));
+    mozc::ParallelFor(&pool, inputs.size(), [&](size_t i) {
+      absl::StatusOr<std::string> content =
+          mozc::FileUtil::GetContents(inputs[i].filename);
+      CHECK_OK(content) << inputs[i].filename;
+      contents[i] = *std::move(content);
+    });
+  }
+  LOG(INFO) << "Read " << inputs.size() << " files in " << absl::Now() - start;
+
   // DataSetWriter directly writes to the specified stream, so if it fails for
   // an input, the output contains a partial result.  To avoid such partial file
   // creation, write to a temporary file then rename it.
   const std::string tmpfile = absl::GetFlag(FLAGS_output) + ".tmp";
   {
     mozc::DataSetWriter writer(magic);
-    for (const auto& input : inputs) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const Input& input = inputs[i];
       MOZC_VLOG(1) << "Writing " << input.name
                    << ", alignment = " << input.alignment
                    << ", file = " << input.filename;
-      writer.AddFile(input.name, input.alignment, input.filename);
+      writer.Add(input.name, input.alignment, contents[i]);
     }
     mozc::OutputFileStream output(tmpfile,
                                   std::ios_base::out | std::ios_base::binary);
@@ -168,11 +168,11 @@ def mozc_dataset(
         "pos_matcher:32:$(@D)/pos_matcher.data " +
         "user_pos_token:32:$(@D)/user_pos_token_array.data " +
         "user_pos_string:32:$(@D)/user_pos_string_array.data " +
-        "coll:32:$(location :" + name + "@collocation) " +
-        "cols:32:$(location :" + name + "@collocation_suppression) " +
+        "coll:512:$(location :" + name + "@collocation) " +
+        "cols:512:$(location :" + name + "@collocation_suppression) " +
         "conn:32:$(location :" + name + "@connection) " +
         "dict:32:$(location :" + name + "@dictionary) " +
-        "sugg:32:$(location :" + name + "@suggestion_filter) " +
+        "sugg:512:$(location :" + name + "@suggestion_filter) " +
         "posg:32:$(location :" + name + "@pos_group) " +
         "bdry:32:$(location :" + name + "@boundary) " +
         "segmenter_sizeinfo:32:$(@D)/segmenter_sizeinfo.data " +
@@ -188,8 +188,10 @@ def mozc_dataset(
         "reading_correction_correction:32:$(@D)/reading_correction_correction.data " +
         "symbol_token:32:$(@D)/symbol_token.data " +
         "symbol_string:32:$(@D)/symbol_string.data " +
+        "symbol_key_index:32:$(@D)/symbol_key_index.data " +
         "emoticon_token:32:$(@D)/emoticon_token.data " +
         "emoticon_string:32:$(@D)/emoticon_string.data " +
+        "emoticon_key_index:32:$(@D)/emoticon_key_index.data " +
         "emoji_token:32:$(@D)/emoji_token.data " +
         "emoji_string:32:$(@D)/emoji_string.data " +
         "single_kanji_token:32:$(@D)/single_kanji_token.data " +
@@ -532,6 +534,7 @@ def mozc_dataset(
         outs = [
             "symbol_token.data",
             "symbol_string.data",
+            "symbol_key_index.data",
         ],
         cmd = (
             "$(location //rewriter:gen_symbol_rewriter_dictionary_main) " +
@@ -540,7 +543,8 @@ def mozc_dataset(
             "--sorting_table=$(location " + sorting_map + ") " +
             "--ordering_rule=$(location " + symbol_ordering_rule + ") " +
             "--output_token_array=$(location :symbol_token.data) " +
-            "--output_string_array=$(location :symbol_string.data)"
+            "--output_string_array=$(location :symbol_string.data) " +
+            "--output_key_index=$(location :symbol_key_index.data)"
         ),
         tools = ["//rewriter:gen_symbol_rewriter_dictionary_main"],
     )
@@ -551,12 +555,14 @@ def mozc_dataset(
         outs = [
             "emoticon_token.data",
             "emoticon_string.data",
+            "emoticon_key_index.data",
         ],
         cmd = (
             "$(location //rewriter:gen_emoticon_rewriter_data) " +
             "--input=$< " +
             "--output_token_array=$(location :emoticon_token.data) " +
-            "--output_string_array=$(location :emoticon_string.data)"
+            "--output_string_array=$(location :emoticon_string.data) " +
+            "--output_key_index=$(location :emoticon_key_index.data)"
         ),
         tools = ["//rewriter:gen_emoticon_rewriter_data"],
     )
@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <istream>
@@ -48,6 +49,7 @@
 #include "base/container/serialized_string_array.h"
 #include "base/file_stream.h"
 #include "base/file_util.h"
+#include "base/hash.h"
 #include "base/number_util.h"
 
 namespace mozc {
@@ -87,19 +89,53 @@ void LoadTokens(std::istream* ifs, std::map<std::string, TokenList>* dic) {
 }  // namespace
 
 SerializedDictionary::SerializedDictionary(absl::string_view token_array,
-                                           absl::string_view string_array_data)
+                                           absl::string_view string_array_data,
+                                           absl::string_view key_index_data)
     : token_array_(token_array) {
   DCHECK(VerifyData(token_array, string_array_data));
   string_array_.Set(string_array_data);
+  if (!key_index_data.empty()) {
+    DCHECK(VerifyKeyIndex(key_index_data, token_array));
+    key_index_mask_ = LoadUnaligned<uint32_t>(key_index_data.data()) - 1;
+    key_index_slots_ = key_index_data.substr(sizeof(uint32_t));
+  }
 }
 
 SerializedDictionary::IterRange SerializedDictionary::equal_range(
     absl::string_view key) const {
+  if (!key_index_slots_.empty()) {
+    return LookupKeyIndex(key);
+  }
   // TODO(noriyukit): Instead of comparing key as string, we can do binary
   // search using key index to minimize string comparison cost.
   return std::equal_range(begin(), end(), key);
 }
 
+SerializedDictionary::IterRange SerializedDictionary::LookupKeyIndex(
+    absl::string_view key) const {
+  const uint64_t hash = CityFingerprint(key);
+  const uint32_t upper_hash = static_cast<uint32_t>(hash >> 32);
+  uint32_t slot = static_cast<uint32_t>(hash) & key_index_mask_;
+  // The table has empty slots, but the loop is bounded for broken data.
+  for (uint32_t i = 0; i <= key_index_mask_; ++i) {
+    const char* ptr =
+        key_index_slots_.data() + slot * kKeyIndexSlotByteLength;
+    const uint32_t first = LoadUnaligned<uint32_t>(ptr + 4);
+    const uint32_t last = LoadUnaligned<uint32_t>(ptr + 8);
+    if (first == last) {
+      break;
+    }
+    if (LoadUnaligned<uint32_t>(ptr) == upper_hash) {
+      const iterator iter = begin() + first;
+      if (iter.key() == key) {
+        return IterRange(iter, begin() + last);
+      }
+    }
+    slot = (slot + 1) & key_index_mask_;
+  }
+  return IterRange(end(), end());
+}
+
 std::pair<absl::string_view, absl::string_view> SerializedDictionary::Compile(
     std::istream* input, std::unique_ptr<uint32_t[]>* output_token_array_buf,
     std::unique_ptr<uint32_t[]>* output_string_array_buf) {
@@ -187,26 +223,77 @@ std::pair<absl::string_view, absl::string_view> SerializedDictionary::Compile(
                                                          string_array);
 }
 
+absl::string_view SerializedDictionary::BuildKeyIndex(
+    absl::string_view token_array_data, absl::string_view string_array_data,
+    std::unique_ptr<uint32_t[]>* output_key_index_buf) {
+  static_assert(std::endian::native == std::endian::little);
+
+  // Collect the ranges of tokens sharing the same key.  Since strings are
+  // deduplicated in the string array, the same key has the same key index.
+  const SerializedDictionary dic(token_array_data, string_array_data);
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  for (iterator iter = dic.begin(); iter != dic.end();) {
+    const iterator first = iter;
+    do {
+      ++iter;
+    } while (iter != dic.end() && iter.key_index() == first.key_index());
+    ranges.emplace_back(first - dic.begin(), iter - dic.begin());
+  }
+
+  // Keep the load factor at most 1/2 so that probing ends early, especially
+  // for missing keys.
+  const size_t num_slots = std::bit_ceil(2 * ranges.size() + 1);
+  CHECK_LE(num_slots, UINT32_MAX);
+  const size_t buf_size = 1 + num_slots * kKeyIndexSlotByteLength / 4;
+  // All the slots are initialized to be empty.
+  *output_key_index_buf = std::make_unique<uint32_t[]>(buf_size);
+  uint32_t* buf = output_key_index_buf->get();
+  buf[0] = static_cast<uint32_t>(num_slots);
+  uint32_t* slots = buf + 1;
+  for (const auto& [first, last] : ranges) {
+    const uint64_t hash = CityFingerprint((dic.begin() + first).key());
+    size_t slot = hash & (num_slots - 1);
+    while (slots[3 * slot + 1] != slots[3 * slot + 2]) {
+      slot = (slot + 1) & (num_slots - 1);
+    }
+    slots[3 * slot] = static_cast<uint32_t>(hash >> 32);
+    slots[3 * slot + 1] = first;
+    slots[3 * slot + 2] = last;
+  }
+  return absl::string_view(reinterpret_cast<const char*>(buf),
+                           buf_size * sizeof(uint32_t));
+}
+
 void SerializedDictionary::CompileToFiles(
     absl::string_view input, absl::string_view output_token_array,
-    absl::string_view output_string_array) {
+    absl::string_view output_string_array,
+    absl::string_view output_key_index) {
   InputFileStream ifs(input);
   CHECK(ifs.good());
   std::map<std::string, TokenList> dic;
   LoadTokens(&ifs, &dic);
-  CompileToFiles(dic, output_token_array, output_string_array);
+  CompileToFiles(dic, output_token_array, output_string_array,
+                 output_key_index);
 }
 
 void SerializedDictionary::CompileToFiles(
     const std::map<std::string, TokenList>& dic,
     absl::string_view output_token_array,
-    absl::string_view output_string_array) {
+    absl::string_view output_string_array,
+    absl::string_view output_key_index) {
   std::unique_ptr<uint32_t[]> buf1, buf2;
   const std::pair<absl::string_view, absl::string_view> data =
       Compile(dic, &buf1, &buf2);
   CHECK(VerifyData(data.first, data.second));
   CHECK_OK(FileUtil::SetContents(output_token_array, data.first));
   CHECK_OK(FileUtil::SetContents(output_string_array, data.second));
+  if (!output_key_index.empty()) {
+    std::unique_ptr<uint32_t[]> buf3;
+    const absl::string_view key_index =
+        BuildKeyIndex(data.first, data.second, &buf3);
+    CHECK(VerifyKeyIndex(key_index, data.first));
+    CHECK_OK(FileUtil::SetContents(output_key_index, key_index));
+  }
 }
 
 bool SerializedDictionary::VerifyData(absl::string_view token_array_data,
@@ -232,4 +319,28 @@ bool SerializedDictionary::VerifyData(absl::string_view token_array_data,
   return true;
 }
 
+bool SerializedDictionary::VerifyKeyIndex(absl::string_view key_index_data,
+                                          absl::string_view token_array_data) {
+  if (key_index_data.size() < sizeof(uint32_t)) {
+    return false;
+  }
+  const uint32_t num_slots = LoadUnaligned<uint32_t>(key_index_data.data());
+  if (!std::has_single_bit(num_slots) ||
+      key_index_data.size() !=
+          sizeof(uint32_t) + num_slots * kKeyIndexSlotByteLength) {
+    return false;
+  }
+  const size_t num_tokens = token_array_data.size() / kTokenByteLength;
+  for (const char* ptr = key_index_data.data() + sizeof(uint32_t);
+       ptr != key_index_data.data() + key_index_data.size();
+       ptr += kKeyIndexSlotByteLength) {
+    const uint32_t first = LoadUnaligned<uint32_t>(ptr + 4);
+    const uint32_t last = LoadUnaligned<uint32_t>(ptr + 8);
+    if (first > last || last > num_tokens) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace mozc
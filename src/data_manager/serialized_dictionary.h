@@ -73,7 +73,8 @@ namespace mozc {
 // token array and string array, e.g., from files, onto memory blocks.  But
 // these two memory blocks must be aligned at 4 byte boundary.  Accessors are
 // designed to have similar interfaces to std::multimap<string, Value>, so
-// values can be looked up by equal_range(), etc.
+// values can be looked up by equal_range(), etc.  Optionally, the third image,
+// key index, can be passed to look up keys without binary search.
 //
 // * Binary format
 //
@@ -110,6 +111,38 @@ namespace mozc {
 // byte boundary by the insertion of padding.  String values of a token (key,
 // value, description, additional_description) can be retrieved from the string
 // array by index.
+//
+// ** Key index (optional)
+// Binary search over the token array touches a token and a string at distant
+// addresses per probe.  The key index is an open addressing hash table which
+// maps a key to the range of its tokens, so a lookup usually reads one slot
+// and the first token of the range.  Use BuildKeyIndex() to create the image
+// from the token array and the string array.
+//
+// Key index layout
+// +---------------------------------------+
+// | Number of slots = N (4 bytes)         |
+// +---------------------------------------+
+// | Slot 0 (12 bytes)                     |
+// + - - - - - - - - - - - - - - - - - - - +
+// | ...                                   |
+// + - - - - - - - - - - - - - - - - - - - +
+// | Slot N - 1 (12 bytes)                 |
+// +---------------------------------------+
+//
+// Slot layout (12 bytes)
+// +---------------------------------------+
+// | Upper 32 bits of key hash (4 bytes)   |
+// + - - - - - - - - - - - - - - - - - - - +
+// | Begin token position (4 bytes)        |
+// + - - - - - - - - - - - - - - - - - - - +
+// | End token position (4 bytes)          |
+// +---------------------------------------+
+//
+// N is a power of 2 and at least twice the number of keys.  The hash is
+// CityFingerprint() of the key, and the slot of a key is searched by linear
+// probing from (hash mod N).  The positions are the indices of tokens in the
+// token array, and empty slots have the same begin and end positions.
 class SerializedDictionary {
  public:
   struct CompilerToken {
@@ -124,6 +157,7 @@ class SerializedDictionary {
   using TokenList = std::vector<std::unique_ptr<CompilerToken>>;
 
   static constexpr size_t kTokenByteLength = 24;
+  static constexpr size_t kKeyIndexSlotByteLength = 12;
 
   class iterator {
    public:
@@ -280,22 +314,37 @@ class SerializedDictionary {
       std::unique_ptr<uint32_t[]>* output_token_array_buf,
       std::unique_ptr<uint32_t[]>* output_string_array_buf);
 
-  // Creates serialized data and writes them to files.
+  // Creates the key index for the serialized data.  The returned string view
+  // points to the memory block of |output_key_index_buf|.
+  static absl::string_view BuildKeyIndex(
+      absl::string_view token_array_data, absl::string_view string_array_data,
+      std::unique_ptr<uint32_t[]>* output_key_index_buf);
+
+  // Creates serialized data and writes them to files.  The key index is also
+  // written if |output_key_index| is not empty.
   static void CompileToFiles(absl::string_view input,
                              absl::string_view output_token_array,
-                             absl::string_view output_string_array);
+                             absl::string_view output_string_array,
+                             absl::string_view output_key_index = "");
   static void CompileToFiles(const std::map<std::string, TokenList>& dic,
                              absl::string_view output_token_array,
-                             absl::string_view output_string_array);
+                             absl::string_view output_string_array,
+                             absl::string_view output_key_index = "");
 
   // Validates the serialized data.
   static bool VerifyData(absl::string_view token_array_data,
                          absl::string_view string_array_data);
 
-  // Both |token_array| and |string_array_data| must be aligned at 4-byte
-  // boundary.
+  // Validates the key index for |token_array_data|.
+  static bool VerifyKeyIndex(absl::string_view key_index_data,
+                             absl::string_view token_array_data);
+
+  // All of |token_array|, |string_array_data| and |key_index_data| must be
+  // aligned at 4-byte boundary.  |key_index_data| may be empty, in which case
+  // equal_range() falls back to binary search.
   SerializedDictionary(absl::string_view token_array,
-                       absl::string_view string_array_data);
+                       absl::string_view string_array_data,
+                       absl::string_view key_index_data = "");
   ~SerializedDictionary() = default;
 
   std::size_t size() const { return token_array_.size() / kTokenByteLength; }
@@ -313,12 +362,18 @@ class SerializedDictionary {
   }
 
   // Returns the range of iterators whose keys match the given key.  The range
-  // is sorted in ascending order of cost.
+  // is sorted in ascending order of cost.  If the key is not found, the range
+  // is empty but its position is unspecified.
   IterRange equal_range(absl::string_view key) const;
 
  private:
+  IterRange LookupKeyIndex(absl::string_view key) const;
+
   absl::string_view token_array_;
   SerializedStringArray string_array_;
+  // Slots of the key index without the header.  Empty if not available.
+  absl::string_view key_index_slots_;
+  uint32_t key_index_mask_ = 0;
 };
 
 }  // namespace mozc
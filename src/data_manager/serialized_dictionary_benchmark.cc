@@ -0,0 +1,112 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Microbenchmarks of SerializedDictionary::equal_range() on the symbol and
+// emoticon dictionaries of the OSS dataset, comparing binary search over the
+// token array and the key index.
+//
+// The keys are all the keys in the dictionary and the same number of missing
+// keys, looked up in random order.
+//
+// Example:
+//   bazel run -c opt //data_manager:serialized_dictionary_benchmark
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/random/random.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "data_manager/serialized_dictionary.h"
+
+namespace mozc {
+namespace {
+
+const oss::OssDataManager& GetDataManager() {
+  static const oss::OssDataManager* data_manager = new oss::OssDataManager();
+  return *data_manager;
+}
+
+std::vector<std::string> MakeKeys(const SerializedDictionary& dic) {
+  std::vector<std::string> keys;
+  for (auto iter = dic.begin(); iter != dic.end(); ++iter) {
+    if (keys.empty() || keys.back() != iter.key()) {
+      keys.emplace_back(iter.key());
+    }
+  }
+  const size_t num_keys = keys.size();
+  for (size_t i = 0; i < num_keys; ++i) {
+    keys.push_back(absl::StrCat(keys[i], "ー"));
+  }
+  absl::BitGen gen;
+  std::shuffle(keys.begin(), keys.end(), gen);
+  return keys;
+}
+
+// state.range(0) is 1 to use the key index.
+void RunEqualRange(benchmark::State& state,
+                   const std::array<absl::string_view, 3>& data) {
+  std::unique_ptr<uint32_t[]> buf;
+  const absl::string_view key_index =
+      state.range(0) == 0
+          ? absl::string_view()
+          : SerializedDictionary::BuildKeyIndex(data[0], data[1], &buf);
+  const SerializedDictionary dic(data[0], data[1], key_index);
+  const std::vector<std::string> keys = MakeKeys(dic);
+  for (auto _ : state) {
+    for (const std::string& key : keys) {
+      benchmark::DoNotOptimize(dic.equal_range(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  state.counters["lookup_time"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * keys.size()),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["index_bytes"] = static_cast<double>(key_index.size());
+}
+
+void BM_SymbolEqualRange(benchmark::State& state) {
+  RunEqualRange(state, GetDataManager().GetSymbolRewriterData());
+}
+BENCHMARK(BM_SymbolEqualRange)->ArgName("key_index")->Arg(0)->Arg(1);
+
+void BM_EmoticonEqualRange(benchmark::State& state) {
+  RunEqualRange(state, GetDataManager().GetEmoticonRewriterData());
+}
+BENCHMARK(BM_EmoticonEqualRange)->ArgName("key_index")->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace mozc
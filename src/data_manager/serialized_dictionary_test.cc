@@ -30,11 +30,13 @@
 #include "data_manager/serialized_dictionary.h"
 
 #include <cstdint>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "base/container/serialized_string_array.h"
 #include "testing/gunit.h"
@@ -183,5 +185,90 @@ TEST_F(SerializedDictionaryTest, EqualRange) {
   }
 }
 
+TEST_F(SerializedDictionaryTest, KeyIndex) {
+  std::unique_ptr<uint32_t[]> buf;
+  const absl::string_view key_index = SerializedDictionary::BuildKeyIndex(
+      token_array_data_, string_array_data_, &buf);
+  ASSERT_TRUE(
+      SerializedDictionary::VerifyKeyIndex(key_index, token_array_data_));
+  // Two keys need more than 4 slots.
+  EXPECT_EQ(key_index.size(),
+            4 + 8 * SerializedDictionary::kKeyIndexSlotByteLength);
+
+  SerializedDictionary dic(token_array_data_, string_array_data_, key_index);
+  {
+    auto range = dic.equal_range("key1");
+    ASSERT_EQ(std::distance(range.first, range.second), 2);
+    EXPECT_EQ(range.first, dic.begin());
+    EXPECT_EQ(range.first.value(), "value2");
+    EXPECT_EQ((range.first + 1).value(), "value1");
+  }
+  {
+    auto range = dic.equal_range("key2");
+    ASSERT_EQ(std::distance(range.first, range.second), 1);
+    EXPECT_EQ(range.first.value(), "value3");
+  }
+  {
+    auto range = dic.equal_range("mozc");
+    EXPECT_EQ(range.first, range.second);
+  }
+  {
+    auto range = dic.equal_range("");
+    EXPECT_EQ(range.first, range.second);
+  }
+}
+
+TEST_F(SerializedDictionaryTest, KeyIndexMatchesBinarySearch) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    for (int j = 0; j <= i % 3; ++j) {
+      absl::StrAppend(&input, "key", i, "\t1\t2\t", j, "\tvalue", i, "_", j,
+                      "\n");
+    }
+  }
+  std::stringstream ifs(input);
+  std::unique_ptr<uint32_t[]> buf1, buf2, buf3;
+  const auto [token_array, string_array] =
+      SerializedDictionary::Compile(&ifs, &buf1, &buf2);
+  const absl::string_view key_index =
+      SerializedDictionary::BuildKeyIndex(token_array, string_array, &buf3);
+  ASSERT_TRUE(SerializedDictionary::VerifyKeyIndex(key_index, token_array));
+
+  const SerializedDictionary expected(token_array, string_array);
+  const SerializedDictionary actual(token_array, string_array, key_index);
+  for (int i = 0; i < 1100; ++i) {
+    const std::string key = absl::StrCat("key", i);
+    const auto expected_range = expected.equal_range(key);
+    const auto actual_range = actual.equal_range(key);
+    ASSERT_EQ(std::distance(actual_range.first, actual_range.second),
+              std::distance(expected_range.first, expected_range.second))
+        << key;
+    if (expected_range.first != expected_range.second) {
+      EXPECT_EQ(actual_range.first - actual.begin(),
+                expected_range.first - expected.begin())
+          << key;
+    }
+  }
+}
+
+TEST_F(SerializedDictionaryTest, VerifyKeyIndex) {
+  std::unique_ptr<uint32_t[]> buf;
+  const absl::string_view key_index = SerializedDictionary::BuildKeyIndex(
+      token_array_data_, string_array_data_, &buf);
+
+  // Truncated.
+  EXPECT_FALSE(SerializedDictionary::VerifyKeyIndex("", token_array_data_));
+  EXPECT_FALSE(SerializedDictionary::VerifyKeyIndex(
+      key_index.substr(0, key_index.size() - 4), token_array_data_));
+  // The number of slots is not a power of 2.
+  buf[0] = 7;
+  EXPECT_FALSE(
+      SerializedDictionary::VerifyKeyIndex(key_index, token_array_data_));
+  buf[0] = 8;
+  // The range exceeds the token array.
+  EXPECT_FALSE(SerializedDictionary::VerifyKeyIndex(
+      key_index, token_array_data_.substr(0, 1)));
+}
+
 }  // namespace
 }  // namespace mozc
@@ -42,6 +42,7 @@
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
+#include "dictionary/suppression_dictionary.h"
 #include "protocol/config.pb.h"
 #include "request/conversion_request.h"
 
@@ -78,6 +79,12 @@ bool DictionaryImpl::HasValue(absl::string_view value) const {
   });
 }
 
+bool DictionaryImpl::MayHaveKeyWithPrefix(absl::string_view prefix) const {
+  return absl::c_any_of(dics_, [&prefix](const DictionaryInterface* dic) {
+    return dic->MayHaveKeyWithPrefix(prefix);
+  });
+}
+
 namespace {
 
 class CallbackWithFilter : public DictionaryInterface::Callback {
@@ -88,8 +95,7 @@ class CallbackWithFilter : public DictionaryInterface::Callback {
                      DictionaryInterface::Callback* callback)
       : request_(request),
         pos_matcher_(pos_matcher),
-        user_dictionary_(user_dictionary),
-        has_suppressed_entries_(user_dictionary_.HasSuppressedEntries()),
+        suppression_dictionary_(user_dictionary.GetSuppressionDictionary()),
         callback_(callback) {}
 
   ResultType OnKey(absl::string_view key) override {
@@ -103,6 +109,11 @@ class CallbackWithFilter : public DictionaryInterface::Callback {
 
   ResultType OnToken(absl::string_view key, absl::string_view actual_key,
                      const Token& token) override {
+    return OnTokenView(key, actual_key, token);
+  }
+
+  ResultType OnTokenView(absl::string_view key, absl::string_view actual_key,
+                         const TokenView& token) override {
     if (!(token.attributes & Token::USER_DICTIONARY)) {
       if (!request_.config().use_spelling_correction() &&
           (token.attributes & Token::SPELLING_CORRECTION)) {
@@ -117,11 +128,11 @@ class CallbackWithFilter : public DictionaryInterface::Callback {
         return TRAVERSE_CONTINUE;
       }
     }
-    if (has_suppressed_entries_ &&
-        user_dictionary_.IsSuppressedEntry(token.key, token.value)) {
+    if (suppression_dictionary_ &&
+        suppression_dictionary_->IsSuppressedEntry(token.key, token.value)) {
       return TRAVERSE_CONTINUE;
     }
-    return callback_->OnToken(key, actual_key, token);
+    return callback_->OnTokenView(key, actual_key, token);
   }
 
   bool IsKanaModifierInsensitiveConversion() const override {
@@ -131,11 +142,10 @@ class CallbackWithFilter : public DictionaryInterface::Callback {
  private:
   const ConversionRequest& request_;
   const PosMatcher& pos_matcher_;
-  const UserDictionaryInterface& user_dictionary_;
-  // cache the result of HasSuppressedEntries, because calling
-  // IsSuppressedEntry() has some latency because of mutex lock even when
-  // the entry is empty.
-  const bool has_suppressed_entries_ = false;
+  // Snapshot of the suppression entries taken once per lookup, so that the
+  // check for each token is free from the lock of the user dictionary.
+  // nullptr if there's no suppression entry.
+  const std::shared_ptr<const SuppressionDictionary> suppression_dictionary_;
   DictionaryInterface::Callback* callback_ = nullptr;
 };
 
@@ -65,6 +65,7 @@ class DictionaryImpl : public DictionaryInterface {
 
   bool HasKey(absl::string_view key) const override;
   bool HasValue(absl::string_view value) const override;
+  bool MayHaveKeyWithPrefix(absl::string_view prefix) const override;
 
   void LookupPredictive(absl::string_view key,
                         Callback* callback) const override;
@@ -30,13 +30,16 @@
 #ifndef MOZC_DICTIONARY_DICTIONARY_INTERFACE_H_
 #define MOZC_DICTIONARY_DICTIONARY_INTERFACE_H_
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/strings/string_view.h"
 #include "dictionary/dictionary_token.h"
+#include "dictionary/suppression_dictionary.h"
 #include "protocol/user_dictionary_storage.pb.h"
 #include "request/conversion_request.h"
 
@@ -55,7 +58,7 @@ class DictionaryInterface {
   //   OnKey(key);
   //   OnActualKey(key, actual_key, key != actual_key);
   //   for (each token in the token array for the key) {
-  //     OnToken(key, actual_key, token);
+  //     OnTokenView(key, actual_key, token);  // Calls OnToken() by default.
   //   }
   // }
   //
@@ -110,10 +113,25 @@ class DictionaryInterface {
       return TRAVERSE_CONTINUE;
     }
 
+    // Called back when a token is decoded, without copying its strings.
+    // Dictionaries call this method. The default implementation copies the
+    // token to a buffer reused across calls and calls OnToken(). Callbacks
+    // filtering many tokens should override this method and copy only the
+    // tokens they keep.
+    virtual ResultType OnTokenView(absl::string_view key,
+                                   absl::string_view expanded_key,
+                                   const TokenView& token) {
+      token.CopyTo(&token_buffer_);
+      return OnToken(key, expanded_key, token_buffer_);
+    }
+
     virtual bool IsKanaModifierInsensitiveConversion() const { return false; }
 
    protected:
     Callback() = default;
+
+   private:
+    Token token_buffer_;
   };
 
   virtual ~DictionaryInterface() = default;
@@ -124,6 +142,14 @@ class DictionaryInterface {
   // Returns true if the dictionary has an entry for the given value.
   virtual bool HasValue(absl::string_view value) const { return false; }
 
+  // Returns false if the dictionary has no entry whose key starts with the
+  // given prefix, i.e., LookupPrefix() for any key starting with `prefix`
+  // finds no entry longer than `prefix`. Returning true is always safe and is
+  // the default.
+  virtual bool MayHaveKeyWithPrefix(absl::string_view prefix) const {
+    return true;
+  }
+
   // Looks up values whose keys start from the key.
   // (e.g. key = "abc" -> {"abc": "ABC", "abcd": "ABCD"})
   virtual void LookupPredictive(absl::string_view key,
@@ -227,6 +253,8 @@ class InlineCallback : public DictionaryInterface::Callback {
       std::function<ResultType(absl::string_view, absl::string_view, int)>;
   using TokenHandler = std::function<ResultType(
       absl::string_view, absl::string_view, const Token&)>;
+  using TokenViewHandler = std::function<ResultType(
+      absl::string_view, absl::string_view, const TokenView&)>;
 
   InlineCallback() = default;
 
@@ -245,6 +273,12 @@ class InlineCallback : public DictionaryInterface::Callback {
     return *this;
   }
 
+  // Takes precedence over the handler set by OnToken(TokenHandler).
+  InlineCallback& OnTokenView(TokenViewHandler handler) {
+    token_view_handler_ = std::move(handler);
+    return *this;
+  }
+
   ResultType OnKey(absl::string_view key) override {
     return key_handler_ ? key_handler_(key) : TRAVERSE_CONTINUE;
   }
@@ -257,14 +291,29 @@ class InlineCallback : public DictionaryInterface::Callback {
 
   ResultType OnToken(absl::string_view key, absl::string_view expanded_key,
                      const Token& token_info) override {
+    if (token_view_handler_) {
+      return token_view_handler_(key, expanded_key, token_info);
+    }
     return token_handler_ ? token_handler_(key, expanded_key, token_info)
                           : TRAVERSE_CONTINUE;
   }
 
+  ResultType OnTokenView(absl::string_view key, absl::string_view expanded_key,
+                         const TokenView& token) override {
+    if (token_view_handler_) {
+      return token_view_handler_(key, expanded_key, token);
+    }
+    if (!token_handler_) {
+      return TRAVERSE_CONTINUE;
+    }
+    return Callback::OnTokenView(key, expanded_key, token);
+  }
+
  private:
   KeyHandler key_handler_;
   ActualKeyHandler actual_handler_;
   TokenHandler token_handler_;
+  TokenViewHandler token_view_handler_;
 };
 
 class UserDictionaryInterface : public DictionaryInterface {
@@ -290,11 +339,23 @@ class UserDictionaryInterface : public DictionaryInterface {
   // Return true if the dictionary has at least one suppression entry.
   virtual bool HasSuppressedEntries() const = 0;
 
+  // Returns the current suppression entries, or nullptr if there's none.
+  // The returned set is immutable and stays valid across reloads. Prefer it
+  // to IsSuppressedEntry() when checking many words, e.g., every token of a
+  // lookup, as it doesn't take a lock per word.
+  virtual std::shared_ptr<const SuppressionDictionary>
+  GetSuppressionDictionary() const = 0;
+
   // Reload dictionary data from local disk.
   virtual bool Reload() { return true; }
 
   // Returns the filename of user dictionary.
   virtual std::string GetFileName() const { return ""; }
+
+  // Returns a number that changes whenever the dictionary contents are
+  // replaced, e.g., by Load() or Reload(). Caches of conversion results use
+  // it to detect stale entries.
+  virtual uint64_t GetGeneration() const { return 0; }
 };
 
 }  // namespace dictionary
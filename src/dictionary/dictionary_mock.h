@@ -30,12 +30,14 @@
 #ifndef MOZC_DICTIONARY_DICTIONARY_MOCK_H_
 #define MOZC_DICTIONARY_DICTIONARY_MOCK_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_token.h"
+#include "dictionary/suppression_dictionary.h"
 #include "protocol/user_dictionary_storage.pb.h"
 #include "request/conversion_request.h"
 #include "testing/gmock.h"
@@ -117,6 +119,8 @@ class MockUserDictionary : public UserDictionaryInterface {
               (absl::string_view key, absl::string_view value),
               (const, override));
   MOCK_METHOD(bool, HasSuppressedEntries, (), (const, override));
+  MOCK_METHOD(std::shared_ptr<const SuppressionDictionary>,
+              GetSuppressionDictionary, (), (const, override));
 };
 
 class MockCallback : public DictionaryInterface::Callback {
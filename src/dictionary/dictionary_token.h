@@ -70,6 +70,46 @@ struct Token {
   AttributesBitfield attributes = NONE;
 };
 
+// Non-owning view of a Token passed to DictionaryInterface::Callback. The key
+// and value point to buffers owned by the dictionary or by the lookup, and
+// are valid only during the callback. Consumers keeping the token copy it with
+// ToToken() or CopyTo().
+struct TokenView {
+  TokenView() = default;
+  TokenView(absl::string_view k, absl::string_view v, int c, uint16_t l,
+            uint16_t r, Token::AttributesBitfield a)
+      : key(k), value(v), cost(c), lid(l), rid(r), attributes(a) {}
+  // Implicit so that a Token can be passed where a view is expected.
+  TokenView(const Token& token)  // NOLINT(runtime/explicit)
+      : key(token.key),
+        value(token.value),
+        cost(token.cost),
+        lid(token.lid),
+        rid(token.rid),
+        attributes(token.attributes) {}
+
+  Token ToToken() const {
+    return Token(key, value, cost, lid, rid, attributes);
+  }
+
+  // Copies the view to `token` reusing its string buffers.
+  void CopyTo(Token* token) const {
+    token->key.assign(key.data(), key.size());
+    token->value.assign(value.data(), value.size());
+    token->cost = cost;
+    token->lid = lid;
+    token->rid = rid;
+    token->attributes = attributes;
+  }
+
+  absl::string_view key;
+  absl::string_view value;
+  int cost = 0;
+  uint16_t lid = 0;
+  uint16_t rid = 0;
+  Token::AttributesBitfield attributes = Token::NONE;
+};
+
 }  // namespace dictionary
 }  // namespace mozc
 
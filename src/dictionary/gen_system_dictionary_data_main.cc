@@ -34,21 +34,28 @@
 //  --output="output.h"
 //  --make_header
 
+#include <algorithm>
+#include <cstdint>
 #include <ios>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "base/file_stream.h"
 #include "base/init_mozc.h"
+#include "base/thread_pool.h"
 #include "data_manager/data_manager.h"
 #include "dictionary/pos_matcher.h"
 #include "dictionary/system/system_dictionary_builder.h"
@@ -57,6 +64,9 @@
 ABSL_FLAG(std::string, input, "", "space separated input text files");
 ABSL_FLAG(std::string, user_pos_manager_data, "", "user pos manager data");
 ABSL_FLAG(std::string, output, "", "output binary file");
+ABSL_FLAG(int32_t, num_threads, 0,
+          "number of threads used to build the dictionary. 0 means the number "
+          "of the hardware threads.");
 
 namespace mozc {
 namespace {
@@ -111,11 +121,25 @@ int main(int argc, char** argv) {
   const mozc::dictionary::PosMatcher pos_matcher(
       data_manager.value()->GetPosMatcherData());
 
+  int num_threads = absl::GetFlag(FLAGS_num_threads);
+  if (num_threads <= 0) {
+    num_threads = std::max<int>(1, std::thread::hardware_concurrency());
+  }
+  mozc::ThreadPool pool(num_threads);
+
+  absl::Time start = absl::Now();
   mozc::dictionary::TextDictionaryLoader loader(pos_matcher);
+  loader.set_thread_pool(&pool);
   loader.Load(system_dictionary_input, reading_correction_input);
+  LOG(INFO) << "Loaded " << loader.tokens().size() << " tokens in "
+            << absl::Now() - start;
 
+  start = absl::Now();
   mozc::dictionary::SystemDictionaryBuilder builder;
+  builder.set_thread_pool(&pool);
   builder.BuildFromTokens(loader.tokens());
+  LOG(INFO) << "Built the dictionary with " << num_threads << " threads in "
+            << absl::Now() - start;
 
   auto output_stream = std::make_unique<mozc::OutputFileStream>(
       absl::GetFlag(FLAGS_output), std::ios::out | std::ios::binary);
@@ -0,0 +1,83 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dictionary/lookup_benchmark_util.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/strings/unicode.h"
+#include "benchmark/benchmark.h"
+#include "testing/allocation_counter.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+template <typename String>
+std::vector<std::string> MakeSuffixesImpl(absl::Span<const String> keys) {
+  std::vector<std::string> suffixes;
+  for (absl::string_view key : keys) {
+    while (!key.empty()) {
+      suffixes.emplace_back(key);
+      key.remove_prefix(strings::OneCharLen(key.front()));
+    }
+  }
+  return suffixes;
+}
+
+}  // namespace
+
+std::vector<std::string> MakeSuffixes(absl::Span<const std::string> keys) {
+  return MakeSuffixesImpl(keys);
+}
+
+std::vector<std::string> MakeSuffixes(
+    absl::Span<const absl::string_view> keys) {
+  return MakeSuffixesImpl(keys);
+}
+
+void SetLookupCounters(benchmark::State& state, int64_t num_lookups,
+                       const CountingCallback& callback,
+                       const testing::AllocationCounter& allocations) {
+  state.counters["lookup_time"] = benchmark::Counter(
+      num_lookups, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["tokens"] = benchmark::Counter(
+      callback.num_tokens(), benchmark::Counter::kIsRate);
+  state.counters["tokens/lookup"] =
+      static_cast<double>(callback.num_tokens()) / num_lookups;
+  state.counters["allocs/lookup"] =
+      static_cast<double>(allocations.num_allocations()) / num_lookups;
+}
+
+}  // namespace dictionary
+}  // namespace mozc
@@ -0,0 +1,131 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Key corpora and helpers shared by the dictionary lookup benchmarks.
+
+#ifndef MOZC_DICTIONARY_LOOKUP_BENCHMARK_UTIL_H_
+#define MOZC_DICTIONARY_LOOKUP_BENCHMARK_UTIL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "dictionary/dictionary_interface.h"
+#include "dictionary/dictionary_token.h"
+#include "testing/allocation_counter.h"
+
+namespace mozc {
+namespace dictionary {
+
+// Keys typed at the beginning of a word. Typical for suggestion.
+inline constexpr absl::string_view kShortPrefixes[] = {
+    "あ",     "か",     "さ",     "き",       "こう",     "しょ",
+    "わたし", "にほん", "とうき", "かいしゃ", "でんわ",   "よろし",
+    "おね",   "ありが", "すみ",   "けんき",   "じかん",   "せつめい",
+};
+
+// Whole sentences. Prefix lookups are issued at every character position, as
+// ImmutableConverter::MakeLattice does.
+inline constexpr absl::string_view kSentences[] = {
+    "わたしのなまえはなかのです",
+    "きょうはいいてんきですね",
+    "あしたのかいぎはごごさんじからです",
+    "にほんごにゅうりょくのへんかんせいどをたかめる",
+    "このたびはごめいわくをおかけしてもうしわけありません",
+    "とうきょうとちよだくにあるかいしゃにでんしゃでかよっています",
+};
+
+// Counts visited keys and tokens without copying the tokens. Never stops the
+// traversal.
+class CountingCallback : public DictionaryInterface::Callback {
+ public:
+  explicit CountingCallback(bool kana_modifier_insensitive)
+      : kana_modifier_insensitive_(kana_modifier_insensitive) {}
+
+  ResultType OnKey(absl::string_view key) override {
+    ++num_keys_;
+    return TRAVERSE_CONTINUE;
+  }
+
+  ResultType OnTokenView(absl::string_view key, absl::string_view actual_key,
+                         const TokenView& token) override {
+    ++num_tokens_;
+    benchmark::DoNotOptimize(token.cost);
+    return TRAVERSE_CONTINUE;
+  }
+
+  bool IsKanaModifierInsensitiveConversion() const override {
+    return kana_modifier_insensitive_;
+  }
+
+  int64_t num_keys() const { return num_keys_; }
+  int64_t num_tokens() const { return num_tokens_; }
+
+ private:
+  const bool kana_modifier_insensitive_;
+  int64_t num_keys_ = 0;
+  int64_t num_tokens_ = 0;
+};
+
+// Returns all the suffixes of `keys` starting at character boundaries.
+std::vector<std::string> MakeSuffixes(absl::Span<const std::string> keys);
+std::vector<std::string> MakeSuffixes(
+    absl::Span<const absl::string_view> keys);
+
+// Sets the lookup time, the visited tokens and the heap allocations per
+// lookup to the counters of `state`.
+void SetLookupCounters(benchmark::State& state, int64_t num_lookups,
+                       const CountingCallback& callback,
+                       const testing::AllocationCounter& allocations);
+
+// Runs `lookup(dictionary, key, &callback)` on each key of `keys` in every
+// iteration, and sets the counters.
+template <typename Dictionary, typename Lookup>
+void RunLookups(benchmark::State& state, const Dictionary& dictionary,
+                absl::Span<const std::string> keys,
+                bool kana_modifier_insensitive, Lookup lookup) {
+  CountingCallback callback(kana_modifier_insensitive);
+  testing::AllocationCounter allocations;
+  int64_t num_lookups = 0;
+  for (auto _ : state) {
+    for (const std::string& key : keys) {
+      lookup(dictionary, key, &callback);
+    }
+    num_lookups += keys.size();
+  }
+  SetLookupCounters(state, num_lookups, callback, allocations);
+}
+
+}  // namespace dictionary
+}  // namespace mozc
+
+#endif  // MOZC_DICTIONARY_LOOKUP_BENCHMARK_UTIL_H_
@@ -86,10 +86,10 @@ void SuffixDictionary::LookupPredictive(absl::string_view key,
         return x.substr(0, key.size()) < y.substr(0, key.size());
       });
 
-  Token token;
+  TokenView token;
   token.attributes = Token::SUFFIX_DICTIONARY;
   for (auto it = begin; it != end; ++it) {
-    token.key.assign((*it).data(), (*it).size());
+    token.key = *it;
     switch (callback->OnKey(token.key)) {
       case Callback::TRAVERSE_DONE:
         return;
@@ -105,12 +105,8 @@ void SuffixDictionary::LookupPredictive(absl::string_view key,
       return;
     }
     const size_t index = it - key_array_.begin();
-    if (value_array_[index].empty()) {
-      token.value = token.key;
-    } else {
-      token.value.assign(value_array_[index].data(),
-                         value_array_[index].size());
-    }
+    token.value =
+        value_array_[index].empty() ? token.key : value_array_[index];
 
     // Invalid index.
     if (index >= token_array_.size()) break;
@@ -119,7 +115,7 @@ void SuffixDictionary::LookupPredictive(absl::string_view key,
     token.lid = data.lid;
     token.rid = data.rid;
     token.cost = data.cost;
-    if (callback->OnToken(token.key, token.key, token) !=
+    if (callback->OnTokenView(token.key, token.key, token) !=
         Callback::TRAVERSE_CONTINUE) {
       break;
     }
@@ -0,0 +1,93 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_DICTIONARY_SUPPRESSION_DICTIONARY_H_
+#define MOZC_DICTIONARY_SUPPRESSION_DICTIONARY_H_
+
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+
+namespace mozc {
+namespace dictionary {
+
+// A set of the words suppressed by the user dictionary. The entries are added
+// while the user dictionary is loaded and the set is immutable afterwards.
+// UserDictionary publishes it through a shared pointer on every reload, so
+// readers can check many words against one snapshot without any lock or
+// allocation.
+class SuppressionDictionary {
+ public:
+  SuppressionDictionary() = default;
+
+  SuppressionDictionary(const SuppressionDictionary&) = delete;
+  SuppressionDictionary& operator=(const SuppressionDictionary&) = delete;
+
+  SuppressionDictionary(SuppressionDictionary&&) = default;
+  SuppressionDictionary& operator=(SuppressionDictionary&&) = default;
+
+  // Adds an entry. An empty `key` suppresses `value` with any key and vice
+  // versa. Returns false if both are empty.
+  bool AddEntry(std::string key, std::string value);
+
+  bool IsEmpty() const {
+    return keys_only_.empty() && values_only_.empty() && keys_values_.empty();
+  }
+
+  bool IsSuppressedEntry(absl::string_view key, absl::string_view value) const {
+    // Each set is checked only when it's not empty to save the hashing.
+    return (!keys_values_.empty() &&
+            keys_values_.contains(std::make_pair(key, value))) ||
+           (!keys_only_.empty() && keys_only_.contains(key)) ||
+           (!values_only_.empty() && values_only_.contains(value));
+  }
+
+ private:
+  using KeyValue = std::pair<std::string, std::string>;
+  using KeyValueView = std::pair<absl::string_view, absl::string_view>;
+  struct KeyValueHash : public absl::Hash<KeyValueView> {
+    using is_transparent = void;
+  };
+  struct KeyValueEq : public std::equal_to<KeyValueView> {
+    using is_transparent = void;
+  };
+
+  absl::flat_hash_set<KeyValue, KeyValueHash, KeyValueEq> keys_values_;
+  absl::flat_hash_set<std::string> keys_only_;
+  absl::flat_hash_set<std::string> values_only_;
+};
+
+}  // namespace dictionary
+}  // namespace mozc
+
+#endif  // MOZC_DICTIONARY_SUPPRESSION_DICTIONARY_H_
@@ -0,0 +1,67 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dictionary/suppression_dictionary.h"
+
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+TEST(SuppressionDictionaryTest, IsSuppressedEntry) {
+  SuppressionDictionary dic;
+  EXPECT_TRUE(dic.IsEmpty());
+  EXPECT_FALSE(dic.IsSuppressedEntry("key", "value"));
+
+  EXPECT_FALSE(dic.AddEntry("", ""));
+  EXPECT_TRUE(dic.IsEmpty());
+
+  EXPECT_TRUE(dic.AddEntry("key1", "value1"));
+  EXPECT_TRUE(dic.AddEntry("key2", ""));
+  EXPECT_TRUE(dic.AddEntry("", "value3"));
+  EXPECT_FALSE(dic.IsEmpty());
+
+  EXPECT_TRUE(dic.IsSuppressedEntry("key1", "value1"));
+  EXPECT_FALSE(dic.IsSuppressedEntry("key1", "value2"));
+  EXPECT_FALSE(dic.IsSuppressedEntry("key", "value1"));
+
+  // Key-only entry suppresses every value of the key.
+  EXPECT_TRUE(dic.IsSuppressedEntry("key2", "value1"));
+  EXPECT_TRUE(dic.IsSuppressedEntry("key2", "value2"));
+
+  // Value-only entry suppresses the value with any key.
+  EXPECT_TRUE(dic.IsSuppressedEntry("key1", "value3"));
+  EXPECT_TRUE(dic.IsSuppressedEntry("key", "value3"));
+  EXPECT_FALSE(dic.IsSuppressedEntry("key", "value"));
+}
+
+}  // namespace
+}  // namespace dictionary
+}  // namespace mozc
@@ -614,6 +614,13 @@ std::string SystemDictionaryCodec::EncodeValue(absl::string_view src) const {
 
 std::string SystemDictionaryCodec::DecodeValue(absl::string_view src) const {
   std::string dst;
+  DecodeValue(src, &dst);
+  return dst;
+}
+
+void SystemDictionaryCodec::DecodeValue(absl::string_view src,
+                                        std::string* dst) const {
+  dst->clear();
   const uint8_t* p = reinterpret_cast<const uint8_t*>(src.data());
   const uint8_t* const end = p + src.size();
   while (p < end) {
@@ -659,9 +666,8 @@ std::string SystemDictionaryCodec::DecodeValue(absl::string_view src) const {
     } else {
       MOZC_VLOG(1) << "should never come here";
     }
-    Util::CodepointToUtf8Append(c, &dst);
+    Util::CodepointToUtf8Append(c, dst);
   }
-  return dst;
 }
 
 uint8_t SystemDictionaryCodec::GetTokensTerminationFlag() const {
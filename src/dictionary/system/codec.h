@@ -77,6 +77,9 @@ class SystemDictionaryCodec {
   // Decompress value string
   virtual std::string DecodeValue(absl::string_view src) const;
 
+  // Decompress value string to `dst`, reusing its buffer.
+  virtual void DecodeValue(absl::string_view src, std::string* dst) const;
+
   // Compress tokens
   virtual std::string EncodeTokens(absl::Span<const TokenInfo> tokens) const;
 
@@ -83,12 +83,14 @@
 #include "dictionary/system/words_info.h"
 #include "storage/louds/bit_vector_based_array.h"
 #include "storage/louds/louds_trie.h"
+#include "storage/louds/simple_succinct_bit_vector_index.h"
 
 namespace mozc {
 namespace dictionary {
 
 using ::mozc::storage::louds::BitVectorBasedArray;
 using ::mozc::storage::louds::LoudsTrie;
+using ::mozc::storage::louds::SimpleSuccinctBitVectorIndex;
 
 namespace {
 
@@ -109,6 +111,11 @@ constexpr size_t kValueTrieSelect0CacheSize = 1 * 1024;
 constexpr size_t kValueTrieSelect1CacheSize = 16 * 1024;
 constexpr size_t kValueTrieTermvecCacheSize = 4 * 1024;
 
+// The select-heavy traversal of the tries is faster with the rank9 index. The
+// lower bound cache sizes above are not used with it.
+constexpr SimpleSuccinctBitVectorIndex::IndexType kTrieIndexType =
+    SimpleSuccinctBitVectorIndex::RANK9_INDEX;
+
 // Expansion table format:
 // "<Character to expand>[<Expanded character 1><Expanded character 2>...]"
 //
@@ -456,7 +463,7 @@ bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
   if (!key_trie_.Open(reinterpret_cast<const uint8_t*>(key_image->data()),
                       kKeyTrieLb0CacheSize, kKeyTrieLb1CacheSize,
                       kKeyTrieSelect0CacheSize, kKeyTrieSelect1CacheSize,
-                      kKeyTrieTermvecCacheSize)) {
+                      kKeyTrieTermvecCacheSize, kTrieIndexType)) {
     LOG(ERROR) << "cannot open key trie";
     return false;
   }
@@ -466,7 +473,7 @@ bool SystemDictionary::OpenDictionaryFile(bool enable_reverse_lookup_index) {
   if (!value_trie_.Open(reinterpret_cast<const uint8_t*>(value_image->data()),
                         kValueTrieLb0CacheSize, kValueTrieLb1CacheSize,
                         kValueTrieSelect0CacheSize, kValueTrieSelect1CacheSize,
-                        kValueTrieTermvecCacheSize)) {
+                        kValueTrieTermvecCacheSize, kTrieIndexType)) {
     LOG(ERROR) << "can not open value trie";
     return false;
   }
@@ -493,6 +500,13 @@ bool SystemDictionary::HasKey(absl::string_view key) const {
   return key_trie_.HasKey(codec_->EncodeKey(key));
 }
 
+bool SystemDictionary::MayHaveKeyWithPrefix(absl::string_view prefix) const {
+  // Keys are encoded character by character, so the encoded prefix is a
+  // prefix of the encoded keys.
+  LoudsTrie::Node node;  // Root
+  return key_trie_.Traverse(codec_->EncodeKey(prefix), &node);
+}
+
 bool SystemDictionary::HasValue(absl::string_view value) const {
   if (value_trie_.HasKey(codec_->EncodeValue(value))) {
     return true;
@@ -528,11 +542,11 @@ bool SystemDictionary::HasValue(absl::string_view value) const {
   const uint8_t* encoded_tokens_ptr = GetTokenArrayPtr(token_array_, key_id);
 
   // Check tokens.
+  TokenDecodeIterator::Buffer token_buffer;
   for (TokenDecodeIterator iter(*codec_, value_trie_, frequent_pos_, key,
-                                encoded_tokens_ptr);
+                                encoded_tokens_ptr, &token_buffer);
        !iter.Done(); iter.Next()) {
-    const Token* token = iter.Get().token;
-    if (value == token->value) {
+    if (value == iter.GetView().value) {
       return true;
     }
   }
@@ -633,6 +647,7 @@ void SystemDictionary::LookupPredictive(absl::string_view key,
 
   // Reused buffer and instances inside the following loop.
   char encoded_actual_key_buffer[LoudsTrie::kMaxDepth + 1];
+  TokenDecodeIterator::Buffer token_buffer;
   std::string decoded_key, actual_key_str;
   decoded_key.reserve(key.size() * 2);
   actual_key_str.reserve(key.size() * 2);
@@ -687,11 +702,11 @@ void SystemDictionary::LookupPredictive(absl::string_view key,
     const int key_id = key_trie_.GetKeyIdOfTerminalNode(state.node);
     for (TokenDecodeIterator iter(*codec_, value_trie_, frequent_pos_,
                                   actual_key,
-                                  GetTokenArrayPtr(token_array_, key_id));
+                                  GetTokenArrayPtr(token_array_, key_id),
+                                  &token_buffer);
          !iter.Done(); iter.Next()) {
-      const TokenInfo& token_info = iter.Get();
       const Callback::ResultType result =
-          callback->OnToken(decoded_key, actual_key, *token_info.token);
+          callback->OnTokenView(decoded_key, actual_key, iter.GetView());
       if (result == Callback::TRAVERSE_DONE) {
         return;
       }
@@ -717,8 +732,9 @@ namespace {
 //   callback:
 //     A callback function to be called.
 //   token_filter:
-//     A functor of signature bool(const TokenInfo &).  Only tokens for which
-//     this functor returns true are passed to callback function.
+//     A functor of signature bool(const TokenInfo &, const TokenView &).  Only
+//     tokens for which this functor returns true are passed to callback
+//     function.
 template <typename Func>
 void RunCallbackOnEachPrefix(
     const LoudsTrie& key_trie, const LoudsTrie& value_trie,
@@ -727,6 +743,7 @@ void RunCallbackOnEachPrefix(
     absl::string_view encoded_key, DictionaryInterface::Callback* callback,
     Func token_filter) {
   typedef DictionaryInterface::Callback Callback;
+  TokenDecodeIterator::Buffer token_buffer;
   LoudsTrie::Node node;
   for (absl::string_view::size_type i = 0; i < encoded_key.size();) {
     if (!key_trie.MoveToChildByLabel(encoded_key[i], &node)) {
@@ -762,14 +779,15 @@ void RunCallbackOnEachPrefix(
 
     const int key_id = key_trie.GetKeyIdOfTerminalNode(node);
     for (TokenDecodeIterator iter(codec, value_trie, frequent_pos, prefix,
-                                  GetTokenArrayPtr(token_array, key_id));
+                                  GetTokenArrayPtr(token_array, key_id),
+                                  &token_buffer);
          !iter.Done(); iter.Next()) {
-      const TokenInfo& token_info = iter.Get();
-      if (!token_filter(token_info)) {
+      const TokenView token = iter.GetView();
+      if (!token_filter(iter.Get(), token)) {
         continue;
       }
       const Callback::ResultType res =
-          callback->OnToken(prefix, prefix, *token_info.token);
+          callback->OnTokenView(prefix, prefix, token);
       if (res == Callback::TRAVERSE_DONE || res == Callback::TRAVERSE_CULL) {
         return;
       }
@@ -785,12 +803,12 @@ class ReverseLookupCallbackWrapper : public DictionaryInterface::Callback {
   explicit ReverseLookupCallbackWrapper(DictionaryInterface::Callback* callback)
       : callback_(callback) {}
   ~ReverseLookupCallbackWrapper() override = default;
-  SystemDictionary::Callback::ResultType OnToken(absl::string_view key,
-                                                 absl::string_view actual_key,
-                                                 const Token& token) override {
-    Token modified_token = token;
-    modified_token.key.swap(modified_token.value);
-    return callback_->OnToken(key, actual_key, modified_token);
+  SystemDictionary::Callback::ResultType OnTokenView(
+      absl::string_view key, absl::string_view actual_key,
+      const TokenView& token) override {
+    TokenView modified_token = token;
+    std::swap(modified_token.key, modified_token.value);
+    return callback_->OnTokenView(key, actual_key, modified_token);
   }
 
   DictionaryInterface::Callback* callback_;
@@ -828,7 +846,8 @@ SystemDictionary::LookupPrefixWithKeyExpansionImpl(
     absl::string_view key, absl::string_view encoded_key,
     const KeyExpansionTable& table, Callback* callback, LoudsTrie::Node node,
     absl::string_view::size_type key_pos, int num_expanded,
-    char* actual_key_buffer, std::string* actual_prefix) const {
+    char* actual_key_buffer, std::string* actual_prefix,
+    TokenDecodeIterator::Buffer* token_buffer) const {
   // This do-block handles a terminal node and callback.  do-block is used to
   // break the block and continue to the subsequent traversal phase.
   do {
@@ -862,10 +881,10 @@ SystemDictionary::LookupPrefixWithKeyExpansionImpl(
     const int key_id = key_trie_.GetKeyIdOfTerminalNode(node);
     for (TokenDecodeIterator iter(*codec_, value_trie_, frequent_pos_,
                                   *actual_prefix,
-                                  GetTokenArrayPtr(token_array_, key_id));
+                                  GetTokenArrayPtr(token_array_, key_id),
+                                  token_buffer);
          !iter.Done(); iter.Next()) {
-      const TokenInfo& token_info = iter.Get();
-      result = callback->OnToken(prefix, *actual_prefix, *token_info.token);
+      result = callback->OnTokenView(prefix, *actual_prefix, iter.GetView());
       if (result == Callback::TRAVERSE_DONE ||
           result == Callback::TRAVERSE_CULL) {
         return result;
@@ -892,7 +911,7 @@ SystemDictionary::LookupPrefixWithKeyExpansionImpl(
     const Callback::ResultType result = LookupPrefixWithKeyExpansionImpl(
         key, encoded_key, table, callback, node, key_pos + 1,
         num_expanded + static_cast<int>(c != current_char), actual_key_buffer,
-        actual_prefix);
+        actual_prefix, token_buffer);
     if (result == Callback::TRAVERSE_DONE) {
       return Callback::TRAVERSE_DONE;
     }
@@ -909,16 +928,20 @@ void SystemDictionary::LookupPrefix(absl::string_view key,
     RunCallbackOnEachPrefix(key_trie_, value_trie_, token_array_, *codec_,
                             frequent_pos_, key.data(), encoded_key, callback,
                             // Select all tokens.
-                            [](const TokenInfo& token_info) { return true; });
+                            [](const TokenInfo& token_info,
+                               const TokenView& token) { return true; });
     return;
   }
 
   char actual_key_buffer[LoudsTrie::kMaxDepth + 1];
   std::string actual_prefix;
   actual_prefix.reserve(key.size() * 3);
-  LookupPrefixWithKeyExpansionImpl(
-      key.data(), encoded_key, hiragana_expansion_table_, callback,
-      LoudsTrie::Node(), 0, false, actual_key_buffer, &actual_prefix);
+  TokenDecodeIterator::Buffer token_buffer;
+  LookupPrefixWithKeyExpansionImpl(key.data(), encoded_key,
+                                   hiragana_expansion_table_, callback,
+                                   LoudsTrie::Node(), 0, false,
+                                   actual_key_buffer, &actual_prefix,
+                                   &token_buffer);
 }
 
 void SystemDictionary::LookupExact(absl::string_view key,
@@ -936,10 +959,12 @@ void SystemDictionary::LookupExact(absl::string_view key,
     return;
   }
   // Callback on each token.
+  TokenDecodeIterator::Buffer token_buffer;
   for (TokenDecodeIterator iter(*codec_, value_trie_, frequent_pos_, key,
-                                GetTokenArrayPtr(token_array_, key_id));
+                                GetTokenArrayPtr(token_array_, key_id),
+                                &token_buffer);
        !iter.Done(); iter.Next()) {
-    if (callback->OnToken(key, key, *iter.Get().token) !=
+    if (callback->OnTokenView(key, key, iter.GetView()) !=
         Callback::TRAVERSE_CONTINUE) {
       break;
     }
@@ -1005,17 +1030,17 @@ void SystemDictionary::RegisterReverseLookupTokensForT13N(
   prev_value.reserve(LoudsTrie::kMaxDepth * 3);
   RunCallbackOnEachPrefix(
       key_trie_, value_trie_, token_array_, *codec_, frequent_pos_,
-      hiragana_value, encoded_key, callback, [&](const TokenInfo& token_info) {
+      hiragana_value, encoded_key, callback,
+      [&](const TokenInfo& token_info, const TokenView& token) {
         // Skip spelling corrections.
-        if (token_info.token->attributes & Token::SPELLING_CORRECTION) {
+        if (token.attributes & Token::SPELLING_CORRECTION) {
           return false;
         }
         if (token_info.value_type != TokenInfo::AS_IS_HIRAGANA &&
             token_info.value_type != TokenInfo::AS_IS_KATAKANA) {
           // SAME_AS_PREV_VALUE may be t13n token.
-          prev_value =
-              japanese_util::KatakanaToHiragana(token_info.token->value);
-          if (token_info.token->key != prev_value) {
+          prev_value = japanese_util::KatakanaToHiragana(token.value);
+          if (token.key != prev_value) {
             return false;
           }
         }
@@ -1068,6 +1093,7 @@ void SystemDictionary::RegisterReverseLookupResults(
     Callback* callback) const {
   const uint8_t* encoded_tokens_ptr = GetTokenArrayPtr(token_array_, 0);
   char buffer[LoudsTrie::kMaxDepth + 1];
+  TokenDecodeIterator::Buffer token_buffer;
   for (const int value_id : id_set) {
     const auto range = cache.results.equal_range(value_id);
     for (auto result_itr = range.first; result_itr != range.second;
@@ -1082,14 +1108,15 @@ void SystemDictionary::RegisterReverseLookupResults(
       }
       for (TokenDecodeIterator iter(
                *codec_, value_trie_, frequent_pos_, tokens_key,
-               encoded_tokens_ptr + reverse_result.tokens_offset);
+               encoded_tokens_ptr + reverse_result.tokens_offset,
+               &token_buffer);
            !iter.Done(); iter.Next()) {
         const TokenInfo& token_info = iter.Get();
         if (token_info.token->attributes & Token::SPELLING_CORRECTION ||
             token_info.id_in_value_trie != value_id) {
           continue;
         }
-        callback->OnToken(tokens_key, tokens_key, *token_info.token);
+        callback->OnTokenView(tokens_key, tokens_key, iter.GetView());
       }
     }
   }
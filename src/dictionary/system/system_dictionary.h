@@ -46,6 +46,7 @@
 #include "dictionary/file/dictionary_file.h"
 #include "dictionary/system/codec.h"
 #include "dictionary/system/key_expansion_table.h"
+#include "dictionary/system/token_decode_iterator.h"
 #include "storage/louds/bit_vector_based_array.h"
 #include "storage/louds/louds_trie.h"
 
@@ -120,6 +121,7 @@ class SystemDictionary : public DictionaryInterface {
 
   // Implementation of DictionaryInterface.
   bool HasKey(absl::string_view key) const override;
+  bool MayHaveKeyWithPrefix(absl::string_view prefix) const override;
   bool HasValue(absl::string_view value) const override;
 
   void LookupPredictive(absl::string_view key,
@@ -160,7 +162,8 @@ class SystemDictionary : public DictionaryInterface {
       const KeyExpansionTable& table, Callback* callback,
       storage::louds::LoudsTrie::Node node,
       absl::string_view::size_type key_pos, int num_expanded,
-      char* actual_key_buffer, std::string* actual_prefix) const;
+      char* actual_key_buffer, std::string* actual_prefix,
+      TokenDecodeIterator::Buffer* token_buffer) const;
 
   void CollectPredictiveNodesInBfsOrder(
       absl::string_view encoded_key, const KeyExpansionTable& table,
@@ -27,3 +27,158 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+// Microbenchmarks for SystemDictionary lookups on the OSS dataset.
+//
+// The benchmarks replay hiragana key corpora through LookupPrefix,
+// LookupPredictive, LookupExact and LookupReverse, and report the time per
+// lookup, the number of visited tokens per second and the number of heap
+// allocations per lookup.
+//
+// Example:
+//   bazel run -c opt //dictionary/system:system_dictionary_benchmark --
+//     --benchmark_filter=LookupPrefix --key_corpus=/path/to/keys.txt
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "base/file_util.h"
+#include "base/strings/unicode.h"
+#include "benchmark/benchmark.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "dictionary/dictionary_interface.h"
+#include "dictionary/lookup_benchmark_util.h"
+#include "dictionary/system/system_dictionary.h"
+
+ABSL_FLAG(std::string, key_corpus, "",
+          "Optional file of hiragana keys (one key per line) used in addition "
+          "to the built-in corpora.");
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+// Keys whose lookups hit KeyExpansionTable, e.g. "はは" -> "ばば", "ぱぱ" and
+// "かつこう" -> "かっこう".
+constexpr absl::string_view kExpansionKeys[] = {
+    "はは",     "かつこう", "しよう", "ひよう",   "きつて",
+    "はつはん", "つくえ",   "よやく", "しゆつちよう", "ふあん",
+};
+
+// Values for reverse lookup.
+constexpr absl::string_view kValues[] = {
+    "私", "名前", "今日", "天気", "会議", "日本語", "東京都", "会社", "電話",
+};
+
+const SystemDictionary& GetSystemDictionary() {
+  static const SystemDictionary* dictionary = [] {
+    static const oss::OssDataManager* data_manager = new oss::OssDataManager();
+    const absl::string_view image = data_manager->GetSystemDictionaryData();
+    absl::StatusOr<std::unique_ptr<SystemDictionary>> result =
+        SystemDictionary::Builder(image.data(), image.size()).Build();
+    CHECK_OK(result);
+    return result->release();
+  }();
+  return *dictionary;
+}
+
+// Returns the keys in `keys` followed by the keys in --key_corpus.
+template <size_t N>
+std::vector<std::string> MakeCorpus(const absl::string_view (&keys)[N]) {
+  std::vector<std::string> corpus(std::begin(keys), std::end(keys));
+  const std::string path = absl::GetFlag(FLAGS_key_corpus);
+  if (!path.empty()) {
+    absl::StatusOr<std::string> content = FileUtil::GetContents(path);
+    CHECK_OK(content) << path;
+    for (absl::string_view line :
+         absl::StrSplit(*content, '\n', absl::SkipWhitespace())) {
+      corpus.emplace_back(absl::StripAsciiWhitespace(line));
+    }
+  }
+  return corpus;
+}
+
+void LookupPrefix(const SystemDictionary& dictionary, absl::string_view key,
+                  DictionaryInterface::Callback* callback) {
+  dictionary.LookupPrefix(key, callback);
+}
+
+void LookupPredictive(const SystemDictionary& dictionary,
+                      absl::string_view key,
+                      DictionaryInterface::Callback* callback) {
+  dictionary.LookupPredictive(key, callback);
+}
+
+void LookupExact(const SystemDictionary& dictionary, absl::string_view key,
+                 DictionaryInterface::Callback* callback) {
+  dictionary.LookupExact(key, callback);
+}
+
+void LookupReverse(const SystemDictionary& dictionary, absl::string_view key,
+                   DictionaryInterface::Callback* callback) {
+  dictionary.LookupReverse(key, callback);
+}
+
+void BM_LookupPrefixSentence(benchmark::State& state) {
+  const std::vector<std::string> keys =
+      MakeSuffixes(MakeCorpus(kSentences));
+  RunLookups(state, GetSystemDictionary(), keys, state.range(0),
+             LookupPrefix);
+}
+BENCHMARK(BM_LookupPrefixSentence)->ArgName("expansion")->Arg(0)->Arg(1);
+
+void BM_LookupPrefixExpansion(benchmark::State& state) {
+  const std::vector<std::string> keys = MakeCorpus(kExpansionKeys);
+  RunLookups(state, GetSystemDictionary(), keys, state.range(0),
+             LookupPrefix);
+}
+BENCHMARK(BM_LookupPrefixExpansion)->ArgName("expansion")->Arg(0)->Arg(1);
+
+void BM_LookupPredictiveShortPrefix(benchmark::State& state) {
+  const std::vector<std::string> keys = MakeCorpus(kShortPrefixes);
+  RunLookups(state, GetSystemDictionary(), keys, state.range(0),
+             LookupPredictive);
+}
+BENCHMARK(BM_LookupPredictiveShortPrefix)
+    ->ArgName("expansion")
+    ->Arg(0)
+    ->Arg(1);
+
+void BM_LookupPredictiveExpansion(benchmark::State& state) {
+  const std::vector<std::string> keys = MakeCorpus(kExpansionKeys);
+  RunLookups(state, GetSystemDictionary(), keys, state.range(0),
+             LookupPredictive);
+}
+BENCHMARK(BM_LookupPredictiveExpansion)->ArgName("expansion")->Arg(0)->Arg(1);
+
+void BM_LookupExact(benchmark::State& state) {
+  // Exact lookups with all the prefixes of the sentences, most of which miss.
+  std::vector<std::string> keys;
+  for (const std::string& sentence : MakeCorpus(kSentences)) {
+    for (size_t pos = 0; pos < sentence.size();) {
+      pos += strings::OneCharLen(sentence[pos]);
+      keys.push_back(sentence.substr(0, pos));
+    }
+  }
+  RunLookups(state, GetSystemDictionary(), keys, false, LookupExact);
+}
+BENCHMARK(BM_LookupExact);
+
+void BM_LookupReverse(benchmark::State& state) {
+  const std::vector<std::string> values(std::begin(kValues),
+                                        std::end(kValues));
+  RunLookups(state, GetSystemDictionary(), values, false, LookupReverse);
+}
+BENCHMARK(BM_LookupReverse);
+
+}  // namespace
+}  // namespace dictionary
+}  // namespace mozc
@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <ios>
@@ -51,10 +52,13 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "base/file_stream.h"
 #include "base/file_util.h"
 #include "base/japanese_util.h"
+#include "base/thread_pool.h"
 #include "base/util.h"
 #include "base/vlog.h"
 #include "dictionary/dictionary_token.h"
@@ -83,6 +87,14 @@ void WriteSectionToFile(const DictionaryFileSection& section,
   }
 }
 
+// Runs `phase` and logs the elapsed time.
+template <typename Phase>
+void RunPhase(absl::string_view name, Phase phase) {
+  const absl::Time start = absl::Now();
+  phase();
+  LOG(INFO) << name << ": " << absl::Now() - start;
+}
+
 }  // namespace
 
 void SystemDictionaryBuilder::BuildFromTokens(
@@ -97,20 +109,37 @@ void SystemDictionaryBuilder::BuildFromTokens(
 
 void SystemDictionaryBuilder::BuildFromTokensInternal(
     std::vector<Token*> tokens) {
-  KeyInfoList key_info_list = ReadTokens(std::move(tokens));
+  const absl::Time start = absl::Now();
+  KeyInfoList key_info_list;
+  RunPhase("ReadTokens",
+           [&] { key_info_list = ReadTokens(std::move(tokens)); });
 
-  BuildFrequentPos(key_info_list);
-  BuildValueTrie(key_info_list);
-  BuildKeyTrie(key_info_list);
+  RunPhase("BuildFrequentPos", [&] { BuildFrequentPos(key_info_list); });
+  RunPhase("BuildTries", [&] { BuildTries(key_info_list); });
 
-  SetIdForValue(&key_info_list);
-  SetIdForKey(&key_info_list);
-  SortTokenInfo(&key_info_list);
-  SetCostType(&key_info_list);
-  SetPosType(&key_info_list);
-  SetValueType(&key_info_list);
+  RunPhase("SetIdForValue", [&] { SetIdForValue(&key_info_list); });
+  RunPhase("SetIdForKey", [&] { SetIdForKey(&key_info_list); });
+  RunPhase("SortTokenInfo", [&] { SortTokenInfo(&key_info_list); });
+  RunPhase("SetCostType", [&] { SetCostType(&key_info_list); });
+  RunPhase("SetPosType", [&] { SetPosType(&key_info_list); });
+  RunPhase("SetValueType", [&] { SetValueType(&key_info_list); });
 
-  BuildTokenArray(key_info_list);
+  RunPhase("BuildTokenArray", [&] { BuildTokenArray(key_info_list); });
+  LOG(INFO) << "Built the system dictionary in " << absl::Now() - start;
+}
+
+template <typename KeyInfoListT, typename Func>
+void SystemDictionaryBuilder::ForEachKeyInfo(KeyInfoListT& key_info_list,
+                                             Func func) const {
+  // A few chunks per thread to balance the load.
+  const size_t num_chunks = pool_ == nullptr ? 1 : pool_->num_threads() * 4;
+  const size_t size = key_info_list.size();
+  ParallelFor(pool_, num_chunks, [&](size_t chunk) {
+    const size_t end = size * (chunk + 1) / num_chunks;
+    for (size_t i = size * chunk / num_chunks; i < end; ++i) {
+      func(key_info_list[i]);
+    }
+  });
 }
 
 void SystemDictionaryBuilder::WriteToFile(absl::string_view output_file) const {
@@ -229,8 +258,8 @@ SystemDictionaryBuilder::KeyInfoList SystemDictionaryBuilder::ReadTokens(
   //    [KeyInfo(key:aaa)[Token 1][Token 2]][KeyInfo(key:abc)[Token 3]][...]
 
   // Step 1.
-  std::stable_sort(
-      tokens.begin(), tokens.end(),
+  ParallelStableSort(
+      pool_, tokens.begin(), tokens.end(),
       [](const Token* l, const Token* r) { return l->key < r->key; });
 
   // Step 2.
@@ -247,9 +276,14 @@ SystemDictionaryBuilder::KeyInfoList SystemDictionaryBuilder::ReadTokens(
       last_key_info.key = token->key;
     }
     last_key_info.tokens.emplace_back(token);
-    last_key_info.tokens.back().value_type = GetValueType(token);
   }
   key_info_list.push_back(std::move(last_key_info));
+
+  ForEachKeyInfo(key_info_list, [](KeyInfo& key_info) {
+    for (TokenInfo& token_info : key_info.tokens) {
+      token_info.value_type = GetValueType(token_info.token);
+    }
+  });
   return key_info_list;
 }
 
@@ -258,13 +292,17 @@ void SystemDictionaryBuilder::BuildFrequentPos(
   // Calculate the frequency of each POS.
   // TODO(toshiyuki): It might be better to count frequency
   // with considering same_as_prev_pos.
-  absl::btree_map<uint32_t, int> pos_map;
+  absl::flat_hash_map<uint32_t, int> pos_count;
   for (const KeyInfo& key_info : key_info_list) {
     for (const TokenInfo& token_info : key_info.tokens) {
       const Token* token = token_info.token;
-      pos_map[GetCombinedPos(token->lid, token->rid)]++;
+      pos_count[GetCombinedPos(token->lid, token->rid)]++;
     }
   }
+  // The indices are assigned in the order of POS.
+  std::vector<std::pair<uint32_t, int>> pos_map(pos_count.begin(),
+                                                pos_count.end());
+  std::sort(pos_map.begin(), pos_map.end());
 
   // Get histgram of frequency.
   absl::btree_map<int, int> freq_map;
@@ -301,33 +339,43 @@ void SystemDictionaryBuilder::BuildFrequentPos(
                << " tokens";
 }
 
-void SystemDictionaryBuilder::BuildValueTrie(const KeyInfoList& key_info_list) {
-  for (const KeyInfo& key_info : key_info_list) {
-    for (const TokenInfo& token_info : key_info.tokens) {
-      if (token_info.value_type == TokenInfo::AS_IS_HIRAGANA ||
-          token_info.value_type == TokenInfo::AS_IS_KATAKANA) {
-        // These values will be stored in token array as flags
-        continue;
+void SystemDictionaryBuilder::BuildTries(const KeyInfoList& key_info_list) {
+  // The value trie and the key trie don't depend on each other.
+  ParallelFor(pool_, 2, [&](size_t i) {
+    if (i == 0) {
+      for (const KeyInfo& key_info : key_info_list) {
+        for (const TokenInfo& token_info : key_info.tokens) {
+          if (token_info.value_type == TokenInfo::AS_IS_HIRAGANA ||
+              token_info.value_type == TokenInfo::AS_IS_KATAKANA) {
+            // These values will be stored in token array as flags
+            continue;
+          }
+          std::string value_str = codec_->EncodeValue(token_info.token->value);
+          value_trie_builder_.Add(std::move(value_str));
+        }
+      }
+      value_trie_builder_.Build();
+    } else {
+      for (const KeyInfo& key_info : key_info_list) {
+        key_trie_builder_.Add(codec_->EncodeKey(key_info.key));
       }
-      std::string value_str = codec_->EncodeValue(token_info.token->value);
-      value_trie_builder_.Add(std::move(value_str));
+      key_trie_builder_.Build();
     }
-  }
-  value_trie_builder_.Build();
+  });
 }
 
 void SystemDictionaryBuilder::SetIdForValue(KeyInfoList* key_info_list) const {
-  for (KeyInfo& key_info : *key_info_list) {
+  ForEachKeyInfo(*key_info_list, [this](KeyInfo& key_info) {
     for (TokenInfo& token_info : key_info.tokens) {
       const std::string value_str =
           codec_->EncodeValue(token_info.token->value);
       token_info.id_in_value_trie = value_trie_builder_.GetId(value_str);
     }
-  }
+  });
 }
 
 void SystemDictionaryBuilder::SortTokenInfo(KeyInfoList* key_info_list) const {
-  for (KeyInfo& key_info : *key_info_list) {
+  ForEachKeyInfo(*key_info_list, [](KeyInfo& key_info) {
     std::stable_sort(
         key_info.tokens.begin(), key_info.tokens.end(),
         [](const TokenInfo& lhs, const TokenInfo& rhs) {
@@ -337,7 +385,7 @@ void SystemDictionaryBuilder::SortTokenInfo(KeyInfoList* key_info_list) const {
                  std::tie(lhs.token->lid, lhs.token->rid, rhs.id_in_value_trie,
                           rhs.token->attributes);
         });
-  }
+  });
 }
 
 void SystemDictionaryBuilder::SetCostType(KeyInfoList* key_info_list) const {
@@ -367,17 +415,17 @@ void SystemDictionaryBuilder::SetCostType(KeyInfoList* key_info_list) const {
 
   const int min_key_len =
       absl::GetFlag(FLAGS_min_key_length_to_use_small_cost_encoding);
-  for (KeyInfo& key_info : *key_info_list) {
+  ForEachKeyInfo(*key_info_list, [&](KeyInfo& key_info) {
     if (Util::CharsLen(key_info.key) < min_key_len) {
       // Do not use small cost encoding for short keys.
-      continue;
+      return;
     }
     if (HasHomonymsInSamePos(key_info)) {
-      continue;
+      return;
     }
     if (HasHeterophones(key_info, heterophone_values)) {
       // We want to keep the cost order for LookupReverse().
-      continue;
+      return;
     }
 
     for (TokenInfo& token_info : key_info.tokens) {
@@ -387,11 +435,11 @@ void SystemDictionaryBuilder::SetCostType(KeyInfoList* key_info_list) const {
       }
       token_info.cost_type = TokenInfo::CAN_USE_SMALL_ENCODING;
     }
-  }
+  });
 }
 
 void SystemDictionaryBuilder::SetPosType(KeyInfoList* key_info_list) const {
-  for (KeyInfo& key_info : *key_info_list) {
+  ForEachKeyInfo(*key_info_list, [this](KeyInfo& key_info) {
     for (size_t i = 0; i < key_info.tokens.size(); ++i) {
       TokenInfo* token_info = &(key_info.tokens[i]);
       const uint32_t pos =
@@ -410,11 +458,11 @@ void SystemDictionaryBuilder::SetPosType(KeyInfoList* key_info_list) const {
         }
       }
     }
-  }
+  });
 }
 
 void SystemDictionaryBuilder::SetValueType(KeyInfoList* key_info_list) const {
-  for (KeyInfo& key_info : *key_info_list) {
+  ForEachKeyInfo(*key_info_list, [](KeyInfo& key_info) {
     for (size_t i = 1; i < key_info.tokens.size(); ++i) {
       const TokenInfo& prev_token_info = key_info.tokens[i - 1];
       TokenInfo* token_info = &(key_info.tokens[i]);
@@ -424,37 +472,29 @@ void SystemDictionaryBuilder::SetValueType(KeyInfoList* key_info_list) const {
         token_info->value_type = TokenInfo::SAME_AS_PREV_VALUE;
       }
     }
-  }
-}
-
-void SystemDictionaryBuilder::BuildKeyTrie(const KeyInfoList& key_info_list) {
-  for (const KeyInfo& key_info : key_info_list) {
-    key_trie_builder_.Add(codec_->EncodeKey(key_info.key));
-  }
-  key_trie_builder_.Build();
+  });
 }
 
 void SystemDictionaryBuilder::SetIdForKey(KeyInfoList* key_info_list) const {
-  for (KeyInfo& key_info : *key_info_list) {
+  ForEachKeyInfo(*key_info_list, [this](KeyInfo& key_info) {
     key_info.id_in_key_trie =
         key_trie_builder_.GetId(codec_->EncodeKey(key_info.key));
-  }
+  });
 }
 
 void SystemDictionaryBuilder::BuildTokenArray(
     const KeyInfoList& key_info_list) {
-  // Here we make a reverse lookup table as follows:
-  //   |key_info_list[X].id_in_key_trie| -> |key_info_list[X]|
-  // assuming |key_info_list[X].id_in_key_trie| is unique and successive.
+  // Here we encode the tokens into the table indexed by
+  // |key_info_list[X].id_in_key_trie|, assuming it is unique and successive.
   {
-    std::vector<const KeyInfo*> id_to_keyinfo_table(key_info_list.size());
-    for (const KeyInfo& key_info : key_info_list) {
-      const int id = key_info.id_in_key_trie;
-      id_to_keyinfo_table[id] = &key_info;
-    }
-
-    for (const KeyInfo* key_info : id_to_keyinfo_table) {
-      token_array_builder_.Add(codec_->EncodeTokens(key_info->tokens));
+    std::vector<std::string> id_to_encoded_tokens(key_info_list.size());
+    ForEachKeyInfo(key_info_list, [&](const KeyInfo& key_info) {
+      id_to_encoded_tokens[key_info.id_in_key_trie] =
+          codec_->EncodeTokens(key_info.tokens);
+    });
+
+    for (std::string& encoded_tokens : id_to_encoded_tokens) {
+      token_array_builder_.Add(std::move(encoded_tokens));
     }
   }
 
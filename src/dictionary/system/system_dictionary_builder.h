@@ -40,6 +40,7 @@
 
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/thread_pool.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/file/codec.h"
 #include "dictionary/system/codec.h"
@@ -73,6 +74,10 @@ class SystemDictionaryBuilder final {
   SystemDictionaryBuilder(const SystemDictionaryBuilder&) = delete;
   SystemDictionaryBuilder& operator=(const SystemDictionaryBuilder&) = delete;
 
+  // Runs the build phases on `pool`. The output is identical to the one built
+  // without a pool. `pool` must outlive the calls to BuildFromTokens().
+  void set_thread_pool(ThreadPool* pool) { pool_ = pool; }
+
   void BuildFromTokens(absl::Span<Token* const> tokens) {
     BuildFromTokensInternal(std::vector<Token*>(tokens.begin(), tokens.end()));
   }
@@ -93,10 +98,13 @@ class SystemDictionaryBuilder final {
   KeyInfoList ReadTokens(std::vector<Token*> tokens) const;
 
   void BuildFrequentPos(const KeyInfoList& key_info_list);
-  void BuildValueTrie(const KeyInfoList& key_info_list);
-  void BuildKeyTrie(const KeyInfoList& key_info_list);
+  void BuildTries(const KeyInfoList& key_info_list);
   void BuildTokenArray(const KeyInfoList& key_info_list);
 
+  // Calls `func` for each KeyInfo in `key_info_list` on the thread pool.
+  template <typename KeyInfoListT, typename Func>
+  void ForEachKeyInfo(KeyInfoListT& key_info_list, Func func) const;
+
   void SetIdForValue(KeyInfoList* key_info_list) const;
   void SetIdForKey(KeyInfoList* key_info_list) const;
   void SortTokenInfo(KeyInfoList* key_info_list) const;
@@ -114,6 +122,7 @@ class SystemDictionaryBuilder final {
 
   std::unique_ptr<const SystemDictionaryCodec> codec_;
   std::unique_ptr<const DictionaryFileCodec> file_codec_;
+  ThreadPool* pool_ = nullptr;
 };
 
 }  // namespace dictionary
@@ -43,12 +43,14 @@
 #include "absl/container/btree_set.h"
 #include "absl/flags/declare.h"
 #include "absl/flags/flag.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "base/file/temp_dir.h"
 #include "base/file_util.h"
+#include "base/thread_pool.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_mock.h"
@@ -125,9 +127,6 @@ class SystemDictionaryTest : public testing::TestWithTempUserProfile {
 };
 
 Token* GetTokenPointer(Token& token) { return &token; }
-Token* GetTokenPointer(const std::unique_ptr<Token>& token) {
-  return token.get();
-}
 
 // Get pointers to the Tokens contained in `token_container`. Since the returned
 // vector contains mutable pointers to the elements of `token_container`, it
@@ -365,15 +364,15 @@ TEST_F(SystemDictionaryTest, SameWord) {
 }
 
 TEST_F(SystemDictionaryTest, LookupAllWords) {
-  absl::Span<const std::unique_ptr<Token>> source_tokens = text_dict_.tokens();
+  absl::Span<Token* const> source_tokens = text_dict_.tokens();
   std::unique_ptr<SystemDictionary> system_dic =
-      BuildSystemDictionary(MakeTokenPointers(&source_tokens),
+      BuildSystemDictionary(source_tokens,
                             absl::GetFlag(FLAGS_dictionary_test_size));
   ASSERT_TRUE(system_dic);
 
   // All the tokens should be looked up.
   for (size_t i = 0; i < source_tokens.size(); ++i) {
-    CheckTokenExistenceCallback callback(source_tokens[i].get());
+    CheckTokenExistenceCallback callback(source_tokens[i]);
     system_dic->LookupPrefix(source_tokens[i]->key, &callback);
     EXPECT_TRUE(callback.found())
         << "Token was not found: " << PrintToken(*source_tokens[i]);
@@ -398,6 +397,24 @@ TEST_F(SystemDictionaryTest, SimpleLookupPrefix) {
   EXPECT_TRUE(callback.found());
 }
 
+TEST_F(SystemDictionaryTest, MayHaveKeyWithPrefix) {
+  Token t0 = {"はひふ", "aa", 0, 0, 0, Token::NONE};
+  Token t1 = {"はへ", "bb", 0, 0, 0, Token::NONE};
+
+  std::vector<Token*> source_tokens = {&t0, &t1};
+  text_dict_.CollectTokens(&source_tokens);
+  std::unique_ptr<SystemDictionary> system_dic =
+      BuildSystemDictionary(source_tokens, 100);
+  ASSERT_TRUE(system_dic);
+
+  EXPECT_TRUE(system_dic->MayHaveKeyWithPrefix("は"));
+  EXPECT_TRUE(system_dic->MayHaveKeyWithPrefix("はひ"));
+  EXPECT_TRUE(system_dic->MayHaveKeyWithPrefix("はひふ"));
+  EXPECT_TRUE(system_dic->MayHaveKeyWithPrefix("はへ"));
+  EXPECT_FALSE(system_dic->MayHaveKeyWithPrefix("はほ"));
+  EXPECT_FALSE(system_dic->MayHaveKeyWithPrefix("はひふへ"));
+}
+
 class LookupPrefixTestCallback : public TokenCallbackBase {
  public:
   ResultType OnKey(absl::string_view key) override {
@@ -627,6 +644,48 @@ TEST_F(SystemDictionaryTest, LookupExact) {
   EXPECT_TRUE(callback_hoge.tokens().empty());
 }
 
+TEST_F(SystemDictionaryTest, LookupWithTokenView) {
+  // Covers AS_IS_HIRAGANA, AS_IS_KATAKANA and normal values.
+  Token t0 = {"あい", "あい", 100, 1, 1, Token::NONE};
+  Token t1 = {"あい", "アイ", 200, 2, 2, Token::NONE};
+  Token t2 = {"あい", "愛", 300, 3, 3, Token::NONE};
+  Token t3 = {"あいて", "相手", 400, 4, 4, Token::NONE};
+  std::vector<Token*> source_tokens = {&t0, &t1, &t2, &t3};
+  std::unique_ptr<SystemDictionary> system_dic =
+      BuildSystemDictionary(source_tokens, 100);
+  ASSERT_TRUE(system_dic);
+
+  // The views should be identical to the materialized tokens.
+  auto check = [&](auto lookup) {
+    CollectTokenCallback token_callback;
+    lookup(&token_callback);
+    std::vector<Token> viewed_tokens;
+    InlineCallback view_callback;
+    view_callback.OnTokenView([&](absl::string_view key,
+                                  absl::string_view actual_key,
+                                  const TokenView& token) {
+      viewed_tokens.push_back(token.ToToken());
+      return DictionaryInterface::Callback::TRAVERSE_CONTINUE;
+    });
+    lookup(&view_callback);
+    ASSERT_EQ(viewed_tokens.size(), token_callback.tokens().size());
+    for (size_t i = 0; i < viewed_tokens.size(); ++i) {
+      EXPECT_TRUE(CompareTokensForLookup(viewed_tokens[i],
+                                         token_callback.tokens()[i], false))
+          << PrintToken(viewed_tokens[i]);
+    }
+  };
+  check([&](DictionaryInterface::Callback* callback) {
+    system_dic->LookupPrefix("あいて", callback);
+  });
+  check([&](DictionaryInterface::Callback* callback) {
+    system_dic->LookupPredictive("あ", callback);
+  });
+  check([&](DictionaryInterface::Callback* callback) {
+    system_dic->LookupExact("あい", callback);
+  });
+}
+
 TEST_F(SystemDictionaryTest, LookupReverse) {
   Token tokens[] = {
       {"ど", "ド", 1, 2, 3, Token::NONE},
@@ -702,8 +761,8 @@ TEST_F(SystemDictionaryTest, LookupReverse) {
 }
 
 TEST_F(SystemDictionaryTest, LookupReverseIndex) {
-  absl::Span<const std::unique_ptr<Token>> source_tokens = text_dict_.tokens();
-  BuildAndWriteSystemDictionary(MakeTokenPointers(&source_tokens),
+  absl::Span<Token* const> source_tokens = text_dict_.tokens();
+  BuildAndWriteSystemDictionary(source_tokens,
                                 absl::GetFlag(FLAGS_dictionary_test_size),
                                 dic_fn_);
 
@@ -939,6 +998,34 @@ TEST_F(SystemDictionaryTest, ShouldNotUseSmallCostEncodingForHeteronyms) {
   }
 }
 
+TEST_F(SystemDictionaryTest, ParallelBuildProducesIdenticalImage) {
+  absl::SetFlag(&FLAGS_min_key_length_to_use_small_cost_encoding,
+                original_flags_min_key_length_to_use_small_cost_encoding_);
+
+  const std::string expected_fn =
+      FileUtil::JoinPath(temp_dir_.path(), "expected.dic");
+  {
+    SystemDictionaryBuilder builder;
+    builder.BuildFromTokens(text_dict_.tokens());
+    builder.WriteToFile(expected_fn);
+  }
+  const std::string actual_fn =
+      FileUtil::JoinPath(temp_dir_.path(), "actual.dic");
+  {
+    ThreadPool pool(4);
+    SystemDictionaryBuilder builder;
+    builder.set_thread_pool(&pool);
+    builder.BuildFromTokens(text_dict_.tokens());
+    builder.WriteToFile(actual_fn);
+  }
+
+  absl::StatusOr<std::string> expected = FileUtil::GetContents(expected_fn);
+  ASSERT_OK(expected);
+  absl::StatusOr<std::string> actual = FileUtil::GetContents(actual_fn);
+  ASSERT_OK(actual);
+  EXPECT_TRUE(*actual == *expected);
+}
+
 }  // namespace
 }  // namespace dictionary
 }  // namespace mozc
@@ -47,17 +47,31 @@
 namespace mozc {
 namespace dictionary {
 
+// Decodes the tokens for a key. The decoded token is returned as a TokenView
+// whose value points to `buffer`. The strings of TokenInfo::token are not set.
 class TokenDecodeIterator {
  public:
+  // Scratch buffers for decoded strings. Reuse one instance for the iterators
+  // in a lookup so that decoding tokens doesn't allocate memory.
+  struct Buffer {
+    std::string value;
+    std::string key_katakana;
+  };
+
   TokenDecodeIterator(const TokenDecodeIterator&) = delete;
   TokenDecodeIterator& operator=(const TokenDecodeIterator&) = delete;
   TokenDecodeIterator(const SystemDictionaryCodec& codec,
                       const storage::louds::LoudsTrie& value_trie,
                       absl::Span<const uint32_t> frequent_pos,
-                      absl::string_view key, const uint8_t* ptr);
+                      absl::string_view key, const uint8_t* ptr,
+                      Buffer* buffer);
   ~TokenDecodeIterator() = default;
 
   const TokenInfo& Get() const { return token_info_; }
+  TokenView GetView() const {
+    return TokenView(key_, buffer_->value, token_.cost, token_.lid,
+                     token_.rid, token_.attributes);
+  }
   bool Done() const { return state_ == DONE; }
   void Next();
 
@@ -70,11 +84,11 @@ class TokenDecodeIterator {
 
   void NextInternal();
 
-  std::string LookupValue(int id) const {
+  void LookupValue(int id) {
     char buffer[storage::louds::LoudsTrie::kMaxDepth + 1];
     const absl::string_view encoded_value =
         value_trie_.RestoreKeyString(id, buffer);
-    return codec_.DecodeValue(encoded_value);
+    codec_.DecodeValue(encoded_value, &buffer_->value);
   }
 
   const SystemDictionaryCodec& codec_;
@@ -82,13 +96,15 @@ class TokenDecodeIterator {
   absl::Span<const uint32_t> frequent_pos_;
 
   const absl::string_view key_;
-  // Katakana key will be lazily initialized.
-  std::string key_katakana_;
+  Buffer* buffer_;
+  // Katakana key will be lazily initialized in buffer_->key_katakana.
+  bool has_key_katakana_ = false;
 
   State state_;
   const uint8_t* ptr_;
 
   TokenInfo token_info_;
+  // Holds the fields other than key and value.
   Token token_;
 };
 
@@ -98,15 +114,16 @@ inline TokenDecodeIterator::TokenDecodeIterator(
     const SystemDictionaryCodec& codec,
     const storage::louds::LoudsTrie& value_trie,
     absl::Span<const uint32_t> frequent_pos, absl::string_view key,
-    const uint8_t* ptr)
+    const uint8_t* ptr, Buffer* buffer)
     : codec_(codec),
       value_trie_(value_trie),
       frequent_pos_(frequent_pos),
       key_(key),
+      buffer_(buffer),
       state_(HAS_NEXT),
       ptr_(ptr),
       token_info_(nullptr) {
-  token_.key.assign(key.data(), key.size());
+  DCHECK(buffer_);
   NextInternal();
 }
 
@@ -130,7 +147,8 @@ inline void TokenDecodeIterator::NextInternal() {
 
   // This implementation is depending on the internal behavior of DecodeToken
   // especially which fields are updated or not. Important fields are:
-  // Token::key, Token::value : key and value are never updated.
+  // Token::key, Token::value : key and value are never updated. They are held
+  //   by key_ and buffer_->value instead.
   // Token::cost : always updated.
   // Token::lid, Token::rid : updated iff the pos_type is neither
   //   FREQUENT_POS nor SAME_AS_PREV_POS.
@@ -152,7 +170,7 @@ inline void TokenDecodeIterator::NextInternal() {
   // Fill remaining values.
   switch (token_info_.value_type) {
     case TokenInfo::DEFAULT_VALUE: {
-      token_.value = LookupValue(token_info_.id_in_value_trie);
+      LookupValue(token_info_.id_in_value_trie);
       break;
     }
     case TokenInfo::SAME_AS_PREV_VALUE: {
@@ -162,14 +180,15 @@ inline void TokenDecodeIterator::NextInternal() {
       break;
     }
     case TokenInfo::AS_IS_HIRAGANA: {
-      token_.value = token_.key;
+      buffer_->value.assign(key_.data(), key_.size());
       break;
     }
     case TokenInfo::AS_IS_KATAKANA: {
-      if (!key_.empty() && key_katakana_.empty()) {
-        key_katakana_ = japanese_util::HiraganaToKatakana(key_);
+      if (!has_key_katakana_) {
+        buffer_->key_katakana = japanese_util::HiraganaToKatakana(key_);
+        has_key_katakana_ = true;
       }
-      token_.value = key_katakana_;
+      buffer_->value.assign(buffer_->key_katakana);
       break;
     }
     default: {
@@ -179,7 +198,7 @@ inline void TokenDecodeIterator::NextInternal() {
   }
 
   if (token_info_.accent_encoding_type == TokenInfo::EMBEDDED_IN_TOKEN) {
-    absl::StrAppend(&token_.value, "_", token_info_.accent_type);
+    absl::StrAppend(&buffer_->value, "_", token_info_.accent_type);
   }
 
   if (token_info_.pos_type == TokenInfo::FREQUENT_POS) {
@@ -53,14 +53,11 @@ ValueDictionary::ValueDictionary(const PosMatcher& pos_matcher,
 
 namespace {
 
-// A version of the above function for Token.
-inline void FillToken(const uint16_t suggestion_only_word_id,
-                      absl::string_view key, Token* token) {
-  token->key.assign(key.data(), key.size());
-  token->value = token->key;
-  token->cost = 10000;
-  token->lid = token->rid = suggestion_only_word_id;
-  token->attributes = Token::NONE;
+// Returns a token view whose key and value both refer to `key`.
+inline TokenView MakeTokenView(const uint16_t suggestion_only_word_id,
+                               absl::string_view key) {
+  return TokenView(key, key, 10000, suggestion_only_word_id,
+                   suggestion_only_word_id, Token::NONE);
 }
 
 inline bool IsValidKey(absl::string_view key) {
@@ -82,7 +79,7 @@ inline DictionaryInterface::Callback::ResultType HandleTerminalNode(
     const LoudsTrie& value_trie, const SystemDictionaryCodec& codec,
     const uint16_t suggestion_only_word_id, const LoudsTrie::Node& node,
     DictionaryInterface::Callback* callback, char* encoded_value_buffer,
-    std::string* value, Token* token) {
+    std::string* value) {
   const absl::string_view encoded_value =
       value_trie.RestoreKeyString(node, encoded_value_buffer);
 
@@ -95,8 +92,8 @@ inline DictionaryInterface::Callback::ResultType HandleTerminalNode(
   if (result != DictionaryInterface::Callback::TRAVERSE_CONTINUE) {
     return result;
   }
-  FillToken(suggestion_only_word_id, *value, token);
-  return callback->OnToken(*value, *value, *token);
+  return callback->OnTokenView(*value, *value,
+                               MakeTokenView(suggestion_only_word_id, *value));
 }
 
 }  // namespace
@@ -115,7 +112,6 @@ void ValueDictionary::LookupPredictive(absl::string_view key,
   char encoded_value_buffer[LoudsTrie::kMaxDepth + 1];
   std::string value;
   value.reserve(key.size() * 2);
-  Token token;
 
   // Traverse subtree rooted at |node|.
   std::queue<LoudsTrie::Node> queue;
@@ -126,8 +122,8 @@ void ValueDictionary::LookupPredictive(absl::string_view key,
 
     if (value_trie_.IsTerminalNode(node)) {
       switch (HandleTerminalNode(value_trie_, codec_, suggestion_only_word_id_,
-                                 node, callback, encoded_value_buffer, &value,
-                                 &token)) {
+                                 node, callback, encoded_value_buffer,
+                                 &value)) {
         case Callback::TRAVERSE_DONE:
           return;
         case Callback::TRAVERSE_CULL:
@@ -160,9 +156,7 @@ void ValueDictionary::LookupExact(absl::string_view key,
       Callback::TRAVERSE_CONTINUE) {
     return;
   }
-  Token token;
-  FillToken(suggestion_only_word_id_, key, &token);
-  callback->OnToken(key, key, token);
+  callback->OnTokenView(key, key, MakeTokenView(suggestion_only_word_id_, key));
 }
 
 }  // namespace dictionary
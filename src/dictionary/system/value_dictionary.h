@@ -56,6 +56,11 @@ class ValueDictionary : public DictionaryInterface {
   ValueDictionary(const ValueDictionary&) = delete;
   ValueDictionary& operator=(const ValueDictionary&) = delete;
 
+  // LookupPrefix() is not supported.
+  bool MayHaveKeyWithPrefix(absl::string_view prefix) const override {
+    return false;
+  }
+
   void LookupPredictive(absl::string_view key,
                         Callback* callback) const override;
   void LookupExact(absl::string_view key, Callback* callback) const override;
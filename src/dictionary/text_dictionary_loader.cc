@@ -34,10 +34,10 @@
 #include "dictionary/text_dictionary_loader.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <iterator>
+#include <deque>
 #include <limits>
-#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -49,9 +49,14 @@
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "base/container/arena.h"
 #include "base/japanese_util.h"
 #include "base/multifile.h"
+#include "base/thread_pool.h"
 #include "base/util.h"
 #include "base/vlog.h"
 #include "dictionary/dictionary_token.h"
@@ -66,41 +71,46 @@ namespace {
 
 using ValueAndKey = std::pair<absl::string_view, absl::string_view>;
 
-ValueAndKey ToValueAndKey(const std::unique_ptr<Token>& token) {
+ValueAndKey ToValueAndKey(const Token* token) {
   return ValueAndKey(token->value, token->key);
 }
 
 // Functor to sort a sequence of Tokens first by value and then by key.
 struct OrderByValueThenByKey {
-  bool operator()(const std::unique_ptr<Token>& l,
-                  const std::unique_ptr<Token>& r) const {
+  bool operator()(const Token* l, const Token* r) const {
     return ToValueAndKey(l) < ToValueAndKey(r);
   }
 
-  bool operator()(const std::unique_ptr<Token>& token,
-                  const ValueAndKey& value_key) const {
+  bool operator()(const Token* token, const ValueAndKey& value_key) const {
     return ToValueAndKey(token) < value_key;
   }
 
-  bool operator()(const ValueAndKey& value_key,
-                  const std::unique_ptr<Token>& token) const {
+  bool operator()(const ValueAndKey& value_key, const Token* token) const {
     return value_key < ToValueAndKey(token);
   }
 };
 
 // Functor to sort a sequence of Tokens by value.
 struct OrderByValue {
-  bool operator()(const std::unique_ptr<Token>& token,
-                  absl::string_view value) const {
+  bool operator()(const Token* token, absl::string_view value) const {
     return token->value < value;
   }
 
-  bool operator()(absl::string_view value,
-                  const std::unique_ptr<Token>& token) const {
+  bool operator()(absl::string_view value, const Token* token) const {
     return value < token->value;
   }
 };
 
+// Lines of a dictionary file parsed by one task.
+struct ParseBatch {
+  static constexpr size_t kMaxLines = 1 << 14;
+
+  std::vector<std::string> lines;
+  std::vector<Token*> tokens;
+  Arena<Token> arena{kMaxLines};
+  absl::Notification done;
+};
+
 // Parses one line of reading correction file.  Since the result is returned as
 // string views, |line| needs to outlive |value_key|.
 ValueAndKey ParseReadingCorrectionTSV(
@@ -155,7 +165,7 @@ void TextDictionaryLoader::Load(
 void TextDictionaryLoader::LoadWithLineLimit(
     const absl::string_view dictionary_filename,
     const absl::string_view reading_correction_filename, int limit) {
-  tokens_.clear();
+  Clear();
 
   // Roughly allocate buffers for Token pointers.
   if (limit < 0) {
@@ -165,19 +175,47 @@ void TextDictionaryLoader::LoadWithLineLimit(
     tokens_.reserve(limit);
   }
 
-  // Read system dictionary.
+  // Read system dictionary. The lines are parsed in batches on the thread
+  // pool while the following lines are read. Every line yields a token, so the
+  // batches are concatenated in order after parsing.
   {
+    const absl::Time start = absl::Now();
     InputMultiFile file(dictionary_filename);
-    std::string line;
-    while (limit > 0 && file.ReadLine(&line)) {
-      Util::ChopReturns(&line);
-      std::unique_ptr<Token> token = ParseTSVLine(line);
-      if (token) {
-        tokens_.push_back(std::move(token));
+    std::deque<ParseBatch> batches;
+    while (limit > 0) {
+      ParseBatch& batch = batches.emplace_back();
+      std::string line;
+      while (limit > 0 && batch.lines.size() < ParseBatch::kMaxLines &&
+             file.ReadLine(&line)) {
+        batch.lines.push_back(std::move(line));
         --limit;
       }
+      if (batch.lines.empty()) {
+        batches.pop_back();
+        break;
+      }
+      auto parse = [this, &batch] {
+        batch.tokens.reserve(batch.lines.size());
+        for (std::string& line : batch.lines) {
+          Util::ChopReturns(&line);
+          batch.tokens.push_back(batch.arena.Alloc(ParseTSVLine(line)));
+        }
+        batch.lines = std::vector<std::string>();
+        batch.done.Notify();
+      };
+      if (pool_ == nullptr) {
+        parse();
+      } else {
+        pool_->Schedule(parse);
+      }
+    }
+    for (ParseBatch& batch : batches) {
+      batch.done.WaitForNotification();
+      tokens_.insert(tokens_.end(), batch.tokens.begin(), batch.tokens.end());
+      arenas_.push_back(std::move(batch.arena));
     }
-    LOG(INFO) << tokens_.size() << " tokens from " << dictionary_filename;
+    LOG(INFO) << tokens_.size() << " tokens from " << dictionary_filename
+              << " in " << absl::Now() - start;
   }
 
   if (reading_correction_filename.empty() || limit <= 0) {
@@ -192,25 +230,28 @@ void TextDictionaryLoader::LoadWithLineLimit(
   //   2. Accessing all the tokens that have the same value: Since tokens are
   //      also sorted in order of value, this can be done by finding a range of
   //      tokens that have the same value.
-  std::stable_sort(tokens_.begin(), tokens_.end(), OrderByValueThenByKey());
+  const absl::Time start = absl::Now();
+  ParallelStableSort(pool_, tokens_.begin(), tokens_.end(),
+                     OrderByValueThenByKey());
 
-  std::vector<std::unique_ptr<Token>> reading_correction_tokens =
+  std::vector<Token> reading_correction_tokens =
       LoadReadingCorrectionTokens(reading_correction_filename, tokens_, &limit);
-  tokens_.insert(tokens_.end(),
-                 std::make_move_iterator(reading_correction_tokens.begin()),
-                 std::make_move_iterator(reading_correction_tokens.end()));
+  Arena<Token>& arena = arenas_.emplace_back(
+      std::max<size_t>(1, reading_correction_tokens.size()));
+  for (Token& token : reading_correction_tokens) {
+    tokens_.push_back(arena.Alloc(std::move(token)));
+  }
+  LOG(INFO) << "Reading corrections are added in " << absl::Now() - start;
 }
 
 // Loads reading correction data into |tokens|.  The second argument is used to
 // determine costs of reading correction tokens and must be sorted by
-// OrderByValueThenByKey().  The output tokens are newly allocated and the
-// caller is responsible to delete them.
-std::vector<std::unique_ptr<Token>>
-TextDictionaryLoader::LoadReadingCorrectionTokens(
+// OrderByValueThenByKey().
+std::vector<Token> TextDictionaryLoader::LoadReadingCorrectionTokens(
     const absl::string_view reading_correction_filename,
-    absl::Span<const std::unique_ptr<Token>> ref_sorted_tokens, int* limit) {
+    absl::Span<Token* const> ref_sorted_tokens, int* limit) {
   // Load reading correction entries.
-  std::vector<std::unique_ptr<Token>> tokens;
+  std::vector<Token> tokens;
   int reading_correction_size = 0;
   InputMultiFile file(reading_correction_filename);
   std::string line;
@@ -248,10 +289,10 @@ TextDictionaryLoader::LoadReadingCorrectionTokens(
     // this reading correction entry.  Next, find the token that has the
     // maximum cost in [begin, end).  Note that linear search is sufficiently
     // fast here because the size of the range is small.
-    const Token* max_cost_token = begin->get();
+    const Token* max_cost_token = *begin;
     for (++begin; begin != end; ++begin) {
       if ((*begin)->cost > max_cost_token->cost) {
-        max_cost_token = begin->get();
+        max_cost_token = *begin;
       }
     }
 
@@ -259,18 +300,17 @@ TextDictionaryLoader::LoadReadingCorrectionTokens(
     // We here assume that the wrong reading appear with 1/100 probability
     // of the original (correct) reading.
     constexpr int kCostPenalty = 2302;  // -log(1/100) * 500;
-    auto token = std::make_unique<Token>();
-    token->key.assign(value_key.second.data(), value_key.second.size());
-    token->value = max_cost_token->value;
-    token->lid = max_cost_token->lid;
-    token->rid = max_cost_token->rid;
-    token->cost = max_cost_token->cost + kCostPenalty;
+    Token& token = tokens.emplace_back();
+    token.key.assign(value_key.second.data(), value_key.second.size());
+    token.value = max_cost_token->value;
+    token.lid = max_cost_token->lid;
+    token.rid = max_cost_token->rid;
+    token.cost = max_cost_token->cost + kCostPenalty;
     // We don't set SPELLING_CORRECTION. The entries in reading_correction
     // data are also stored in rewriter/correction_rewriter.cc.
     // reading_correction_rewriter annotates the spelling correction
     // notations.
-    token->attributes = Token::NONE;
-    tokens.push_back(std::move(token));
+    token.attributes = Token::NONE;
     ++reading_correction_size;
     if (--*limit <= 0) {
       break;
@@ -283,39 +323,35 @@ TextDictionaryLoader::LoadReadingCorrectionTokens(
 
 void TextDictionaryLoader::CollectTokens(std::vector<Token*>* res) const {
   DCHECK(res);
-  res->reserve(res->size() + tokens_.size());
-  for (const std::unique_ptr<Token>& token : tokens_) {
-    res->push_back(token.get());
-  }
+  res->insert(res->end(), tokens_.begin(), tokens_.end());
 }
 
-std::unique_ptr<Token> TextDictionaryLoader::ParseTSVLine(
-    absl::string_view line) const {
+Token TextDictionaryLoader::ParseTSVLine(absl::string_view line) const {
   const std::vector<absl::string_view> columns =
       absl::StrSplit(line, '\t', absl::SkipEmpty());
   return ParseTSV(columns);
 }
 
-std::unique_ptr<Token> TextDictionaryLoader::ParseTSV(
+Token TextDictionaryLoader::ParseTSV(
     absl::Span<const absl::string_view> columns) const {
   CHECK_LE(5, columns.size()) << "Lack of columns: " << columns.size();
 
-  auto token = std::make_unique<Token>();
+  Token token;
 
   // Parse key, lid, rid, cost, value.
-  token->key = japanese_util::NormalizeVoicedSoundMark(columns[0]);
-  CHECK(absl::SimpleAtoi(columns[1], &token->lid))
+  token.key = japanese_util::NormalizeVoicedSoundMark(columns[0]);
+  CHECK(absl::SimpleAtoi(columns[1], &token.lid))
       << "Wrong lid: " << columns[1];
-  CHECK(absl::SimpleAtoi(columns[2], &token->rid))
+  CHECK(absl::SimpleAtoi(columns[2], &token.rid))
       << "Wrong rid: " << columns[2];
-  CHECK(absl::SimpleAtoi(columns[3], &token->cost))
+  CHECK(absl::SimpleAtoi(columns[3], &token.cost))
       << "Wrong cost: " << columns[3];
-  token->value = japanese_util::NormalizeVoicedSoundMark(columns[4]);
+  token.value = japanese_util::NormalizeVoicedSoundMark(columns[4]);
 
   // Optionally, label (SPELLING_CORRECTION, ZIP_CODE, etc.) may be provided in
   // column 6.
   if (columns.size() > 5) {
-    CHECK(RewriteSpecialToken(token.get(), columns[5]))
+    CHECK(RewriteSpecialToken(&token, columns[5]))
         << "Invalid label: " << columns[5];
   }
   return token;
@@ -30,13 +30,15 @@
 #ifndef MOZC_DICTIONARY_TEXT_DICTIONARY_LOADER_H_
 #define MOZC_DICTIONARY_TEXT_DICTIONARY_LOADER_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/container/arena.h"
+#include "base/thread_pool.h"
 #include "dictionary/dictionary_token.h"
 
 namespace mozc {
@@ -70,14 +72,25 @@ class TextDictionaryLoader {
                          absl::string_view reading_correction_filename,
                          int limit);
 
+  // Parses the lines of the dictionary files and sorts the tokens on `pool`.
+  // The loaded tokens are the same as the ones without a pool. `pool` must
+  // outlive the calls to Load().
+  void set_thread_pool(ThreadPool* pool) { pool_ = pool; }
+
   // Clears the loaded tokens.
-  void Clear() { tokens_.clear(); }
+  void Clear() {
+    tokens_.clear();
+    arenas_.clear();
+  }
 
-  void AddToken(std::unique_ptr<Token> token) {
-    tokens_.push_back(std::move(token));
+  void AddToken(Token token) {
+    if (arenas_.empty()) {
+      arenas_.emplace_back(kArenaChunkSize);
+    }
+    tokens_.push_back(arenas_.back().Alloc(std::move(token)));
   }
 
-  absl::Span<const std::unique_ptr<Token>> tokens() const { return tokens_; }
+  absl::Span<Token* const> tokens() const { return tokens_; }
 
   // Appends the tokens owned by this instance to |res|.  Note that the appended
   // tokens are still owned by this instance and deleted on destruction of this
@@ -87,9 +100,11 @@ class TextDictionaryLoader {
  private:
   friend class TextDictionaryLoaderTestPeer;
 
-  static std::vector<std::unique_ptr<Token>> LoadReadingCorrectionTokens(
+  static constexpr size_t kArenaChunkSize = 1 << 14;
+
+  static std::vector<Token> LoadReadingCorrectionTokens(
       absl::string_view reading_correction_filename,
-      absl::Span<const std::unique_ptr<Token>> ref_sorted_tokens, int* limit);
+      absl::Span<Token* const> ref_sorted_tokens, int* limit);
 
   // Encodes special information into |token| with the |label|.
   // Currently, label must be:
@@ -100,13 +115,16 @@ class TextDictionaryLoader {
   // Otherwise, the method returns false.
   bool RewriteSpecialToken(Token* token, absl::string_view label) const;
 
-  std::unique_ptr<Token> ParseTSVLine(absl::string_view line) const;
-  std::unique_ptr<Token> ParseTSV(
-      absl::Span<const absl::string_view> columns) const;
+  Token ParseTSVLine(absl::string_view line) const;
+  Token ParseTSV(absl::Span<const absl::string_view> columns) const;
 
   const uint16_t zipcode_id_;
   const uint16_t isolated_word_id_;
-  std::vector<std::unique_ptr<Token>> tokens_;
+  ThreadPool* pool_ = nullptr;
+  std::vector<Token*> tokens_;
+  // Owns the tokens. The batches of lines parsed in parallel have their own
+  // arenas.
+  std::vector<Arena<Token>> arenas_;
 };
 
 }  // namespace dictionary
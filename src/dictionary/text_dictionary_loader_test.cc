@@ -33,9 +33,11 @@
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "base/file/temp_dir.h"
 #include "base/file_util.h"
+#include "base/thread_pool.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
@@ -98,7 +100,7 @@ TEST_F(TextDictionaryLoaderTest, BasicTest) {
   {
     std::unique_ptr<TextDictionaryLoader> loader = CreateTextDictionaryLoader();
     loader->Load(filename, "");
-    absl::Span<const std::unique_ptr<Token>> tokens = loader->tokens();
+    absl::Span<Token* const> tokens = loader->tokens();
 
     EXPECT_EQ(tokens.size(), 3);
 
@@ -127,7 +129,7 @@ TEST_F(TextDictionaryLoaderTest, BasicTest) {
   {
     std::unique_ptr<TextDictionaryLoader> loader = CreateTextDictionaryLoader();
     loader->LoadWithLineLimit(filename, "", 2);
-    absl::Span<const std::unique_ptr<Token>> tokens = loader->tokens();
+    absl::Span<Token* const> tokens = loader->tokens();
 
     EXPECT_EQ(tokens.size(), 2);
 
@@ -152,7 +154,7 @@ TEST_F(TextDictionaryLoaderTest, BasicTest) {
     // open twice -- tokens are cleared everytime
     loader->Load(filename, "");
     loader->Load(filename, "");
-    absl::Span<const std::unique_ptr<Token>> tokens = loader->tokens();
+    absl::Span<Token* const> tokens = loader->tokens();
     EXPECT_EQ(tokens.size(), 3);
   }
 
@@ -247,7 +249,7 @@ TEST_F(TextDictionaryLoaderTest, ReadingCorrectionTest) {
   FileUnlinker reading_correction_unlinker(reading_correction_filename);
 
   loader->Load(dic_filename, reading_correction_filename);
-  absl::Span<const std::unique_ptr<Token>> tokens = loader->tokens();
+  absl::Span<Token* const> tokens = loader->tokens();
   ASSERT_EQ(tokens.size(), 4);
   EXPECT_EQ(tokens[3]->key, "foobar_error");
   EXPECT_EQ(tokens[3]->value, "foobar");
@@ -256,5 +258,50 @@ TEST_F(TextDictionaryLoaderTest, ReadingCorrectionTest) {
   EXPECT_EQ(tokens[3]->cost, 30 + 2302);
 }
 
+TEST_F(TextDictionaryLoaderTest, ParallelLoadTest) {
+  // Large enough to be split into several batches.
+  std::string lines;
+  for (int i = 0; i < 50000; ++i) {
+    absl::StrAppend(&lines, "key", i % 1000, "\t", i % 7, "\t", i % 11, "\t",
+                    i, "\tvalue", i, "\n");
+  }
+  std::string reading_corrections;
+  for (int i = 0; i < 1000; ++i) {
+    absl::StrAppend(&reading_corrections, "value", i, "\terror", i, "\tkey",
+                    i, "\n");
+  }
+  const std::string dic_filename =
+      FileUtil::JoinPath(temp_dir_.path(), "test.tsv");
+  const std::string reading_correction_filename =
+      FileUtil::JoinPath(temp_dir_.path(), "reading_correction.tsv");
+  ASSERT_OK(FileUtil::SetContents(dic_filename, lines));
+  FileUnlinker dic_unlinker(dic_filename);
+  ASSERT_OK(
+      FileUtil::SetContents(reading_correction_filename, reading_corrections));
+  FileUnlinker reading_correction_unlinker(reading_correction_filename);
+
+  std::unique_ptr<TextDictionaryLoader> expected = CreateTextDictionaryLoader();
+  expected->Load(dic_filename, reading_correction_filename);
+
+  ThreadPool pool(4);
+  std::unique_ptr<TextDictionaryLoader> actual = CreateTextDictionaryLoader();
+  actual->set_thread_pool(&pool);
+  actual->Load(dic_filename, reading_correction_filename);
+
+  // The result is independent of the number of threads.
+  ASSERT_EQ(actual->tokens().size(), expected->tokens().size());
+  EXPECT_EQ(actual->tokens().size(), 50000 + 1000);
+  for (size_t i = 0; i < expected->tokens().size(); ++i) {
+    const Token& a = *actual->tokens()[i];
+    const Token& e = *expected->tokens()[i];
+    EXPECT_EQ(a.key, e.key);
+    EXPECT_EQ(a.value, e.value);
+    EXPECT_EQ(a.lid, e.lid);
+    EXPECT_EQ(a.rid, e.rid);
+    EXPECT_EQ(a.cost, e.cost);
+    EXPECT_EQ(a.attributes, e.attributes);
+  }
+}
+
 }  // namespace dictionary
 }  // namespace mozc
@@ -33,7 +33,6 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <limits>
 #include <memory>
 #include <optional>
@@ -42,7 +41,6 @@
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
-#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -51,6 +49,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "base/file_util.h"
 #include "base/hash.h"
 #include "base/strings/assign.h"
@@ -61,36 +60,31 @@
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
+#include "dictionary/suppression_dictionary.h"
 #include "dictionary/user_dictionary_importer.h"
 #include "dictionary/user_dictionary_storage.h"
 #include "dictionary/user_dictionary_util.h"
 #include "dictionary/user_pos.h"
 #include "protocol/config.pb.h"
 #include "protocol/user_dictionary_storage.pb.h"
+#include "storage/louds/louds_trie.h"
+#include "storage/louds/louds_trie_builder.h"
+#include "storage/louds/simple_succinct_bit_vector_index.h"
 
 namespace mozc {
 namespace dictionary {
 namespace {
 
-struct OrderByKey {
-  bool operator()(const UserPos::Token& token, absl::string_view key) const {
-    return token.key < key;
-  }
-
-  bool operator()(absl::string_view key, const UserPos::Token& token) const {
-    return key < token.key;
-  }
-};
-
-struct OrderByKeyPrefix {
-  bool operator()(const UserPos::Token& token, absl::string_view prefix) const {
-    return absl::string_view(token.key).substr(0, prefix.size()) < prefix;
-  }
+using ::mozc::storage::louds::LoudsTrie;
+using ::mozc::storage::louds::LoudsTrieBuilder;
+using ::mozc::storage::louds::SimpleSuccinctBitVectorIndex;
 
-  bool operator()(absl::string_view prefix, const UserPos::Token& token) const {
-    return prefix < absl::string_view(token.key).substr(0, prefix.size());
-  }
-};
+// Cache sizes of the key trie. See system_dictionary.cc.
+constexpr size_t kKeyTrieLb0CacheSize = 1 * 1024;
+constexpr size_t kKeyTrieLb1CacheSize = 1 * 1024;
+constexpr size_t kKeyTrieSelect0CacheSize = 4 * 1024;
+constexpr size_t kKeyTrieSelect1CacheSize = 4 * 1024;
+constexpr size_t kKeyTrieTermvecCacheSize = 1 * 1024;
 
 struct OrderByKeyThenById {
   bool operator()(const UserPos::Token& lhs, const UserPos::Token& rhs) const {
@@ -99,50 +93,6 @@ struct OrderByKeyThenById {
   }
 };
 
-class SuppressionDictionary {
- public:
-  bool AddEntry(std::string key, std::string value) {
-    if (key.empty() && value.empty()) {
-      LOG(WARNING) << "Both key and value are empty";
-      return false;
-    }
-
-    if (key.empty()) {
-      values_only_.emplace(std::move(value));
-    } else if (value.empty()) {
-      keys_only_.emplace(std::move(key));
-    } else {
-      keys_values_.emplace(std::move(key), std::move(value));
-    }
-
-    return true;
-  }
-
-  bool IsEmpty() const {
-    return keys_only_.empty() && values_only_.empty() && keys_values_.empty();
-  }
-
-  bool IsSuppressedEntry(const absl::string_view key,
-                         const absl::string_view value) const {
-    return !IsEmpty() &&
-           (keys_values_.contains(std::make_pair(key, value)) ||
-            keys_only_.contains(key) || values_only_.contains(value));
-  }
-
- private:
-  using KeyValue = std::pair<std::string, std::string>;
-  using KeyValueView = std::pair<absl::string_view, absl::string_view>;
-  struct KeyValueHash : public absl::Hash<KeyValueView> {
-    using is_transparent = void;
-  };
-  struct KeyValueEq : public std::equal_to<KeyValueView> {
-    using is_transparent = void;
-  };
-
-  absl::flat_hash_set<KeyValue, KeyValueHash, KeyValueEq> keys_values_;
-  absl::flat_hash_set<std::string> keys_only_;
-  absl::flat_hash_set<std::string> values_only_;
-};
 }  // namespace
 
 class UserDictionary::TokensIndex {
@@ -154,18 +104,85 @@ class UserDictionary::TokensIndex {
   bool empty() const { return user_pos_tokens_.empty(); }
   size_t size() const { return user_pos_tokens_.size(); }
 
-  std::vector<UserPos::Token>::const_iterator begin() const {
-    return user_pos_tokens_.begin();
+  bool MayHaveKeyWithPrefix(absl::string_view prefix) const {
+    // Every node of the trie leads to at least one key.
+    LoudsTrie::Node node;
+    return !empty() && key_trie_.Traverse(prefix, &node);
   }
-  std::vector<UserPos::Token>::const_iterator end() const {
-    return user_pos_tokens_.end();
+
+  // Returns the tokens whose key is `key`, sorted by POS id.
+  absl::Span<const UserPos::Token> FindExact(absl::string_view key) const {
+    if (empty()) {
+      return {};
+    }
+    LoudsTrie::Node node;
+    if (!key_trie_.Traverse(key, &node) || !key_trie_.IsTerminalNode(node)) {
+      return {};
+    }
+    return GetTokens(key_trie_.GetKeyIdOfTerminalNode(node));
+  }
+
+  // Returns the tokens whose key starts with `prefix`, sorted by key and then
+  // by POS id.
+  absl::Span<const UserPos::Token> FindPredictive(
+      absl::string_view prefix) const {
+    if (empty()) {
+      return {};
+    }
+    LoudsTrie::Node node;
+    if (!key_trie_.Traverse(prefix, &node)) {
+      return {};
+    }
+    // The children are ordered by the edge label, so the smallest key in the
+    // subtree is reached by following the first children and the largest one
+    // by following the last children. Every leaf is a terminal node.
+    LoudsTrie::Node first = node;
+    while (!key_trie_.IsTerminalNode(first)) {
+      key_trie_.MoveToFirstChild(&first);
+    }
+    LoudsTrie::Node last = node;
+    for (LoudsTrie::Node child = key_trie_.MoveToFirstChild(last);
+         key_trie_.IsValidNode(child);
+         child = key_trie_.MoveToFirstChild(last)) {
+      do {
+        last = child;
+        LoudsTrie::MoveToNextSibling(&child);
+      } while (key_trie_.IsValidNode(child));
+    }
+    const uint32_t begin =
+        key_ranges_[key_trie_.GetKeyIdOfTerminalNode(first)].begin;
+    const uint32_t end =
+        key_ranges_[key_trie_.GetKeyIdOfTerminalNode(last)].end;
+    return absl::MakeConstSpan(user_pos_tokens_).subspan(begin, end - begin);
+  }
+
+  // Calls `func` with the tokens of each key that is a prefix of `key`, from
+  // the shortest key. Stops when `func` returns false.
+  template <typename Func>
+  void ForEachPrefix(absl::string_view key, Func func) const {
+    if (empty()) {
+      return;
+    }
+    LoudsTrie::Node node;
+    for (size_t i = 0; i < key.size();) {
+      if (!key_trie_.MoveToChildByLabel(key[i], &node)) {
+        return;
+      }
+      ++i;
+      if (key_trie_.IsTerminalNode(node) &&
+          !func(GetTokens(key_trie_.GetKeyIdOfTerminalNode(node)))) {
+        return;
+      }
+    }
   }
 
   void Load(const user_dictionary::UserDictionaryStorage& storage,
             std::atomic<bool>* canceled_signal) {
     DCHECK(canceled_signal);
     user_pos_tokens_.clear();
+    suppression_dictionary_.reset();
     absl::flat_hash_set<uint64_t> seen;
+    SuppressionDictionary suppression_dictionary;
 
     for (const UserDictionaryStorage::UserDictionary& dic :
          storage.dictionaries()) {
@@ -173,6 +190,7 @@ class UserDictionary::TokensIndex {
            dic.entries()) {
         if (canceled_signal->load()) {
           LOG(INFO) << "User dictionary loading is canceled";
+          user_pos_tokens_.clear();
           return;
         }
 
@@ -200,7 +218,7 @@ class UserDictionary::TokensIndex {
 
         if (entry.pos() == user_dictionary::UserDictionary::SUPPRESSION_WORD) {
           // "抑制単語"
-          suppression_dictionary_.AddEntry(std::move(reading), entry.value());
+          suppression_dictionary.AddEntry(std::move(reading), entry.value());
         } else {
           const absl::string_view comment =
               absl::StripAsciiWhitespace(entry.comment());
@@ -213,26 +231,83 @@ class UserDictionary::TokensIndex {
       }
     }
     user_pos_tokens_.shrink_to_fit();
+    if (!suppression_dictionary.IsEmpty()) {
+      suppression_dictionary_ = std::make_shared<const SuppressionDictionary>(
+          std::move(suppression_dictionary));
+    }
 
     // Sort first by key and then by POS ID.
     std::sort(user_pos_tokens_.begin(), user_pos_tokens_.end(),
               OrderByKeyThenById());
+    BuildKeyTrie();
 
     MOZC_VLOG(1) << user_pos_tokens_.size() << " user dic entries loaded";
   }
 
-  bool IsSuppressedEntry(absl::string_view key, absl::string_view value) const {
-    return suppression_dictionary_.IsSuppressedEntry(key, value);
+  // Returns nullptr if there's no suppression entry.
+  const std::shared_ptr<const SuppressionDictionary>& suppression_dictionary()
+      const {
+    return suppression_dictionary_;
+  }
+
+ private:
+  // The range of `user_pos_tokens_` sharing the same key.
+  struct TokenRange {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  // Builds the trie of the distinct keys of the sorted `user_pos_tokens_` and
+  // maps each key id to its token range.
+  void BuildKeyTrie() {
+    if (user_pos_tokens_.empty()) {
+      return;
+    }
+    LoudsTrieBuilder builder;
+    std::vector<TokenRange> ranges;
+    for (uint32_t i = 0; i < user_pos_tokens_.size();) {
+      const std::string& key = user_pos_tokens_[i].key;
+      uint32_t end = i + 1;
+      while (end < user_pos_tokens_.size() &&
+             user_pos_tokens_[end].key == key) {
+        ++end;
+      }
+      builder.Add(key);
+      ranges.push_back({i, end});
+      i = end;
+    }
+    builder.Build();
+
+    // The builder assigns key ids in the breadth-first order of the trie.
+    key_ranges_.resize(ranges.size());
+    for (const TokenRange& range : ranges) {
+      const int key_id = builder.GetId(user_pos_tokens_[range.begin].key);
+      DCHECK_GE(key_id, 0);
+      key_ranges_[key_id] = range;
+    }
+    key_trie_image_ = std::string(builder.image());
+    CHECK(key_trie_.Open(
+        reinterpret_cast<const uint8_t*>(key_trie_image_.data()),
+        kKeyTrieLb0CacheSize, kKeyTrieLb1CacheSize, kKeyTrieSelect0CacheSize,
+        kKeyTrieSelect1CacheSize, kKeyTrieTermvecCacheSize,
+        SimpleSuccinctBitVectorIndex::RANK9_INDEX));
   }
 
-  bool HasSuppressedEntries() const {
-    return !suppression_dictionary_.IsEmpty();
+  absl::Span<const UserPos::Token> GetTokens(int key_id) const {
+    const TokenRange& range = key_ranges_[key_id];
+    return absl::MakeConstSpan(user_pos_tokens_)
+        .subspan(range.begin, range.end - range.begin);
   }
 
- private:
   const UserPos& user_pos_;
-  SuppressionDictionary suppression_dictionary_;
+  std::shared_ptr<const SuppressionDictionary> suppression_dictionary_;
+  // Sorted by key and then by POS id.
   std::vector<UserPos::Token> user_pos_tokens_;
+  // Index of the distinct keys of `user_pos_tokens_`. Built on load so that
+  // the lookups don't depend on the number of entries.
+  std::string key_trie_image_;
+  LoudsTrie key_trie_;
+  std::vector<TokenRange> key_ranges_;
 };
 
 class UserDictionary::UserDictionaryReloader {
@@ -324,6 +399,10 @@ bool UserDictionary::HasKey(absl::string_view key) const {
   return false;
 }
 
+bool UserDictionary::MayHaveKeyWithPrefix(absl::string_view prefix) const {
+  return GetTokens()->MayHaveKeyWithPrefix(prefix);
+}
+
 bool UserDictionary::HasValue(absl::string_view value) const {
   // TODO(noriyukit): Currently, we don't support HasValue() for user dictionary
   // because we need to search tokens linearly, which might be slow in extreme
@@ -345,12 +424,8 @@ void UserDictionary::LookupPredictive(absl::string_view key,
     return;
   }
 
-  // Find the starting point of iteration over dictionary contents.
-  Token token;
-  for (auto [begin, end] = std::equal_range(tokens->begin(), tokens->end(), key,
-                                            OrderByKeyPrefix());
-       begin != end; ++begin) {
-    const UserPos::Token& user_pos_token = *begin;
+  TokenView token;
+  for (const UserPos::Token& user_pos_token : tokens->FindPredictive(key)) {
     switch (callback->OnKey(user_pos_token.key)) {
       case Callback::TRAVERSE_DONE:
         return;
@@ -367,7 +442,7 @@ void UserDictionary::LookupPredictive(absl::string_view key,
       return;
     }
     PopulateTokenFromUserPosToken(user_pos_token, PREDICTIVE, &token);
-    if (callback->OnToken(user_pos_token.key, user_pos_token.key, token) ==
+    if (callback->OnTokenView(user_pos_token.key, user_pos_token.key, token) ==
         Callback::TRAVERSE_DONE) {
       return;
     }
@@ -388,50 +463,43 @@ void UserDictionary::LookupPrefix(absl::string_view key,
     return;
   }
 
-  // Find the starting point for iteration over dictionary contents.
-  const absl::string_view first_char = Utf8AsChars(key).front();
-  Token token;
-  for (auto it = std::lower_bound(tokens->begin(), tokens->end(), first_char,
-                                  OrderByKey());
-       it != tokens->end(); ++it) {
-    const UserPos::Token& user_pos_token = *it;
-    if (user_pos_token.key > key) {
-      break;
-    }
-    if (user_pos_token.pos_type() ==
-        user_dictionary::UserDictionary::SUGGESTION_ONLY) {
-      continue;
-    }
-    if (!key.starts_with(user_pos_token.key)) {
-      continue;
-    }
-    switch (callback->OnKey(user_pos_token.key)) {
-      case Callback::TRAVERSE_DONE:
-        return;
-      case Callback::TRAVERSE_NEXT_KEY:
+  TokenView token;
+  tokens->ForEachPrefix(key, [&](absl::Span<const UserPos::Token> key_tokens) {
+    for (const UserPos::Token& user_pos_token : key_tokens) {
+      if (user_pos_token.pos_type() ==
+          user_dictionary::UserDictionary::SUGGESTION_ONLY) {
         continue;
-      case Callback::TRAVERSE_CULL:
-        LOG(FATAL) << "UserDictionary doesn't support culling.";
-        break;
-      default:
-        break;
-    }
-    if (callback->OnActualKey(user_pos_token.key, user_pos_token.key,
-                              /* num_expanded= */ 0) ==
-        Callback::TRAVERSE_DONE) {
-      return;
-    }
-    PopulateTokenFromUserPosToken(user_pos_token, PREFIX, &token);
-    switch (callback->OnToken(user_pos_token.key, user_pos_token.key, token)) {
-      case Callback::TRAVERSE_DONE:
-        return;
-      case Callback::TRAVERSE_CULL:
-        LOG(FATAL) << "UserDictionary doesn't support culling.";
-        break;
-      default:
-        break;
+      }
+      switch (callback->OnKey(user_pos_token.key)) {
+        case Callback::TRAVERSE_DONE:
+          return false;
+        case Callback::TRAVERSE_NEXT_KEY:
+          continue;
+        case Callback::TRAVERSE_CULL:
+          LOG(FATAL) << "UserDictionary doesn't support culling.";
+          break;
+        default:
+          break;
+      }
+      if (callback->OnActualKey(user_pos_token.key, user_pos_token.key,
+                                /* num_expanded= */ 0) ==
+          Callback::TRAVERSE_DONE) {
+        return false;
+      }
+      PopulateTokenFromUserPosToken(user_pos_token, PREFIX, &token);
+      switch (callback->OnTokenView(user_pos_token.key, user_pos_token.key,
+                                    token)) {
+        case Callback::TRAVERSE_DONE:
+          return false;
+        case Callback::TRAVERSE_CULL:
+          LOG(FATAL) << "UserDictionary doesn't support culling.";
+          break;
+        default:
+          break;
+      }
     }
-  }
+    return true;
+  });
 }
 
 void UserDictionary::LookupExact(absl::string_view key,
@@ -441,9 +509,8 @@ void UserDictionary::LookupExact(absl::string_view key,
   if (key.empty() || tokens->empty()) {
     return;
   }
-  auto [begin, end] =
-      std::equal_range(tokens->begin(), tokens->end(), key, OrderByKey());
-  if (begin == end) {
+  const absl::Span<const UserPos::Token> key_tokens = tokens->FindExact(key);
+  if (key_tokens.empty()) {
     return;
   }
   if (callback->OnKey(key) != Callback::TRAVERSE_CONTINUE) {
@@ -454,15 +521,14 @@ void UserDictionary::LookupExact(absl::string_view key,
     return;
   }
 
-  Token token;
-  for (; begin != end; ++begin) {
-    const UserPos::Token& user_pos_token = *begin;
+  TokenView token;
+  for (const UserPos::Token& user_pos_token : key_tokens) {
     if (user_pos_token.pos_type() ==
         user_dictionary::UserDictionary::SUGGESTION_ONLY) {
       continue;
     }
     PopulateTokenFromUserPosToken(user_pos_token, EXACT, &token);
-    if (callback->OnToken(key, key, token) != Callback::TRAVERSE_CONTINUE) {
+    if (callback->OnTokenView(key, key, token) != Callback::TRAVERSE_CONTINUE) {
       return;
     }
   }
@@ -485,10 +551,7 @@ bool UserDictionary::LookupComment(absl::string_view key,
   }
 
   // Set the comment that was found first.
-  for (auto [begin, end] =
-           std::equal_range(tokens->begin(), tokens->end(), key, OrderByKey());
-       begin != end; ++begin) {
-    const UserPos::Token& token = *begin;
+  for (const UserPos::Token& token : tokens->FindExact(key)) {
     if (token.value == value && !token.comment.empty()) {
       comment->assign(token.comment);
       return true;
@@ -499,11 +562,19 @@ bool UserDictionary::LookupComment(absl::string_view key,
 
 bool UserDictionary::IsSuppressedEntry(absl::string_view key,
                                        absl::string_view value) const {
-  return GetTokens()->IsSuppressedEntry(key, value);
+  const std::shared_ptr<const SuppressionDictionary> suppression_dictionary =
+      GetSuppressionDictionary();
+  return suppression_dictionary &&
+         suppression_dictionary->IsSuppressedEntry(key, value);
 }
 
 bool UserDictionary::HasSuppressedEntries() const {
-  return GetTokens()->HasSuppressedEntries();
+  return GetSuppressionDictionary() != nullptr;
+}
+
+std::shared_ptr<const SuppressionDictionary>
+UserDictionary::GetSuppressionDictionary() const {
+  return GetTokens()->suppression_dictionary();
 }
 
 bool UserDictionary::Reload() {
@@ -541,7 +612,7 @@ std::string UserDictionary::GetFileName() const { return filename_; }
 
 void UserDictionary::PopulateTokenFromUserPosToken(
     const UserPos::Token& user_pos_token, RequestType request_type,
-    Token* token) const {
+    TokenView* token) const {
   token->key = user_pos_token.key;
   token->value = user_pos_token.value;
   token->lid = token->rid = user_pos_token.id;
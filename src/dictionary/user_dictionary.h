@@ -31,6 +31,7 @@
 #define MOZC_DICTIONARY_USER_DICTIONARY_H_
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -44,6 +45,7 @@
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_token.h"
 #include "dictionary/pos_matcher.h"
+#include "dictionary/suppression_dictionary.h"
 #include "dictionary/user_pos.h"
 #include "protocol/user_dictionary_storage.pb.h"
 
@@ -65,6 +67,7 @@ class UserDictionary : public UserDictionaryInterface {
   ~UserDictionary() override;
 
   bool HasKey(absl::string_view key) const override;
+  bool MayHaveKeyWithPrefix(absl::string_view prefix) const override;
   bool HasValue(absl::string_view value) const override;
 
   // Lookup methods don't support kana modifier insensitive lookup, i.e.,
@@ -87,6 +90,9 @@ class UserDictionary : public UserDictionaryInterface {
 
   bool HasSuppressedEntries() const override;
 
+  std::shared_ptr<const SuppressionDictionary> GetSuppressionDictionary()
+      const override;
+
   // Loads dictionary from UserDictionaryStorage.
   // mainly for unit testing
   bool Load(const user_dictionary::UserDictionaryStorage& storage) override;
@@ -102,15 +108,18 @@ class UserDictionary : public UserDictionaryInterface {
 
   enum RequestType { PREFIX, PREDICTIVE, EXACT };
 
-  // Populates Token from UserToken.
+  // Populates TokenView from UserToken. The view refers to the strings of
+  // `user_pos_token`.
   // This method sets the actual cost and rewrites POS id depending
   // on the POS and attribute.
   void PopulateTokenFromUserPosToken(const UserPos::Token& user_pos_token,
                                      RequestType request_type,
-                                     Token* token) const;
+                                     TokenView* token) const;
 
   std::string GetFileName() const override;
 
+  uint64_t GetGeneration() const override { return generation_.load(); }
+
  private:
   class TokensIndex;
   class UserDictionaryReloader;
@@ -122,6 +131,7 @@ class UserDictionary : public UserDictionaryInterface {
   void SetTokens(std::shared_ptr<TokensIndex> tokens) {
     DCHECK(tokens);
     tokens_.store(std::move(tokens));
+    generation_.fetch_add(1);
   }
 
   std::unique_ptr<UserDictionaryReloader> reloader_;
@@ -133,6 +143,9 @@ class UserDictionary : public UserDictionaryInterface {
   // TODO(all): use std::atomic<std::shared_ptr> once it gets available.
   AtomicSharedPtr<TokensIndex> tokens_;
 
+  // Incremented every time `tokens_` is replaced.
+  std::atomic<uint64_t> generation_ = 0;
+
   // Signal variable to cancel the dictionary loading thread.
   // We want to immediately cancel the loading thread in the detractor of
   // UserDictionary. This variable is shared by the main thread and loader
@@ -0,0 +1,195 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Microbenchmarks for UserDictionary lookups on large user dictionaries.
+//
+// The dictionaries hold synthetic hiragana entries, imitating imported
+// glossaries, plus the words of a few sentences so that the lookups hit.
+// The benchmarks are run with 10k, 100k and 1M entries and report the time
+// per lookup, the number of visited tokens per lookup and the number of heap
+// allocations per lookup.
+//
+// Example:
+//   bazel run -c opt //dictionary:user_dictionary_benchmark --
+//     --benchmark_filter=LookupPrefix
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/base/no_destructor.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/random/random.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "base/container/tuple.h"
+#include "base/random.h"
+#include "base/strings/unicode.h"
+#include "benchmark/benchmark.h"
+#include "data_manager/data_manager.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "dictionary/dictionary_interface.h"
+#include "dictionary/lookup_benchmark_util.h"
+#include "dictionary/pos_matcher.h"
+#include "dictionary/user_dictionary.h"
+#include "dictionary/user_pos.h"
+#include "protocol/user_dictionary_storage.pb.h"
+
+namespace mozc {
+namespace dictionary {
+namespace {
+
+using ::mozc::user_dictionary::UserDictionaryStorage;
+using UserDictionaryProto = ::mozc::user_dictionary::UserDictionary;
+
+const DataManager& GetDataManager() {
+  static const absl::NoDestructor<oss::OssDataManager> data_manager;
+  return *data_manager;
+}
+
+std::unique_ptr<UserDictionary> CreateUserDictionary() {
+  const DataManager& data_manager = GetDataManager();
+  // The file doesn't exist, so the dictionary is filled only by Load().
+  return std::make_unique<UserDictionary>(
+      make_unique_from_tuples<UserPos>(data_manager.GetUserPosData()),
+      PosMatcher(data_manager.GetPosMatcherData()),
+      "/nonexistent/user_dictionary.db");
+}
+
+// Returns a storage with `size` entries.
+UserDictionaryStorage MakeStorage(int64_t size) {
+  UserDictionaryStorage storage;
+  UserDictionaryProto* dic = storage.add_dictionaries();
+  auto add_entry = [dic](std::string key) {
+    UserDictionaryProto::Entry* entry = dic->add_entries();
+    entry->set_value(absl::StrCat("単語", dic->entries_size()));
+    entry->set_key(std::move(key));
+    entry->set_pos(UserDictionaryProto::NOUN);
+  };
+  // The words of the sentences are registered so that the lookups hit.
+  for (absl::string_view sentence : kSentences) {
+    for (absl::string_view rest = sentence; !rest.empty();
+         rest.remove_prefix(strings::OneCharLen(rest.front()))) {
+      for (size_t len = 2; len <= 4; ++len) {
+        const absl::string_view word = strings::Utf8Substring(rest, 0, len);
+        if (strings::CharsLen(word) == len) {
+          add_entry(std::string(word));
+        }
+      }
+    }
+  }
+  Random random(std::seed_seq{0});
+  while (dic->entries_size() < size) {
+    const size_t len = absl::Uniform<size_t>(random, 2, 9);
+    add_entry(random.Utf8String(len, U'ぁ', U'ん'));
+  }
+  return storage;
+}
+
+// Returns the dictionary with `size` entries, which is built only once.
+const UserDictionary& GetUserDictionary(int64_t size) {
+  static absl::NoDestructor<
+      absl::flat_hash_map<int64_t, std::unique_ptr<UserDictionary>>>
+      dictionaries;
+  std::unique_ptr<UserDictionary>& dictionary = (*dictionaries)[size];
+  if (!dictionary) {
+    dictionary = CreateUserDictionary();
+    dictionary->Load(MakeStorage(size));
+  }
+  return *dictionary;
+}
+
+void BM_LookupPrefixSentence(benchmark::State& state) {
+  const std::vector<std::string> keys = MakeSuffixes(kSentences);
+  RunLookups(state, GetUserDictionary(state.range(0)), keys,
+             /* kana_modifier_insensitive= */ false,
+             [](const UserDictionary& dictionary, absl::string_view key,
+                DictionaryInterface::Callback* callback) {
+               dictionary.LookupPrefix(key, callback);
+             });
+}
+BENCHMARK(BM_LookupPrefixSentence)
+    ->ArgName("entries")
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+void BM_LookupPredictiveShortPrefix(benchmark::State& state) {
+  const std::vector<std::string> keys(std::begin(kShortPrefixes),
+                                      std::end(kShortPrefixes));
+  RunLookups(state, GetUserDictionary(state.range(0)), keys,
+             /* kana_modifier_insensitive= */ false,
+             [](const UserDictionary& dictionary, absl::string_view key,
+                DictionaryInterface::Callback* callback) {
+               dictionary.LookupPredictive(key, callback);
+             });
+}
+BENCHMARK(BM_LookupPredictiveShortPrefix)
+    ->ArgName("entries")
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+void BM_LookupExactSentence(benchmark::State& state) {
+  const std::vector<std::string> keys = MakeSuffixes(kSentences);
+  RunLookups(state, GetUserDictionary(state.range(0)), keys,
+             /* kana_modifier_insensitive= */ false,
+             [](const UserDictionary& dictionary, absl::string_view key,
+                DictionaryInterface::Callback* callback) {
+               dictionary.LookupExact(key, callback);
+             });
+}
+BENCHMARK(BM_LookupExactSentence)
+    ->ArgName("entries")
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+// Measures Load(), which builds the index on every reload.
+void BM_Load(benchmark::State& state) {
+  const UserDictionaryStorage storage = MakeStorage(state.range(0));
+  std::unique_ptr<UserDictionary> dictionary = CreateUserDictionary();
+  for (auto _ : state) {
+    dictionary->Load(storage);
+  }
+}
+BENCHMARK(BM_Load)
+    ->ArgName("entries")
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace dictionary
+}  // namespace mozc
@@ -30,11 +30,13 @@
 #ifndef MOZC_DICTIONARY_USER_DICTIONARY_STUB_H_
 #define MOZC_DICTIONARY_USER_DICTIONARY_STUB_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
 #include "dictionary/dictionary_interface.h"
+#include "dictionary/suppression_dictionary.h"
 #include "protocol/user_dictionary_storage.pb.h"
 
 namespace mozc {
@@ -65,6 +67,11 @@ class UserDictionaryStub : public UserDictionaryInterface {
   }
 
   bool HasSuppressedEntries() const override { return false; }
+
+  std::shared_ptr<const SuppressionDictionary> GetSuppressionDictionary()
+      const override {
+    return nullptr;
+  }
 };
 
 }  // namespace dictionary
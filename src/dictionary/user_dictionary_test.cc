@@ -517,6 +517,77 @@ TEST_F(UserDictionaryTest, TestLookupPrefix) {
   EXPECT_THAT(LookupPrefix("starting", *dic), IsEmpty());
 }
 
+TEST_F(UserDictionaryTest, MayHaveKeyWithPrefix) {
+  std::unique_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
+  // Wait for async reload called from the constructor.
+  dic->WaitForReloader();
+
+  {
+    UserDictionaryStorage storage("");
+    LoadFromString(kUserDictionary0, &storage);
+    dic->Load(storage.GetProto());
+  }
+
+  EXPECT_TRUE(dic->MayHaveKeyWithPrefix("s"));
+  EXPECT_TRUE(dic->MayHaveKeyWithPrefix("star"));
+  EXPECT_TRUE(dic->MayHaveKeyWithPrefix("startin"));
+  EXPECT_TRUE(dic->MayHaveKeyWithPrefix("starting"));
+  EXPECT_FALSE(dic->MayHaveKeyWithPrefix("startx"));
+  EXPECT_FALSE(dic->MayHaveKeyWithPrefix("startings"));
+}
+
+TEST_F(UserDictionaryTest, LookupMatchesLinearScan) {
+  std::unique_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
+  // Wait for async reload called from the constructor.
+  dic->WaitForReloader();
+
+  // Keys over a few characters share many prefixes. The lookups through the
+  // key trie must return the same entries as scanning all the entries.
+  Random random;
+  std::vector<Entry> entries;
+  {
+    UserDictionaryStorage storage("");
+    UserDictionaryStorage::UserDictionary* user_dic =
+        storage.GetProto().add_dictionaries();
+    for (int i = 0; i < 500; ++i) {
+      UserDictionaryStorage::UserDictionaryEntry* entry =
+          user_dic->add_entries();
+      entry->set_key(random.Utf8StringRandomLen(4, U'か', U'く'));
+      entry->set_value(absl::StrCat("value", i));
+      entry->set_pos(user_dictionary::UserDictionary::NOUN);
+      entries.push_back({.key = entry->key(),
+                         .value = entry->value(),
+                         .lid = 100,
+                         .rid = 100});
+    }
+    dic->Load(storage.GetProto());
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    const std::string key = random.Utf8StringRandomLen(5, U'か', U'く');
+    std::vector<Entry> prefix, predictive, exact;
+    for (const Entry& entry : entries) {
+      if (key.starts_with(entry.key)) {
+        prefix.push_back(entry);
+      }
+      if (entry.key.starts_with(key)) {
+        predictive.push_back(entry);
+      }
+      if (entry.key == key) {
+        exact.push_back(entry);
+      }
+    }
+    EXPECT_THAT(LookupPrefix(key, *dic), UnorderedElementsAreArray(prefix))
+        << key;
+    EXPECT_THAT(LookupPredictive(key, *dic),
+                UnorderedElementsAreArray(predictive))
+        << key;
+    EXPECT_THAT(LookupExact(key, *dic), UnorderedElementsAreArray(exact))
+        << key;
+    EXPECT_EQ(dic->MayHaveKeyWithPrefix(key), !predictive.empty()) << key;
+  }
+}
+
 TEST_F(UserDictionaryTest, TestLookupExact) {
   std::unique_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
   // Wait for async reload called from the constructor.
@@ -870,6 +941,17 @@ TEST_F(UserDictionaryTest, TestSuggestionOnlyWord) {
   }
 }
 
+TEST_F(UserDictionaryTest, GetGeneration) {
+  std::unique_ptr<UserDictionary> user_dic(CreateDictionaryWithMockPos());
+  user_dic->WaitForReloader();
+  const uint64_t generation = user_dic->GetGeneration();
+  EXPECT_EQ(user_dic->GetGeneration(), generation);
+
+  user_dictionary::UserDictionaryStorage storage;
+  user_dic->Load(storage);
+  EXPECT_NE(user_dic->GetGeneration(), generation);
+}
+
 TEST_F(UserDictionaryTest, LookupComment) {
   std::unique_ptr<UserDictionary> dic(CreateDictionaryWithMockPos());
   // Wait for async reload called from the constructor.
@@ -927,7 +1009,7 @@ TEST_F(UserDictionaryTest, TestPopulateTokenFromUserPosToken) {
                               SA_IRREGULAR_CONJUGATION_NOUN);  // 名詞サ変
 
   const int expected_cost = UserPos::GetCostFromPosType(user_token.pos_type());
-  Token token;
+  TokenView token;
 
   dic->PopulateTokenFromUserPosToken(user_token, UserDictionary::PREFIX,
                                      &token);
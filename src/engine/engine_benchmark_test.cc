@@ -0,0 +1,449 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// End-to-end keystroke latency benchmark.
+//
+// Replays a session scenario (the format of session_handler_main, e.g.
+// session/session_handler_main_sample.tsv) through SessionHandler with the
+// OSS data, and reports the p50/p95/p99 latency per keystroke. The latency is
+// split into the following phases:
+//   composer:   everything outside of the converter, i.e. the session, the
+//               composer and the output construction.
+//   prediction: PredictorInterface::Predict and Finish.
+//   conversion: ImmutableConverterInterface::Convert.
+//   rewriter:   RewriterInterface::Rewrite, Focus and Finish.
+// Time spent in nested calls (e.g. the realtime conversion inside the
+// predictor) is attributed to the innermost phase.
+//
+// Example:
+//   bazel run -c opt //engine:engine_benchmark_test --
+//     --scenario=$PWD/data/test/session/scenario/conversion.txt
+
+#include <algorithm>
+#include <array>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "base/file/temp_dir.h"
+#include "base/file_stream.h"
+#include "base/strings/unicode.h"
+#include "base/system_util.h"
+#include "benchmark/benchmark.h"
+#include "converter/converter.h"
+#include "converter/converter_interface.h"
+#include "converter/immutable_converter.h"
+#include "converter/immutable_converter_interface.h"
+#include "converter/segments.h"
+#include "data_manager/oss/oss_data_manager.h"
+#include "engine/engine.h"
+#include "engine/engine_converter.h"
+#include "engine/engine_converter_interface.h"
+#include "engine/engine_interface.h"
+#include "engine/modules.h"
+#include "prediction/predictor.h"
+#include "prediction/predictor_interface.h"
+#include "prediction/result.h"
+#include "request/conversion_request.h"
+#include "rewriter/rewriter.h"
+#include "rewriter/rewriter_interface.h"
+#include "session/session_handler_tool.h"
+#include "testing/mozctest.h"
+
+ABSL_FLAG(std::string, scenario, "",
+          "Scenario file in the format of session_handler_main. "
+          "session/session_handler_main_sample.tsv is used if empty.");
+
+namespace mozc {
+namespace {
+
+enum Phase {
+  kComposer = 0,
+  kPrediction,
+  kConversion,
+  kRewriter,
+  kNumPhases,
+};
+
+constexpr std::array<absl::string_view, kNumPhases> kPhaseNames = {
+    "composer", "prediction", "conversion", "rewriter"};
+
+using Clock = std::chrono::steady_clock;
+
+// Accumulates exclusive time per phase. Nested scopes pause the enclosing
+// phase, so that each nanosecond is attributed to exactly one phase.
+// The benchmark is single threaded.
+class PhaseTimer {
+ public:
+  class Scope {
+   public:
+    Scope(PhaseTimer& timer, Phase phase) : timer_(timer) {
+      timer_.Push(phase);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() { timer_.Pop(); }
+
+   private:
+    PhaseTimer& timer_;
+  };
+
+  // Starts a keystroke. Time outside of any scope is attributed to kComposer.
+  void Start() {
+    elapsed_.fill(Clock::duration::zero());
+    stack_.assign(1, kComposer);
+    last_ = Clock::now();
+  }
+
+  // Finishes the keystroke and returns the elapsed time per phase.
+  const std::array<Clock::duration, kNumPhases>& Stop() {
+    Flush();
+    stack_.clear();
+    return elapsed_;
+  }
+
+ private:
+  void Push(Phase phase) {
+    Flush();
+    stack_.push_back(phase);
+  }
+
+  void Pop() {
+    Flush();
+    stack_.pop_back();
+  }
+
+  void Flush() {
+    const Clock::time_point now = Clock::now();
+    if (!stack_.empty()) {
+      elapsed_[stack_.back()] += now - last_;
+    }
+    last_ = now;
+  }
+
+  std::vector<Phase> stack_;
+  Clock::time_point last_;
+  std::array<Clock::duration, kNumPhases> elapsed_;
+};
+
+PhaseTimer& GetPhaseTimer() {
+  static PhaseTimer* timer = new PhaseTimer();
+  return *timer;
+}
+
+class TimedImmutableConverter : public ImmutableConverterInterface {
+ public:
+  explicit TimedImmutableConverter(
+      std::unique_ptr<const ImmutableConverterInterface> base)
+      : base_(std::move(base)) {}
+
+  bool Convert(const ConversionRequest& request,
+               Segments* segments) const override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kConversion);
+    return base_->Convert(request, segments);
+  }
+
+ private:
+  std::unique_ptr<const ImmutableConverterInterface> base_;
+};
+
+class TimedPredictor : public prediction::PredictorInterface {
+ public:
+  explicit TimedPredictor(std::unique_ptr<prediction::PredictorInterface> base)
+      : base_(std::move(base)) {}
+
+  std::vector<prediction::Result> Predict(
+      const ConversionRequest& request) const override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kPrediction);
+    return base_->Predict(request);
+  }
+  void Finish(const ConversionRequest& request,
+              absl::Span<const prediction::Result> results,
+              uint32_t revert_id) override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kPrediction);
+    base_->Finish(request, results, revert_id);
+  }
+  void Revert(uint32_t revert_id) override { base_->Revert(revert_id); }
+  void CommitContext(const ConversionRequest& request) const override {
+    base_->CommitContext(request);
+  }
+  bool ClearAllHistory() override { return base_->ClearAllHistory(); }
+  bool ClearUnusedHistory() override { return base_->ClearUnusedHistory(); }
+  bool ClearHistoryEntry(absl::string_view key,
+                         absl::string_view value) override {
+    return base_->ClearHistoryEntry(key, value);
+  }
+  bool AddHistoryEntry(absl::string_view key,
+                       absl::string_view value) override {
+    return base_->AddHistoryEntry(key, value);
+  }
+  bool Sync() override { return base_->Sync(); }
+  bool Reload() override { return base_->Reload(); }
+  bool Wait() override { return base_->Wait(); }
+  absl::string_view GetPredictorName() const override {
+    return base_->GetPredictorName();
+  }
+
+ private:
+  std::unique_ptr<prediction::PredictorInterface> base_;
+};
+
+class TimedRewriter : public RewriterInterface {
+ public:
+  explicit TimedRewriter(std::unique_ptr<RewriterInterface> base)
+      : base_(std::move(base)) {}
+
+  int capability(const ConversionRequest& request) const override {
+    return base_->capability(request);
+  }
+  std::optional<ResizeSegmentsRequest> CheckResizeSegmentsRequest(
+      const ConversionRequest& request,
+      const Segments& segments) const override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kRewriter);
+    return base_->CheckResizeSegmentsRequest(request, segments);
+  }
+  bool Rewrite(const ConversionRequest& request,
+               Segments* segments) const override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kRewriter);
+    return base_->Rewrite(request, segments);
+  }
+  bool Focus(Segments* segments, size_t segment_index,
+             int candidate_index) const override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kRewriter);
+    return base_->Focus(segments, segment_index, candidate_index);
+  }
+  void Finish(const ConversionRequest& request,
+              const Segments& segments) override {
+    PhaseTimer::Scope scope(GetPhaseTimer(), kRewriter);
+    base_->Finish(request, segments);
+  }
+  void Revert(const Segments& segments) override { base_->Revert(segments); }
+  bool ClearHistoryEntry(const Segments& segments, size_t segment_index,
+                         int candidate_index) override {
+    return base_->ClearHistoryEntry(segments, segment_index, candidate_index);
+  }
+  bool Sync() override { return base_->Sync(); }
+  bool Reload() override { return base_->Reload(); }
+  void Clear() override { base_->Clear(); }
+
+ private:
+  std::unique_ptr<RewriterInterface> base_;
+};
+
+// Engine whose converter components are wrapped by the timers above. The
+// components are created in the same way as Engine::Init().
+class TimedEngine : public EngineInterface {
+ public:
+  static std::unique_ptr<TimedEngine> Create() {
+    absl::StatusOr<std::unique_ptr<engine::Modules>> modules =
+        engine::Modules::Create(std::make_unique<oss::OssDataManager>());
+    CHECK_OK(modules);
+    return std::unique_ptr<TimedEngine>(
+        new TimedEngine(*std::move(modules)));
+  }
+
+  std::unique_ptr<engine::EngineConverterInterface> CreateEngineConverter()
+      const override {
+    return std::make_unique<engine::EngineConverter>(converter_);
+  }
+  absl::string_view GetDataVersion() const override {
+    return converter_->modules().GetDataManager().GetDataVersion();
+  }
+  bool Reload() override { return converter_->Reload(); }
+  bool Sync() override { return converter_->Sync(); }
+  bool Wait() override { return converter_->Wait(); }
+  bool ReloadAndWait() override { return Reload() && Wait(); }
+  bool ClearUserHistory() override {
+    converter_->rewriter().Clear();
+    return true;
+  }
+  bool ClearUserPrediction() override {
+    return converter_->predictor().ClearAllHistory();
+  }
+
+ private:
+  explicit TimedEngine(std::unique_ptr<engine::Modules> modules)
+      : converter_(std::make_shared<converter::Converter>(
+            std::move(modules),
+            [](const engine::Modules& modules) {
+              return std::make_unique<TimedImmutableConverter>(
+                  std::make_unique<ImmutableConverter>(modules));
+            },
+            [](const engine::Modules& modules,
+               const ConverterInterface& converter,
+               const ImmutableConverterInterface& immutable_converter) {
+              return std::make_unique<TimedPredictor>(
+                  std::make_unique<prediction::Predictor>(
+                      modules, converter, immutable_converter));
+            },
+            [](const engine::Modules& modules) {
+              return std::make_unique<TimedRewriter>(
+                  std::make_unique<Rewriter>(modules));
+            })) {}
+
+  std::shared_ptr<converter::Converter> converter_;
+};
+
+// Reads the scenario and splits SEND_KEYS and SEND_KANA_KEYS into commands of
+// a single keystroke, so that the latency is measured per keystroke.
+std::vector<std::vector<std::string>> LoadScenario(
+    session::SessionHandlerInterpreter& interpreter) {
+  std::string path = absl::GetFlag(FLAGS_scenario);
+  if (path.empty()) {
+    path = testing::GetSourceFileOrDie(
+        {"session", "session_handler_main_sample.tsv"});
+  }
+  InputFileStream input(path);
+  std::vector<std::vector<std::string>> commands;
+  std::string line;
+  while (std::getline(input, line)) {
+    std::vector<std::string> args = interpreter.Parse(line);
+    if (args.empty() || args[0].starts_with("SHOW")) {
+      continue;
+    }
+    if (args[0] == "SEND_KEYS" && args.size() == 2) {
+      for (const char c : args[1]) {
+        commands.push_back({args[0], std::string(1, c)});
+      }
+      continue;
+    }
+    if (args[0] == "SEND_KANA_KEYS" && args.size() >= 3) {
+      absl::string_view kanas = args[2];
+      for (const char c : args[1]) {
+        if (kanas.empty()) {
+          break;
+        }
+        const size_t len = strings::OneCharLen(kanas.front());
+        commands.push_back(
+            {args[0], std::string(1, c), std::string(kanas.substr(0, len))});
+        kanas.remove_prefix(len);
+      }
+      continue;
+    }
+    commands.push_back(std::move(args));
+  }
+  return commands;
+}
+
+bool IsKeystroke(absl::string_view command) {
+  return command.starts_with("SEND_") || command.starts_with("TEST_SEND_") ||
+         command.starts_with("SUBMIT_CANDIDATE") ||
+         command.starts_with("SELECT_CANDIDATE");
+}
+
+double Percentile(std::vector<Clock::duration>& values, double p) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  const size_t index = std::min(values.size() - 1,
+                                static_cast<size_t>(values.size() * p / 100));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return std::chrono::duration<double, std::micro>(values[index]).count();
+}
+
+void RunScenario(benchmark::State& state,
+                 std::unique_ptr<EngineInterface> engine) {
+  const TempDirectory temp_dir = testing::MakeTempDirectoryOrDie();
+  SystemUtil::SetUserProfileDirectory(temp_dir.path());
+
+  session::SessionHandlerInterpreter interpreter(std::move(engine));
+  const std::vector<std::vector<std::string>> commands =
+      LoadScenario(interpreter);
+
+  PhaseTimer& timer = GetPhaseTimer();
+  std::vector<Clock::duration> total;
+  std::array<std::vector<Clock::duration>, kNumPhases> phases;
+  for (auto _ : state) {
+    state.PauseTiming();
+    interpreter.ClearAll();
+    state.ResumeTiming();
+    for (const std::vector<std::string>& args : commands) {
+      const bool is_keystroke = IsKeystroke(args[0]);
+      timer.Start();
+      const absl::Status status = interpreter.Eval(args);
+      const std::array<Clock::duration, kNumPhases>& elapsed = timer.Stop();
+      if (!status.ok()) {
+        const std::string message =
+            absl::StrCat(args[0], ": ", status.message());
+        state.SkipWithError(message.c_str());
+        return;
+      }
+      if (!is_keystroke) {
+        continue;
+      }
+      Clock::duration sum = Clock::duration::zero();
+      for (size_t i = 0; i < kNumPhases; ++i) {
+        phases[i].push_back(elapsed[i]);
+        sum += elapsed[i];
+      }
+      total.push_back(sum);
+    }
+  }
+
+  state.counters["keystrokes"] = benchmark::Counter(
+      total.size(), benchmark::Counter::kIsRate);
+  for (const int p : {50, 95, 99}) {
+    state.counters[absl::StrCat("p", p, "_us")] = Percentile(total, p);
+    for (size_t i = 0; i < kNumPhases; ++i) {
+      state.counters[absl::StrCat(kPhaseNames[i], "_p", p, "_us")] =
+          Percentile(phases[i], p);
+    }
+  }
+}
+
+// Measures the engine created by Engine::CreateEngine(). Only the total
+// latency is meaningful as all the time is attributed to the composer phase.
+void BM_EngineKeystroke(benchmark::State& state) {
+  absl::StatusOr<std::unique_ptr<Engine>> engine =
+      Engine::CreateEngine(std::make_unique<oss::OssDataManager>());
+  CHECK_OK(engine);
+  RunScenario(state, *std::move(engine));
+}
+BENCHMARK(BM_EngineKeystroke)->Unit(benchmark::kMillisecond);
+
+// Measures the same engine with the latency split into phases.
+void BM_EngineKeystrokePhases(benchmark::State& state) {
+  RunScenario(state, TimedEngine::Create());
+}
+BENCHMARK(BM_EngineKeystrokePhases)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mozc
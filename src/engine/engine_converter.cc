@@ -44,6 +44,7 @@
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "base/latency_tracer.h"
 #include "base/text_normalizer.h"
 #include "base/util.h"
 #include "base/vlog.h"
@@ -127,6 +128,10 @@ EngineConverter::EngineConverter(
   conversion_preferences_.use_history = true;
   conversion_preferences_.request_suggestion = true;
   candidate_list_.set_page_size(request_->candidate_page_size());
+  // The segments are rebuilt on every key stroke. Reuse the segments and
+  // candidates to avoid reallocating their strings.
+  segments_.set_recycling_enabled(true);
+  incognito_segments_.set_recycling_enabled(true);
   SetConfig(std::move(config));
 }
 
@@ -150,6 +155,9 @@ bool EngineConverter::Convert(const composer::Composer& composer) {
 bool EngineConverter::ConvertWithPreferences(
     const composer::Composer& composer,
     const ConversionPreferences& preferences) {
+  static const LatencyTracer::StageId kLatencyStage =
+      LatencyTracer::RegisterStage("engine_converter/convert");
+  ScopedLatencyTimer latency_timer(kLatencyStage);
   DCHECK(CheckState(COMPOSITION | SUGGESTION | CONVERSION));
 
   DCHECK(request_);
@@ -495,6 +503,9 @@ bool EngineConverter::Suggest(const composer::Composer& composer,
 bool EngineConverter::SuggestWithPreferences(
     const composer::Composer& composer, const commands::Context& context,
     const ConversionPreferences& preferences) {
+  static const LatencyTracer::StageId kLatencyStage =
+      LatencyTracer::RegisterStage("engine_converter/suggest");
+  ScopedLatencyTimer latency_timer(kLatencyStage);
   DCHECK(CheckState(COMPOSITION | SUGGESTION));
   candidate_list_visible_ = false;
 
@@ -621,6 +632,9 @@ bool EngineConverter::IsEmptySegment(const Segment& segment) const {
 bool EngineConverter::PredictWithPreferences(
     const composer::Composer& composer,
     const ConversionPreferences& preferences) {
+  static const LatencyTracer::StageId kLatencyStage =
+      LatencyTracer::RegisterStage("engine_converter/predict");
+  ScopedLatencyTimer latency_timer(kLatencyStage);
   // TODO(komatsu): DCHECK should be
   // DCHECK(CheckState(COMPOSITION | SUGGESTION | PREDICTION));
   DCHECK(CheckState(COMPOSITION | SUGGESTION | CONVERSION | PREDICTION));
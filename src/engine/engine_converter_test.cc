@@ -65,6 +65,7 @@
 #include "protocol/config.pb.h"
 #include "request/conversion_request.h"
 #include "request/request_test_util.h"
+#include "testing/allocation_counter.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
 #include "testing/mozctest.h"
@@ -157,6 +158,10 @@ class EngineConverterTest : public testing::TestWithTempUserProfile {
     converter->state_ = state;
   }
 
+  static void SetRecyclingEnabled(bool enabled, EngineConverter* converter) {
+    converter->segments_.set_recycling_enabled(enabled);
+  }
+
   static size_t GetSegmentIndex(const EngineConverter& converter) {
     return converter.segment_index_;
   }
@@ -2314,6 +2319,56 @@ TEST_F(EngineConverterTest, SuggestFillIncognitoCandidateWords) {
   }
 }
 
+TEST_F(EngineConverterTest, SuggestRecyclesSegments) {
+  // Emulates the converter, which rebuilds the conversion segment with new
+  // candidates on every key stroke.
+  constexpr int kNumCandidates = 10;
+  const std::string long_value(64, 'x');
+  int64_t converter_allocations = 0;
+  auto mock_converter = std::make_shared<MockConverter>();
+  EXPECT_CALL(*mock_converter, StartPrediction(_, _))
+      .WillRepeatedly([&](const ConversionRequest&, Segments* segments) {
+        testing::AllocationCounter counter;
+        Segment* segment = segments->add_segment();
+        segment->set_key(kChars_Mo);
+        for (int i = 0; i < kNumCandidates; ++i) {
+          converter::Candidate* candidate = segment->add_candidate();
+          candidate->key = long_value;
+          candidate->content_key = long_value;
+          candidate->value = long_value;
+          candidate->content_value = long_value;
+        }
+        converter_allocations += counter.num_allocations();
+        return true;
+      });
+  EngineConverter converter(mock_converter, request_, config_);
+  composer_->InsertCharacterPreedit(kChars_Mo);
+
+  auto type_keys = [&](int num_keys) {
+    testing::AllocationCounter counter;
+    for (int i = 0; i < num_keys; ++i) {
+      EXPECT_TRUE(converter.Suggest(*composer_, Context::default_instance()));
+    }
+    return counter.num_allocations();
+  };
+
+  // Warm up.
+  type_keys(2);
+  converter_allocations = 0;
+
+  // The segment, the candidates and their strings are reused.
+  constexpr int kNumKeys = 10;
+  const int64_t recycled_allocations = type_keys(kNumKeys);
+  EXPECT_EQ(converter_allocations, 0);
+
+  // Without recycling, every key stroke allocates the candidates and their
+  // strings again.
+  SetRecyclingEnabled(false, &converter);
+  const int64_t allocations = type_keys(kNumKeys);
+  EXPECT_GT(converter_allocations, kNumKeys * kNumCandidates * 4);
+  EXPECT_LE(recycled_allocations + kNumKeys * kNumCandidates * 4, allocations);
+}
+
 TEST_F(EngineConverterTest, OnePhaseSuggestion) {
   auto mock_converter = std::make_shared<MockConverter>();
   EngineConverter converter(mock_converter, request_, config_);
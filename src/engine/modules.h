@@ -132,6 +132,7 @@ class Modules {
 
   std::unique_ptr<const DataManager> data_manager_;
   std::unique_ptr<const dictionary::PosMatcher> pos_matcher_;
+  Connector::Layout connector_layout_ = Connector::Layout::kCompressed;
   Connector connector_;
   std::unique_ptr<const Segmenter> segmenter_;
   std::unique_ptr<dictionary::UserDictionaryInterface> user_dictionary_;
@@ -170,6 +171,10 @@ class ModulesPresetBuilder {
           single_kanji_dictionary);
   ModulesPresetBuilder& PresetSupplementalModel(
       std::unique_ptr<engine::SupplementalModelInterface> supplemental_model);
+  // Selects how the connector stores the transition costs. The dense layout
+  // uses more memory in exchange for faster lookups. The default is the dense
+  // layout if --dense_connector is set, and the compressed layout otherwise.
+  ModulesPresetBuilder& PresetConnectorLayout(Connector::Layout layout);
   absl::StatusOr<std::unique_ptr<Modules>> Build(
       std::unique_ptr<const DataManager> data_manager);
 
@@ -32,6 +32,10 @@
 #include <memory>
 #include <utility>
 
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "converter/connector.h"
 #include "data_manager/testing/mock_data_manager.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_mock.h"
@@ -39,6 +43,8 @@
 #include "engine/supplemental_model_interface.h"
 #include "testing/gunit.h"
 
+ABSL_DECLARE_FLAG(bool, dense_connector);
+
 namespace mozc {
 namespace engine {
 
@@ -92,6 +98,39 @@ TEST(ModulesTest, PresetTest) {
   EXPECT_EQ(&modules->GetDictionary(), dictionary_ptr);
 }
 
+TEST(ModulesTest, ConnectorLayoutTest) {
+  std::unique_ptr<const Modules> compressed =
+      Modules::Create(std::make_unique<testing::MockDataManager>()).value();
+  EXPECT_EQ(compressed->GetConnector().GetLayout(),
+            Connector::Layout::kCompressed);
+
+  std::unique_ptr<const Modules> dense =
+      ModulesPresetBuilder()
+          .PresetConnectorLayout(Connector::Layout::kDense)
+          .Build(std::make_unique<testing::MockDataManager>())
+          .value();
+  EXPECT_EQ(dense->GetConnector().GetLayout(), Connector::Layout::kDense);
+  EXPECT_EQ(dense->GetConnector().GetTransitionCost(0, 0),
+            compressed->GetConnector().GetTransitionCost(0, 0));
+}
+
+TEST(ModulesTest, DenseConnectorFlagTest) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_dense_connector, true);
+  std::unique_ptr<const Modules> dense =
+      Modules::Create(std::make_unique<testing::MockDataManager>()).value();
+  EXPECT_EQ(dense->GetConnector().GetLayout(), Connector::Layout::kDense);
+
+  // An explicit preset takes precedence over the flag.
+  std::unique_ptr<const Modules> compressed =
+      ModulesPresetBuilder()
+          .PresetConnectorLayout(Connector::Layout::kCompressed)
+          .Build(std::make_unique<testing::MockDataManager>())
+          .value();
+  EXPECT_EQ(compressed->GetConnector().GetLayout(),
+            Connector::Layout::kCompressed);
+}
+
 TEST(ModulesTest, SupplementalModelTest) {
   std::unique_ptr<Modules> modules1 =
       Modules::Create(std::make_unique<testing::MockDataManager>()).value();
@@ -85,6 +85,10 @@ class IPCClientInterface {
   virtual absl::string_view GetServerProductVersion() const = 0;
   virtual uint32_t GetServerProcessId() const = 0;
 
+  // Requests to keep the connection open across Call()s. Implementations that
+  // don't support it ignore the request and can be called only once.
+  virtual void set_persistent_connection(bool persistent) {}
+
   // return last error
   virtual IPCErrorType GetLastIPCError() const = 0;
 };
@@ -145,10 +149,23 @@ class IPCClient : public IPCClientInterface {
   // When Server doesn't send response within timeout, 'Call' returns false.
   // When timeout (in msec) is set -1, 'Call' waits forever.
   // Note that on Linux and Windows, Call() closes the socket_. This means you
-  // cannot call the Call() function more than once.
+  // cannot call the Call() function more than once, unless the persistent
+  // connection is enabled.
   bool Call(absl::string_view request, std::string* response,
             absl::Duration timeout) override;
 
+  // Keeps the connection open across Call()s. Each request and response is
+  // sent as a length-prefixed frame instead of being terminated by closing
+  // the socket, so one client can issue any number of Call()s without
+  // reconnecting. Must be set before the first Call(). Only Linux supports
+  // this mode; it is ignored on the other platforms.
+  // A failed Call() leaves GetLastIPCError() at IPC_NO_CONNECTION or
+  // IPC_WRITE_ERROR only when the server has not received the whole request.
+  // After the other errors, the server may have processed it.
+  void set_persistent_connection(bool persistent) override {
+    persistent_connection_ = persistent;
+  }
+
   IPCErrorType GetLastIPCError() const override { return last_ipc_error_; }
 
   // terminate the server process named |name|
@@ -173,8 +190,10 @@ class IPCClient : public IPCClientInterface {
   MachPortManagerInterface* mach_port_manager_;
 #else   // _WIN32
   int socket_;
+  bool preamble_sent_ = false;
 #endif  // _WIN32
   bool connected_;
+  bool persistent_connection_ = false;
   IPCPathManager* ipc_path_manager_;
   IPCErrorType last_ipc_error_;
 };
@@ -240,6 +259,15 @@ class IPCServer {
   // If 'Process' return false, server finishes select loop
   virtual bool Process(absl::string_view request, std::string* response) = 0;
 
+  // Sets the number of worker threads that run Process(). With zero workers,
+  // which is the default, every request is processed on the thread running
+  // Loop(). With two or more workers, requests from different connections
+  // are processed concurrently, so Process() must be thread-safe. Must be
+  // called before Loop(). Only Linux supports worker threads; it is ignored
+  // on the other platforms.
+  void set_num_workers(int num_workers) { num_workers_ = num_workers; }
+  int num_workers() const { return num_workers_; }
+
   // Start select loop. It goes into infinite loop.
   void Loop();
 
@@ -285,6 +313,7 @@ class IPCServer {
 #endif  // _WIN32
 
   absl::Duration timeout_;
+  int num_workers_ = 0;
 };
 
 }  // namespace mozc
@@ -67,6 +67,10 @@ uint32_t IPCClientMock::GetServerProcessId() const {
 bool IPCClientMock::Call(absl::string_view request, std::string *response,
                          const absl::Duration timeout) {
   caller_->SetGeneratedRequest(request);
+  last_ipc_error_ = caller_->TakeNextCallError();
+  if (last_ipc_error_ != IPC_NO_ERROR) {
+    return false;
+  }
   if (!connected_ || !result_) {
     return false;
   }
@@ -122,6 +126,16 @@ void IPCClientFactoryMock::SetServerProcessId(
   server_process_id_ = server_process_id;
 }
 
+void IPCClientFactoryMock::SetNextCallError(const IPCErrorType error) {
+  next_call_error_ = error;
+}
+
+IPCErrorType IPCClientFactoryMock::TakeNextCallError() {
+  const IPCErrorType error = next_call_error_;
+  next_call_error_ = IPC_NO_ERROR;
+  return error;
+}
+
 std::unique_ptr<IPCClientMock> IPCClientFactoryMock::NewClientMock() {
   auto client = std::make_unique<IPCClientMock>(this);
   client->set_connection(connection_);
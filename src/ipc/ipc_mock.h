@@ -54,7 +54,7 @@ class IPCClientMock : public IPCClientInterface {
   bool Call(absl::string_view request, std::string *response,
             absl::Duration timeout) override;
 
-  IPCErrorType GetLastIPCError() const override { return IPC_NO_ERROR; }
+  IPCErrorType GetLastIPCError() const override { return last_ipc_error_; }
 
   void set_connection(const bool connection) { connected_ = connection; }
   void set_result(const bool result) { result_ = result; }
@@ -77,6 +77,7 @@ class IPCClientMock : public IPCClientInterface {
   uint32_t server_process_id_;
   bool result_;
   std::string response_;
+  IPCErrorType last_ipc_error_ = IPC_NO_ERROR;
 };
 
 class IPCClientFactoryMock : public IPCClientFactoryInterface {
@@ -115,6 +116,14 @@ class IPCClientFactoryMock : public IPCClientFactoryInterface {
   // This function is for unit tests.
   void SetServerProcessId(uint32_t server_process_id);
 
+  // This function is for unit tests. Makes the next Call() of any client,
+  // including the ones already created, fail with |error|.
+  void SetNextCallError(IPCErrorType error);
+
+  // This function is for IPCClientMock. Returns the error set by
+  // SetNextCallError() and clears it.
+  IPCErrorType TakeNextCallError();
+
  private:
   std::unique_ptr<IPCClientMock> NewClientMock();
 
@@ -125,6 +134,7 @@ class IPCClientFactoryMock : public IPCClientFactoryInterface {
   uint32_t server_process_id_;
   std::string request_;
   std::string response_;
+  IPCErrorType next_call_error_ = IPC_NO_ERROR;
 };
 
 }  // namespace mozc
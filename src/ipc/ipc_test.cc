@@ -163,5 +163,56 @@ TEST_F(IPCTest, IPCTest) {
   con.Wait();
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST_F(IPCTest, PersistentConnectionTest) {
+  EchoServer con(kServerAddress, 10, absl::Milliseconds(1000));
+  con.set_num_workers(2);
+  con.LoopAndReturn();
+
+  std::vector<Thread> cons;
+  for (int i = 0; i < kNumThreads; ++i) {
+    cons.push_back(Thread([] {
+      absl::SleepFor(absl::Milliseconds(100));
+      IPCClient con(kServerAddress, "");
+      con.set_persistent_connection(true);
+      ASSERT_TRUE(con.Connected());
+      for (int i = 0; i < kNumRequests; ++i) {
+        const std::string input = GenerateInputData(i);
+        std::string output;
+        ASSERT_TRUE(con.Call(input, &output, absl::Milliseconds(1000)))
+            << "size=" << input.size();
+        EXPECT_EQ(output, input);
+      }
+      // An empty request is still delivered as a frame.
+      std::string output = "not empty";
+      ASSERT_TRUE(con.Call("", &output, absl::Milliseconds(1000)));
+      EXPECT_TRUE(output.empty());
+      EXPECT_TRUE(con.Connected());
+    }));
+  }
+
+  // One-shot clients are served while the persistent connections are open.
+  for (int i = 0; i < 10; ++i) {
+    const std::string input = GenerateInputData(i);
+    IPCClient one_shot(kServerAddress, "");
+    ASSERT_TRUE(one_shot.Connected());
+    std::string output;
+    ASSERT_TRUE(one_shot.Call(input, &output, absl::Milliseconds(1000)));
+    EXPECT_EQ(output, input);
+  }
+
+  for (Thread &con : cons) {
+    con.Join();
+  }
+
+  IPCClient kill(kServerAddress, "");
+  kill.set_persistent_connection(true);
+  std::string output;
+  kill.Call("kill", &output, absl::Milliseconds(1000));
+
+  con.Wait();
+}
+#endif  // __linux__ && !__ANDROID__
+
 }  // namespace
 }  // namespace mozc
@@ -31,6 +31,7 @@
 #if defined(__linux__)
 
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -38,19 +39,27 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
 #include <string>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "base/file_util.h"
+#include "base/thread.h"
 #include "base/vlog.h"
 #include "ipc/ipc.h"
 #include "ipc/ipc_path_manager.h"
@@ -64,6 +73,15 @@ namespace {
 
 constexpr int kInvalidSocket = -1;
 
+// The bytes a client sends first on a persistent connection. A serialized
+// protobuf never starts with '\0' as the field number 0 is invalid, so the
+// preamble cannot be mistaken for the head of a one-shot request.
+constexpr absl::string_view kPersistentPreamble("\0MZP", 4);
+
+// Upper bound of a frame body, so that a broken length header is rejected
+// before the buffer is allocated.
+constexpr uint32_t kMaxFrameSize = 64 * 1024 * 1024;
+
 absl::Status mkdir_p(absl::string_view dirname) {
   const std::string parent_dir(FileUtil::Dirname(dirname));
   struct stat st;
@@ -118,6 +136,17 @@ bool IsWriteTimeout(int socket, absl::Duration timeout) {
   return true;
 }
 
+// Returns true if the peer has closed the connection, or has sent bytes that
+// no request is waiting for. Doesn't block.
+bool IsConnectionBroken(int socket) {
+  char c;
+  const ssize_t l = ::recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (l < 0) {
+    return errno != EAGAIN && errno != EWOULDBLOCK;
+  }
+  return true;
+}
+
 bool IsPeerValid(int socket, pid_t *pid) {
   *pid = 0;
 
@@ -161,14 +190,16 @@ IPCErrorType SendMessage(int socket, absl::string_view msg,
   return IPC_NO_ERROR;
 }
 
+// Receives the message until the peer half-closes the socket. The received
+// bytes are appended to |msg|.
 IPCErrorType RecvMessage(int socket, std::string *msg, absl::Duration timeout) {
   if (!msg) {
     LOG(WARNING) << "msg is nullptr";
     return IPC_UNKNOWN_ERROR;
   }
-  msg->resize(IPC_INITIAL_READ_BUFFER_SIZE);
+  size_t offset = msg->size();
+  msg->resize(std::max(IPC_INITIAL_READ_BUFFER_SIZE, offset * 2));
   ssize_t read_length = 0;
-  int offset = 0;
   do {
     if (IsReadTimeout(socket, timeout)) {
       LOG(WARNING) << "Read timeout " << timeout;
@@ -192,6 +223,76 @@ IPCErrorType RecvMessage(int socket, std::string *msg, absl::Duration timeout) {
   return IPC_NO_ERROR;
 }
 
+// Receives up to |size| bytes into |buf|. Stops early when the peer closes the
+// connection. |received| is set to the number of bytes actually read.
+IPCErrorType RecvBytes(int socket, char *buf, size_t size,
+                       absl::Duration timeout, size_t *received) {
+  *received = 0;
+  while (*received < size) {
+    if (IsReadTimeout(socket, timeout)) {
+      LOG(WARNING) << "Read timeout " << timeout;
+      return IPC_TIMEOUT_ERROR;
+    }
+    const ssize_t l = ::recv(socket, buf + *received, size - *received,
+                             /* flags */ 0);
+    if (l < 0) {
+      LOG(ERROR) << "an error occurred during recv(): " << strerror(errno);
+      return IPC_READ_ERROR;
+    }
+    if (l == 0) {
+      break;
+    }
+    *received += l;
+  }
+  return IPC_NO_ERROR;
+}
+
+// A frame of the persistent connection is the body size in the host byte
+// order followed by the body. Both ends are on the same host.
+IPCErrorType SendFrame(int socket, absl::string_view msg,
+                       absl::Duration timeout) {
+  if (msg.size() > kMaxFrameSize) {
+    LOG(ERROR) << "too large frame: " << msg.size();
+    return IPC_WRITE_ERROR;
+  }
+  const uint32_t size = msg.size();
+  std::string frame;
+  frame.reserve(sizeof(size) + msg.size());
+  frame.append(reinterpret_cast<const char *>(&size), sizeof(size));
+  frame.append(msg.data(), msg.size());
+  return SendMessage(socket, frame, timeout);
+}
+
+// Returns IPC_NO_CONNECTION when the peer has closed the connection between
+// frames.
+IPCErrorType RecvFrame(int socket, std::string *msg, absl::Duration timeout) {
+  uint32_t size = 0;
+  size_t received = 0;
+  IPCErrorType error = RecvBytes(socket, reinterpret_cast<char *>(&size),
+                                 sizeof(size), timeout, &received);
+  if (error != IPC_NO_ERROR) {
+    return error;
+  }
+  if (received == 0) {
+    return IPC_NO_CONNECTION;
+  }
+  if (received != sizeof(size) || size > kMaxFrameSize) {
+    LOG(ERROR) << "broken frame header";
+    return IPC_READ_ERROR;
+  }
+  msg->resize(size);
+  error = RecvBytes(socket, msg->data(), size, timeout, &received);
+  if (error != IPC_NO_ERROR) {
+    return error;
+  }
+  if (received != size) {
+    LOG(ERROR) << "truncated frame: " << received << " < " << size;
+    return IPC_READ_ERROR;
+  }
+  MOZC_VLOG(1) << size << " bytes received";
+  return IPC_NO_ERROR;
+}
+
 void SetCloseOnExecFlag(int fd) {
   int flags = ::fcntl(fd, F_GETFD, 0);
   if (flags < 0) {
@@ -211,6 +312,284 @@ void SetCloseOnExecFlag(int fd) {
 bool IsAbstractSocket(absl::string_view address) {
   return (!address.empty()) && (address[0] == '\0');
 }
+
+// Serves the connections accepted by IPCServer::Loop().
+//
+// A one-shot connection carries a single request terminated by half-closing
+// the socket, and is closed after the response. A persistent connection
+// starts with kPersistentPreamble and carries any number of framed requests.
+// Between requests it stays in the poll set of the loop thread, and each
+// request is dispatched when the socket becomes readable, so a few workers
+// can serve many connections. Without workers, requests are processed on the
+// loop thread.
+class ConnectionDispatcher {
+ public:
+  ConnectionDispatcher(IPCServer *server, int num_workers,
+                       absl::Duration timeout);
+  ConnectionDispatcher(const ConnectionDispatcher &) = delete;
+  ConnectionDispatcher &operator=(const ConnectionDispatcher &) = delete;
+  ~ConnectionDispatcher();
+
+  // Accepts and serves connections on |listen_socket| until Process() returns
+  // false or |terminate| is notified.
+  void Run(int listen_socket, const absl::Notification &terminate);
+
+ private:
+  struct Connection {
+    int socket;
+    bool persistent;
+  };
+
+  void Dispatch(Connection connection);
+  // Serves one request of |connection|, then either closes it or returns it
+  // to the poll set.
+  void Serve(Connection connection, std::string *request,
+             std::string *response);
+  void ServeOneShot(int socket, std::string *request, std::string *response);
+  void Release(int socket);
+  void Stop();
+  void Wake();
+  void WorkerLoop();
+  bool HasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return shutdown_ || !pending_.empty();
+  }
+
+  IPCServer *server_;
+  const absl::Duration timeout_;
+  int wake_pipe_[2] = {kInvalidSocket, kInvalidSocket};
+  std::atomic<bool> stopped_ = false;
+  // Persistent connections waiting for the next request. Only accessed by the
+  // loop thread.
+  std::vector<int> idle_;
+  // Buffers used when requests are processed on the loop thread.
+  std::string request_;
+  std::string response_;
+  absl::Mutex mutex_;
+  std::deque<Connection> pending_ ABSL_GUARDED_BY(mutex_);
+  std::vector<int> released_ ABSL_GUARDED_BY(mutex_);
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<Thread> workers_;
+};
+
+ConnectionDispatcher::ConnectionDispatcher(IPCServer *server, int num_workers,
+                                           absl::Duration timeout)
+    : server_(server), timeout_(timeout) {
+  if (::pipe2(wake_pipe_, O_CLOEXEC | O_NONBLOCK) != 0) {
+    LOG(FATAL) << "pipe2() failed: " << strerror(errno);
+  }
+  workers_.reserve(std::max(num_workers, 0));
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ConnectionDispatcher::~ConnectionDispatcher() {
+  {
+    absl::MutexLock l(mutex_);
+    shutdown_ = true;
+  }
+  // Joins the workers.
+  workers_.clear();
+  for (const Connection &connection : pending_) {
+    ::close(connection.socket);
+  }
+  for (const int socket : released_) {
+    ::close(socket);
+  }
+  for (const int socket : idle_) {
+    ::close(socket);
+  }
+  ::close(wake_pipe_[0]);
+  ::close(wake_pipe_[1]);
+}
+
+void ConnectionDispatcher::Run(int listen_socket,
+                               const absl::Notification &terminate) {
+  std::vector<pollfd> fds;
+  while (!stopped_.load(std::memory_order_acquire) &&
+         !terminate.HasBeenNotified()) {
+    fds.clear();
+    fds.push_back({listen_socket, POLLIN, 0});
+    fds.push_back({wake_pipe_[0], POLLIN, 0});
+    for (const int socket : idle_) {
+      fds.push_back({socket, POLLIN, 0});
+    }
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(FATAL) << "poll() failed: " << strerror(errno);
+      return;
+    }
+
+    // Hang-ups are dispatched as well so that Serve() sees the end of the
+    // stream and closes the connection. Serve() may append the connection
+    // to |idle_| again while iterating when there is no worker.
+    const size_t num_polled = fds.size() - 2;
+    size_t num_kept = 0;
+    for (size_t i = 0; i < num_polled; ++i) {
+      if (fds[i + 2].revents == 0) {
+        idle_[num_kept++] = idle_[i];
+      } else {
+        Dispatch({idle_[i], /* persistent= */ true});
+      }
+    }
+    idle_.erase(idle_.begin() + num_kept, idle_.begin() + num_polled);
+
+    if (fds[1].revents != 0) {
+      char buf[64];
+      while (::read(wake_pipe_[0], buf, sizeof(buf)) > 0) {
+      }
+      absl::MutexLock l(mutex_);
+      idle_.insert(idle_.end(), released_.begin(), released_.end());
+      released_.clear();
+    }
+
+    if (fds[0].revents != 0) {
+      const int new_sock = ::accept(listen_socket, nullptr, nullptr);
+      if (new_sock < 0) {
+        LOG(FATAL) << "accept() failed: " << strerror(errno);
+        return;
+      }
+      pid_t pid = 0;
+      if (!IsPeerValid(new_sock, &pid)) {
+        ::close(new_sock);
+        continue;
+      }
+      Dispatch({new_sock, /* persistent= */ false});
+    }
+  }
+}
+
+void ConnectionDispatcher::Dispatch(Connection connection) {
+  if (workers_.empty()) {
+    Serve(connection, &request_, &response_);
+    return;
+  }
+  absl::MutexLock l(mutex_);
+  pending_.push_back(connection);
+}
+
+void ConnectionDispatcher::Serve(Connection connection, std::string *request,
+                                 std::string *response) {
+  const int socket = connection.socket;
+  if (!connection.persistent) {
+    ServeOneShot(socket, request, response);
+    return;
+  }
+
+  const IPCErrorType error = RecvFrame(socket, request, timeout_);
+  if (error == IPC_NO_CONNECTION) {
+    MOZC_VLOG(1) << "persistent connection closed by the client";
+    ::close(socket);
+    return;
+  }
+  if (error != IPC_NO_ERROR) {
+    LOG(WARNING) << "RecvFrame() failed";
+    ::close(socket);
+    return;
+  }
+  if (!server_->Process(*request, response)) {
+    LOG(WARNING) << "Process() failed";
+    ::close(socket);
+    Stop();
+    return;
+  }
+  if (SendFrame(socket, *response, timeout_) != IPC_NO_ERROR) {
+    LOG(WARNING) << "SendFrame() failed";
+    ::close(socket);
+    return;
+  }
+  Release(socket);
+}
+
+void ConnectionDispatcher::ServeOneShot(int socket, std::string *request,
+                                        std::string *response) {
+  // The first bytes tell whether the client asks for a persistent connection.
+  request->resize(kPersistentPreamble.size());
+  size_t received = 0;
+  if (RecvBytes(socket, request->data(), request->size(), timeout_,
+                &received) != IPC_NO_ERROR) {
+    LOG(WARNING) << "RecvBytes() failed";
+    ::close(socket);
+    return;
+  }
+  request->resize(received);
+  if (*request == kPersistentPreamble) {
+    MOZC_VLOG(1) << "persistent connection established";
+    Release(socket);
+    return;
+  }
+
+  if (RecvMessage(socket, request, timeout_) != IPC_NO_ERROR) {
+    LOG(WARNING) << "RecvMessage() failed";
+    ::close(socket);
+    return;
+  }
+
+  if (!server_->Process(*request, response)) {
+    LOG(WARNING) << "Process() failed";
+    ::close(socket);
+    Stop();
+    return;
+  }
+
+  if (response->empty()) {
+    LOG(WARNING) << "response is empty";
+    ::close(socket);
+    return;
+  }
+
+  if (SendMessage(socket, *response, timeout_) != IPC_NO_ERROR) {
+    LOG(WARNING) << "SendMessage() failed";
+  }
+  ::close(socket);
+}
+
+void ConnectionDispatcher::Release(int socket) {
+  if (workers_.empty()) {
+    idle_.push_back(socket);
+    return;
+  }
+  {
+    absl::MutexLock l(mutex_);
+    released_.push_back(socket);
+  }
+  Wake();
+}
+
+void ConnectionDispatcher::Stop() {
+  stopped_.store(true, std::memory_order_release);
+  Wake();
+}
+
+void ConnectionDispatcher::Wake() {
+  const char c = 0;
+  // The pipe is non-blocking. When it is full, the loop thread is going to
+  // wake up anyway.
+  if (::write(wake_pipe_[1], &c, sizeof(c)) < 0 && errno != EAGAIN) {
+    LOG(WARNING) << "write() failed: " << strerror(errno);
+  }
+}
+
+void ConnectionDispatcher::WorkerLoop() {
+  std::string request;
+  std::string response;
+  while (true) {
+    Connection connection;
+    {
+      absl::MutexLock l(mutex_,
+                        absl::Condition(this, &ConnectionDispatcher::HasWork));
+      if (shutdown_) {
+        return;
+      }
+      connection = pending_.front();
+      pending_.pop_front();
+    }
+    Serve(connection, &request, &response);
+  }
+}
+
 }  // namespace
 
 // Client
@@ -310,6 +689,46 @@ bool IPCClient::Call(absl::string_view request, std::string *response,
     LOG(ERROR) << "Call failed: not connected";
     return false;
   }
+
+  if (persistent_connection_) {
+    // Any error leaves the stream out of sync, so the connection is not
+    // reused after that.
+    if (!preamble_sent_) {
+      last_ipc_error_ = SendMessage(socket_, kPersistentPreamble, timeout);
+      if (last_ipc_error_ != IPC_NO_ERROR) {
+        LOG(ERROR) << "SendMessage failed";
+        connected_ = false;
+        return false;
+      }
+      preamble_sent_ = true;
+    } else if (IsConnectionBroken(socket_)) {
+      // The server has closed the idle connection, e.g., on restart. Nothing
+      // is sent, so the caller can safely send the request again.
+      LOG(WARNING) << "persistent connection closed by the server";
+      last_ipc_error_ = IPC_NO_CONNECTION;
+      connected_ = false;
+      return false;
+    }
+    last_ipc_error_ = SendFrame(socket_, request, timeout);
+    if (last_ipc_error_ != IPC_NO_ERROR) {
+      LOG(ERROR) << "SendFrame failed";
+      connected_ = false;
+      return false;
+    }
+    last_ipc_error_ = RecvFrame(socket_, response, timeout);
+    if (last_ipc_error_ == IPC_NO_CONNECTION) {
+      // The server may have processed the request before closing.
+      last_ipc_error_ = IPC_READ_ERROR;
+    }
+    if (last_ipc_error_ != IPC_NO_ERROR) {
+      LOG(ERROR) << "RecvFrame failed";
+      connected_ = false;
+      return false;
+    }
+    MOZC_VLOG(1) << "Call succeeded";
+    return true;
+  }
+
   last_ipc_error_ = SendMessage(socket_, request, timeout);
   if (last_ipc_error_ != IPC_NO_ERROR) {
     LOG(ERROR) << "SendMessage failed";
@@ -324,6 +743,7 @@ bool IPCClient::Call(absl::string_view request, std::string *response,
   // data. Will revisit later.
   ::shutdown(socket_, SHUT_WR);
 
+  response->clear();
   last_ipc_error_ = RecvMessage(socket_, response, timeout);
   if (last_ipc_error_ != IPC_NO_ERROR) {
     LOG(ERROR) << "RecvMessage failed";
@@ -422,44 +842,9 @@ IPCServer::~IPCServer() {
 bool IPCServer::Connected() const { return connected_; }
 
 void IPCServer::Loop() {
-  // The most portable and straightforward single-thread server
-  bool error = false;
-  pid_t pid = 0;
-  std::string request;
-  std::string response;
-  while (!error && !terminate_.HasBeenNotified()) {
-    const int new_sock = ::accept(socket_, nullptr, nullptr);
-    if (new_sock < 0) {
-      LOG(FATAL) << "accept() failed: " << strerror(errno);
-      return;
-    }
-    if (!IsPeerValid(new_sock, &pid)) {
-      continue;
-    }
-
-    if (RecvMessage(new_sock, &request, timeout_) != IPC_NO_ERROR) {
-      LOG(WARNING) << "RecvMessage() failed";
-      ::close(new_sock);
-      continue;
-    }
-
-    if (!Process(request, &response)) {
-      LOG(WARNING) << "Process() failed";
-      ::close(new_sock);
-      error = true;
-      continue;
-    }
-
-    if (response.empty()) {
-      LOG(WARNING) << "response is empty";
-      ::close(new_sock);
-      continue;
-    }
-
-    if (SendMessage(new_sock, response, timeout_) != IPC_NO_ERROR) {
-      LOG(WARNING) << "SendMessage() failed";
-    }
-    ::close(new_sock);
+  {
+    ConnectionDispatcher dispatcher(this, num_workers_, timeout_);
+    dispatcher.Run(socket_, terminate_);
   }
 
   ::shutdown(socket_, SHUT_RDWR);
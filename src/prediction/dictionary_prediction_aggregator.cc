@@ -34,6 +34,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -41,16 +42,21 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/call_once.h"
 #include "absl/container/btree_set.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/types/span.h"
 #include "base/japanese_util.h"
 #include "base/number_util.h"
 #include "base/strings/unicode.h"
+#include "base/thread_pool.h"
 #include "base/util.h"
 #include "composer/query.h"
 #include "config/character_form_manager.h"
@@ -79,6 +85,7 @@ using ::mozc::commands::Request;
 using ::mozc::composer::TypeCorrectedQuery;
 using ::mozc::dictionary::DictionaryInterface;
 using ::mozc::dictionary::Token;
+using ::mozc::dictionary::TokenView;
 
 // Note that PREDICTION mode is much slower than SUGGESTION.
 // Number of prediction calls should be minimized.
@@ -119,6 +126,21 @@ bool IsMixedConversionEnabled(const ConversionRequest& request) {
   return request.request().mixed_conversion();
 }
 
+// Returns true if the aggregators can run concurrently for `request`.
+// The English aggregators used in Latin input mode pass the whole result
+// list to the supplemental model, which is neither thread-safe nor
+// independent of the other aggregators, so they always run sequentially.
+bool IsParallelAggregationEnabled(const ConversionRequest& request) {
+  return request.request()
+             .decoder_experiment_params()
+             .enable_parallel_prediction_aggregation() &&
+         !IsLatinInputMode(request);
+}
+
+void AppendResults(std::vector<Result> from, std::vector<Result>* to) {
+  absl::c_move(from, std::back_inserter(*to));
+}
+
 bool HasHistoryKeyLongerThanOrEqualTo(const ConversionRequest& request,
                                       size_t utf8_len) {
   return Util::CharsLen(request.converter_history_key(1)) >= utf8_len;
@@ -211,6 +233,11 @@ class PredictiveLookupCallback : public DictionaryInterface::Callback {
 
   ResultType OnToken(absl::string_view key, absl::string_view actual_key,
                      const Token& token) override {
+    return OnTokenView(key, actual_key, token);
+  }
+
+  ResultType OnTokenView(absl::string_view key, absl::string_view actual_key,
+                         const TokenView& token) override {
     // If the token is from user dictionary and its POS is unknown, it is
     // suggest-only words.  Such words are looked up only when their keys
     // exactly match |key|.  Otherwise, unigram suggestion can be annoying.  For
@@ -254,7 +281,8 @@ class PredictiveLookupCallback : public DictionaryInterface::Callback {
   // - the key predicts number ("十月[10がつ]" for the key, "1")
   // - the value predicts number ("12時" for the key, "1")
   // - the value contains long suffix ("101匹わんちゃん" for the key, "101")
-  bool IsNoisyNumberToken(absl::string_view key, const Token& token) const {
+  bool IsNoisyNumberToken(absl::string_view key,
+                          const TokenView& token) const {
     const auto orig_key = absl::ClippedSubstr(key, 0, original_key_len_);
     if (!NumberUtil::IsArabicNumber(orig_key)) {
       return false;
@@ -304,8 +332,8 @@ class PredictiveBigramLookupCallback : public PredictiveLookupCallback {
   PredictiveBigramLookupCallback& operator=(
       const PredictiveBigramLookupCallback&) = delete;
 
-  ResultType OnToken(absl::string_view key, absl::string_view expanded_key,
-                     const Token& token) override {
+  ResultType OnTokenView(absl::string_view key, absl::string_view expanded_key,
+                         const TokenView& token) override {
     // Skip the token if its value doesn't start with the previous user input,
     // |history_value_|.
     if (!token.value.starts_with(history_value_) ||
@@ -313,7 +341,7 @@ class PredictiveBigramLookupCallback : public PredictiveLookupCallback {
       return TRAVERSE_CONTINUE;
     }
     ResultType result_type =
-        PredictiveLookupCallback::OnToken(key, expanded_key, token);
+        PredictiveLookupCallback::OnTokenView(key, expanded_key, token);
     return result_type;
   }
 
@@ -334,12 +362,12 @@ std::optional<Token> FindKeyAndValue(const DictionaryInterface& dic,
                                      absl::string_view value) {
   std::optional<Token> result_token;
   dictionary::InlineCallback cb;
-  cb.OnToken([&](absl::string_view,  // key
-                 absl::string_view,  // actual_key
-                 const Token& token) {
+  cb.OnTokenView([&](absl::string_view,  // key
+                     absl::string_view,  // actual_key
+                     const TokenView& token) {
     using enum DictionaryInterface::Callback::ResultType;
     if (token.value != value) return TRAVERSE_CONTINUE;
-    result_token = token;
+    result_token = token.ToToken();
     return TRAVERSE_DONE;
   });
   dic.LookupPrefix(key, request, &cb);
@@ -426,14 +454,20 @@ DictionaryPredictionAggregator::AggregateResultsForMixedConversion(
     return results;
   }
 
+  const bool is_partial =
+      request.request_type() == ConversionRequest::PARTIAL_SUGGESTION ||
+      request.request_type() == ConversionRequest::PARTIAL_PREDICTION;
+  if (!is_partial && IsParallelAggregationEnabled(request)) {
+    return AggregateResultsForMixedConversionInParallel(request);
+  }
+
   // Always aggregate realtime results when mixed conversion mode.
   AggregateRealtime(
       request, GetRealtimeCandidateMaxSize(request),
       request.options().use_actual_converter_for_realtime_conversion, &results);
 
   // In partial suggestion or prediction, only realtime candidates are used.
-  if (request.request_type() == ConversionRequest::PARTIAL_SUGGESTION ||
-      request.request_type() == ConversionRequest::PARTIAL_PREDICTION) {
+  if (is_partial) {
     return results;
   }
 
@@ -473,6 +507,77 @@ DictionaryPredictionAggregator::AggregateResultsForMixedConversion(
   return results;
 }
 
+std::vector<Result>
+DictionaryPredictionAggregator::AggregateResultsForMixedConversionInParallel(
+    const ConversionRequest& request) const {
+  constexpr int kMinHistoryKeyLen = 3;
+  const bool use_bigram =
+      HasHistoryKeyLongerThanOrEqualTo(request, kMinHistoryKeyLen);
+  const bool use_prefix = request_util::IsAutoPartialSuggestionEnabled(request);
+
+  std::vector<Result> results;
+  std::vector<Result> unigram_results, number_results, bigram_results,
+      prefix_results, single_kanji_results;
+  int min_unigram_key_len = 0;
+
+  std::vector<absl::AnyInvocable<void() &&>> tasks;
+  tasks.push_back([&] {
+    AggregateUnigram(request, &unigram_results, &min_unigram_key_len);
+  });
+  tasks.push_back([&] { AggregateNumber(request, &number_results); });
+  if (use_bigram) {
+    tasks.push_back([&] { AggregateBigram(request, &bigram_results); });
+  }
+  if (use_prefix) {
+    tasks.push_back([&] { AggregatePrefix(request, &prefix_results); });
+  }
+  tasks.push_back(
+      [&] { AggregateSingleKanji(request, &single_kanji_results); });
+
+  // The realtime conversion runs on the calling thread so that it keeps
+  // reusing the thread local lattice of the previous key stroke.
+  RunInParallel(
+      [&] {
+        AggregateRealtime(
+            request, GetRealtimeCandidateMaxSize(request),
+            request.options().use_actual_converter_for_realtime_conversion,
+            &results);
+      },
+      std::move(tasks));
+
+  // Merges the results in the same order and under the same conditions as
+  // AggregateResultsForMixedConversion.
+  AppendResults(std::move(unigram_results), &results);
+  if (IsNotExceedingCutoffThreshold(request, results)) {
+    AppendResults(std::move(number_results), &results);
+  }
+  AppendResults(std::move(bigram_results), &results);
+
+  const size_t key_len = Util::CharsLen(request.key());
+  if (IsLanguageAwareInputEnabled(request) && !IsLatinInputMode(request) &&
+      IsQwertyMobileTable(request) && key_len >= min_unigram_key_len) {
+    AggregateEnglishUsingRawInput(request, &results);
+  }
+
+  if (use_prefix && IsNotExceedingCutoffThreshold(request, results)) {
+    // AggregatePrefix stops once the total size reaches the limit. Keeps the
+    // number of prefix results it would have added to `results`.
+    const size_t limit = GetCandidateCutoffThreshold(request.request_type());
+    const size_t max_size =
+        results.size() < limit ? limit - results.size() : 1;
+    if (prefix_results.size() > max_size) {
+      prefix_results.resize(max_size);
+    }
+    AppendResults(std::move(prefix_results), &results);
+  }
+
+  AppendResults(std::move(single_kanji_results), &results);
+
+  MaybePopulateTypingCorrectionPenalty(request, &results);
+
+  return results;
+}
+
 std::vector<Result> DictionaryPredictionAggregator::AggregateResultsForDesktop(
     const ConversionRequest& request) const {
   DCHECK(!IsMixedConversionEnabled(request));
@@ -486,6 +591,13 @@ std::vector<Result> DictionaryPredictionAggregator::AggregateResultsForDesktop(
     return results;
   }
 
+  // Desktop mode never sets PARTIAL mode.
+  if (request.request_type() != ConversionRequest::PARTIAL_SUGGESTION &&
+      request.request_type() != ConversionRequest::PARTIAL_PREDICTION &&
+      IsParallelAggregationEnabled(request)) {
+    return AggregateResultsForDesktopInParallel(request);
+  }
+
   if (ShouldAggregateRealTimeConversionResults(request)) {
     AggregateRealtime(
         request, GetRealtimeCandidateMaxSize(request),
@@ -515,6 +627,64 @@ std::vector<Result> DictionaryPredictionAggregator::AggregateResultsForDesktop(
   return results;
 }
 
+std::vector<Result>
+DictionaryPredictionAggregator::AggregateResultsForDesktopInParallel(
+    const ConversionRequest& request) const {
+  constexpr int kMinHistoryKeyLen = 3;
+  const bool use_bigram =
+      HasHistoryKeyLongerThanOrEqualTo(request, kMinHistoryKeyLen);
+
+  std::vector<Result> results;
+  std::vector<Result> unigram_results, number_results, bigram_results;
+  int min_unigram_key_len = 0;
+
+  std::vector<absl::AnyInvocable<void() &&>> tasks;
+  tasks.push_back([&] {
+    AggregateUnigram(request, &unigram_results, &min_unigram_key_len);
+  });
+  tasks.push_back([&] { AggregateNumber(request, &number_results); });
+  if (use_bigram) {
+    tasks.push_back([&] { AggregateBigram(request, &bigram_results); });
+  }
+
+  RunInParallel(
+      [&] {
+        if (ShouldAggregateRealTimeConversionResults(request)) {
+          AggregateRealtime(
+              request, GetRealtimeCandidateMaxSize(request),
+              request.options().use_actual_converter_for_realtime_conversion,
+              &results);
+        }
+      },
+      std::move(tasks));
+
+  AppendResults(std::move(unigram_results), &results);
+  if (IsNotExceedingCutoffThreshold(request, results)) {
+    AppendResults(std::move(number_results), &results);
+  }
+  AppendResults(std::move(bigram_results), &results);
+
+  return results;
+}
+
+void DictionaryPredictionAggregator::RunInParallel(
+    absl::FunctionRef<void()> local_task,
+    std::vector<absl::AnyInvocable<void() &&>> tasks) const {
+  absl::call_once(thread_pool_once_, [this] {
+    thread_pool_ = std::make_unique<ThreadPool>(kNumAggregationThreads);
+  });
+
+  absl::BlockingCounter counter(tasks.size());
+  for (absl::AnyInvocable<void() &&>& task : tasks) {
+    thread_pool_->Schedule([&counter, task = std::move(task)]() mutable {
+      std::move(task)();
+      counter.DecrementCount();
+    });
+  }
+  local_task();
+  counter.Wait();
+}
+
 std::vector<Result> DictionaryPredictionAggregator::
     AggregateTypingCorrectedResultsForMixedConversion(
         const ConversionRequest& request) const {
@@ -800,8 +970,8 @@ void DictionaryPredictionAggregator::AggregateUnigramForHandwriting(
       ++processed_count;
 
       dictionary::InlineCallback cb;
-      cb.OnToken([&](absl::string_view key, absl::string_view actual_key,
-                     const Token& token) {
+      cb.OnTokenView([&](absl::string_view key, absl::string_view actual_key,
+                         const TokenView& token) {
         using enum DictionaryInterface::Callback::ResultType;
         const int penalty = handwriting_cost_offset + recognition_cost;
         size_t next_pos = 0;
@@ -962,8 +1132,8 @@ void DictionaryPredictionAggregator::AggregatePrefix(
   const int limit = GetCandidateCutoffThreshold(request.request_type());
 
   dictionary::InlineCallback cb;
-  cb.OnToken([&](absl::string_view key, absl::string_view actual_key,
-                 const Token& token) {
+  cb.OnTokenView([&](absl::string_view key, absl::string_view actual_key,
+                     const TokenView& token) {
     using enum DictionaryInterface::Callback::ResultType;
     if ((token.attributes & Token::USER_DICTIONARY) != 0 &&
         token.lid == unknown_id_) {
@@ -32,12 +32,17 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "absl/base/call_once.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/thread_pool.h"
 #include "base/util.h"
 #include "dictionary/dictionary_interface.h"
 #include "dictionary/dictionary_token.h"
@@ -110,6 +115,23 @@ class DictionaryPredictionAggregator
     std::vector<std::string> constraints;
   };
 
+  // Parallel versions of AggregateResultsForMixedConversion and
+  // AggregateResultsForDesktop, used when
+  // `enable_parallel_prediction_aggregation` is set. Each aggregator writes
+  // to its own result list, and the lists are concatenated in the order of
+  // the sequential versions. The size limits of an aggregator are applied to
+  // its own results rather than to the running total, so the result can
+  // differ slightly from the sequential one when the limits are reached.
+  std::vector<Result> AggregateResultsForMixedConversionInParallel(
+      const ConversionRequest& request) const;
+  std::vector<Result> AggregateResultsForDesktopInParallel(
+      const ConversionRequest& request) const;
+
+  // Runs `tasks` on the thread pool and `local_task` on the calling thread,
+  // and waits for all of them.
+  void RunInParallel(absl::FunctionRef<void()> local_task,
+                     std::vector<absl::AnyInvocable<void() &&>> tasks) const;
+
   //////////////////////////////////////////////////////////////////////////
   // Top level basic aggregators.
   // Do not implement preconditions for calling the actual operation within
@@ -263,6 +285,11 @@ class DictionaryPredictionAggregator
   const uint16_t unknown_id_;
   const ZeroQueryDict& zero_query_dict_;
   const ZeroQueryDict& zero_query_number_dict_;
+
+  // Worker pool for the parallel aggregation, created on first use.
+  static constexpr int kNumAggregationThreads = 4;
+  mutable absl::once_flag thread_pool_once_;
+  mutable std::unique_ptr<ThreadPool> thread_pool_;
 };
 
 }  // namespace prediction
@@ -36,11 +36,13 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
@@ -2325,6 +2327,52 @@ TEST_F(DictionaryPredictionAggregatorTest, PrefixCandidates) {
   }
 }
 
+TEST_F(DictionaryPredictionAggregatorTest, ParallelAggregation) {
+  std::unique_ptr<MockDataAndAggregator> data_and_aggregator =
+      CreateAggregatorWithMockData();
+  const DictionaryPredictionAggregatorTestPeer& aggregator =
+      data_and_aggregator->aggregator();
+  {
+    MockSingleKanjiDictionary* mock =
+        data_and_aggregator->mutable_single_kanji_dictionary();
+    EXPECT_CALL(*mock, LookupKanjiEntries(_, _))
+        .WillRepeatedly(Return(std::vector<std::string>{"具"}));
+  }
+  config_->set_use_dictionary_suggest(true);
+  PrependHistory("ぐーぐる", "グーグル");
+
+  auto to_tuples = [](absl::Span<const Result> results) {
+    std::vector<std::tuple<std::string, std::string, PredictionTypes>> ret;
+    for (const Result& result : results) {
+      ret.emplace_back(result.key, result.value, result.types);
+    }
+    return ret;
+  };
+
+  auto aggregate = [&](bool parallel, absl::string_view key) {
+    request_->mutable_decoder_experiment_params()
+        ->set_enable_parallel_prediction_aggregation(parallel);
+    const ConversionRequest convreq = CreatePredictionConversionRequest(key);
+    return to_tuples(aggregator.AggregateResultsForTesting(convreq));
+  };
+
+  for (const bool mobile : {true, false}) {
+    if (mobile) {
+      request_test_util::FillMobileRequest(request_.get());
+    } else {
+      request_->Clear();
+    }
+    for (absl::string_view key : {"ぐーぐるあ", "ぐーぐる", "あ"}) {
+      SCOPED_TRACE(absl::StrCat("mobile: ", mobile, ", key: ", key));
+      const auto expected = aggregate(false, key);
+      // The merge order does not depend on the thread scheduling.
+      for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(aggregate(true, key), expected);
+      }
+    }
+  }
+}
+
 TEST_F(DictionaryPredictionAggregatorTest, CandidatesFromUserDictionary) {
   std::unique_ptr<MockDataAndAggregator> data_and_aggregator =
       CreateAggregatorWithMockData();
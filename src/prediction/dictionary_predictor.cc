@@ -43,11 +43,13 @@
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/latency_tracer.h"
 #include "base/util.h"
 #include "base/vlog.h"
 #include "composer/composer.h"
@@ -64,6 +66,7 @@
 #include "prediction/suggestion_filter.h"
 #include "protocol/commands.pb.h"
 #include "request/conversion_request.h"
+#include "request/request_fingerprint.h"
 #include "request/request_util.h"
 #include "transliteration/transliteration.h"
 
@@ -91,6 +94,12 @@ bool IsTypingCorrectionEnabled(const ConversionRequest& request) {
   return request.config().use_typing_correction();
 }
 
+bool IsResultCacheEnabled(const ConversionRequest& request) {
+  return request.request()
+      .decoder_experiment_params()
+      .enable_conversion_result_cache();
+}
+
 template <typename... Args>
 void AppendDescription(Result& result, Args&&... args) {
   absl::StrAppend(&result.description, result.description.empty() ? "" : " ",
@@ -149,7 +158,8 @@ DictionaryPredictor::DictionaryPredictor(
       suggestion_filter_(modules.GetSuggestionFilter()),
       pos_matcher_(modules.GetPosMatcher()),
       general_symbol_id_(pos_matcher_.GetGeneralSymbolId()),
-      modules_(modules) {}
+      modules_(modules),
+      result_cache_(kResultCacheSize) {}
 
 std::vector<Result> DictionaryPredictor::Predict(
     const ConversionRequest& request) const {
@@ -157,7 +167,70 @@ std::vector<Result> DictionaryPredictor::Predict(
     MOZC_VLOG(2) << "request type is CONVERSION";
     return {};
   }
+  static const LatencyTracer::StageId kLatencyStage =
+      LatencyTracer::RegisterStage("dictionary_predictor/predict");
+  ScopedLatencyTimer latency_timer(kLatencyStage);
+
+  std::vector<Result> results = IsResultCacheEnabled(request)
+                                    ? AggregateResultsWithCache(request)
+                                    : AggregateResults(request);
+
+  // `results` are no longer used.
+  return RerankAndFilterResults(request, std::move(results));
+}
 
+// The realtime conversion results depend on the user history through the
+// rewriters, so the cached results are dropped whenever the history changes.
+void DictionaryPredictor::Finish(const ConversionRequest& request,
+                                 absl::Span<const Result> results,
+                                 uint32_t revert_id) {
+  result_cache_.Clear();
+}
+
+void DictionaryPredictor::Revert(uint32_t revert_id) { result_cache_.Clear(); }
+
+bool DictionaryPredictor::ClearAllHistory() {
+  result_cache_.Clear();
+  return true;
+}
+
+bool DictionaryPredictor::ClearHistoryEntry(absl::string_view key,
+                                            absl::string_view value) {
+  result_cache_.Clear();
+  return true;
+}
+
+bool DictionaryPredictor::Reload() {
+  result_cache_.Clear();
+  return true;
+}
+
+std::vector<Result> DictionaryPredictor::AggregateResultsWithCache(
+    const ConversionRequest& request) const {
+  static const LatencyTracer::StageId kHitStage =
+      LatencyTracer::RegisterStage("dictionary_predictor/result_cache_hit");
+  static const LatencyTracer::StageId kMissStage =
+      LatencyTracer::RegisterStage("dictionary_predictor/result_cache_miss");
+
+  const uint64_t cache_key =
+      absl::HashOf(ConversionRequestFingerprint(request),
+                   modules_.GetUserDictionary().GetGeneration());
+
+  CachedResults cached;
+  if (result_cache_.Lookup(cache_key, &cached)) {
+    ScopedLatencyTimer latency_timer(kHitStage);
+    return *cached;
+  }
+
+  ScopedLatencyTimer latency_timer(kMissStage);
+  std::vector<Result> results = AggregateResults(request);
+  result_cache_.Insert(cache_key,
+                       std::make_shared<const std::vector<Result>>(results));
+  return results;
+}
+
+std::vector<Result> DictionaryPredictor::AggregateResults(
+    const ConversionRequest& request) const {
   std::vector<Result> results;
 
   // TODO(taku): Separate DesktopPredictor and MixedDecodingPredictor.
@@ -176,8 +249,7 @@ std::vector<Result> DictionaryPredictor::Predict(
 
   MaybeRescoreResults(request, absl::MakeSpan(results));
 
-  // `results` are no longer used.
-  return RerankAndFilterResults(request, std::move(results));
+  return results;
 }
 
 void DictionaryPredictor::RewriteResultsForPrediction(
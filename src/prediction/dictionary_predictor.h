@@ -40,6 +40,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/container/flat_concurrent_cache.h"
 #include "base/thread.h"
 #include "converter/connector.h"
 #include "converter/segmenter.h"
@@ -67,6 +68,16 @@ class DictionaryPredictor : public PredictorInterface {
 
   std::vector<Result> Predict(const ConversionRequest& request) const override;
 
+  // The following methods only drop the cached results. See
+  // `result_cache_`.
+  void Finish(const ConversionRequest& request,
+              absl::Span<const Result> results, uint32_t revert_id) override;
+  void Revert(uint32_t revert_id) override;
+  bool ClearAllHistory() override;
+  bool ClearHistoryEntry(absl::string_view key,
+                         absl::string_view value) override;
+  bool Reload() override;
+
   absl::string_view GetPredictorName() const override {
     return "DictionaryPredictor";
   }
@@ -88,6 +99,15 @@ class DictionaryPredictor : public PredictorInterface {
   std::vector<Result> RerankAndFilterResults(const ConversionRequest& request,
                                              std::vector<Result> result) const;
 
+  // Aggregates the results and populates their costs. The results are not
+  // reranked yet.
+  std::vector<Result> AggregateResults(const ConversionRequest& request) const;
+
+  // Same as AggregateResults, but reuses the results of the same request when
+  // `enable_conversion_result_cache` is set.
+  std::vector<Result> AggregateResultsWithCache(
+      const ConversionRequest& request) const;
+
   // Returns language model cost of |token| given prediction type |type|.
   // |rid| is the right id of previous word (token).
   // If |rid| is unknown, set 0 as a default value.
@@ -203,6 +223,13 @@ class DictionaryPredictor : public PredictorInterface {
   const dictionary::PosMatcher pos_matcher_;
   const uint16_t general_symbol_id_;
   const engine::Modules& modules_;
+
+  // Results of AggregateResults keyed by the fingerprint of the request and
+  // the user dictionary generation. Hit and miss counts are reported to
+  // LatencyTracer.
+  static constexpr size_t kResultCacheSize = 32;
+  using CachedResults = std::shared_ptr<const std::vector<Result>>;
+  mutable FlatConcurrentCache<uint64_t, CachedResults> result_cache_;
 };
 
 }  // namespace mozc::prediction
@@ -535,6 +535,35 @@ TEST_F(DictionaryPredictorTest, SuggestSpellingCorrection) {
   EXPECT_TRUE(FindCandidateByValue(results, "アボカド"));
 }
 
+TEST_F(DictionaryPredictorTest, ResultCache) {
+  auto data_and_predictor = std::make_unique<MockDataAndPredictor>();
+  DictionaryPredictor& predictor = *data_and_predictor->mutable_predictor();
+  MockAggregator* aggregator = data_and_predictor->mutable_aggregator();
+  request_->mutable_decoder_experiment_params()
+      ->set_enable_conversion_result_cache(true);
+
+  // The second call with the same request hits the cache, and the cache is
+  // dropped by Reload().
+  EXPECT_CALL(*aggregator, AggregateResultsForDesktop(_))
+      .Times(2)
+      .WillRepeatedly(Return(std::vector<Result>{
+          CreateResult5("あぼがど", "アボガド", 500, prediction::UNIGRAM,
+                        Token::NONE)}));
+
+  const ConversionRequest convreq =
+      CreateConversionRequest(ConversionRequest::PREDICTION, "あぼがど");
+  const std::vector<Result> results1 = predictor.Predict(convreq);
+  const std::vector<Result> results2 = predictor.Predict(convreq);
+  ASSERT_EQ(results1.size(), results2.size());
+  for (size_t i = 0; i < results1.size(); ++i) {
+    EXPECT_EQ(results1[i].value, results2[i].value);
+    EXPECT_EQ(results1[i].cost, results2[i].cost);
+  }
+
+  EXPECT_TRUE(predictor.Reload());
+  EXPECT_TRUE(FindCandidateByValue(predictor.Predict(convreq), "アボガド"));
+}
+
 TEST_F(DictionaryPredictorTest, DoNotSuggestSpellingCorrectionBeforeMismatch) {
   auto data_and_predictor = std::make_unique<MockDataAndPredictor>();
   const DictionaryPredictor& predictor = data_and_predictor->predictor();
@@ -140,6 +140,7 @@ std::vector<Result> Predictor::Predict(const ConversionRequest& request) const {
 
 void Predictor::Finish(const ConversionRequest& request,
                        absl::Span<const Result> results, uint32_t revert_id) {
+  dictionary_predictor_->Finish(request, results, revert_id);
   user_history_predictor_->Finish(request, results, revert_id);
 }
 
@@ -147,13 +148,15 @@ void Predictor::CommitContext(const ConversionRequest& request) const {
   user_history_predictor_->CommitContext(request);
 }
 
-// Since DictionaryPredictor is immutable, no need
-// to call DictionaryPredictor::Revert/Clear*/Finish methods.
+// DictionaryPredictor doesn't learn, but drops its cached results when the
+// history changes.
 void Predictor::Revert(uint32_t revert_id) {
+  dictionary_predictor_->Revert(revert_id);
   user_history_predictor_->Revert(revert_id);
 }
 
 bool Predictor::ClearAllHistory() {
+  dictionary_predictor_->ClearAllHistory();
   return user_history_predictor_->ClearAllHistory();
 }
 
@@ -163,6 +166,7 @@ bool Predictor::ClearUnusedHistory() {
 
 bool Predictor::ClearHistoryEntry(absl::string_view key,
                                   absl::string_view value) {
+  dictionary_predictor_->ClearHistoryEntry(key, value);
   return user_history_predictor_->ClearHistoryEntry(key, value);
 }
 
@@ -175,7 +179,10 @@ bool Predictor::Wait() { return user_history_predictor_->Wait(); }
 
 bool Predictor::Sync() { return user_history_predictor_->Sync(); }
 
-bool Predictor::Reload() { return user_history_predictor_->Reload(); }
+bool Predictor::Reload() {
+  dictionary_predictor_->Reload();
+  return user_history_predictor_->Reload();
+}
 
 std::vector<Result> Predictor::PredictForDesktop(
     const ConversionRequest& request) const {
@@ -106,12 +106,13 @@ bool TiebreakLess(const Result& lhs, const Result& rhs) {
 
 using ::mozc::converter::Attribute;
 using ::mozc::dictionary::Token;
+using ::mozc::dictionary::TokenView;
 
-void Result::InitializeByTokenAndTypes(const Token& token,
+void Result::InitializeByTokenAndTypes(const TokenView& token,
                                        PredictionTypes types) {
   SetTypesAndTokenAttributes(types, token.attributes);
-  key = token.key;
-  value = token.value;
+  key.assign(token.key.data(), token.key.size());
+  value.assign(token.value.data(), token.value.size());
   wcost = token.cost;
   lid = token.lid;
   rid = token.rid;
@@ -98,7 +98,7 @@ enum PredictionType {
 using PredictionTypes = int32_t;
 
 struct Result {
-  void InitializeByTokenAndTypes(const dictionary::Token& token,
+  void InitializeByTokenAndTypes(const dictionary::TokenView& token,
                                  PredictionTypes types);
   void SetTypesAndTokenAttributes(
       PredictionTypes prediction_types,
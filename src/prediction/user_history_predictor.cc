@@ -1511,7 +1511,7 @@ UserHistoryPredictor::CreateEntryQueueFromHistory(
 
   EntryPriorityQueue entry_queue;
 
-  storage_.ForEach([&](uint64_t fp, const Entry& entry) {
+  const auto lookup = [&](uint64_t fp, const Entry& entry) {
     // already found enough entry_queue.
     if (entry_queue.size() >= max_entry_queue_size) {
       return false;
@@ -1555,7 +1555,21 @@ UserHistoryPredictor::CreateEntryQueueFromHistory(
     }
 
     return true;
-  });
+  };
+
+  // LookupEntry() only matches the entries whose key shares a prefix with
+  // `base_key`. Unless the roman fuzzy, zero query or typing correction lookup
+  // can match other entries, only visit those entries through the key index.
+  const bool use_key_index =
+      !base_key.empty() && !request_key.empty() && roman_request_key.empty() &&
+      absl::c_none_of(corrected, [](const TypeCorrectedQuery& c) {
+        return c.score > 0.0;
+      });
+  if (use_key_index) {
+    storage_.ForEachPrefixMatch(base_key, lookup);
+  } else {
+    storage_.ForEach(lookup);
+  }
 
   return entry_queue;
 }
@@ -1564,17 +1578,15 @@ UserHistoryPredictor::CreateEntryQueueFromHistory(
 std::tuple<std::string, std::string, std::unique_ptr<Trie<std::string>>>
 UserHistoryPredictor::GetInputKeyFromRequest(const ConversionRequest& request) {
   std::string request_key = request.composer().GetStringForPreedit();
-  // auto = std::pair<std::string, absl::btree_set<std::string>>
-  auto [query_base, expanded_set] =
-      request.composer().GetQueriesForPrediction();
   std::unique_ptr<Trie<std::string>> expanded;
-  if (!expanded_set.empty()) {
-    expanded = std::make_unique<Trie<std::string>>();
-    for (absl::string_view expanded_key : expanded_set) {
-      // For getting matched key, insert values
-      expanded->AddEntry(expanded_key, expanded_key);
-    }
-  }
+  std::string query_base = request.composer().GetQueriesForPrediction(
+      [&expanded](absl::string_view expanded_key) {
+        if (!expanded) {
+          expanded = std::make_unique<Trie<std::string>>();
+        }
+        // For getting matched key, insert values
+        expanded->AddEntry(expanded_key, expanded_key);
+      });
 
   return {request_key, query_base, std::move(expanded)};
 }
@@ -2436,8 +2448,8 @@ bool UserHistoryPredictor::IsProperNoun(const ConversionRequest& request,
   auto is_proper_noun_key_in_dic = [&](absl::string_view request_key) {
     bool found = false;
     dictionary::InlineCallback cb;
-    cb.OnToken([&](absl::string_view key, absl::string_view value,
-                   const dictionary::Token& token) {
+    cb.OnTokenView([&](absl::string_view key, absl::string_view value,
+                       const dictionary::TokenView& token) {
       if (pos_matcher.IsUniqueNoun(token.lid) ||
           pos_matcher.IsUniqueNoun(token.rid)) {
         found = true;
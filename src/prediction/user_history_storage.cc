@@ -33,16 +33,21 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/base/nullability.h"
+#include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/random/distributions.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -50,6 +55,7 @@
 #include "base/config_file_stream.h"
 #include "base/file_util.h"
 #include "base/hash.h"
+#include "base/random.h"
 #include "base/util.h"
 #include "prediction/user_history_predictor.pb.h"
 #include "storage/encrypted_string_storage.h"
@@ -68,6 +74,15 @@ constexpr absl::string_view kDelimiter = "\t";
 // than this size.
 constexpr size_t kLruCacheSize = 10000;
 
+// The key index is pruned when it holds this many more fingerprints than the
+// LRU, e.g., after evictions.
+constexpr size_t kMaxStaleIndexSize = 1024;
+
+// The whole history is saved instead of appending to the journal when the
+// journal has this many records, or a record has this many changes.
+constexpr size_t kMaxJournalRecords = 256;
+constexpr size_t kMaxJournalRecordChanges = kLruCacheSize / 4;
+
 // File name for the history
 #ifdef _WIN32
 constexpr absl::string_view kFileName = "user://history.db";
@@ -76,6 +91,113 @@ constexpr absl::string_view kFileName = "user://.history.db";
 #endif  // _WIN32
 }  // namespace
 
+namespace internal {
+
+void KeyIndex::Touch(uint64_t fp) {
+  items_[fp].stamp = ++clock_;
+  pending_.insert(fp);
+}
+
+void KeyIndex::Insert(uint64_t fp, absl::string_view key) {
+  Item& item = items_[fp];
+  item.stamp = ++clock_;
+  SetKey(fp, item, key);
+  pending_.erase(fp);
+}
+
+void KeyIndex::MarkPending(uint64_t fp) {
+  if (items_.contains(fp)) {
+    pending_.insert(fp);
+  }
+}
+
+void KeyIndex::Erase(uint64_t fp) {
+  const auto it = items_.find(fp);
+  if (it == items_.end()) {
+    return;
+  }
+  keys_.erase({it->second.key, fp});
+  items_.erase(it);
+  pending_.erase(fp);
+}
+
+void KeyIndex::Clear() {
+  items_.clear();
+  keys_.clear();
+  pending_.clear();
+}
+
+void KeyIndex::ResolvePending(
+    absl::FunctionRef<const std::string*(uint64_t)> get_key) {
+  for (const uint64_t fp : pending_) {
+    const auto it = items_.find(fp);
+    if (it == items_.end()) {
+      continue;
+    }
+    const std::string* key = get_key(fp);
+    if (key == nullptr) {
+      keys_.erase({it->second.key, fp});
+      items_.erase(it);
+      continue;
+    }
+    SetKey(fp, it->second, *key);
+  }
+  pending_.clear();
+}
+
+void KeyIndex::Prune(absl::FunctionRef<bool(uint64_t)> exists) {
+  std::vector<uint64_t> removed;
+  for (const auto& [fp, item] : items_) {
+    if (!exists(fp)) {
+      removed.push_back(fp);
+    }
+  }
+  for (const uint64_t fp : removed) {
+    Erase(fp);
+  }
+}
+
+std::vector<uint64_t> KeyIndex::FindPrefixMatch(absl::string_view key) const {
+  DCHECK(pending_.empty());
+  std::vector<uint64_t> fps;
+  if (key.empty()) {
+    return fps;
+  }
+
+  // Keys starting with `key`, including `key` itself.
+  for (auto it = keys_.lower_bound({std::string(key), 0});
+       it != keys_.end() && it->first.starts_with(key); ++it) {
+    fps.push_back(it->second);
+  }
+  // Keys that are proper prefixes of `key`.
+  for (size_t len = 1; len < key.size(); ++len) {
+    const std::string prefix(key.substr(0, len));
+    for (auto it = keys_.lower_bound({prefix, 0});
+         it != keys_.end() && it->first == prefix; ++it) {
+      fps.push_back(it->second);
+    }
+  }
+
+  // Newer first, as the LRU is iterated.
+  absl::c_sort(fps, [this](uint64_t lhs, uint64_t rhs) {
+    return items_.at(lhs).stamp > items_.at(rhs).stamp;
+  });
+  return fps;
+}
+
+void KeyIndex::SetKey(uint64_t fp, Item& item, absl::string_view key) {
+  if (item.key == key) {
+    return;
+  }
+  keys_.erase({item.key, fp});
+  item.key.assign(key.data(), key.size());
+  if (!item.key.empty()) {
+    keys_.insert({item.key, fp});
+  }
+}
+
+}  // namespace internal
+
 UserHistoryStorage::UserHistoryStorage(absl::string_view filename)
     : dic_(std::make_unique<DicCache>(kLruCacheSize)), filename_(filename) {
   AsyncLoad();
@@ -121,13 +243,19 @@ void UserHistoryStorage::AsyncLoad() {
 }
 
 void UserHistoryStorage::Clear() {
-  auto lock = AcquireUniqueLock();
-  dic_ = std::make_unique<DicCache>(kLruCacheSize);
-  needs_sync_ = true;
+  {
+    auto lock = AcquireUniqueLock();
+    dic_ = std::make_unique<DicCache>(kLruCacheSize);
+    key_index_.Clear();
+    needs_compaction_ = true;
+    needs_sync_ = true;
+  }
+  // Save() must be called without `mutex_`. See `save_mutex_`.
   Save();
 }
 
 bool UserHistoryStorage::Load() {
+  absl::MutexLock save_lock(save_mutex_);
   storage::EncryptedStringStorage storage(filename());
 
   std::string input;
@@ -144,7 +272,11 @@ bool UserHistoryStorage::Load() {
 
   MigrateNextEntries(&proto);
 
-  return Load(std::move(proto));
+  const uint64_t journal_id = proto.journal_id();
+  if (!Load(std::move(proto))) {
+    return false;
+  }
+  return ReplayJournal(storage, journal_id);
 }
 
 bool UserHistoryStorage::Load(user_history_predictor::UserHistory&& proto) {
@@ -152,11 +284,13 @@ bool UserHistoryStorage::Load(user_history_predictor::UserHistory&& proto) {
   auto lock = AcquireUniqueLock();
 
   dic_->Clear();
+  key_index_.Clear();
 
   // 1) After loading `dic_` no need to sync.
   // 2) When AsyncLoad is canceled, `dic_` has incomplete data,
   //    so must not be synced.
   needs_sync_ = false;
+  ResetJournalState(proto.journal_id());
 
   for (Entry& entry : *proto.mutable_entries()) {
     if (canceled_) {
@@ -181,17 +315,148 @@ bool UserHistoryStorage::Load(user_history_predictor::UserHistory&& proto) {
     // Avoid std::move() is called before Fingerprint.
 
     const uint64_t fp = Fingerprint(entry);
+    key_index_.Insert(fp, entry.key());
     dic_->Insert(fp, std::move(entry));
   }
 
   return true;
 }
 
+bool UserHistoryStorage::ReplayJournal(
+    const storage::EncryptedStringStorage& storage, uint64_t journal_id) {
+  std::vector<std::string> records;
+  const bool complete = storage.LoadJournal(&records);
+
+  // Enters syncer's critical section.
+  auto lock = AcquireUniqueLock();
+
+  // The journal is rewritten by the next save if it has anything unexpected.
+  bool needs_compaction = !complete;
+  for (const std::string& data : records) {
+    if (canceled_) {
+      LOG(ERROR) << "Loading thread is canceled";
+      return false;
+    }
+
+    user_history_predictor::UserHistoryJournal record;
+    if (!record.ParseFromString(data)) {
+      LOG(ERROR) << "ParseFromString failed. journal looks broken";
+      needs_compaction = true;
+      break;
+    }
+    if (journal_id == 0 || record.journal_id() != journal_id) {
+      // Written for another snapshot, e.g., the process was terminated before
+      // removing the journal after the compaction.
+      needs_compaction = true;
+      continue;
+    }
+
+    for (const uint64_t fp : record.erased_fps()) {
+      dic_->Erase(fp);
+      key_index_.Erase(fp);
+    }
+    for (Entry& entry : *record.mutable_updated_entries()) {
+      const uint64_t fp = Fingerprint(entry);
+      if (Entry* existing = dic_->MutableLookupWithoutInsert(fp)) {
+        *existing = std::move(entry);
+      }
+    }
+    for (Entry& entry : *record.mutable_inserted_entries()) {
+      if (entry.value().empty() || entry.key().empty() ||
+          !Util::IsValidUtf8(entry.value())) {
+        continue;
+      }
+      const uint64_t fp = Fingerprint(entry);
+      key_index_.Insert(fp, entry.key());
+      dic_->Insert(fp, std::move(entry));
+    }
+  }
+
+  num_journal_records_ = records.size();
+  if (needs_compaction) {
+    needs_compaction_ = true;
+    needs_sync_ = true;
+  }
+  return true;
+}
+
 bool UserHistoryStorage::Save() {
   if (!needs_sync_) {
     return true;
   }
 
+  absl::MutexLock save_lock(save_mutex_);
+  storage::EncryptedStringStorage storage(filename());
+
+  // The journal is meaningless without the snapshot, e.g., when the file was
+  // removed by the user.
+  user_history_predictor::UserHistoryJournal record;
+  if (!FileUtil::FileExists(filename()).ok() || !BuildJournalRecord(&record)) {
+    return SaveSnapshot(storage);
+  }
+
+  std::string output;
+  if (!record.AppendToString(&output) || !storage.AppendToJournal(output)) {
+    LOG(ERROR) << "Can't append to user history journal.";
+    // The changes in `record` are no longer tracked.
+    auto lock = AcquireUniqueLock();
+    needs_compaction_ = true;
+    needs_sync_ = true;
+    return false;
+  }
+  ++num_journal_records_;
+
+  return true;
+}
+
+bool UserHistoryStorage::BuildJournalRecord(
+    user_history_predictor::UserHistoryJournal* record) {
+  // Enters syncer's critical section.
+  auto lock = AcquireUniqueLock();
+
+  const size_t num_changes =
+      updated_fps_.size() + inserted_fps_.size() + erased_fps_.size();
+  if (needs_compaction_ || journal_id_ == 0 ||
+      num_journal_records_ >= kMaxJournalRecords ||
+      num_changes > kMaxJournalRecordChanges) {
+    return false;
+  }
+
+  record->set_journal_id(journal_id_);
+  record->mutable_erased_fps()->Reserve(erased_fps_.size());
+  for (const uint64_t fp : erased_fps_) {
+    record->add_erased_fps(fp);
+  }
+  for (const uint64_t fp : updated_fps_) {
+    if (const Entry* entry = dic_->LookupWithoutInsert(fp)) {
+      *record->add_updated_entries() = *entry;
+    }
+  }
+  // The inserted entries are at the LRU head. Stops the scan once all of them
+  // are found.
+  size_t remaining = absl::c_count_if(
+      inserted_fps_, [this](uint64_t fp) { return dic_->HasKey(fp); });
+  for (const DicElement& elm : *dic_) {
+    if (remaining == 0) {
+      break;
+    }
+    if (inserted_fps_.contains(elm.key)) {
+      *record->add_inserted_entries() = elm.value;
+      --remaining;
+    }
+  }
+  // Oldest first, so that the replay reproduces the LRU order.
+  absl::c_reverse(*record->mutable_inserted_entries());
+
+  updated_fps_.clear();
+  inserted_fps_.clear();
+  erased_fps_.clear();
+  needs_sync_ = false;
+  return true;
+}
+
+bool UserHistoryStorage::SaveSnapshot(
+    const storage::EncryptedStringStorage& storage) {
   user_history_predictor::UserHistory proto;
   {
     // Enters syncer's critical section.
@@ -205,35 +470,56 @@ bool UserHistoryStorage::Save() {
       }
       *proto.add_entries() = elm.value;
     }
+
+    // Changes after here go to the journal of the new snapshot.
+    uint64_t journal_id = 0;
+    if (proto.entries_size() > 0) {
+      constexpr uint64_t kMaxId = std::numeric_limits<uint64_t>::max();
+      Random random;
+      journal_id =
+          absl::Uniform<uint64_t>(absl::IntervalClosed, random, 1, kMaxId);
+    }
+    proto.set_journal_id(journal_id);
+    ResetJournalState(journal_id);
+    needs_sync_ = false;
   }
 
   // Reverse the contents to keep the LRU order when loading.
   absl::c_reverse(*proto.mutable_entries());
 
-  std::string output;
-  if (!proto.AppendToString(&output)) {
-    LOG(ERROR) << "AppendToString failed";
-    return false;
-  }
-
   // Remove the storage file when proto is empty because
   // storing empty file causes an error.
-  if (output.empty()) {
+  if (proto.entries_size() == 0) {
     FileUtil::UnlinkIfExists(filename()).IgnoreError();
+    storage.ClearJournal();
     return true;
   }
 
-  storage::EncryptedStringStorage storage(filename());
-  if (!storage.Save(output)) {
+  std::string output;
+  if (!proto.AppendToString(&output) || !storage.Save(output)) {
     LOG(ERROR) << "Can't save user history data.";
+    auto lock = AcquireUniqueLock();
+    needs_compaction_ = true;
+    needs_sync_ = true;
     return false;
   }
 
-  needs_sync_ = false;
+  // The records in the old journal have a different id, so they are ignored
+  // even if the process is terminated before the removal.
+  storage.ClearJournal();
 
   return true;
 }
 
+void UserHistoryStorage::ResetJournalState(uint64_t journal_id) {
+  updated_fps_.clear();
+  inserted_fps_.clear();
+  erased_fps_.clear();
+  needs_compaction_ = (journal_id == 0);
+  journal_id_ = journal_id;
+  num_journal_records_ = 0;
+}
+
 UserHistoryStorage::UniqueLock UserHistoryStorage::AcquireUniqueLock() const {
   return UniqueLock(mutex_);
 }
@@ -253,6 +539,9 @@ void UserHistoryStorage::ForEach(
     absl::FunctionRef<bool(uint64_t fp, Entry& entry)> func) {
   auto lock = AcquireUniqueLock();
 
+  // Entries may be modified anywhere in the LRU.
+  needs_compaction_ = true;
+
   for (DicElement& elm : *dic_) {
     if (!func(elm.key, elm.value)) {
       break;
@@ -266,6 +555,10 @@ UserHistoryStorage::EntrySnapshot UserHistoryStorage::Insert(
   needs_sync_ = true;
 
   DicElement* elm = dic_->Insert(fp);
+  key_index_.Touch(fp);
+  inserted_fps_.insert(fp);
+  updated_fps_.erase(fp);
+  erased_fps_.erase(fp);
   return EntrySnapshot(elm ? &elm->value : nullptr, std::move(lock));
 }
 
@@ -274,6 +567,10 @@ void UserHistoryStorage::Insert(Entry entry) const {
 
   auto lock = AcquireUniqueLock();
   needs_sync_ = true;
+  key_index_.Insert(fp, entry.key());
+  inserted_fps_.insert(fp);
+  updated_fps_.erase(fp);
+  erased_fps_.erase(fp);
   dic_->Insert(fp, std::move(entry));
 }
 
@@ -281,6 +578,10 @@ UserHistoryStorage::EntrySnapshot UserHistoryStorage::MutableLookup(
     uint64_t fp) const {
   auto lock = AcquireUniqueLock();
   needs_sync_ = true;
+  key_index_.MarkPending(fp);
+  if (!inserted_fps_.contains(fp)) {
+    updated_fps_.insert(fp);
+  }
   return EntrySnapshot(dic_->MutableLookupWithoutInsert(fp), std::move(lock));
 }
 
@@ -308,6 +609,32 @@ UserHistoryStorage::ConstEntrySnapshot UserHistoryStorage::NullEntry() const {
   return ConstEntrySnapshot(nullptr, std::move(lock));
 }
 
+void UserHistoryStorage::ForEachPrefixMatch(
+    absl::string_view key_base,
+    absl::FunctionRef<bool(uint64_t, const Entry&)> func) const {
+  auto lock = AcquireUniqueLock();
+
+  key_index_.ResolvePending([this](uint64_t fp) -> const std::string* {
+    const Entry* entry = dic_->LookupWithoutInsert(fp);
+    return entry ? &entry->key() : nullptr;
+  });
+  if (key_index_.size() > dic_->Size() + kMaxStaleIndexSize) {
+    key_index_.Prune([this](uint64_t fp) { return dic_->HasKey(fp); });
+  }
+
+  for (const uint64_t fp : key_index_.FindPrefixMatch(key_base)) {
+    const Entry* entry = dic_->LookupWithoutInsert(fp);
+    if (entry == nullptr) {
+      // Evicted from the LRU.
+      key_index_.Erase(fp);
+      continue;
+    }
+    if (!func(fp, *entry)) {
+      break;
+    }
+  }
+}
+
 UserHistoryStorage::ConstEntrySnapshot UserHistoryStorage::FindIf(
     absl::FunctionRef<bool(uint64_t, const Entry&)> func, int size) const {
   auto lock = AcquireUniqueLock();
@@ -334,6 +661,10 @@ void UserHistoryStorage::Erase(absl::Span<const uint64_t> fps) const {
 
   for (const uint64_t fp : fps) {
     dic_->Erase(fp);
+    key_index_.Erase(fp);
+    inserted_fps_.erase(fp);
+    updated_fps_.erase(fp);
+    erased_fps_.insert(fp);
   }
 }
 
@@ -41,6 +41,9 @@
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/functional/function_ref.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
@@ -86,6 +89,58 @@ class Snapshot {
   std::unique_lock<RecursiveMutex> lock_;
 };
 
+// Incremental index from entry keys to fingerprints, used to find the entries
+// whose key shares a prefix with the user input without scanning the whole
+// LRU. The index also records the LRU order so that the matched entries are
+// visited in the same order as the full scan.
+//
+// The key of an entry inserted by fingerprint is not known until the caller
+// fills it, so such entries are kept pending and resolved at the next lookup.
+// Entries evicted from the LRU are removed lazily.
+class KeyIndex {
+ public:
+  // Moves `fp` to the LRU head. Its key is resolved later.
+  void Touch(uint64_t fp);
+
+  // Moves `fp` to the LRU head with `key`.
+  void Insert(uint64_t fp, absl::string_view key);
+
+  // Marks the key of `fp` as possibly modified without changing LRU order.
+  void MarkPending(uint64_t fp);
+
+  void Erase(uint64_t fp);
+  void Clear();
+
+  // Resolves the pending keys with `get_key`, which returns nullptr when the
+  // entry no longer exists.
+  void ResolvePending(
+      absl::FunctionRef<const std::string*(uint64_t)> get_key);
+
+  // Removes the fingerprints for which `exists` returns false.
+  void Prune(absl::FunctionRef<bool(uint64_t)> exists);
+
+  // Returns the fingerprints whose key starts with `key` or is a non-empty
+  // prefix of `key`, in LRU order. Pending keys must be resolved beforehand.
+  std::vector<uint64_t> FindPrefixMatch(absl::string_view key) const;
+
+  size_t size() const { return items_.size(); }
+  bool has_pending() const { return !pending_.empty(); }
+
+ private:
+  struct Item {
+    std::string key;
+    // Larger is newer.
+    uint64_t stamp = 0;
+  };
+
+  void SetKey(uint64_t fp, Item& item, absl::string_view key);
+
+  absl::flat_hash_map<uint64_t, Item> items_;
+  absl::btree_set<std::pair<std::string, uint64_t>> keys_;
+  absl::flat_hash_set<uint64_t> pending_;
+  uint64_t clock_ = 0;
+};
+
 }  // namespace internal
 
 // UserHistoryStorage is a class that encapsulates lookup, insertion, and
@@ -156,6 +211,9 @@ class UserHistoryStorage {
   bool Load();
 
   // Saves the user history to the local disk. This method is blocking.
+  // Usually only the changes since the last save are appended to the journal.
+  // The whole history is written and the journal is cleared (compaction) when
+  // the journal gets long or the changes can't be tracked.
   bool Save();
 
   // Iterates the all entries in LRU order.
@@ -210,6 +268,14 @@ class UserHistoryStorage {
   // snapshot = std::move(snapshot2);
   ConstEntrySnapshot NullEntry() const;
 
+  // Iterates the entries whose key starts with `key_base` or is a non-empty
+  // prefix of `key_base` in LRU order. The result is the same as ForEach()
+  // skipping the other entries, but only the matching entries are visited
+  // through the key index.
+  void ForEachPrefixMatch(
+      absl::string_view key_base,
+      absl::FunctionRef<bool(uint64_t, const Entry&)> func) const;
+
   // Finds the entry with linear search. Only top `size` elements are
   // searched. When the size is -1 (default) search all entries.
   ConstEntrySnapshot FindIf(
@@ -233,6 +299,20 @@ class UserHistoryStorage {
 
   bool Load(user_history_predictor::UserHistory&& proto);
 
+  // Replays the journal records written for the snapshot `journal_id`.
+  bool ReplayJournal(const storage::EncryptedStringStorage& storage,
+                     uint64_t journal_id);
+
+  // Builds the journal record of the changes since the last save. Returns
+  // false if the whole history needs to be saved instead.
+  bool BuildJournalRecord(user_history_predictor::UserHistoryJournal* record);
+
+  // Saves the whole history and starts a new journal.
+  bool SaveSnapshot(const storage::EncryptedStringStorage& storage);
+
+  // Starts tracking changes for a new journal.
+  void ResetJournalState(uint64_t journal_id);
+
   // Migrate old 32bit Fingerprint to 64bit Fingerprint.
   static uint32_t FingerprintDepereated(absl::string_view key,
                                         absl::string_view value);
@@ -249,10 +329,27 @@ class UserHistoryStorage {
   // Sets true to cancel the syncer threads.
   std::atomic<bool> canceled_ = false;
 
+  // Serializes Save() so that a compaction never removes journal records
+  // appended concurrently. Acquired before `mutex_`.
+  absl::Mutex save_mutex_;
+
+  // Changes since the last save, written to the journal on the next save.
+  // Guarded by `mutex_`.
+  mutable absl::flat_hash_set<uint64_t> updated_fps_;
+  mutable absl::flat_hash_set<uint64_t> inserted_fps_;
+  mutable absl::flat_hash_set<uint64_t> erased_fps_;
+  // True if the changes can't be represented in the journal.
+  mutable bool needs_compaction_ = true;
+  // Id of the saved snapshot, and the number of records in its journal.
+  uint64_t journal_id_ = 0;
+  size_t num_journal_records_ = 0;
+
   mutable TaskManager task_manager_;
 
   mutable RecursiveMutex mutex_;
   mutable std::unique_ptr<DicCache> dic_;
+  // Key index over `dic_`. Guarded by `mutex_`.
+  mutable internal::KeyIndex key_index_;
 
   const std::string filename_;
 };
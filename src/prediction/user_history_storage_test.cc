@@ -34,6 +34,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "base/file/temp_dir.h"
@@ -224,6 +225,92 @@ TEST_F(UserHistoryStorageTest, BasicTest) {
   EXPECT_TRUE(storage.IsEmpty());
 }
 
+// Returns the fingerprints ForEachPrefixMatch() must visit, by a full scan.
+std::vector<uint64_t> ScanPrefixMatch(const UserHistoryStorage& storage,
+                                      absl::string_view key_base) {
+  std::vector<uint64_t> fps;
+  storage.ForEach([&](uint64_t fp, const Entry& entry) {
+    if (entry.key().starts_with(key_base) ||
+        (!entry.key().empty() && key_base.starts_with(entry.key()))) {
+      fps.push_back(fp);
+    }
+    return true;
+  });
+  return fps;
+}
+
+std::vector<uint64_t> IndexPrefixMatch(const UserHistoryStorage& storage,
+                                       absl::string_view key_base) {
+  std::vector<uint64_t> fps;
+  storage.ForEachPrefixMatch(key_base, [&](uint64_t fp, const Entry& entry) {
+    fps.push_back(fp);
+    return true;
+  });
+  return fps;
+}
+
+TEST_F(UserHistoryStorageTest, ForEachPrefixMatchTest) {
+  TempFile file(testing::MakeTempFileOrDie());
+  UserHistoryStorage storage(file.path());
+  storage.Wait();
+
+  for (int i = 0; i < 300; ++i) {
+    storage.Insert(MakeEntry(i));
+  }
+  // Inserted by fingerprint. The key is filled after the insertion.
+  for (absl::string_view key : {"ke", "key1", "key12", "key123"}) {
+    auto snapshot = storage.Insert(UserHistoryStorage::Fingerprint(key, "v"));
+    snapshot->set_key(key);
+    snapshot->set_value("v");
+  }
+  // Moves an old entry to the LRU head.
+  storage.Insert(MakeEntry(12));
+  storage.Erase({UserHistoryStorage::Fingerprint(MakeEntry(120))});
+
+  for (absl::string_view key_base :
+       {"k", "key", "key1", "key12", "key123", "key1234", "key299", "x"}) {
+    SCOPED_TRACE(key_base);
+    EXPECT_EQ(IndexPrefixMatch(storage, key_base),
+              ScanPrefixMatch(storage, key_base));
+  }
+  EXPECT_TRUE(IndexPrefixMatch(storage, "").empty());
+
+  // Stops the iteration.
+  int num_visited = 0;
+  storage.ForEachPrefixMatch("key", [&](uint64_t fp, const Entry& entry) {
+    return ++num_visited < 3;
+  });
+  EXPECT_EQ(num_visited, 3);
+
+  // Reloaded from the file.
+  storage.AsyncSave();
+  storage.Wait();
+  storage.AsyncLoad();
+  storage.Wait();
+  EXPECT_EQ(IndexPrefixMatch(storage, "key1"),
+            ScanPrefixMatch(storage, "key1"));
+
+  storage.Clear();
+  EXPECT_TRUE(IndexPrefixMatch(storage, "key").empty());
+}
+
+TEST_F(UserHistoryStorageTest, ForEachPrefixMatchAfterEvictionTest) {
+  TempFile file(testing::MakeTempFileOrDie());
+  UserHistoryStorage storage(file.path());
+  storage.Wait();
+
+  // More than the LRU size so that old entries are evicted.
+  for (int i = 0; i < 12000; ++i) {
+    storage.Insert(MakeEntry(i));
+  }
+  EXPECT_FALSE(storage.Contains(UserHistoryStorage::Fingerprint(MakeEntry(0))));
+  for (absl::string_view key_base : {"key1", "key11", "key1999", "key11999"}) {
+    SCOPED_TRACE(key_base);
+    EXPECT_EQ(IndexPrefixMatch(storage, key_base),
+              ScanPrefixMatch(storage, key_base));
+  }
+}
+
 TEST_F(UserHistoryStorageTest, MultiThreadsTest) {
   TempFile file(testing::MakeTempFileOrDie());
   UserHistoryStorage storage(file.path());
@@ -354,6 +441,105 @@ TEST_F(UserHistoryStorageTest, CancelTest) {
   check_serialized_data();
 }
 
+// Returns the entries in LRU order.
+std::vector<std::pair<std::string, uint32_t>> GetEntries(
+    const UserHistoryStorage& storage) {
+  std::vector<std::pair<std::string, uint32_t>> entries;
+  storage.ForEach([&](uint64_t fp, const Entry& entry) {
+    entries.emplace_back(absl::StrCat(entry.key(), "\t", entry.value()),
+                         entry.suggestion_freq());
+    return true;
+  });
+  return entries;
+}
+
+TEST_F(UserHistoryStorageTest, JournalTest) {
+  const TempFile file = testing::MakeTempFileOrDie();
+  const std::string journal_path = absl::StrCat(file.path(), ".journal");
+
+  UserHistoryStorage storage(file.path());
+  storage.Wait();
+  for (int i = 0; i < 100; ++i) {
+    storage.Insert(MakeEntry(i));
+  }
+  // The first save writes the whole history.
+  ASSERT_TRUE(storage.Save());
+  EXPECT_OK(FileUtil::FileExists(file.path()));
+  EXPECT_FALSE(FileUtil::FileExists(journal_path).ok());
+  const absl::StatusOr<std::string> snapshot =
+      FileUtil::GetContents(file.path());
+  ASSERT_OK(snapshot);
+
+  // Insertion, update in place, move to the LRU head and erase.
+  storage.Insert(MakeEntry(100));
+  storage.MutableLookup(UserHistoryStorage::Fingerprint(MakeEntry(10)))
+      ->set_suggestion_freq(5);
+  storage.Insert(UserHistoryStorage::Fingerprint(MakeEntry(20)));
+  storage.Erase({UserHistoryStorage::Fingerprint(MakeEntry(30))});
+  ASSERT_TRUE(storage.Save());
+  storage.Insert(MakeEntry(101));
+  ASSERT_TRUE(storage.Save());
+
+  // Only the journal is written.
+  EXPECT_EQ(FileUtil::GetContents(file.path()).value(), *snapshot);
+  EXPECT_OK(FileUtil::FileExists(journal_path));
+
+  {
+    UserHistoryStorage reloaded(file.path());
+    reloaded.Wait();
+    EXPECT_EQ(GetEntries(reloaded), GetEntries(storage));
+  }
+
+  // Simulates a crash in the middle of the last append. The records before it
+  // are still replayed.
+  const absl::StatusOr<std::string> journal =
+      FileUtil::GetContents(journal_path);
+  ASSERT_OK(journal);
+  ASSERT_OK(FileUtil::SetContents(journal_path,
+                                  journal->substr(0, journal->size() - 1)));
+  {
+    UserHistoryStorage reloaded(file.path());
+    reloaded.Wait();
+    EXPECT_TRUE(reloaded.Contains(MakeEntry(100)));
+    EXPECT_FALSE(reloaded.Contains(MakeEntry(101)));
+    EXPECT_FALSE(reloaded.Contains(MakeEntry(30)));
+    EXPECT_EQ(reloaded.Lookup(MakeEntry(10))->suggestion_freq(), 5);
+
+    // The broken journal is compacted into the snapshot.
+    reloaded.Insert(MakeEntry(102));
+    ASSERT_TRUE(reloaded.Save());
+    EXPECT_FALSE(FileUtil::FileExists(journal_path).ok());
+  }
+}
+
+TEST_F(UserHistoryStorageTest, StaleJournalTest) {
+  const TempFile file = testing::MakeTempFileOrDie();
+  const std::string journal_path = absl::StrCat(file.path(), ".journal");
+
+  UserHistoryStorage storage(file.path());
+  storage.Wait();
+  storage.Insert(MakeEntry(0));
+  ASSERT_TRUE(storage.Save());
+  storage.Insert(MakeEntry(1));
+  ASSERT_TRUE(storage.Save());
+  const absl::StatusOr<std::string> old_journal =
+      FileUtil::GetContents(journal_path);
+  ASSERT_OK(old_journal);
+
+  // Compaction by clearing the history.
+  storage.Erase({UserHistoryStorage::Fingerprint(MakeEntry(1))});
+  storage.ForEach([](uint64_t fp, Entry& entry) { return true; });
+  ASSERT_TRUE(storage.Save());
+  EXPECT_FALSE(FileUtil::FileExists(journal_path).ok());
+
+  // The process was terminated before removing the old journal.
+  ASSERT_OK(FileUtil::SetContents(journal_path, *old_journal));
+  UserHistoryStorage reloaded(file.path());
+  reloaded.Wait();
+  EXPECT_TRUE(reloaded.Contains(MakeEntry(0)));
+  EXPECT_FALSE(reloaded.Contains(MakeEntry(1)));
+}
+
 TEST_F(UserHistoryStorageTest, MigrateNextEntriesTest) {
   mozc::user_history_predictor::UserHistory proto;
 
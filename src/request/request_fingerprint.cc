@@ -0,0 +1,118 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "request/request_fingerprint.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "composer/composer.h"
+#include "prediction/result.h"
+#include "protocol/commands.pb.h"
+#include "request/conversion_request.h"
+
+namespace mozc {
+namespace {
+
+template <typename H>
+H HashOptions(H h, const ConversionRequest::Options& options) {
+  return H::combine(
+      std::move(h), options.request_type, options.composer_key_selection,
+      options.max_conversion_candidates_size,
+      options.max_user_history_prediction_candidates_size,
+      options.max_user_history_prediction_candidates_size_for_zero_query,
+      options.max_dictionary_prediction_candidates_size,
+      options.use_actual_converter_for_realtime_conversion,
+      options.skip_slow_rewriters, options.create_partial_candidates,
+      options.enable_user_history_for_conversion,
+      options.kana_modifier_insensitive_conversion,
+      options.use_already_typing_corrected_key, options.incognito_mode,
+      options.bos_id, options.disable_prefix_penalty);
+}
+
+template <typename H>
+H HashComposer(H h, const composer::ComposerData& composer) {
+  h = H::combine(std::move(h), composer.GetRawString(),
+                 composer.GetStringForTypeCorrection(),
+                 composer.GetQueryForPrediction(), composer.GetInputMode(),
+                 composer.GetCursor(), composer.GetLength());
+  for (const commands::SessionCommand::CompositionEvent& event :
+       composer.GetHandwritingCompositions()) {
+    h = H::combine(std::move(h), event.composition_string(),
+                   event.probability());
+  }
+  return h;
+}
+
+template <typename H>
+H HashHistory(H h, const prediction::Result& history) {
+  return H::combine(std::move(h), history.key, history.value, history.lid,
+                    history.rid, history.cost, history.inner_segment_boundary);
+}
+
+template <typename H>
+H HashContext(H h, const commands::Context& context) {
+  // `revision` changes on every edit and does not affect the result.
+  h = H::combine(std::move(h), context.preceding_text(),
+                 context.following_text(), context.suppress_suggestion(),
+                 context.input_field_type());
+  for (const std::string& feature : context.experimental_features()) {
+    h = H::combine(std::move(h), feature);
+  }
+  return H::combine(std::move(h), context.experimental_features_size());
+}
+
+// Wrapper to hash the ConversionRequest with absl::HashOf.
+struct RequestHashView {
+  const ConversionRequest& request;
+
+  template <typename H>
+  friend H AbslHashValue(H h, const RequestHashView& view) {
+    const ConversionRequest& request = view.request;
+    h = H::combine(std::move(h), request.key());
+    h = HashOptions(std::move(h), request.options());
+    h = HashComposer(std::move(h), request.composer());
+    h = HashHistory(std::move(h), request.history_result());
+    h = HashContext(std::move(h), request.context());
+    // The protos are small, and comparing their serialization is the only way
+    // to cover fields added in the future.
+    return H::combine(std::move(h), request.request().SerializeAsString(),
+                      request.config().SerializeAsString());
+  }
+};
+
+}  // namespace
+
+uint64_t ConversionRequestFingerprint(const ConversionRequest& request) {
+  return absl::HashOf(RequestHashView{request});
+}
+
+}  // namespace mozc
@@ -0,0 +1,116 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "request/request_fingerprint.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "composer/composer.h"
+#include "composer/table.h"
+#include "prediction/result.h"
+#include "protocol/commands.pb.h"
+#include "protocol/config.pb.h"
+#include "request/conversion_request.h"
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace {
+
+class RequestFingerprintTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    composer_ = std::make_unique<composer::Composer>(
+        std::make_shared<composer::Table>(), request_, config_);
+    composer_->SetPreeditTextForTestOnly("あいう");
+  }
+
+  uint64_t Fingerprint() const {
+    const ConversionRequest convreq =
+        ConversionRequestBuilder()
+            .SetComposer(*composer_)
+            .SetRequest(request_)
+            .SetConfig(config_)
+            .SetContext(context_)
+            .SetHistoryResultView(history_)
+            .SetOptions({.request_type = ConversionRequest::SUGGESTION})
+            .Build();
+    return ConversionRequestFingerprint(convreq);
+  }
+
+  commands::Request request_;
+  config::Config config_;
+  commands::Context context_;
+  prediction::Result history_;
+  std::unique_ptr<composer::Composer> composer_;
+};
+
+TEST_F(RequestFingerprintTest, SameRequest) {
+  EXPECT_EQ(Fingerprint(), Fingerprint());
+}
+
+TEST_F(RequestFingerprintTest, IgnoresContextRevision) {
+  const uint64_t fp = Fingerprint();
+  context_.set_revision(10);
+  EXPECT_EQ(Fingerprint(), fp);
+}
+
+TEST_F(RequestFingerprintTest, ChangesWithKey) {
+  const uint64_t fp = Fingerprint();
+  composer_->SetPreeditTextForTestOnly("あい");
+  EXPECT_NE(Fingerprint(), fp);
+}
+
+TEST_F(RequestFingerprintTest, ChangesWithHistory) {
+  const uint64_t fp = Fingerprint();
+  history_.key = "わたし";
+  history_.value = "私";
+  EXPECT_NE(Fingerprint(), fp);
+}
+
+TEST_F(RequestFingerprintTest, ChangesWithContext) {
+  const uint64_t fp = Fingerprint();
+  context_.set_preceding_text("今日は");
+  const uint64_t fp_preceding = Fingerprint();
+  EXPECT_NE(fp_preceding, fp);
+  context_.add_experimental_features("feature");
+  EXPECT_NE(Fingerprint(), fp_preceding);
+}
+
+TEST_F(RequestFingerprintTest, ChangesWithProtos) {
+  const uint64_t fp = Fingerprint();
+  config_.set_use_spelling_correction(!config_.use_spelling_correction());
+  const uint64_t fp_config = Fingerprint();
+  EXPECT_NE(fp_config, fp);
+  request_.set_mixed_conversion(!request_.mixed_conversion());
+  EXPECT_NE(Fingerprint(), fp_config);
+}
+
+}  // namespace
+}  // namespace mozc
@@ -39,6 +39,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
@@ -80,6 +81,27 @@ bool CollocationFilter::Exists(const absl::string_view left,
   return filter_.Exists({left, right});
 }
 
+size_t CollocationFilter::FindFirst(
+    const absl::string_view left,
+    const absl::Span<const absl::string_view> rights) const {
+  if (left.empty()) {
+    return rights.size();
+  }
+  absl::InlinedVector<std::array<absl::string_view, 2>, 32> pairs;
+  pairs.reserve(rights.size());
+  for (const absl::string_view right : rights) {
+    pairs.push_back({left, right});
+  }
+  absl::InlinedVector<bool, 32> results(rights.size());
+  filter_.ExistsMany(absl::MakeConstSpan(pairs), absl::MakeSpan(results));
+  for (size_t i = 0; i < rights.size(); ++i) {
+    if (results[i] && !rights[i].empty()) {
+      return i;
+    }
+  }
+  return rights.size();
+}
+
 absl::StatusOr<SuppressionFilter> SuppressionFilter::Create(
     absl::string_view data) {
   absl::StatusOr<ExistenceFilter> filter =
@@ -627,6 +649,28 @@ bool CollocationRewriter::RewriteUsingNextSegment(Segment* next_seg,
     next_seg_ok[j] = 1;
   }
 
+  // Flatten the tokens of the next segment so that all the pairs for a token
+  // of |seg| are checked in one batch. |next_indices| holds the candidate
+  // index of each token.
+  std::vector<absl::string_view> next_tokens;
+  std::vector<size_t> next_indices;
+  for (size_t j = 0; j < j_max; ++j) {
+    if (next_seg->candidate(j).cost >
+        next_seg->candidate(0).cost + kMaxCostDiff) {
+      continue;
+    }
+    if (!next_seg_ok[j]) {
+      continue;
+    }
+    for (absl::string_view next : nexts[j]) {
+      next_tokens.push_back(next);
+      next_indices.push_back(j);
+    }
+  }
+  if (next_tokens.empty()) {
+    return false;
+  }
+
   // Reuse |curs| in the loop as this method is performance critical.
   std::vector<std::string> curs;
   for (size_t i = 0; i < i_max; ++i) {
@@ -646,30 +690,21 @@ bool CollocationRewriter::RewriteUsingNextSegment(Segment* next_seg,
     }
 
     for (absl::string_view cur : curs) {
-      for (size_t j = 0; j < j_max; ++j) {
-        if (next_seg->candidate(j).cost >
-            next_seg->candidate(0).cost + kMaxCostDiff) {
-          continue;
-        }
-        if (!next_seg_ok[j]) {
-          continue;
-        }
-
-        for (absl::string_view next : nexts[j]) {
-          if (collocation_filter_.Exists(cur, next)) {
-            DCHECK(VerifyNaturalContent(next_seg->candidate(j),
-                                        next_seg->candidate(0), RIGHT))
-                << "IsNaturalContent() should not fail here.";
-            seg->move_candidate(i, 0);
-            seg->mutable_candidate(0)->attributes |=
-                converter::Attribute::CONTEXT_SENSITIVE;
-            next_seg->move_candidate(j, 0);
-            next_seg->mutable_candidate(0)->attributes |=
-                converter::Attribute::CONTEXT_SENSITIVE;
-            return true;
-          }
-        }
+      const size_t found = collocation_filter_.FindFirst(cur, next_tokens);
+      if (found == next_tokens.size()) {
+        continue;
       }
+      const size_t j = next_indices[found];
+      DCHECK(VerifyNaturalContent(next_seg->candidate(j),
+                                  next_seg->candidate(0), RIGHT))
+          << "IsNaturalContent() should not fail here.";
+      seg->move_candidate(i, 0);
+      seg->mutable_candidate(0)->attributes |=
+          converter::Attribute::CONTEXT_SENSITIVE;
+      next_seg->move_candidate(j, 0);
+      next_seg->mutable_candidate(0)->attributes |=
+          converter::Attribute::CONTEXT_SENSITIVE;
+      return true;
     }
   }
   return false;
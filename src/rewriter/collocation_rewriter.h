@@ -30,6 +30,7 @@
 #ifndef MOZC_REWRITER_COLLOCATION_REWRITER_H_
 #define MOZC_REWRITER_COLLOCATION_REWRITER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <utility>
@@ -56,6 +57,12 @@ class CollocationFilter {
 
   bool Exists(absl::string_view left, absl::string_view right) const;
 
+  // Returns the index of the first element of `rights` that makes a
+  // collocation with `left`, or `rights.size()` if there's none. The pairs are
+  // checked in a batch.
+  size_t FindFirst(absl::string_view left,
+                   absl::Span<const absl::string_view> rights) const;
+
  private:
   storage::ExistenceFilter filter_;
 };
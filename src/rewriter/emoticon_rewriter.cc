@@ -202,8 +202,9 @@ bool EmoticonRewriter::RewriteCandidate(Segments* segments) const {
 }
 
 EmoticonRewriter::EmoticonRewriter(absl::string_view token_array_data,
-                                   absl::string_view string_array_data)
-    : dic_(token_array_data, string_array_data) {}
+                                   absl::string_view string_array_data,
+                                   absl::string_view key_index_data)
+    : dic_(token_array_data, string_array_data, key_index_data) {}
 
 int EmoticonRewriter::capability(const ConversionRequest& request) const {
   if (request.request().mixed_conversion()) {
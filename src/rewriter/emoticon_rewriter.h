@@ -42,8 +42,10 @@ namespace mozc {
 
 class EmoticonRewriter : public RewriterInterface {
  public:
+  // `key_index_data` is optional; see SerializedDictionary.
   EmoticonRewriter(absl::string_view token_array_data,
-                   absl::string_view string_array_data);
+                   absl::string_view string_array_data,
+                   absl::string_view key_index_data = "");
 
   int capability(const ConversionRequest& request) const override;
 
@@ -50,6 +50,7 @@
 ABSL_FLAG(std::string, input, "", "Emoticon dictionary file");
 ABSL_FLAG(std::string, output_token_array, "", "Output token array");
 ABSL_FLAG(std::string, output_string_array, "", "Output string array");
+ABSL_FLAG(std::string, output_key_index, "", "Output key index (optional)");
 
 namespace mozc {
 namespace {
@@ -135,6 +136,7 @@ int main(int argc, char** argv) {
   const auto& input_data = mozc::ReadEmoticonTsv(absl::GetFlag(FLAGS_input));
   mozc::SerializedDictionary::CompileToFiles(
       input_data, absl::GetFlag(FLAGS_output_token_array),
-      absl::GetFlag(FLAGS_output_string_array));
+      absl::GetFlag(FLAGS_output_string_array),
+      absl::GetFlag(FLAGS_output_key_index));
   return 0;
 }
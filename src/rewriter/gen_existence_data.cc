@@ -46,15 +46,20 @@ namespace mozc {
 namespace {
 
 using ::mozc::storage::ExistenceFilterBuilder;
+using ::mozc::storage::ExistenceFilterParams;
 
 std::string GenExistenceData(const absl::Span<const std::string> entries,
                              double error_rate) {
   const int n = entries.size();
-  const int m =
-      ExistenceFilterBuilder::MinFilterSizeInBytesForErrorRate(error_rate, n);
+  const int m = ExistenceFilterBuilder::MinFilterSizeInBytesForErrorRate(
+      error_rate, n, ExistenceFilterParams::BLOCKED_VERSION);
   LOG(INFO) << "entry: " << n << " err: " << error_rate << " bytes: " << m;
 
-  ExistenceFilterBuilder builder(ExistenceFilterBuilder::CreateOptimal(m, n));
+  // CollocationRewriter looks up the entries given in pieces, so the
+  // streaming fingerprint saves the concatenation.
+  ExistenceFilterBuilder builder(ExistenceFilterBuilder::CreateOptimal(
+      m, n, ExistenceFilterParams::STREAMING_FP,
+      ExistenceFilterParams::BLOCKED_VERSION));
 
   for (absl::string_view entry : entries) {
     builder.Insert(entry);
@@ -77,6 +77,8 @@ ABSL_FLAG(std::string, output_token_array, "",
           "output token array binary file");
 ABSL_FLAG(std::string, output_string_array, "",
           "output string array binary file");
+ABSL_FLAG(std::string, output_key_index, "",
+          "output key index binary file (optional)");
 
 namespace mozc {
 namespace {
@@ -1113,7 +1115,8 @@ int main(int argc, char** argv) {
   }
   mozc::SerializedDictionary::CompileToFiles(
       tmp_text_file->path(), absl::GetFlag(FLAGS_output_token_array),
-      absl::GetFlag(FLAGS_output_string_array));
+      absl::GetFlag(FLAGS_output_string_array),
+      absl::GetFlag(FLAGS_output_key_index));
 
   return 0;
 }
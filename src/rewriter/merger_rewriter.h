@@ -33,10 +33,14 @@
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "base/latency_tracer.h"
 #include "converter/segments.h"
 #include "protocol/commands.pb.h"
 #include "protocol/config.pb.h"
@@ -53,8 +57,15 @@ class MergerRewriter : public RewriterInterface {
   MergerRewriter(const MergerRewriter&) = delete;
   MergerRewriter& operator=(const MergerRewriter&) = delete;
 
-  void AddRewriter(std::unique_ptr<RewriterInterface> rewriter) {
+  // |name| identifies the rewriter in the latency statistics as
+  // "rewriter/<name>". The index of the rewriter is used if it is empty.
+  void AddRewriter(std::unique_ptr<RewriterInterface> rewriter,
+                   absl::string_view name = "") {
     DCHECK(rewriter);
+    const std::string stage_name =
+        name.empty() ? absl::StrCat("rewriter/", rewriters_.size())
+                     : absl::StrCat("rewriter/", name);
+    latency_stages_.push_back(LatencyTracer::RegisterStage(stage_name));
     rewriters_.push_back(std::move(rewriter));
   }
 
@@ -97,9 +108,11 @@ class MergerRewriter : public RewriterInterface {
     }();
 
     bool is_updated = false;
-    for (const std::unique_ptr<RewriterInterface>& rewriter : rewriters_) {
-      if (rewriter->capability(request) & capability_type) {
-        is_updated |= rewriter->Rewrite(request, segments);
+    for (size_t i = 0; i < rewriters_.size(); ++i) {
+      const RewriterInterface& rewriter = *rewriters_[i];
+      if (rewriter.capability(request) & capability_type) {
+        ScopedLatencyTimer latency_timer(latency_stages_[i]);
+        is_updated |= rewriter.Rewrite(request, segments);
       }
     }
 
@@ -182,6 +195,8 @@ class MergerRewriter : public RewriterInterface {
 
  private:
   std::vector<std::unique_ptr<RewriterInterface>> rewriters_;
+  // Parallel to |rewriters_|.
+  std::vector<LatencyTracer::StageId> latency_stages_;
 };
 
 }  // namespace mozc
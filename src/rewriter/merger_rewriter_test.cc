@@ -30,10 +30,12 @@
 #include "rewriter/merger_rewriter.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
 #include "absl/strings/string_view.h"
+#include "base/latency_tracer.h"
 #include "converter/segments.h"
 #include "protocol/commands.pb.h"
 #include "protocol/config.pb.h"
@@ -139,6 +141,38 @@ TEST_F(MergerRewriterTest, Rewrite) {
             "d.Rewrite();");
 }
 
+TEST_F(MergerRewriterTest, RewriteLatency) {
+  LatencyTracer::Reset();
+  std::string call_result;
+  MergerRewriter merger;
+  Segments segments;
+  const ConversionRequest request;
+
+  merger.AddRewriter(std::make_unique<TestRewriter>(&call_result, "a", false),
+                     "TestRewriterA");
+  merger.AddRewriter(std::make_unique<TestRewriter>(
+      &call_result, "b", false, RewriterInterface::NOT_AVAILABLE));
+  merger.AddRewriter(std::make_unique<TestRewriter>(&call_result, "c", false));
+  merger.Rewrite(request, &segments);
+
+  uint64_t count_a = 0, count_b = 0, count_c = 0;
+  for (const LatencyTracer::StageStats& stats :
+       LatencyTracer::GetSnapshot().stages) {
+    if (stats.name == "rewriter/TestRewriterA") {
+      count_a = stats.count;
+    } else if (stats.name == "rewriter/1") {
+      count_b = stats.count;
+    } else if (stats.name == "rewriter/2") {
+      count_c = stats.count;
+    }
+  }
+  EXPECT_EQ(count_a, 1);
+  // Rewriters that are not called are not recorded.
+  EXPECT_EQ(count_b, 0);
+  EXPECT_EQ(count_c, 1);
+  LatencyTracer::Reset();
+}
+
 TEST_F(MergerRewriterTest, RewriteSuggestion) {
   std::string call_result;
   MergerRewriter merger;
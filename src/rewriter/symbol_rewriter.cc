@@ -397,10 +397,11 @@ SymbolRewriter::CheckResizeSegmentsRequest(const ConversionRequest& request,
 }
 
 SymbolRewriter::SymbolRewriter(absl::string_view token_array_data,
-                               absl::string_view string_array_data) {
+                               absl::string_view string_array_data,
+                               absl::string_view key_index_data) {
   DCHECK(SerializedDictionary::VerifyData(token_array_data, string_array_data));
-  dictionary_ = std::make_unique<SerializedDictionary>(token_array_data,
-                                                       string_array_data);
+  dictionary_ = std::make_unique<SerializedDictionary>(
+      token_array_data, string_array_data, key_index_data);
 }
 
 int SymbolRewriter::capability(const ConversionRequest& request) const {
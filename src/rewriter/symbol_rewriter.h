@@ -46,8 +46,10 @@ class ConverterInterface;
 
 class SymbolRewriter : public RewriterInterface {
  public:
+  // `key_index_data` is optional; see SerializedDictionary.
   SymbolRewriter(absl::string_view token_array_data,
-                 absl::string_view string_array_data);
+                 absl::string_view string_array_data,
+                 absl::string_view key_index_data = "");
   ~SymbolRewriter() override = default;
 
   int capability(const ConversionRequest& request) const override;
@@ -44,6 +44,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "base/config_file_stream.h"
 #include "base/file_util.h"
 #include "base/vlog.h"
@@ -189,6 +190,7 @@ void UserBoundaryHistoryRewriter::Finish(const ConversionRequest& request,
   }
 
   if (segments.resized()) {
+    absl::MutexLock lock(mutex_);
     Insert(request, segments);
   }
 }
@@ -237,6 +239,7 @@ UserBoundaryHistoryRewriter::CheckResizeSegmentsRequest(
     return std::nullopt;
   }
 
+  absl::ReaderMutexLock lock(mutex_);
   for (size_t seg_idx = 0; seg_idx < target_segments_size; ++seg_idx) {
     constexpr int kMaxKeysSize = 5;
     const int keys_size =
@@ -279,6 +282,7 @@ UserBoundaryHistoryRewriter::CheckResizeSegmentsRequest(
 bool UserBoundaryHistoryRewriter::Sync() { return true; }
 
 bool UserBoundaryHistoryRewriter::Reload() {
+  absl::MutexLock lock(mutex_);
   const std::string filename = ConfigFileStream::GetFileName(kFileName);
   if (!storage_.OpenOrCreate(filename.c_str(), kValueSize, kLruSize,
                              kSeedValue)) {
@@ -342,6 +346,7 @@ bool UserBoundaryHistoryRewriter::Insert(const ConversionRequest& request,
 
 void UserBoundaryHistoryRewriter::Clear() {
   MOZC_VLOG(1) << "Clearing user segment data";
+  absl::MutexLock lock(mutex_);
   storage_.Clear();
 }
 
@@ -32,6 +32,8 @@
 
 #include <optional>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "converter/segments.h"
 #include "request/conversion_request.h"
 #include "rewriter/rewriter_interface.h"
@@ -58,9 +60,13 @@ class UserBoundaryHistoryRewriter : public RewriterInterface {
   void Clear() override;
 
  private:
-  bool Insert(const ConversionRequest& request, const Segments& segments);
+  bool Insert(const ConversionRequest& request, const Segments& segments)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  storage::LruStorage storage_;
+  // Lookups share the reader lock; learning and reloading take the writer
+  // lock.
+  mutable absl::Mutex mutex_;
+  storage::LruStorage storage_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace mozc
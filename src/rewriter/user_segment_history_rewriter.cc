@@ -46,6 +46,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "base/config_file_stream.h"
 #include "base/file_util.h"
@@ -775,6 +776,7 @@ void UserSegmentHistoryRewriter::Finish(const ConversionRequest& request,
     return;
   }
 
+  absl::MutexLock lock(mutex_);
   if (!IsAvailable(request, segments)) {
     return;
   }
@@ -812,6 +814,7 @@ void UserSegmentHistoryRewriter::Finish(const ConversionRequest& request,
 bool UserSegmentHistoryRewriter::Sync() { return true; }
 
 bool UserSegmentHistoryRewriter::Reload() {
+  absl::MutexLock lock(mutex_);
   const std::string filename = ConfigFileStream::GetFileName(kFileName);
   if (!storage_->OpenOrCreate(filename.c_str(), kValueSize, kLruSize,
                               kSeedValue)) {
@@ -928,6 +931,7 @@ bool UserSegmentHistoryRewriter::RewriteNumber(Segment* segment) const {
 
 bool UserSegmentHistoryRewriter::Rewrite(const ConversionRequest& request,
                                          Segments* segments) const {
+  absl::ReaderMutexLock lock(mutex_);
   if (!IsAvailable(request, *segments)) {
     return false;
   }
@@ -1012,6 +1016,7 @@ bool UserSegmentHistoryRewriter::Rewrite(const ConversionRequest& request,
 }
 
 void UserSegmentHistoryRewriter::Clear() {
+  absl::MutexLock lock(mutex_);
   if (storage_ != nullptr) {
     MOZC_VLOG(1) << "Clearing user segment data";
     storage_->Clear();
@@ -1019,6 +1024,7 @@ void UserSegmentHistoryRewriter::Clear() {
 }
 
 void UserSegmentHistoryRewriter::Revert(const Segments& segments) {
+  absl::MutexLock lock(mutex_);
   const std::vector<std::string>* revert_entries =
       revert_cache_.LookupWithoutInsert(segments.revert_id());
   if (!revert_entries) {
@@ -1041,6 +1047,7 @@ bool UserSegmentHistoryRewriter::ClearHistoryEntry(const Segments& segments,
   absl::string_view value = candidate.value;
 
   FeatureKey fkey(segments, *pos_matcher_, segment_index);
+  absl::MutexLock lock(mutex_);
   bool result = false;
   result |= DeleteEntry(fkey.LeftRight(key, value));
   result |= DeleteEntry(fkey.LeftLeft(key, value));
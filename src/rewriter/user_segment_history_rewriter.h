@@ -37,7 +37,9 @@
 #include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "converter/candidate.h"
 #include "converter/segments.h"
@@ -97,9 +99,11 @@ class UserSegmentHistoryRewriter : public RewriterInterface {
       const ConversionRequest& request, const Segments& segments);
 
   bool IsAvailable(const ConversionRequest& request,
-                   const Segments& segments) const;
+                   const Segments& segments) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
   Score GetScore(const ConversionRequest& request, const Segments& segments,
-                 size_t segment_index, int candidate_index) const;
+                 size_t segment_index, int candidate_index) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
   bool Replaceable(const ConversionRequest& request,
                    const converter::Candidate& best_candidate,
                    const converter::Candidate& target_candidate) const;
@@ -107,30 +111,41 @@ class UserSegmentHistoryRewriter : public RewriterInterface {
   // Finish() operation in Revert().
   void RememberFirstCandidate(const ConversionRequest& request,
                               const Segments& segments, size_t segment_index,
-                              std::vector<std::string>& revert_entries);
+                              std::vector<std::string>& revert_entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void RememberNumberPreference(const Segment& segment,
-                                std::vector<std::string>& revert_entries);
-  bool RewriteNumber(Segment* segment) const;
-  bool ShouldRewrite(const Segment& segment, size_t* max_candidates_size) const;
-  void InsertTriggerKey(const Segment& segment);
+                                std::vector<std::string>& revert_entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool RewriteNumber(Segment* segment) const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+  bool ShouldRewrite(const Segment& segment, size_t* max_candidates_size) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+  void InsertTriggerKey(const Segment& segment)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   bool IsPunctuation(const Segment& seg,
                      const converter::Candidate& candidate) const;
   bool SortCandidates(absl::Span<const ScoreCandidate> sorted_scores,
                       Segment* segment) const;
-  Score Fetch(absl::string_view key, uint32_t weight) const;
+  Score Fetch(absl::string_view key, uint32_t weight) const
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
   void Insert(absl::string_view key, bool force,
-              std::vector<std::string>& revert_entries);
+              std::vector<std::string>& revert_entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void MaybeInsertRevertEntry(absl::string_view key,
-                              std::vector<std::string>& revert_entries);
+                              std::vector<std::string>& revert_entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   // Returns true if deletion succeeded.
-  bool DeleteEntry(absl::string_view key);
+  bool DeleteEntry(absl::string_view key) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  std::unique_ptr<storage::LruStorage> storage_;
+  // Rewrite() only reads the storage, so conversions from different sessions
+  // share the reader lock. Learning and reloading take the writer lock.
+  mutable absl::Mutex mutex_;
+  std::unique_ptr<storage::LruStorage> storage_ ABSL_GUARDED_BY(mutex_);
   const dictionary::PosMatcher* pos_matcher_;
   const dictionary::PosGroup* pos_group_;
 
   // Internal LRU cache to store reverted key.
-  storage::LruCache<uint64_t, std::vector<std::string>> revert_cache_;
+  storage::LruCache<uint64_t, std::vector<std::string>> revert_cache_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace mozc
@@ -44,6 +44,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "base/clock.h"
+#include "base/latency_tracer.h"
 #include "base/util.h"
 #include "composer/composer.h"
 #include "composer/key_event_util.h"
@@ -508,6 +509,9 @@ bool Session::TestSendKey(commands::Command* command) {
 }
 
 bool Session::SendKey(commands::Command* command) {
+  static const LatencyTracer::StageId kLatencyStage =
+      LatencyTracer::RegisterStage("session/send_key");
+  ScopedLatencyTimer latency_timer(kLatencyStage);
   UpdateTime();
   UpdatePreferences(command);
   TransformInput(command->mutable_input());
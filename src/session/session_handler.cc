@@ -43,8 +43,10 @@
 #include "absl/flags/flag.h"
 #include "absl/log/log.h"
 #include "absl/random/random.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "base/clock.h"
+#include "base/latency_tracer.h"
 #include "base/stopwatch.h"
 #include "base/version.h"
 #include "base/vlog.h"
@@ -97,6 +99,10 @@ ABSL_FLAG(int32_t, last_create_session_timeout, 300,
 
 ABSL_FLAG(bool, restricted, false, "Launch server with restricted setting");
 
+ABSL_FLAG(bool, concurrent_sessions, false,
+          "evaluate commands for different sessions concurrently. "
+          "Commands for the same session are still serialized.");
+
 namespace mozc {
 namespace {
 
@@ -153,6 +159,7 @@ SessionHandler::SessionHandler(std::unique_ptr<EngineInterface> engine)
   // Allow [2..128] sessions.
   max_session_size_ = std::clamp(absl::GetFlag(FLAGS_max_session_size), 2, 128);
   session_map_ = std::make_unique<SessionMap>(max_session_size_);
+  concurrent_sessions_ = absl::GetFlag(FLAGS_concurrent_sessions);
 
   if (!engine_) {
     return;
@@ -200,10 +207,10 @@ void SessionHandler::UpdateSessions(
       table_manager_->GetTable(*request_, *config_);
 
   for (SessionElement& element : *session_map_) {
-    std::unique_ptr<session::Session>& session = element.value;
-    if (!session) {
+    if (!element.value || !element.value->session) {
       continue;
     }
+    session::Session* session = element.value->session.get();
     session->SetConfig(config_);
     session->SetKeyMapManager(key_map_manager_);
     session->SetRequest(request_);
@@ -303,6 +310,17 @@ bool SessionHandler::SetRequest(commands::Command* command) {
   return true;
 }
 
+bool SessionHandler::IsSessionCommand(const commands::Command& command) {
+  switch (command.input().type()) {
+    case commands::Input::SEND_KEY:
+    case commands::Input::TEST_SEND_KEY:
+    case commands::Input::SEND_COMMAND:
+      return true;
+    default:
+      return false;
+  }
+}
+
 bool SessionHandler::EvalCommand(commands::Command* command) {
   if (!is_available_) {
     LOG(ERROR) << "SessionHandler is not available.";
@@ -313,6 +331,42 @@ bool SessionHandler::EvalCommand(commands::Command* command) {
   Stopwatch stopwatch;
   stopwatch.Start();
 
+  if (concurrent_sessions_ && IsSessionCommand(*command)) {
+    {
+      absl::ReaderMutexLock lock(mutex_);
+      eval_succeeded = EvalSessionCommand(command);
+    }
+    if (eval_succeeded &&
+        command->input().type() != commands::Input::TEST_SEND_KEY &&
+        command->output().has_config()) {
+      // Applying a config updated by the session touches all the sessions.
+      absl::MutexLock lock(mutex_);
+      MaybeUpdateConfig(command);
+    }
+  } else {
+    absl::MutexLock lock(mutex_);
+    eval_succeeded = EvalCommandExclusively(command);
+  }
+
+  if (eval_succeeded) {
+    if (command->input().type() != commands::Input::CREATE_SESSION) {
+      // Fill a session ID even if command->input() doesn't have a id to ensure
+      // that response size should not be 0, which causes disconnection of IPC.
+      command->mutable_output()->set_id(command->input().id());
+    }
+  } else {
+    command->mutable_output()->set_id(0);
+    command->mutable_output()->set_error_code(
+        commands::Output::SESSION_FAILURE);
+  }
+
+  stopwatch.Stop();
+
+  return is_available_;
+}
+
+bool SessionHandler::EvalCommandExclusively(commands::Command* command) {
+  bool eval_succeeded = false;
   switch (command->input().type()) {
     case commands::Input::CREATE_SESSION:
       eval_succeeded = CreateSession(command);
@@ -321,13 +375,14 @@ bool SessionHandler::EvalCommand(commands::Command* command) {
       eval_succeeded = DeleteSession(command);
       break;
     case commands::Input::SEND_KEY:
-      eval_succeeded = SendKey(command);
+    case commands::Input::SEND_COMMAND:
+      eval_succeeded = EvalSessionCommand(command);
+      if (eval_succeeded) {
+        MaybeUpdateConfig(command);
+      }
       break;
     case commands::Input::TEST_SEND_KEY:
-      eval_succeeded = TestSendKey(command);
-      break;
-    case commands::Input::SEND_COMMAND:
-      eval_succeeded = SendCommand(command);
+      eval_succeeded = EvalSessionCommand(command);
       break;
     case commands::Input::SYNC_DATA:
       eval_succeeded = SyncData(command);
@@ -380,25 +435,13 @@ bool SessionHandler::EvalCommand(commands::Command* command) {
     case commands::Input::GET_SERVER_VERSION:
       eval_succeeded = GetServerVersion(command);
       break;
+    case commands::Input::GET_LATENCY_STATS:
+      eval_succeeded = GetLatencyStats(command);
+      break;
     default:
       eval_succeeded = false;
   }
-
-  if (eval_succeeded) {
-    if (command->input().type() != commands::Input::CREATE_SESSION) {
-      // Fill a session ID even if command->input() doesn't have a id to ensure
-      // that response size should not be 0, which causes disconnection of IPC.
-      command->mutable_output()->set_id(command->input().id());
-    }
-  } else {
-    command->mutable_output()->set_id(0);
-    command->mutable_output()->set_error_code(
-        commands::Output::SESSION_FAILURE);
-  }
-
-  stopwatch.Stop();
-
-  return is_available_;
+  return eval_succeeded;
 }
 
 std::unique_ptr<session::Session> SessionHandler::NewSession() {
@@ -415,39 +458,41 @@ void SessionHandler::MaybeUpdateConfig(commands::Command* command) {
   Reload(command);
 }
 
-bool SessionHandler::SendKey(commands::Command* command) {
-  const SessionID id = command->input().id();
-  std::unique_ptr<session::Session>* session = session_map_->MutableLookup(id);
-  if (session == nullptr || !*session) {
+SessionHandler::SessionEntry* SessionHandler::LookupSession(
+    const SessionID id) {
+  // MutableLookup() updates the LRU order, which is shared by the concurrent
+  // session commands.
+  absl::MutexLock lock(session_map_mutex_);
+  std::unique_ptr<SessionEntry>* entry = session_map_->MutableLookup(id);
+  if (entry == nullptr || !*entry || !(*entry)->session) {
     LOG(WARNING) << "SessionID " << id << " is not available";
-    return false;
+    return nullptr;
   }
-  (*session)->SendKey(command);
-  MaybeUpdateConfig(command);
-  return true;
+  return entry->get();
 }
 
-bool SessionHandler::TestSendKey(commands::Command* command) {
-  const SessionID id = command->input().id();
-  std::unique_ptr<session::Session>* session = session_map_->MutableLookup(id);
-  if (session == nullptr || !*session) {
-    LOG(WARNING) << "SessionID " << id << " is not available";
+bool SessionHandler::EvalSessionCommand(commands::Command* command) {
+  SessionEntry* entry = LookupSession(command->input().id());
+  if (entry == nullptr) {
     return false;
   }
-  (*session)->TestSendKey(command);
-  return true;
-}
 
-bool SessionHandler::SendCommand(commands::Command* command) {
-  const SessionID id = command->input().id();
-  std::unique_ptr<session::Session>* session = session_map_->MutableLookup(id);
-  if (session == nullptr || !*session) {
-    LOG(WARNING) << "SessionID " << id << " is not available";
-    return false;
+  absl::MutexLock lock(entry->mutex);
+  session::Session& session = *entry->session;
+  switch (command->input().type()) {
+    case commands::Input::SEND_KEY:
+      session.SendKey(command);
+      return true;
+    case commands::Input::TEST_SEND_KEY:
+      session.TestSendKey(command);
+      return true;
+    case commands::Input::SEND_COMMAND:
+      session.SendCommand(command);
+      return true;
+    default:
+      LOG(DFATAL) << "Not a session command: " << command->input().type();
+      return false;
   }
-  (*session)->SendCommand(command);
-  MaybeUpdateConfig(command);
-  return true;
 }
 
 void SessionHandler::MaybeReloadEngine(commands::Command* command) {
@@ -476,6 +521,28 @@ bool SessionHandler::GetServerVersion(mozc::commands::Command* command) const {
   return true;
 }
 
+bool SessionHandler::GetLatencyStats(commands::Command* command) const {
+  const LatencyTracer::Snapshot snapshot = LatencyTracer::GetSnapshot();
+  commands::LatencyStats* stats =
+      command->mutable_output()->mutable_latency_stats();
+  for (const LatencyTracer::StageStats& stage_stats : snapshot.stages) {
+    commands::LatencyStats::Stage* stage = stats->add_stages();
+    stage->set_name(stage_stats.name);
+    stage->set_count(stage_stats.count);
+    stage->set_total_micros(absl::ToInt64Microseconds(stage_stats.total));
+    stage->set_max_micros(absl::ToInt64Microseconds(stage_stats.max));
+    for (const uint64_t count : stage_stats.buckets) {
+      stage->add_bucket_counts(count);
+    }
+  }
+  for (const LatencyTracer::Event& event : snapshot.recent_events) {
+    commands::LatencyStats::Event* recent_event = stats->add_recent_events();
+    recent_event->set_stage(event.stage);
+    recent_event->set_latency_micros(absl::ToInt64Microseconds(event.latency));
+  }
+  return true;
+}
+
 bool SessionHandler::CreateSession(commands::Command* command) {
   // prevent DOS attack
   // don't allow CreateSession in very short period.
@@ -529,7 +596,8 @@ bool SessionHandler::CreateSession(commands::Command* command) {
 
   const SessionID new_id = CreateNewSessionID();
   SessionElement* element = session_map_->Insert(new_id);
-  element->value = std::move(session);
+  element->value = std::make_unique<SessionEntry>();
+  element->value->session = std::move(session);
   command->mutable_output()->set_id(new_id);
 
   // The created session has not been fully initialized yet.
@@ -590,7 +658,7 @@ bool SessionHandler::Cleanup(commands::Command* command) {
 
   std::vector<SessionID> remove_ids;
   for (const SessionElement& element : *session_map_) {
-    const session::Session* session = element.value.get();
+    const session::Session* session = element.value->session.get();
     if (!IsApplicationAlive(session)) {
       MOZC_VLOG(2) << "Application is not alive. Removing: " << element.key;
       remove_ids.push_back(element.key);
@@ -697,12 +765,12 @@ SessionID SessionHandler::CreateNewSessionID() {
 }
 
 bool SessionHandler::DeleteSessionID(SessionID id) {
-  std::unique_ptr<session::Session>* session = session_map_->MutableLookup(id);
-  if (session == nullptr || !*session) {
+  std::unique_ptr<SessionEntry>* entry = session_map_->MutableLookup(id);
+  if (entry == nullptr || !*entry) {
     LOG_IF(WARNING, id != 0) << "cannot find SessionID " << id;
     return false;
   }
-  session->reset();
+  entry->reset();
 
   session_map_->Erase(id);  // remove from LRU
 
@@ -32,12 +32,15 @@
 #ifndef MOZC_SESSION_SESSION_HANDLER_H_
 #define MOZC_SESSION_SESSION_HANDLER_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/random/random.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "composer/table.h"
 #include "engine/engine_interface.h"
@@ -64,6 +67,10 @@ class SessionHandler {
   // Returns true if SessionHandle is available.
   bool IsAvailable() const;
 
+  // Evaluates the command. This method is thread-safe. By default, commands
+  // are evaluated one by one. With --concurrent_sessions, key and session
+  // commands for different sessions run in parallel, while the other
+  // commands still run exclusively.
   bool EvalCommand(commands::Command* command);
 
   // Starts watch dog timer to cleanup sessions.
@@ -79,18 +86,38 @@ class SessionHandler {
  private:
   friend class KeyMapManagerAccessorTestPeer;
 
+  // A session and the lock serializing the commands sent to it. The lock is
+  // not needed while `mutex_` is held exclusively.
+  struct SessionEntry {
+    absl::Mutex mutex;
+    std::unique_ptr<session::Session> session;
+  };
   using SessionMap =
-      mozc::storage::LruCache<SessionID, std::unique_ptr<session::Session>>;
+      mozc::storage::LruCache<SessionID, std::unique_ptr<SessionEntry>>;
   using SessionElement = SessionMap::Element;
 
+  // Returns true if the command is addressed to a single session, i.e. it can
+  // be evaluated concurrently with commands for other sessions.
+  static bool IsSessionCommand(const commands::Command& command);
+
+  // Evaluates the command with the exclusive lock of `mutex_`.
+  bool EvalCommandExclusively(commands::Command* command)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Evaluates SEND_KEY, TEST_SEND_KEY and SEND_COMMAND. Only the session of
+  // the command is locked, so the caller may hold `mutex_` shared.
+  bool EvalSessionCommand(commands::Command* command)
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  // Returns the session entry for `id`, or nullptr if it is not available.
+  SessionEntry* LookupSession(SessionID id) ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
   // Updates the config, if the |command| contains the config.
-  void MaybeUpdateConfig(commands::Command* command);
+  void MaybeUpdateConfig(commands::Command* command)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   bool CreateSession(commands::Command* command);
   bool DeleteSession(commands::Command* command);
-  bool TestSendKey(commands::Command* command);
-  bool SendKey(commands::Command* command);
-  bool SendCommand(commands::Command* command);
   // Syncs internal data to local file system and wait for finish.
   bool SyncData(commands::Command* command);
   bool ClearUserHistory(commands::Command* command);
@@ -118,6 +145,7 @@ class SessionHandler {
   bool NoOperation(commands::Command* command);
   bool ReloadSupplementalModel(commands::Command* command);
   bool GetServerVersion(commands::Command* command) const;
+  bool GetLatencyStats(commands::Command* command) const;
 
   // Replaces engine_ with a new instance if it is ready.
   void MaybeReloadEngine(commands::Command* command);
@@ -125,11 +153,19 @@ class SessionHandler {
   SessionID CreateNewSessionID();
   bool DeleteSessionID(SessionID id);
 
+  // Held shared by session commands in the concurrent mode and exclusively by
+  // all the other commands. The engine, the config and the set of sessions
+  // are only modified under the exclusive lock.
+  absl::Mutex mutex_;
+  // Guards the LRU order of `session_map_` while `mutex_` is held shared.
+  absl::Mutex session_map_mutex_ ABSL_ACQUIRED_AFTER(mutex_);
+  bool concurrent_sessions_ = false;
+
   std::unique_ptr<SessionMap> session_map_;
 #ifndef MOZC_DISABLE_SESSION_WATCHDOG
   std::optional<SessionWatchDog> session_watch_dog_;
 #endif  // MOZC_DISABLE_SESSION_WATCHDOG
-  bool is_available_ = false;
+  std::atomic<bool> is_available_ = false;
   uint32_t max_session_size_ = 0;
   absl::Time last_session_empty_time_ = absl::InfinitePast();
   absl::Time last_cleanup_time_ = absl::InfinitePast();
@@ -0,0 +1,458 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Load generator for SessionHandler.
+//
+// Drives --num_users simulated users, each owning a session, for --duration
+// and periodically reports the throughput, the latency of SEND_KEY, the
+// resident set size and the size of the user profile directory. Run it with
+// --concurrent_sessions to measure the concurrent session mode.
+//
+// Usage:
+// session_handler_load_main --num_users 16 --duration 10m
+//                           --profile /tmp/mozc_load --concurrent_sessions
+//
+// By default the users type random sentences generated by
+// RandomKeyEventsGenerator. With --input, they replay recorded keys instead.
+// The file has the same format as the input of session_client_main: one key
+// per line, parsed by KeyParser. An empty line ends a sequence and lines
+// starting with "##" are ignored. Each user starts from a random sequence.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/random/random.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "base/file_stream.h"
+#include "base/file_util.h"
+#include "base/init_mozc.h"
+#include "base/latency_tracer.h"
+#include "base/system_util.h"
+#include "base/thread_pool.h"
+#include "base/util.h"
+#include "composer/key_parser.h"
+#include "engine/engine_factory.h"
+#include "protocol/commands.pb.h"
+#include "request/request_test_util.h"
+#include "session/random_keyevents_generator.h"
+#include "session/session_handler.h"
+
+#ifdef __APPLE__
+#include <mach/mach_init.h>
+#include <mach/task.h>
+#endif  // __APPLE__
+
+#ifdef __linux__
+#include <unistd.h>
+#endif  // __linux__
+
+ABSL_DECLARE_FLAG(int32_t, max_session_size);
+
+ABSL_FLAG(int32_t, num_users, 8, "Number of simulated users.");
+ABSL_FLAG(absl::Duration, duration, absl::Minutes(1), "Duration of the load.");
+ABSL_FLAG(absl::Duration, report_interval, absl::Seconds(10),
+          "Interval of the progress reports.");
+ABSL_FLAG(std::string, input, "",
+          "Recorded key file. Random sentences are typed if empty.");
+ABSL_FLAG(std::string, profile, "", "User profile directory");
+ABSL_FLAG(bool, mobile, false,
+          "Use the mobile request and the mobile key sequences.");
+ABSL_FLAG(std::optional<uint32_t>, random_seed, std::nullopt,
+          "Random seed value. This value will be interpreted as uint32_t.");
+
+namespace mozc {
+namespace {
+
+using KeySequence = std::vector<commands::KeyEvent>;
+
+constexpr absl::string_view kSendKeyStage = "load/send_key";
+
+struct LoadCounters {
+  std::atomic<uint64_t> num_commands = 0;
+  std::atomic<uint64_t> num_failures = 0;
+};
+
+struct ResourceUsage {
+  uint64_t rss = 0;
+  uint64_t profile_size = 0;
+};
+
+// Returns the resident set size of this process in bytes, or 0 if it is not
+// available on this platform.
+uint64_t GetResidentSetSize() {
+#if defined(__linux__)
+  InputFileStream statm("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+  if (statm >> size >> resident) {
+    return resident * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  }
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t info_count = MACH_TASK_BASIC_INFO_COUNT;
+  if (KERN_SUCCESS == task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                                reinterpret_cast<task_info_t>(&info),
+                                &info_count)) {
+    return info.resident_size;
+  }
+#endif  // __linux__, __APPLE__
+  return 0;
+}
+
+// Returns the total size of the files in the user profile directory, where
+// the user history and the other learning data are stored.
+uint64_t GetProfileSize() {
+  std::error_code error;
+  std::filesystem::directory_iterator it(
+      std::filesystem::path(SystemUtil::GetUserProfileDirectory()), error);
+  uint64_t total = 0;
+  for (; !error && it != std::filesystem::directory_iterator();
+       it.increment(error)) {
+    if (it->is_regular_file(error)) {
+      total += it->file_size(error);
+    }
+  }
+  return total;
+}
+
+ResourceUsage GetResourceUsage() {
+  return {.rss = GetResidentSetSize(), .profile_size = GetProfileSize()};
+}
+
+std::string FormatBytes(uint64_t bytes) {
+  return absl::StrFormat("%.1fMiB", bytes / (1024.0 * 1024.0));
+}
+
+std::string FormatGrowth(uint64_t current, uint64_t base) {
+  const int64_t diff =
+      static_cast<int64_t>(current) - static_cast<int64_t>(base);
+  return absl::StrFormat("%s (%+.1fKiB)", FormatBytes(current), diff / 1024.0);
+}
+
+// Reads the recorded key sequences in the format described above.
+std::vector<KeySequence> ReadKeySequences(const std::string& filename) {
+  InputFileStream input(filename);
+  CHECK(!input.fail()) << "Cannot open: " << filename;
+  std::vector<KeySequence> sequences(1);
+  std::string line;
+  while (std::getline(input, line)) {
+    Util::ChopReturns(&line);
+    if (line.size() > 1 && line[0] == '#' && line[1] == '#') {
+      continue;
+    }
+    if (line.empty()) {
+      if (!sequences.back().empty()) {
+        sequences.emplace_back();
+      }
+      continue;
+    }
+    commands::KeyEvent key;
+    if (!KeyParser::ParseKey(line, &key)) {
+      LOG(ERROR) << "cannot parse: " << line;
+      continue;
+    }
+    sequences.back().push_back(std::move(key));
+  }
+  if (sequences.back().empty()) {
+    sequences.pop_back();
+  }
+  return sequences;
+}
+
+// Supplies the key sequences typed by one user.
+class KeySource {
+ public:
+  KeySource(const std::vector<KeySequence>& recorded, uint32_t seed)
+      : recorded_(recorded), generator_(std::seed_seq{seed}) {
+    generator_.PrepareForMemoryLeakTest();
+    if (!recorded_.empty()) {
+      absl::BitGen bitgen(std::seed_seq{seed});
+      next_ = absl::Uniform<size_t>(bitgen, 0, recorded_.size());
+    }
+  }
+
+  const KeySequence& Next() {
+    if (!recorded_.empty()) {
+      const KeySequence& keys = recorded_[next_];
+      next_ = (next_ + 1) % recorded_.size();
+      return keys;
+    }
+    generated_.clear();
+    if (absl::GetFlag(FLAGS_mobile)) {
+      generator_.GenerateMobileSequence(true, &generated_);
+    } else {
+      generator_.GenerateSequence(&generated_);
+    }
+    return generated_;
+  }
+
+ private:
+  const std::vector<KeySequence>& recorded_;
+  session::RandomKeyEventsGenerator generator_;
+  KeySequence generated_;
+  size_t next_ = 0;
+};
+
+bool EvalCommand(SessionHandler& handler, commands::Command& command) {
+  return handler.EvalCommand(&command) &&
+         command.output().error_code() == commands::Output::SESSION_SUCCESS;
+}
+
+bool EvalCommand(SessionHandler& handler, commands::Input::CommandType type) {
+  commands::Command command;
+  command.mutable_input()->set_type(type);
+  return EvalCommand(handler, command);
+}
+
+void RunUser(SessionHandler& handler, KeySource& source,
+             const absl::Time deadline, LoadCounters& counters) {
+  static const LatencyTracer::StageId kStage =
+      LatencyTracer::RegisterStage(kSendKeyStage);
+
+  commands::Command command;
+  command.mutable_input()->set_type(commands::Input::CREATE_SESSION);
+  if (!EvalCommand(handler, command)) {
+    LOG(ERROR) << "CreateSession failed";
+    ++counters.num_failures;
+    return;
+  }
+  const uint64_t id = command.output().id();
+
+  while (absl::Now() < deadline) {
+    for (const commands::KeyEvent& key : source.Next()) {
+      command.Clear();
+      command.mutable_input()->set_id(id);
+      command.mutable_input()->set_type(commands::Input::SEND_KEY);
+      *command.mutable_input()->mutable_key() = key;
+      bool succeeded;
+      {
+        ScopedLatencyTimer timer(kStage);
+        succeeded = EvalCommand(handler, command);
+      }
+      ++counters.num_commands;
+      if (!succeeded) {
+        ++counters.num_failures;
+      }
+    }
+  }
+
+  command.Clear();
+  command.mutable_input()->set_id(id);
+  command.mutable_input()->set_type(commands::Input::DELETE_SESSION);
+  EvalCommand(handler, command);
+}
+
+using Buckets = std::array<uint64_t, LatencyTracer::kNumBuckets>;
+
+Buckets GetSendKeyBuckets() {
+  for (const LatencyTracer::StageStats& stats :
+       LatencyTracer::GetSnapshot().stages) {
+    if (stats.name == kSendKeyStage) {
+      return stats.buckets;
+    }
+  }
+  return {};
+}
+
+// Returns the upper bound of the histogram bucket holding the `quantile`.
+absl::Duration GetQuantile(const Buckets& buckets, double quantile) {
+  uint64_t total = 0;
+  for (const uint64_t count : buckets) {
+    total += count;
+  }
+  const uint64_t rank = static_cast<uint64_t>(quantile * total);
+  uint64_t accumulated = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    accumulated += buckets[i];
+    if (accumulated > rank) {
+      return absl::Microseconds(uint64_t{1} << i);
+    }
+  }
+  return absl::ZeroDuration();
+}
+
+void PrintHistogram(const Buckets& buckets, std::ostream& os) {
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    if (buckets[i] == 0) {
+      continue;
+    }
+    const uint64_t lower = i == 0 ? 0 : uint64_t{1} << (i - 1);
+    os << absl::StrFormat("  [%8dus, %8dus) %d\n", lower, uint64_t{1} << i,
+                          buckets[i]);
+  }
+}
+
+int Run() {
+  const int num_users = absl::GetFlag(FLAGS_num_users);
+  CHECK_GT(num_users, 0);
+  CHECK_LE(num_users, 128) << "SessionHandler keeps 128 sessions at most.";
+  absl::SetFlag(&FLAGS_max_session_size,
+                std::max(absl::GetFlag(FLAGS_max_session_size), num_users));
+
+  std::vector<KeySequence> recorded;
+  if (const std::string input = absl::GetFlag(FLAGS_input); !input.empty()) {
+    recorded = ReadKeySequences(input);
+    CHECK(!recorded.empty()) << "No keys in " << input;
+  }
+
+  SessionHandler handler(EngineFactory::Create().value());
+  if (absl::GetFlag(FLAGS_mobile)) {
+    commands::Command command;
+    command.mutable_input()->set_type(commands::Input::SET_REQUEST);
+    request_test_util::FillMobileRequest(
+        command.mutable_input()->mutable_request());
+    CHECK(EvalCommand(handler, command));
+  }
+
+  uint32_t seed = absl::GetFlag(FLAGS_random_seed).value_or(
+      absl::Uniform<uint32_t>(absl::BitGen()));
+  LOG(INFO) << "Random seed: " << seed;
+  std::vector<std::unique_ptr<KeySource>> sources;
+  for (int i = 0; i < num_users; ++i) {
+    sources.push_back(std::make_unique<KeySource>(recorded, seed++));
+  }
+
+  const ResourceUsage initial_usage = GetResourceUsage();
+  LatencyTracer::Reset();
+  LoadCounters counters;
+  const absl::Time start = absl::Now();
+  const absl::Time deadline = start + absl::GetFlag(FLAGS_duration);
+  {
+    ThreadPool pool(num_users);
+    for (const std::unique_ptr<KeySource>& source : sources) {
+      pool.Schedule([&handler, &source = *source, deadline, &counters] {
+        RunUser(handler, source, deadline, counters);
+      });
+    }
+
+    // Reports the progress while the users are running. The user data is
+    // synced before each report to measure the growth of the files.
+    absl::Time last_time = start;
+    uint64_t last_commands = 0;
+    Buckets last_buckets = {};
+    for (absl::Time now = start; now < deadline;) {
+      absl::SleepFor(
+          std::min(absl::GetFlag(FLAGS_report_interval), deadline - now));
+      EvalCommand(handler, commands::Input::SYNC_DATA);
+      now = absl::Now();
+
+      const uint64_t num_commands = counters.num_commands;
+      const Buckets buckets = GetSendKeyBuckets();
+      Buckets interval_buckets;
+      for (size_t i = 0; i < buckets.size(); ++i) {
+        interval_buckets[i] = buckets[i] - last_buckets[i];
+      }
+      const ResourceUsage usage = GetResourceUsage();
+      std::cout << absl::StrFormat(
+                       "%6.1fs: %8.1f cmd/s p50=%s p99=%s rss=%s profile=%s",
+                       absl::ToDoubleSeconds(now - start),
+                       (num_commands - last_commands) /
+                           absl::ToDoubleSeconds(now - last_time),
+                       absl::FormatDuration(GetQuantile(interval_buckets, 0.5)),
+                       absl::FormatDuration(
+                           GetQuantile(interval_buckets, 0.99)),
+                       FormatGrowth(usage.rss, initial_usage.rss),
+                       FormatGrowth(usage.profile_size,
+                                    initial_usage.profile_size))
+                << std::endl;
+      last_time = now;
+      last_commands = num_commands;
+      last_buckets = buckets;
+    }
+  }
+  const absl::Duration elapsed = absl::Now() - start;
+  EvalCommand(handler, commands::Input::SYNC_DATA);
+
+  const uint64_t num_commands = counters.num_commands;
+  const uint64_t num_failures = counters.num_failures;
+  const Buckets buckets = GetSendKeyBuckets();
+  const ResourceUsage usage = GetResourceUsage();
+  std::cout << "users: " << num_users << "\n"
+            << "elapsed: " << elapsed << "\n"
+            << "commands: " << num_commands << "\n"
+            << "failures: " << num_failures << "\n"
+            << absl::StrFormat("throughput: %.1f cmd/s\n",
+                               num_commands / absl::ToDoubleSeconds(elapsed))
+            << "latency: p50=" << GetQuantile(buckets, 0.5)
+            << " p90=" << GetQuantile(buckets, 0.9)
+            << " p99=" << GetQuantile(buckets, 0.99)
+            << " p99.9=" << GetQuantile(buckets, 0.999) << "\n";
+  PrintHistogram(buckets, std::cout);
+  std::cout << "rss: " << FormatBytes(initial_usage.rss) << " -> "
+            << FormatGrowth(usage.rss, initial_usage.rss) << "\n"
+            << "profile: " << FormatBytes(initial_usage.profile_size) << " -> "
+            << FormatGrowth(usage.profile_size, initial_usage.profile_size)
+            << "\n";
+
+  // Breakdown by the stages traced inside the engine.
+  for (const LatencyTracer::StageStats& stats :
+       LatencyTracer::GetSnapshot().stages) {
+    std::cout << absl::StrFormat(
+        "  %-40s count=%d mean=%s max=%s\n", stats.name, stats.count,
+        absl::FormatDuration(stats.total / std::max<uint64_t>(stats.count, 1)),
+        absl::FormatDuration(stats.max));
+  }
+  return num_failures == 0 ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace mozc
+
+int main(int argc, char** argv) {
+  mozc::InitMozc(argv[0], &argc, &argv);
+  if (const std::string profile = absl::GetFlag(FLAGS_profile);
+      !profile.empty()) {
+    if (!mozc::FileUtil::CreateDirectory(profile).ok()) {
+      std::cout << "ERROR: Failed to create profile directory: " << profile
+                << std::endl;
+      return 1;
+    }
+    mozc::SystemUtil::SetUserProfileDirectory(profile);
+  }
+  return mozc::Run();
+}
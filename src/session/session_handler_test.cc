@@ -47,6 +47,8 @@
 #include "absl/time/time.h"
 #include "base/clock.h"
 #include "base/clock_mock.h"
+#include "base/latency_tracer.h"
+#include "base/thread_pool.h"
 #include "config/config_handler.h"
 #include "data_manager/data_manager.h"
 #include "data_manager/testing/mock_data_manager.h"
@@ -68,6 +70,7 @@ ABSL_DECLARE_FLAG(int32_t, max_session_size);
 ABSL_DECLARE_FLAG(int32_t, create_session_min_interval);
 ABSL_DECLARE_FLAG(int32_t, last_command_timeout);
 ABSL_DECLARE_FLAG(int32_t, last_create_session_timeout);
+ABSL_DECLARE_FLAG(bool, concurrent_sessions);
 
 namespace mozc {
 
@@ -564,6 +567,57 @@ TEST_F(SessionHandlerTest, UpdateComposition) {
   }
 }
 
+TEST_F(SessionHandlerTest, ConcurrentSessions) {
+  absl::SetFlag(&FLAGS_concurrent_sessions, true);
+  SessionHandler handler(CreateMockDataEngine());
+
+  constexpr int kNumSessions = 4;
+  constexpr int kNumKeys = 20;
+  std::vector<uint64_t> session_ids(kNumSessions);
+  for (uint64_t& id : session_ids) {
+    ASSERT_TRUE(CreateSession(handler, &id));
+  }
+
+  std::vector<int> num_failures(kNumSessions, 0);
+  {
+    ThreadPool pool(kNumSessions);
+    for (int i = 0; i < kNumSessions; ++i) {
+      pool.Schedule([&handler, &num_failures, i, id = session_ids[i]] {
+        auto send_key = [&](commands::KeyEvent key) {
+          commands::Command command;
+          command.mutable_input()->set_id(id);
+          command.mutable_input()->set_type(commands::Input::SEND_KEY);
+          *command.mutable_input()->mutable_key() = std::move(key);
+          if (!handler.EvalCommand(&command) ||
+              command.output().error_code() !=
+                  commands::Output::SESSION_SUCCESS) {
+            ++num_failures[i];
+          }
+        };
+        commands::KeyEvent on;
+        on.set_special_key(commands::KeyEvent::ON);
+        send_key(on);
+        for (int j = 0; j < kNumKeys; ++j) {
+          commands::KeyEvent key;
+          key.set_key_code('a');
+          send_key(key);
+          commands::KeyEvent space;
+          space.set_special_key(commands::KeyEvent::SPACE);
+          send_key(space);
+          commands::KeyEvent enter;
+          enter.set_special_key(commands::KeyEvent::ENTER);
+          send_key(enter);
+        }
+      });
+    }
+  }
+
+  for (int i = 0; i < kNumSessions; ++i) {
+    EXPECT_EQ(num_failures[i], 0) << "session " << i;
+    EXPECT_TRUE(IsGoodSession(handler, session_ids[i]));
+  }
+}
+
 TEST_F(SessionHandlerTest, KeyMapTest) {
   const keymap::KeyMapManager* msime_keymap;
 
@@ -781,6 +835,35 @@ TEST_F(SessionHandlerTest, GetServerVersionTest) {
   EXPECT_EQ(command.output().server_version().data_version(), "24.20240101.01");
 }
 
+TEST_F(SessionHandlerTest, GetLatencyStatsTest) {
+  LatencyTracer::Reset();
+  const LatencyTracer::StageId stage =
+      LatencyTracer::RegisterStage("session_handler_test/stage");
+  LatencyTracer::Record(stage, absl::Microseconds(5));
+  LatencyTracer::Record(stage, absl::Microseconds(100));
+
+  SessionHandler handler(std::make_unique<MockEngine>());
+  commands::Command command;
+  command.mutable_input()->set_type(commands::Input::GET_LATENCY_STATS);
+  handler.EvalCommand(&command);
+
+  const commands::LatencyStats& stats = command.output().latency_stats();
+  const auto it = std::find_if(
+      stats.stages().begin(), stats.stages().end(),
+      [](const commands::LatencyStats::Stage& stage) {
+        return stage.name() == "session_handler_test/stage";
+      });
+  ASSERT_NE(it, stats.stages().end());
+  EXPECT_EQ(it->count(), 2);
+  EXPECT_EQ(it->total_micros(), 105);
+  EXPECT_EQ(it->max_micros(), 100);
+  EXPECT_EQ(it->bucket_counts_size(), LatencyTracer::kNumBuckets);
+  EXPECT_EQ(it->bucket_counts(3), 1);  // [4, 8)
+  EXPECT_EQ(it->bucket_counts(7), 1);  // [64, 128)
+  EXPECT_GE(stats.recent_events_size(), 2);
+  LatencyTracer::Reset();
+}
+
 TEST_F(SessionHandlerTest, ReloadFromMinimalEngine) {
   std::unique_ptr<Engine> engine = Engine::CreateEngine();
 
@@ -47,6 +47,7 @@ ABSL_DECLARE_FLAG(int32_t, watch_dog_interval);
 ABSL_DECLARE_FLAG(int32_t, last_command_timeout);
 ABSL_DECLARE_FLAG(int32_t, last_create_session_timeout);
 ABSL_DECLARE_FLAG(bool, restricted);
+ABSL_DECLARE_FLAG(bool, concurrent_sessions);
 
 namespace mozc {
 namespace session {
@@ -109,6 +110,7 @@ void SessionHandlerTestBase::SetUp() {
   flags_last_create_session_timeout_backup_ =
       absl::GetFlag(FLAGS_last_create_session_timeout);
   flags_restricted_backup_ = absl::GetFlag(FLAGS_restricted);
+  flags_concurrent_sessions_backup_ = absl::GetFlag(FLAGS_concurrent_sessions);
 
   config_backup_ = ConfigHandler::GetCopiedConfig();
   ClearState();
@@ -127,6 +129,7 @@ void SessionHandlerTestBase::TearDown() {
   absl::SetFlag(&FLAGS_last_create_session_timeout,
                 flags_last_create_session_timeout_backup_);
   absl::SetFlag(&FLAGS_restricted, flags_restricted_backup_);
+  absl::SetFlag(&FLAGS_concurrent_sessions, flags_concurrent_sessions_backup_);
 }
 
 void SessionHandlerTestBase::ClearState() {
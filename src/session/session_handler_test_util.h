@@ -75,6 +75,7 @@ class SessionHandlerTestBase : public ::mozc::testing::TestWithTempUserProfile {
   int32_t flags_last_command_timeout_backup_;
   int32_t flags_last_create_session_timeout_backup_;
   bool flags_restricted_backup_;
+  bool flags_concurrent_sessions_backup_;
 };
 
 }  // namespace testing
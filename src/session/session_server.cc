@@ -33,9 +33,13 @@
 
 #include "session/session_server.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
 #include "absl/log/log.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
@@ -46,6 +50,12 @@
 #include "protocol/commands.pb.h"
 #include "session/session_handler.h"
 
+ABSL_FLAG(int32_t, session_server_workers, 0,
+          "number of threads that evaluate the requests from clients "
+          "with --concurrent_sessions. Zero uses the default of 4.");
+
+ABSL_DECLARE_FLAG(bool, concurrent_sessions);  // in SessionHandler
+
 namespace {
 
 #ifdef _WIN32
@@ -58,6 +68,7 @@ constexpr int kNumConnections = 10;
 #endif  // _WIN32
 
 constexpr absl::Duration kTimeOut = absl::Milliseconds(5000);
+constexpr int kDefaultNumWorkers = 4;
 constexpr char kSessionName[] = "session";
 constexpr char kEventName[] = "session";
 
@@ -66,9 +77,21 @@ constexpr char kEventName[] = "session";
 namespace mozc {
 
 SessionServer::SessionServer()
+    : SessionServer(
+          std::make_unique<SessionHandler>(EngineFactory::Create().value())) {}
+
+SessionServer::SessionServer(std::unique_ptr<SessionHandler> session_handler)
     : IPCServer(kSessionName, kNumConnections, kTimeOut),
-      session_handler_(
-          std::make_unique<SessionHandler>(EngineFactory::Create().value())) {
+      session_handler_(std::move(session_handler)) {
+  // SessionHandler can be called from several threads only in the
+  // concurrent mode.
+  const int32_t num_workers = absl::GetFlag(FLAGS_session_server_workers);
+  if (absl::GetFlag(FLAGS_concurrent_sessions)) {
+    set_num_workers(num_workers > 0 ? num_workers : kDefaultNumWorkers);
+  } else if (num_workers > 0) {
+    LOG(WARNING) << "--session_server_workers requires --concurrent_sessions";
+  }
+
   // start session watch dog timer
   session_handler_->StartWatchDog();
 
@@ -54,6 +54,8 @@ namespace mozc {
 class SessionServer : public IPCServer {
  public:
   SessionServer();
+  // Serves the requests with the given handler. For testing.
+  explicit SessionServer(std::unique_ptr<SessionHandler> session_handler);
   SessionServer(const SessionServer&) = delete;
   SessionServer& operator=(const SessionServer&) = delete;
 
@@ -0,0 +1,169 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "session/session_server.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "base/thread_pool.h"
+#include "engine/mock_data_engine_factory.h"
+#include "protocol/commands.pb.h"
+#include "session/session_handler.h"
+#include "session/session_handler_test_util.h"
+#include "testing/gunit.h"
+
+ABSL_DECLARE_FLAG(bool, concurrent_sessions);
+ABSL_DECLARE_FLAG(int32_t, session_server_workers);
+
+namespace mozc {
+namespace {
+
+using ::mozc::session::testing::SessionHandlerTestBase;
+
+class SessionServerTest : public SessionHandlerTestBase {
+ protected:
+  static std::unique_ptr<SessionServer> CreateServer() {
+    return std::make_unique<SessionServer>(std::make_unique<SessionHandler>(
+        MockDataEngineFactory::Create().value()));
+  }
+
+  // Sends `input` through SessionServer::Process() as the IPC server does.
+  // Returns false if the request fails.
+  static bool Process(SessionServer& server, const commands::Input& input,
+                      commands::Output* output) {
+    std::string request;
+    std::string response;
+    return input.SerializeToString(&request) &&
+           server.Process(request, &response) &&
+           output->ParseFromString(response) &&
+           output->error_code() == commands::Output::SESSION_SUCCESS;
+  }
+
+  static bool SendCommand(SessionServer& server,
+                          commands::Input::CommandType type, uint64_t id,
+                          commands::Output* output) {
+    commands::Input input;
+    input.set_type(type);
+    input.set_id(id);
+    return Process(server, input, output);
+  }
+
+  static bool SendKey(SessionServer& server, uint64_t id,
+                      commands::KeyEvent key) {
+    commands::Input input;
+    input.set_type(commands::Input::SEND_KEY);
+    input.set_id(id);
+    *input.mutable_key() = std::move(key);
+    commands::Output output;
+    return Process(server, input, &output);
+  }
+
+  absl::FlagSaver flag_saver_;
+};
+
+TEST_F(SessionServerTest, NumWorkers) {
+  EXPECT_EQ(CreateServer()->num_workers(), 0);
+
+  absl::SetFlag(&FLAGS_session_server_workers, 2);
+  // SessionHandler is not thread-safe without --concurrent_sessions.
+  EXPECT_EQ(CreateServer()->num_workers(), 0);
+
+  absl::SetFlag(&FLAGS_concurrent_sessions, true);
+  EXPECT_EQ(CreateServer()->num_workers(), 2);
+
+  absl::SetFlag(&FLAGS_session_server_workers, 0);
+  EXPECT_GT(CreateServer()->num_workers(), 1);
+}
+
+TEST_F(SessionServerTest, ConcurrentProcess) {
+  absl::SetFlag(&FLAGS_concurrent_sessions, true);
+  std::unique_ptr<SessionServer> server = CreateServer();
+
+  commands::Output output;
+  ASSERT_TRUE(
+      SendCommand(*server, commands::Input::CREATE_SESSION, 0, &output));
+  const uint64_t id = output.id();
+
+  // Keys for one session race with the creation and deletion of other
+  // sessions and with reloads, as they do when the IPC workers serve several
+  // clients.
+  constexpr int kNumIterations = 20;
+  int num_key_failures = 0;
+  int num_session_failures = 0;
+  {
+    ThreadPool pool(2);
+    pool.Schedule([&server, &num_key_failures, id] {
+      commands::KeyEvent on;
+      on.set_special_key(commands::KeyEvent::ON);
+      if (!SendKey(*server, id, on)) {
+        ++num_key_failures;
+      }
+      for (int i = 0; i < kNumIterations; ++i) {
+        commands::KeyEvent key;
+        key.set_key_code('a');
+        commands::KeyEvent space;
+        space.set_special_key(commands::KeyEvent::SPACE);
+        commands::KeyEvent enter;
+        enter.set_special_key(commands::KeyEvent::ENTER);
+        if (!SendKey(*server, id, key) || !SendKey(*server, id, space) ||
+            !SendKey(*server, id, enter)) {
+          ++num_key_failures;
+        }
+      }
+    });
+    pool.Schedule([&server, &num_session_failures] {
+      for (int i = 0; i < kNumIterations; ++i) {
+        commands::Output created;
+        commands::Output output;
+        if (!SendCommand(*server, commands::Input::CREATE_SESSION, 0,
+                         &created) ||
+            !SendCommand(*server, commands::Input::RELOAD, 0, &output) ||
+            !SendCommand(*server, commands::Input::DELETE_SESSION,
+                         created.id(), &output)) {
+          ++num_session_failures;
+        }
+      }
+    });
+  }
+  EXPECT_EQ(num_key_failures, 0);
+  EXPECT_EQ(num_session_failures, 0);
+
+  commands::KeyEvent space;
+  space.set_special_key(commands::KeyEvent::SPACE);
+  EXPECT_TRUE(SendKey(*server, id, space));
+}
+
+}  // namespace
+}  // namespace mozc
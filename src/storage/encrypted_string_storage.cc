@@ -30,17 +30,23 @@
 #include "storage/encrypted_string_storage.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <ios>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "base/bits.h"
 #include "base/encryptor.h"
 #include "base/file_stream.h"
 #include "base/file_util.h"
+#include "base/hash.h"
 #include "base/mmap.h"
 #include "base/password_manager.h"
 #include "base/random.h"
@@ -59,6 +65,19 @@ constexpr size_t kSaltSize = 32;
 
 // Maximum file size (64Mbyte)
 constexpr size_t kMaxFileSize = 64 * 1024 * 1024;
+
+// Each journal record is formatted as follows:
+// +-----------+-----------+------------+--------------------+
+// | uint32_t  | uint32_t  | char[32]   | char[]             |
+// | body size | checksum  | salt       | encrypted record   |
+// +-----------+-----------+------------+--------------------+
+//                         |<-------------- body ------------>|
+// The integers are little endian. The checksum is computed over the body.
+constexpr size_t kJournalHeaderSize = 8;
+
+uint32_t JournalChecksum(absl::string_view body) {
+  return static_cast<uint32_t>(CityFingerprint(body));
+}
 }  // namespace
 
 bool EncryptedStringStorage::Load(std::string* output) const {
@@ -165,6 +184,94 @@ bool EncryptedStringStorage::Save(absl::string_view input) const {
   return true;
 }
 
+bool EncryptedStringStorage::AppendToJournal(absl::string_view record) const {
+  const std::string salt = mozc::Random().ByteString(kSaltSize);
+
+  std::string encrypted(record);
+  if (!Encrypt(salt, &encrypted)) {
+    return false;
+  }
+
+  std::string output;
+  output.reserve(kJournalHeaderSize + kSaltSize + encrypted.size());
+  output.resize(kJournalHeaderSize);
+  absl::StrAppend(&output, salt, encrypted);
+  const absl::string_view body =
+      absl::string_view(output).substr(kJournalHeaderSize);
+  StoreUnaligned<uint32_t>(body.size(), output.data());
+  StoreUnaligned<uint32_t>(JournalChecksum(body), output.data() + 4);
+
+  const std::string filename = journal_filename();
+  OutputFileStream ofs(filename,
+                       std::ios::out | std::ios::binary | std::ios::app);
+  if (!ofs) {
+    LOG(ERROR) << "failed to open: " << filename;
+    return false;
+  }
+  ofs.write(output.data(), output.size());
+  ofs.flush();
+  if (!ofs) {
+    LOG(ERROR) << "failed to write: " << filename;
+    return false;
+  }
+  return true;
+}
+
+bool EncryptedStringStorage::LoadJournal(
+    std::vector<std::string>* records) const {
+  DCHECK(records);
+  records->clear();
+
+  const std::string filename = journal_filename();
+  if (!FileUtil::FileExists(filename).ok()) {
+    return true;
+  }
+  const absl::StatusOr<Mmap> mmap = Mmap::Map(filename, Mmap::READ_ONLY);
+  if (!mmap.ok()) {
+    LOG(ERROR) << "cannot open journal: " << mmap.status();
+    return false;
+  }
+  if (mmap->size() > kMaxFileSize) {
+    LOG(ERROR) << "journal is too big.";
+    return false;
+  }
+
+  absl::string_view data = mmap->string_view();
+  while (!data.empty()) {
+    if (data.size() < kJournalHeaderSize) {
+      LOG(WARNING) << "truncated journal header: " << filename;
+      return false;
+    }
+    const uint32_t body_size = LoadUnaligned<uint32_t>(data.data());
+    const uint32_t checksum = LoadUnaligned<uint32_t>(data.data() + 4);
+    data.remove_prefix(kJournalHeaderSize);
+    if (body_size < kSaltSize || body_size > data.size()) {
+      LOG(WARNING) << "truncated journal record: " << filename;
+      return false;
+    }
+    const absl::string_view body = data.substr(0, body_size);
+    data.remove_prefix(body_size);
+    if (JournalChecksum(body) != checksum) {
+      LOG(WARNING) << "journal checksum mismatch: " << filename;
+      return false;
+    }
+    std::string record(body.substr(kSaltSize));
+    if (!Decrypt(body.substr(0, kSaltSize), &record)) {
+      return false;
+    }
+    records->push_back(std::move(record));
+  }
+  return true;
+}
+
+bool EncryptedStringStorage::ClearJournal() const {
+  if (absl::Status s = FileUtil::UnlinkIfExists(journal_filename()); !s.ok()) {
+    LOG(ERROR) << "cannot remove journal: " << s;
+    return false;
+  }
+  return true;
+}
+
 bool EncryptedStringStorage::Encrypt(absl::string_view salt,
                                      std::string* data) const {
   DCHECK(data);
@@ -31,6 +31,7 @@
 #define MOZC_STORAGE_ENCRYPTED_STRING_STORAGE_H_
 
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 
@@ -55,7 +56,23 @@ class EncryptedStringStorage : public StringStorageInterface {
   bool Load(std::string* output) const override;
   bool Save(absl::string_view input) const override;
 
+  // The journal is an append-only sequence of encrypted records stored next
+  // to the file, used to persist changes incrementally between Save() calls.
+  // Each record is encrypted with its own salt and checksummed.
+
+  // Appends `record` to the journal.
+  bool AppendToJournal(absl::string_view record) const;
+
+  // Loads the records in the journal into `records`. Returns true if the
+  // journal doesn't exist. When a record is broken, e.g., partially written on
+  // a crash, returns false with the records before it.
+  bool LoadJournal(std::vector<std::string>* records) const;
+
+  // Removes the journal.
+  bool ClearJournal() const;
+
   absl::string_view filename() const { return filename_; }
+  std::string journal_filename() const { return filename_ + ".journal"; }
 
  protected:
   virtual bool Encrypt(absl::string_view salt, std::string* data) const;
@@ -34,7 +34,9 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/status/statusor.h"
 #include "base/file_stream.h"
 #include "base/file_util.h"
 #include "base/system_util.h"
@@ -128,5 +130,66 @@ TEST_F(EncryptedStringStorageTest, Encrypt) {
 }
 #endif  // __ANDROID__
 
+TEST_F(EncryptedStringStorageTest, JournalEmpty) {
+  std::vector<std::string> records = {"garbage"};
+  EXPECT_TRUE(storage_->LoadJournal(&records));
+  EXPECT_TRUE(records.empty());
+  EXPECT_TRUE(storage_->ClearJournal());
+}
+
+#ifndef __ANDROID__
+// The mock for Android supports only one salt at a time.
+TEST_F(EncryptedStringStorageTest, AppendAndLoadJournal) {
+  ASSERT_TRUE(storage_->AppendToJournal("first"));
+  ASSERT_TRUE(storage_->AppendToJournal("second"));
+  ASSERT_TRUE(storage_->AppendToJournal(std::string(1000, 'x')));
+
+  std::vector<std::string> records;
+  ASSERT_TRUE(storage_->LoadJournal(&records));
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_EQ(records[0], "first");
+  EXPECT_EQ(records[1], "second");
+  EXPECT_EQ(records[2], std::string(1000, 'x'));
+
+  // The journal is independent of the snapshot.
+  ASSERT_TRUE(storage_->Save("snapshot"));
+  ASSERT_TRUE(storage_->LoadJournal(&records));
+  EXPECT_EQ(records.size(), 3);
+
+  ASSERT_TRUE(storage_->ClearJournal());
+  ASSERT_TRUE(storage_->LoadJournal(&records));
+  EXPECT_TRUE(records.empty());
+  std::string output;
+  ASSERT_TRUE(storage_->Load(&output));
+  EXPECT_EQ(output, "snapshot");
+}
+
+TEST_F(EncryptedStringStorageTest, BrokenJournal) {
+  ASSERT_TRUE(storage_->AppendToJournal("first"));
+  ASSERT_TRUE(storage_->AppendToJournal("second"));
+  const std::string journal_filename = storage_->journal_filename();
+  absl::StatusOr<std::string> content =
+      FileUtil::GetContents(journal_filename);
+  ASSERT_TRUE(content.ok());
+
+  // Simulates a crash in the middle of the last append.
+  ASSERT_TRUE(FileUtil::SetContents(journal_filename,
+                                    content->substr(0, content->size() - 3))
+                  .ok());
+  std::vector<std::string> records;
+  EXPECT_FALSE(storage_->LoadJournal(&records));
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0], "first");
+
+  // Corrupted body.
+  std::string corrupted = *content;
+  corrupted[corrupted.size() - 1] ^= 0xFF;
+  ASSERT_TRUE(FileUtil::SetContents(journal_filename, corrupted).ok());
+  EXPECT_FALSE(storage_->LoadJournal(&records));
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(records[0], "first");
+}
+#endif  // __ANDROID__
+
 }  // namespace storage
 }  // namespace mozc
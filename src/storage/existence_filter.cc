@@ -118,7 +118,29 @@ BlockBitmap BlockBitmapBuilder::Build() const {
 
 namespace {
 
+using ::mozc::storage::existence_filter_internal::CacheLineOffset;
+using ::mozc::storage::existence_filter_internal::kCacheLineBits;
+using ::mozc::storage::existence_filter_internal::kCacheLineMask;
+using ::mozc::storage::existence_filter_internal::kCacheLineShift;
+
 constexpr uint32_t kHeaderSize = 3;
+// The header of the blocked format is padded to 64 bytes so that the cache
+// lines are aligned if the data is.
+constexpr uint32_t kBlockedHeaderSize = 16;
+
+constexpr uint32_t HeaderSize(uint8_t version) {
+  return version == ExistenceFilterParams::BLOCKED_VERSION ? kBlockedHeaderSize
+                                                           : kHeaderSize;
+}
+
+// Derives the bit positions in the cache line from `hash`. Each position takes
+// 9 bits, so up to 7 positions are available.
+inline uint64_t CacheLineBitPositions(uint64_t hash) {
+  hash ^= hash >> 31;
+  hash *= 0x9e3779b97f4a7c15ULL;
+  hash ^= hash >> 29;
+  return hash;
+}
 
 absl::StatusOr<ExistenceFilterParams> ReadHeader(
     absl::Span<const uint32_t> buf) {
@@ -137,7 +159,8 @@ absl::StatusOr<ExistenceFilterParams> ReadHeader(
   // binary stores the value in lower bits.
   const uint32_t v = *it++;
   params.num_hashes = v & 0xFFFF;
-  params.fp_type = v >> 16;
+  params.fp_type = (v >> 16) & 0xFF;
+  params.version = v >> 24;
 
   if (params.num_hashes >= 8 || params.num_hashes <= 0) {
     return absl::InvalidArgumentError("Bad number of hashes (header.k)");
@@ -147,6 +170,15 @@ absl::StatusOr<ExistenceFilterParams> ReadHeader(
     return absl::InvalidArgumentError("unsupported fp type");
   }
 
+  if (params.version >= ExistenceFilterParams::VERSION_SIZE) {
+    return absl::InvalidArgumentError("unsupported version");
+  }
+
+  if (params.version == ExistenceFilterParams::BLOCKED_VERSION &&
+      (params.size == 0 || params.size % kCacheLineBits != 0)) {
+    return absl::InvalidArgumentError("Bad size for the blocked filter");
+  }
+
   return params;
 }
 
@@ -158,6 +190,30 @@ constexpr uint32_t BitsToWords(uint32_t bits) {
   return words;
 }
 
+uint16_t OptimalNumHashes(uint32_t m, uint32_t n) {
+  const uint16_t optimal_k =
+      static_cast<uint16_t>(std::round(static_cast<float>(m) / n * log(2.0)));
+  return std::clamp<uint16_t>(optimal_k, 1, 7);
+}
+
+// Returns the false positive rate of the blocked filter. The number of keys in
+// a cache line follows the Poisson distribution, and each line is a small
+// bloom filter of 512 bits.
+double BlockedFalsePositiveRate(uint32_t num_lines, size_t num_elements,
+                                int num_hashes) {
+  const double lambda = static_cast<double>(num_elements) / num_lines;
+  const int max_keys = static_cast<int>(lambda + 10 * std::sqrt(lambda) + 10);
+  double p = std::exp(-lambda);  // Probability that a line has 0 keys.
+  double rate = 0;
+  for (int keys = 0; keys <= max_keys; ++keys) {
+    const double bit_unset =
+        std::pow(1.0 - 1.0 / kCacheLineBits, num_hashes * keys);
+    rate += p * std::pow(1.0 - bit_unset, num_hashes);
+    p *= lambda / (keys + 1);
+  }
+  return rate;
+}
+
 }  // namespace
 
 std::ostream& operator<<(std::ostream& os,
@@ -167,6 +223,18 @@ std::ostream& operator<<(std::ostream& os,
 }
 
 bool ExistenceFilter::Exists(uint64_t hash) const {
+  if (params_.version == ExistenceFilterParams::BLOCKED_VERSION) {
+    const uint32_t offset = CacheLineOffset(hash, params_.size);
+    uint64_t positions = CacheLineBitPositions(hash);
+    for (int i = 0; i < params_.num_hashes; ++i) {
+      if (!rep_.Get(offset + (positions & kCacheLineMask))) {
+        return false;
+      }
+      positions >>= kCacheLineShift;
+    }
+    return true;
+  }
+
   for (int i = 0; i < params_.num_hashes; ++i) {
     hash = std::rotl(hash, 8);
     const uint32_t index = hash % params_.size;
@@ -186,7 +254,12 @@ absl::StatusOr<ExistenceFilter> ExistenceFilter::Read(
   } else {
     return absl::InvalidArgumentError("Invalid format: could not read header");
   }
-  buf.remove_prefix(kHeaderSize);
+  const uint32_t header_size = HeaderSize(params.version);
+  if (buf.size() < header_size) {
+    return absl::InvalidArgumentError(
+        "Not enough bufsize: could not read header");
+  }
+  buf.remove_prefix(header_size);
 
   MOZC_VLOG(1) << "Reading bloom filter with params: " << params;
 
@@ -198,23 +271,35 @@ absl::StatusOr<ExistenceFilter> ExistenceFilter::Read(
 }
 
 ExistenceFilterBuilder ExistenceFilterBuilder::CreateOptimal(
-    size_t size_in_bytes, uint32_t estimated_insertions, uint16_t fp_type) {
+    size_t size_in_bytes, uint32_t estimated_insertions, uint8_t fp_type,
+    uint8_t version) {
   CHECK_LT(size_in_bytes, (1 << 29)) << "Requested size is too big";
   CHECK_GT(estimated_insertions, 0);
   CHECK_LT(fp_type, ExistenceFilterParams::FP_TYPE_SIZE);
-  const uint32_t m = std::max<uint32_t>(1, size_in_bytes * 8);
+  CHECK_LT(version, ExistenceFilterParams::VERSION_SIZE);
+  uint32_t m = std::max<uint32_t>(1, size_in_bytes * 8);
+  if (version == ExistenceFilterParams::BLOCKED_VERSION) {
+    m = (m + kCacheLineBits - 1) & ~static_cast<uint32_t>(kCacheLineMask);
+  }
   const uint32_t n = estimated_insertions;
-
-  uint16_t optimal_k =
-      static_cast<uint16_t>(std::round(static_cast<float>(m) / n * log(2.0)));
-  optimal_k = std::clamp<uint16_t>(optimal_k, 1, 7);
+  const uint16_t optimal_k = OptimalNumHashes(m, n);
 
   MOZC_VLOG(1) << "optimal_k: " << optimal_k;
 
-  return ExistenceFilterBuilder({m, n, optimal_k, fp_type});
+  return ExistenceFilterBuilder({m, n, optimal_k, fp_type, version});
 }
 
 void ExistenceFilterBuilder::Insert(uint64_t hash) {
+  if (params_.version == ExistenceFilterParams::BLOCKED_VERSION) {
+    const uint32_t offset = CacheLineOffset(hash, params_.size);
+    uint64_t positions = CacheLineBitPositions(hash);
+    for (int i = 0; i < params_.num_hashes; ++i) {
+      rep_.Set(offset + (positions & kCacheLineMask));
+      positions >>= kCacheLineShift;
+    }
+    return;
+  }
+
   for (int i = 0; i < params_.num_hashes; ++i) {
     hash = std::rotl(hash, 8);
     const uint32_t index = hash % params_.size;
@@ -223,7 +308,7 @@ void ExistenceFilterBuilder::Insert(uint64_t hash) {
 }
 
 size_t ExistenceFilterBuilder::MinFilterSizeInBytesForErrorRate(
-    float error_rate, size_t num_elements) {
+    float error_rate, size_t num_elements, uint8_t version) {
   // (-num_hashes * num_elements) / log(1 - error_rate^(1/num_hashes))
 
   double min_bits = 0;
@@ -233,12 +318,28 @@ size_t ExistenceFilterBuilder::MinFilterSizeInBytesForErrorRate(
         log(1.0 - pow(static_cast<double>(error_rate), (1.0 / num_hashes)));
     if (min_bits == 0 || num_bits < min_bits) min_bits = num_bits;
   }
-  return static_cast<size_t>(ceil(min_bits / 8));
+  if (version != ExistenceFilterParams::BLOCKED_VERSION) {
+    return static_cast<size_t>(ceil(min_bits / 8));
+  }
+
+  // Grows the filter from the estimate above until the blocked filter built by
+  // CreateOptimal() meets the error rate.
+  uint32_t num_lines = std::max<uint32_t>(1, ceil(min_bits / kCacheLineBits));
+  while (true) {
+    const uint32_t m = num_lines * kCacheLineBits;
+    const uint16_t k = OptimalNumHashes(m, std::max<size_t>(1, num_elements));
+    if (BlockedFalsePositiveRate(num_lines, num_elements, k) <= error_rate) {
+      break;
+    }
+    num_lines += std::max<uint32_t>(1, num_lines / 64);
+  }
+  return static_cast<size_t>(num_lines) * kCacheLineBits / 8;
 }
 
 std::string ExistenceFilterBuilder::SerializeAsString() {
+  const uint32_t header_size = HeaderSize(params_.version);
   const size_t required_bytes =
-      (kHeaderSize + BitsToWords(params_.size)) * sizeof(uint32_t);
+      (header_size + BitsToWords(params_.size)) * sizeof(uint32_t);
   std::string buf;
   buf.resize(required_bytes);
 
@@ -249,7 +350,10 @@ std::string ExistenceFilterBuilder::SerializeAsString() {
   // Original num_hashes was 32 bit integer. Pushes the num_hases first so
   // it can evaluated properly even when loading them as single 32 bit integer.
   it = StoreUnaligned<uint16_t>(params_.num_hashes, it);
-  it = StoreUnaligned<uint16_t>(params_.fp_type, it);
+  it = StoreUnaligned<uint8_t>(params_.fp_type, it);
+  it = StoreUnaligned<uint8_t>(params_.version, it);
+  // The padding is already filled with 0.
+  it += (header_size - kHeaderSize) * sizeof(uint32_t);
   // This method is called on data generation and we can call LOG(INFO) here.
   LOG(INFO) << "Header written: " << params_;
 
@@ -30,6 +30,7 @@
 #ifndef MOZC_STORAGE_EXISTENCE_FILTER_H_
 #define MOZC_STORAGE_EXISTENCE_FILTER_H_
 
+#include <algorithm>
 #include <bit>
 #include <cstddef>
 #include <cstdint>
@@ -39,11 +40,14 @@
 #include <vector>
 
 #include "absl/base/attributes.h"
+#include "absl/base/prefetch.h"
+#include "absl/log/check.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "base/bits.h"
 #include "base/hash.h"
 
 namespace mozc {
@@ -56,6 +60,12 @@ inline constexpr int kBlockMask = kBlockBits - 1;
 inline constexpr int kBlockBytes = kBlockBits >> 3;
 inline constexpr int kBlockWords = kBlockBits >> 5;
 
+// The blocked format sets all the bits of a key in one cache line.
+inline constexpr int kCacheLineShift = 9;  // 2^9 bits == 64 bytes
+inline constexpr int kCacheLineBits = 1 << kCacheLineShift;
+inline constexpr int kCacheLineMask = kCacheLineBits - 1;
+static_assert(kCacheLineShift <= kBlockShift);
+
 // BlockBitmap is an immutable view, directly referencing data given to the
 // constructors.
 class BlockBitmap {
@@ -74,6 +84,13 @@ class BlockBitmap {
     return (blocks_[bindex][windex] >> bitpos) & 1;
   }
 
+  // Returns the address of the word containing the bit at `index`.
+  inline const uint32_t* GetWordAddress(uint32_t index) const {
+    const uint32_t bindex = index >> kBlockShift;
+    const uint32_t windex = (index & kBlockMask) >> 5;
+    return blocks_[bindex].data() + windex;
+  }
+
  protected:
   // Array of blocks. Each block has kBlockBits region except for last block.
   std::vector<absl::Span<const uint32_t>> blocks_;
@@ -103,8 +120,114 @@ class BlockBitmapBuilder {
   std::vector<std::vector<uint32_t>> blocks_;
 };
 
-inline uint64_t Fingerprint(absl::string_view str, uint16_t fp_type) {
-  return fp_type == 0 ? LegacyFingerprint(str) : CityFingerprint(str);
+// StreamingFingerprint computes a 64-bit fingerprint of a string given in
+// pieces without concatenating them. The result only depends on the
+// concatenated string, not on how it is split.
+//
+// Example:
+//   StreamingFingerprint fp;
+//   fp.Update("abc");
+//   fp.Update("def");
+//   fp.Finish();  // same as StreamingFingerprint::Get("abcdef").
+class StreamingFingerprint {
+ public:
+  static uint64_t Get(absl::string_view str) {
+    StreamingFingerprint fp;
+    fp.Update(str);
+    return fp.Finish();
+  }
+
+  void Update(absl::string_view str) {
+    length_ += str.size();
+    // Fills the pending bytes from the previous pieces first.
+    while (pending_size_ > 0 && !str.empty()) {
+      AppendByte(str.front());
+      str.remove_prefix(1);
+    }
+    while (str.size() >= sizeof(uint64_t)) {
+      state_ = Mix(state_, LoadUnaligned<uint64_t>(str.data()));
+      str.remove_prefix(sizeof(uint64_t));
+    }
+    for (const char c : str) {
+      AppendByte(c);
+    }
+  }
+
+  uint64_t Finish() const {
+    uint64_t h = state_;
+    if (pending_size_ > 0) {
+      h = Mix(h, pending_);
+    }
+    h ^= length_;
+    // Finalizer of MurmurHash3.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+ private:
+  static constexpr uint64_t kMul = 0xc6a4a7935bd1e995ULL;
+
+  // Mixes one 64-bit word into `h` in the way of MurmurHash64A.
+  static uint64_t Mix(uint64_t h, uint64_t word) {
+    word *= kMul;
+    word ^= word >> 47;
+    word *= kMul;
+    h ^= word;
+    h *= kMul;
+    return h;
+  }
+
+  void AppendByte(char c) {
+    pending_ |= static_cast<uint64_t>(static_cast<uint8_t>(c))
+                << (pending_size_ * 8);
+    if (++pending_size_ == sizeof(uint64_t)) {
+      state_ = Mix(state_, pending_);
+      pending_ = 0;
+      pending_size_ = 0;
+    }
+  }
+
+  uint64_t state_ = 0x9e3779b97f4a7c15ULL;
+  uint64_t length_ = 0;
+  // Bytes not mixed into `state_` yet, in little endian.
+  uint64_t pending_ = 0;
+  size_t pending_size_ = 0;
+};
+
+inline uint64_t Fingerprint(absl::string_view str, uint8_t fp_type) {
+  switch (fp_type) {
+    case 0:
+      return LegacyFingerprint(str);
+    case 1:
+      return CityFingerprint(str);
+    default:
+      return StreamingFingerprint::Get(str);
+  }
+}
+
+inline uint64_t Fingerprint(absl::Span<const absl::string_view> keys,
+                            uint8_t fp_type) {
+  if (fp_type < 2) {
+    // The legacy fingerprints need the concatenated string.
+    return Fingerprint(absl::StrJoin(keys, ""), fp_type);
+  }
+  StreamingFingerprint fp;
+  for (const absl::string_view key : keys) {
+    fp.Update(key);
+  }
+  return fp.Finish();
+}
+
+// Returns the index of the first bit of the cache line for `hash` in the
+// blocked format. `size` is the number of bits in the filter.
+inline uint32_t CacheLineOffset(uint64_t hash, uint32_t size) {
+  const uint64_t num_lines = size >> kCacheLineShift;
+  return static_cast<uint32_t>(((hash >> 32) * num_lines) >> 32)
+         << kCacheLineShift;
 }
 
 }  // namespace existence_filter_internal
@@ -113,19 +236,32 @@ inline uint64_t Fingerprint(absl::string_view str, uint16_t fp_type) {
 struct ExistenceFilterParams {
   template <typename Sink>
   friend void AbslStringify(Sink& sink, const ExistenceFilterParams& params) {
-    absl::Format(
-        &sink,
-        "size: %d bits, estimated insertions: %d, num_hashes: %d, fp_type: %d",
-        params.size, params.expected_nelts, params.num_hashes, params.fp_type);
+    absl::Format(&sink,
+                 "size: %d bits, estimated insertions: %d, num_hashes: %d, "
+                 "fp_type: %d, version: %d",
+                 params.size, params.expected_nelts, params.num_hashes,
+                 params.fp_type, params.version);
   }
 
   enum FpType {
     LEGACY_FP = 0,
     CITY_FP = 1,
-    FP_TYPE_SIZE = 2,
+    // StreamingFingerprint. Keys given in pieces are not concatenated.
+    STREAMING_FP = 2,
+    FP_TYPE_SIZE = 3,
+  };
+
+  // Format of the bit vector.
+  enum Version {
+    // The bits of a key are spread over the whole bit vector.
+    BIT_VECTOR_VERSION = 0,
+    // The bits of a key are in one 64-byte cache line selected by the hash.
+    // `size` is a multiple of 512 and the bit vector starts at byte offset 64.
+    BLOCKED_VERSION = 1,
+    VERSION_SIZE = 2,
   };
 
-  static constexpr uint16_t kDefaultFpType = CITY_FP;
+  static constexpr uint8_t kDefaultFpType = CITY_FP;
 
   uint32_t size = 0;            // the number of bits in the bit vector
   uint32_t expected_nelts = 0;  // the number of values that will be stored
@@ -137,7 +273,11 @@ struct ExistenceFilterParams {
   // Fingerprint algorithm type.
   // The old code defines `num_hashes` as 32 bits int. To store the fp_type,
   // splits the `num_hashes` into two 16 bits int.
-  uint16_t fp_type = kDefaultFpType;
+  uint8_t fp_type = kDefaultFpType;
+
+  // Format version. It's stored in the upper byte of the old 16 bits fp_type,
+  // so old binaries reject the new versions as an unsupported fp type.
+  uint8_t version = BIT_VECTOR_VERSION;
 
   static_assert(std::endian::native == std::endian::little);
 };
@@ -166,21 +306,54 @@ class ExistenceFilter {
   static absl::StatusOr<ExistenceFilter> Read(
       absl::Span<const uint32_t> buf ABSL_ATTRIBUTE_LIFETIME_BOUND);
 
-  // Checks if the given `args` was in the filter.
+  // Checks if the concatenation of `keys` was in the filter.
   bool Exists(absl::Span<const absl::string_view> keys) const {
-    return Exists(existence_filter_internal::Fingerprint(
-        absl::StrJoin(keys, ""), params_.fp_type));
+    return Exists(Fingerprint(keys));
   }
 
   // Checks if the given `key` was in the filter.
-  bool Exists(absl::string_view key) const {
-    return Exists(existence_filter_internal::Fingerprint(key, params_.fp_type));
+  bool Exists(absl::string_view key) const { return Exists(Fingerprint(key)); }
+
+  // Sets `results[i]` to Exists(keys[i]). `Key` is absl::string_view or a
+  // list of pieces like std::array<absl::string_view, 2>. Fingerprints of a
+  // batch are computed first and their cache lines are prefetched, so the
+  // memory accesses of the blocked format overlap.
+  template <typename Key>
+  void ExistsMany(absl::Span<const Key> keys, absl::Span<bool> results) const {
+    DCHECK_EQ(keys.size(), results.size());
+    uint64_t hashes[kBatchSize];
+    for (size_t begin = 0; begin < keys.size(); begin += kBatchSize) {
+      const size_t size = std::min(kBatchSize, keys.size() - begin);
+      for (size_t i = 0; i < size; ++i) {
+        hashes[i] = Fingerprint(keys[begin + i]);
+        Prefetch(hashes[i]);
+      }
+      for (size_t i = 0; i < size; ++i) {
+        results[begin + i] = Exists(hashes[i]);
+      }
+    }
   }
 
   // Returns params.
   const ExistenceFilterParams& params() const { return params_; }
 
  private:
+  static constexpr size_t kBatchSize = 16;
+
+  uint64_t Fingerprint(absl::string_view key) const {
+    return existence_filter_internal::Fingerprint(key, params_.fp_type);
+  }
+  uint64_t Fingerprint(absl::Span<const absl::string_view> keys) const {
+    return existence_filter_internal::Fingerprint(keys, params_.fp_type);
+  }
+
+  void Prefetch(uint64_t hash) const {
+    if (params_.version == ExistenceFilterParams::BLOCKED_VERSION) {
+      absl::PrefetchToLocalCache(rep_.GetWordAddress(
+          existence_filter_internal::CacheLineOffset(hash, params_.size)));
+    }
+  }
+
   // Checks if the given 'hash' was previously inserted int the filter
   // It may return some false positives
   bool Exists(uint64_t hash) const;
@@ -195,16 +368,22 @@ class ExistenceFilter {
 class ExistenceFilterBuilder {
  public:
   explicit ExistenceFilterBuilder(ExistenceFilterParams params)
-      : params_(std::move(params)), rep_(params_.size) {}
+      : params_(std::move(params)), rep_(params_.size) {
+    CHECK(params_.version != ExistenceFilterParams::BLOCKED_VERSION ||
+          params_.size % existence_filter_internal::kCacheLineBits == 0)
+        << "The size of the blocked filter must be a multiple of 512 bits";
+  }
 
+  // For BLOCKED_VERSION, the size is rounded up to a multiple of 64 bytes.
   static ExistenceFilterBuilder CreateOptimal(
       size_t size_in_bytes, uint32_t estimated_insertions,
-      uint16_t fp_type = ExistenceFilterParams::kDefaultFpType);
+      uint8_t fp_type = ExistenceFilterParams::kDefaultFpType,
+      uint8_t version = ExistenceFilterParams::BIT_VECTOR_VERSION);
 
-  // Inserts a list of string into the filter.
+  // Inserts the concatenation of `keys` into the filter.
   void Insert(absl::Span<const absl::string_view> keys) {
-    return Insert(existence_filter_internal::Fingerprint(
-        absl::StrJoin(keys, ""), params_.fp_type));
+    return Insert(
+        existence_filter_internal::Fingerprint(keys, params_.fp_type));
   }
 
   // Inserts one string into the filter.
@@ -219,9 +398,12 @@ class ExistenceFilterBuilder {
   ExistenceFilter Build() const ABSL_ATTRIBUTE_LIFETIME_BOUND;
 
   // Returns the minimum required size of the filter in bytes
-  // under the given error rate and number of elements
-  static size_t MinFilterSizeInBytesForErrorRate(float error_rate,
-                                                 size_t num_elements);
+  // under the given error rate and number of elements.
+  // The blocked filter needs more bits for the same error rate because the
+  // keys are not evenly distributed over the cache lines.
+  static size_t MinFilterSizeInBytesForErrorRate(
+      float error_rate, size_t num_elements,
+      uint8_t version = ExistenceFilterParams::BIT_VECTOR_VERSION);
 
  private:
   // Inserts a hash value into the filter
@@ -29,9 +29,12 @@
 
 #include "storage/existence_filter.h"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -40,6 +43,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "base/hash.h"
 #include "testing/gmock.h"
 #include "testing/gunit.h"
@@ -217,6 +221,133 @@ TEST(ExistenceFilterTest, FpTypeTest) {
   }
 }
 
+TEST(ExistenceFilterTest, StreamingFingerprintTest) {
+  using existence_filter_internal::StreamingFingerprint;
+  const std::string str = "0123456789abcdefghijklmnopqrstuvwxyz";
+  const absl::string_view view = str;
+  for (size_t len = 0; len <= str.size(); ++len) {
+    const uint64_t expected = StreamingFingerprint::Get(view.substr(0, len));
+    // Any split of the string yields the same fingerprint.
+    for (size_t i = 0; i <= len; ++i) {
+      for (size_t j = i; j <= len; ++j) {
+        StreamingFingerprint fp;
+        fp.Update(view.substr(0, i));
+        fp.Update(view.substr(i, j - i));
+        fp.Update(view.substr(j, len - j));
+        EXPECT_EQ(fp.Finish(), expected) << len << " " << i << " " << j;
+      }
+    }
+  }
+  EXPECT_NE(StreamingFingerprint::Get(""), StreamingFingerprint::Get("a"));
+  EXPECT_NE(StreamingFingerprint::Get("a"), StreamingFingerprint::Get("b"));
+  // Trailing NUL bytes must change the fingerprint.
+  EXPECT_NE(StreamingFingerprint::Get("a"),
+            StreamingFingerprint::Get(absl::string_view("a\0", 2)));
+}
+
+TEST(ExistenceFilterTest, BlockedFilterTest) {
+  constexpr int kNumElements = 10000;
+  constexpr float kErrorRate = 0.001;
+  const size_t num_bytes =
+      ExistenceFilterBuilder::MinFilterSizeInBytesForErrorRate(
+          kErrorRate, kNumElements, ExistenceFilterParams::BLOCKED_VERSION);
+  EXPECT_EQ(num_bytes % 64, 0);
+  // The blocked filter needs more space for the same error rate.
+  EXPECT_GT(num_bytes, ExistenceFilterBuilder::MinFilterSizeInBytesForErrorRate(
+                           kErrorRate, kNumElements));
+
+  for (const uint8_t fp_type :
+       {ExistenceFilterParams::CITY_FP, ExistenceFilterParams::STREAMING_FP}) {
+    ExistenceFilterBuilder builder(ExistenceFilterBuilder::CreateOptimal(
+        num_bytes, kNumElements, fp_type,
+        ExistenceFilterParams::BLOCKED_VERSION));
+    for (int i = 0; i < kNumElements; ++i) {
+      builder.Insert(absl::StrCat("key", i, "\tvalue", i));
+    }
+
+    const std::string buf = builder.SerializeAsString();
+    // 64 bytes header followed by the bit vector.
+    EXPECT_EQ(buf.size(), 64 + num_bytes);
+    const std::vector<uint32_t> aligned_buf = StringToAlignedBuffer(buf);
+    absl::StatusOr<ExistenceFilter> filter = ExistenceFilter::Read(aligned_buf);
+    ASSERT_OK(filter);
+    EXPECT_EQ(filter->params().version, ExistenceFilterParams::BLOCKED_VERSION);
+    EXPECT_EQ(filter->params().fp_type, fp_type);
+
+    for (int i = 0; i < kNumElements; ++i) {
+      const std::string key = absl::StrCat("key", i);
+      const std::string value = absl::StrCat("value", i);
+      EXPECT_TRUE(filter->Exists(absl::StrCat(key, "\t", value)));
+      EXPECT_TRUE(filter->Exists({key, "\t", value}));
+    }
+
+    int false_positives = 0;
+    for (int i = 0; i < kNumElements * 10; ++i) {
+      if (filter->Exists(absl::StrCat("key", i, "\tvalue", i + 1))) {
+        ++false_positives;
+      }
+    }
+    // Allows some margin over the expected rate.
+    EXPECT_LT(false_positives, kNumElements * 10 * kErrorRate * 2);
+  }
+}
+
+TEST(ExistenceFilterTest, ExistsManyTest) {
+  for (const uint8_t version : {ExistenceFilterParams::BIT_VECTOR_VERSION,
+                                ExistenceFilterParams::BLOCKED_VERSION}) {
+    ExistenceFilterBuilder builder(ExistenceFilterBuilder::CreateOptimal(
+        256, 100, ExistenceFilterParams::STREAMING_FP, version));
+    for (int i = 0; i < 100; i += 2) {
+      builder.Insert(absl::StrCat(i, "-", i));
+    }
+    const ExistenceFilter filter = builder.Build();
+
+    std::vector<std::string> strs;
+    for (int i = 0; i < 100; ++i) {
+      strs.push_back(absl::StrCat(i));
+    }
+    std::vector<absl::string_view> keys;
+    std::vector<std::array<absl::string_view, 3>> pieces;
+    for (int i = 0; i < 100; ++i) {
+      keys.push_back(strs[i]);
+      pieces.push_back({strs[i], "-", strs[i]});
+    }
+
+    auto results = std::make_unique<bool[]>(keys.size());
+    filter.ExistsMany(absl::MakeConstSpan(keys),
+                      absl::MakeSpan(results.get(), keys.size()));
+    for (size_t i = 0; i < keys.size(); ++i) {
+      EXPECT_EQ(results[i], filter.Exists(keys[i]));
+    }
+
+    filter.ExistsMany(absl::MakeConstSpan(pieces),
+                      absl::MakeSpan(results.get(), pieces.size()));
+    for (size_t i = 0; i < pieces.size(); ++i) {
+      EXPECT_EQ(results[i], filter.Exists(pieces[i]));
+      if (i % 2 == 0) {
+        EXPECT_TRUE(results[i]);
+      }
+    }
+  }
+}
+
+TEST(ExistenceFilterTest, ReadUnsupportedVersionTest) {
+  ExistenceFilterBuilder builder(ExistenceFilterBuilder::CreateOptimal(
+      64, 10, ExistenceFilterParams::kDefaultFpType,
+      ExistenceFilterParams::BLOCKED_VERSION));
+  std::string buf = builder.SerializeAsString();
+  EXPECT_OK(ExistenceFilter::Read(StringToAlignedBuffer(buf)));
+
+  // The version is stored in the 12th byte.
+  buf[11] = ExistenceFilterParams::VERSION_SIZE;
+  EXPECT_FALSE(ExistenceFilter::Read(StringToAlignedBuffer(buf)).ok());
+
+  // The header of the blocked format must not be truncated.
+  buf[11] = ExistenceFilterParams::BLOCKED_VERSION;
+  buf.resize(32);
+  EXPECT_FALSE(ExistenceFilter::Read(StringToAlignedBuffer(buf)).ok());
+}
+
 }  // namespace
 }  // namespace storage
 }  // namespace mozc
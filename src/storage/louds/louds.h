@@ -97,9 +97,13 @@ class Louds {
   // and |select0_cache_size| to larger values.  On the other hand, to improve
   // the performance of upward traversal (i.e., from leaves to the root), set
   // |bitvec_lb1_cache_size| and |select1_cache_size| to larger values.
+  // |index_type| selects the index of the underlying bit vector; the lower
+  // bound cache sizes are ignored for RANK9_INDEX.
   void Init(const uint8_t* image, int length, size_t bitvec_lb0_cache_size,
             size_t bitvec_lb1_cache_size, size_t select0_cache_size,
-            size_t select1_cache_size);
+            size_t select1_cache_size,
+            SimpleSuccinctBitVectorIndex::IndexType index_type =
+                SimpleSuccinctBitVectorIndex::CHUNK_INDEX);
 
   // Explicitly clears the internal bit array.
   void Reset();
@@ -46,7 +46,8 @@ bool LoudsTrie::Open(const uint8_t *image, size_t louds_lb0_cache_size,
                      size_t louds_lb1_cache_size,
                      size_t louds_select0_cache_size,
                      size_t louds_select1_cache_size,
-                     size_t termvec_lb1_cache_size) {
+                     size_t termvec_lb1_cache_size,
+                     SimpleSuccinctBitVectorIndex::IndexType index_type) {
   // Reads a binary image data, which is compatible with rx.
   // The format is as follows:
   // [trie size: little endian 4byte int]
@@ -82,10 +83,10 @@ bool LoudsTrie::Open(const uint8_t *image, size_t louds_lb0_cache_size,
 
   louds_.Init(louds_image, louds_size, louds_lb0_cache_size,
               louds_lb1_cache_size, louds_select0_cache_size,
-              louds_select1_cache_size);
+              louds_select1_cache_size, index_type);
   terminal_bit_vector_.Init(terminal_image, terminal_size,
                             0,  // Select0 is not carried out.
-                            termvec_lb1_cache_size);
+                            termvec_lb1_cache_size, index_type);
   edge_character_ = reinterpret_cast<const char *>(edge_character);
 
   return true;
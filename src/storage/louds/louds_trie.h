@@ -60,12 +60,15 @@ class LoudsTrie {
   // Opens the binary image and constructs the data structure.  The first four
   // cache sizes are passed to the underlying LOUDS.  See louds.h for more
   // information of cache size.  The last one is passed to the underlying
-  // terminal bit vector.  This class doesn't own the "data", so it is caller's
+  // terminal bit vector.  |index_type| is the type of the index for both of
+  // the bit vectors.  This class doesn't own the "data", so it is caller's
   // responsibility to keep the data alive until Close is invoked.  See .cc file
   // for the detailed format of the binary image.
   bool Open(const uint8_t* image, size_t louds_lb0_cache_size,
             size_t louds_lb1_cache_size, size_t louds_select0_cache_size,
-            size_t louds_select1_cache_size, size_t termvec_lb1_cache_size);
+            size_t louds_select1_cache_size, size_t termvec_lb1_cache_size,
+            SimpleSuccinctBitVectorIndex::IndexType index_type =
+                SimpleSuccinctBitVectorIndex::CHUNK_INDEX);
 
   bool Open(const uint8_t* data) { return Open(data, 0, 0, 0, 0, 0); }
 
@@ -40,6 +40,10 @@
 #include "absl/types/span.h"
 #include "base/bits.h"
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif  // __BMI2__
+
 namespace mozc {
 namespace storage {
 namespace louds {
@@ -159,14 +163,47 @@ void InitLowerBound1Cache(absl::Span<const int> index, int chunk_size,
   cache->push_back(index.data() + index.size());
 }
 
+// Returns the 1-bits before the word-th word in a RANK9_INDEX block.
+inline int GetRelativeRank1(uint64_t packed, int word) {
+  return word == 0 ? 0 : (packed >> (9 * (word - 1))) & 0x1FF;
+}
+
+// Returns the position of the r-th (0-origin) 1-bit in x.
+// REQUIRES: r < std::popcount(x).
+inline int SelectInWord(uint64_t x, int r) {
+#if defined(__BMI2__)
+  return std::countr_zero(_pdep_u64(uint64_t{1} << r, x));
+#else   // __BMI2__
+  int shift = 0;
+  for (int count = std::popcount(x & 0xFF); r >= count;
+       count = std::popcount(x & 0xFF)) {
+    r -= count;
+    x >>= 8;
+    shift += 8;
+  }
+  for (; r > 0; --r) {
+    x &= x - 1;  // Clear the lowest 1-bit.
+  }
+  return shift + std::countr_zero(x);
+#endif  // __BMI2__
+}
+
 }  // namespace
 
 void SimpleSuccinctBitVectorIndex::Init(const uint8_t *data, int length,
                                         size_t lb0_cache_size,
-                                        size_t lb1_cache_size) {
+                                        size_t lb1_cache_size,
+                                        IndexType index_type) {
   data_ = data;
   length_ = length;
+  index_type_ = index_type;
+  if (index_type_ == RANK9_INDEX) {
+    InitRank9();
+    return;
+  }
+
   InitIndex(data, length, chunk_size_, &index_);
+  num_1bits_ = index_.back();
 
   // TODO(noriyukit): Currently, we simply use uniform increment width for lower
   // bound cache.  Nonuniform increment width may improve performance.
@@ -187,10 +224,78 @@ void SimpleSuccinctBitVectorIndex::Init(const uint8_t *data, int length,
                        lb1_cache_size, &lb1_cache_);
 }
 
+void SimpleSuccinctBitVectorIndex::InitRank9() {
+  DCHECK_EQ(length_ % 4, 0);
+  const int num_words = (length_ + 7) / 8;
+  const int num_blocks = (num_words + 7) / 8;
+
+  // Two words for each block and the sentinel.
+  rank9_.clear();
+  rank9_.reserve(2 * (num_blocks + 1));
+  int num_bits = 0;
+  for (int block = 0; block < num_blocks; ++block) {
+    rank9_.push_back(num_bits);
+    uint64_t packed = 0;
+    int relative = 0;
+    for (int word = 0; word < 8; ++word) {
+      if (word > 0) {
+        packed |= static_cast<uint64_t>(relative) << (9 * (word - 1));
+      }
+      const int word_index = block * 8 + word;
+      if (word_index < num_words) {
+        relative += std::popcount(LoadWord(word_index));
+      }
+    }
+    rank9_.push_back(packed);
+    num_bits += relative;
+  }
+  rank9_.push_back(num_bits);
+  rank9_.push_back(0);
+  num_1bits_ = num_bits;
+
+  // Samples the blocks for select. Padded bits in the last block are not
+  // counted as 0-bits.
+  const int total_bits = 8 * length_;
+  const int last_block = std::max(num_blocks - 1, 0);
+  select0_samples_.clear();
+  select1_samples_.clear();
+  int next0 = 0, next1 = 0;
+  for (int block = 0; block < num_blocks; ++block) {
+    const int end_bits = std::min((block + 1) * kBlockBits, total_bits);
+    const int end1 = static_cast<int>(rank9_[2 * (block + 1)]);
+    const int end0 = end_bits - end1;
+    for (; next0 < end0; next0 += kSelectSampleRate) {
+      select0_samples_.push_back(block);
+    }
+    for (; next1 < end1; next1 += kSelectSampleRate) {
+      select1_samples_.push_back(block);
+    }
+  }
+  select0_samples_.push_back(last_block);
+  select1_samples_.push_back(last_block);
+
+  index_.clear();
+  lb0_cache_.clear();
+  lb1_cache_.clear();
+}
+
+uint64_t SimpleSuccinctBitVectorIndex::LoadWord(int n) const {
+  const uint8_t *ptr = data_ + 8 * n;
+  if (8 * n + 8 <= length_) {
+    return LoadUnaligned<uint64_t>(ptr);
+  }
+  return LoadUnaligned<uint32_t>(ptr);
+}
+
 void SimpleSuccinctBitVectorIndex::Reset() {
   data_ = nullptr;
   length_ = 0;
+  num_1bits_ = 0;
+  index_type_ = CHUNK_INDEX;
   index_.clear();
+  rank9_.clear();
+  select0_samples_.clear();
+  select1_samples_.clear();
   lb0_cache_increment_ = 1;
   lb0_cache_.clear();
   lb1_cache_increment_ = 1;
@@ -198,6 +303,10 @@ void SimpleSuccinctBitVectorIndex::Reset() {
 }
 
 int SimpleSuccinctBitVectorIndex::Rank1(int n) const {
+  if (index_type_ == RANK9_INDEX) {
+    return Rank9Rank1(n);
+  }
+
   // Look up pre-computed 1-bits for the preceding chunks.
   const int num_chunks = n / (chunk_size_ * 8);
   int result = index_[n / (chunk_size_ * 8)];
@@ -218,6 +327,9 @@ int SimpleSuccinctBitVectorIndex::Rank1(int n) const {
 
 int SimpleSuccinctBitVectorIndex::Select0(int n) const {
   DCHECK_GT(n, 0);
+  if (index_type_ == RANK9_INDEX) {
+    return Rank9Select0(n);
+  }
 
   // Narrow down the range of |index_| on which lower bound is performed.
   int lb0_cache_index = n / lb0_cache_increment_;
@@ -263,6 +375,9 @@ int SimpleSuccinctBitVectorIndex::Select0(int n) const {
 
 int SimpleSuccinctBitVectorIndex::Select1(int n) const {
   DCHECK_GT(n, 0);
+  if (index_type_ == RANK9_INDEX) {
+    return Rank9Select1(n);
+  }
 
   // Narrow down the range of |index_| on which lower bound is performed.
   int lb1_cache_index = n / lb1_cache_increment_;
@@ -301,6 +416,87 @@ int SimpleSuccinctBitVectorIndex::Select1(int n) const {
   return index - 1;
 }
 
+int SimpleSuccinctBitVectorIndex::Rank9Rank1(int n) const {
+  const int block = n / kBlockBits;
+  int result = static_cast<int>(rank9_[2 * block]) +
+               GetRelativeRank1(rank9_[2 * block + 1], (n / 64) % 8);
+  if (n % 64 > 0) {
+    result += std::popcount(LoadWord(n / 64) << (64 - n % 64));
+  }
+  return result;
+}
+
+int SimpleSuccinctBitVectorIndex::Rank9Select0(int n) const {
+  // The number of 0-bits before the target bit.
+  int rank = n - 1;
+  const auto rank0 = [this](int block) {
+    return block * kBlockBits - static_cast<int>(rank9_[2 * block]);
+  };
+
+  // Find the last block whose rank is not greater than |rank| between the
+  // sampled blocks.
+  const int sample = rank / kSelectSampleRate;
+  DCHECK_LT(sample + 1, select0_samples_.size());
+  int lo = select0_samples_[sample];
+  int hi = select0_samples_[sample + 1];
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (rank0(mid) <= rank) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  rank -= rank0(lo);
+
+  // Find the word in the block.
+  const uint64_t packed = rank9_[2 * lo + 1];
+  int word = 0;
+  while (word < 7 && (word + 1) * 64 - GetRelativeRank1(packed, word + 1) <=
+                         rank) {
+    ++word;
+  }
+  rank -= word * 64 - GetRelativeRank1(packed, word);
+
+  const int word_index = lo * 8 + word;
+  return word_index * 64 + SelectInWord(~LoadWord(word_index), rank);
+}
+
+int SimpleSuccinctBitVectorIndex::Rank9Select1(int n) const {
+  // The number of 1-bits before the target bit.
+  int rank = n - 1;
+  const auto rank1 = [this](int block) {
+    return static_cast<int>(rank9_[2 * block]);
+  };
+
+  // Find the last block whose rank is not greater than |rank| between the
+  // sampled blocks.
+  const int sample = rank / kSelectSampleRate;
+  DCHECK_LT(sample + 1, select1_samples_.size());
+  int lo = select1_samples_[sample];
+  int hi = select1_samples_[sample + 1];
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (rank1(mid) <= rank) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  rank -= rank1(lo);
+
+  // Find the word in the block.
+  const uint64_t packed = rank9_[2 * lo + 1];
+  int word = 0;
+  while (word < 7 && GetRelativeRank1(packed, word + 1) <= rank) {
+    ++word;
+  }
+  rank -= GetRelativeRank1(packed, word);
+
+  const int word_index = lo * 8 + word;
+  return word_index * 64 + SelectInWord(LoadWord(word_index), rank);
+}
+
 }  // namespace louds
 }  // namespace storage
 }  // namespace mozc
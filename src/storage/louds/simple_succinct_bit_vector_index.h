@@ -41,6 +41,23 @@ namespace louds {
 // This is simple(naive) C++ implementation of succinct bit vector.
 class SimpleSuccinctBitVectorIndex {
  public:
+  // Type of the index built by Init().
+  enum IndexType {
+    // Cumulative number of 1-bits for each chunk (chunk_size bytes) with the
+    // optional lower bound caches for select. Select is a binary search on the
+    // chunks followed by a linear bit scan. This is the smallest index.
+    CHUNK_INDEX,
+
+    // Rank9-style index: the cumulative number of 1-bits for each 512-bit
+    // block and the relative 9-bit counts for each 64-bit word in the block,
+    // plus the blocks of every kSelectSampleRate-th 0-bit and 1-bit. Rank is
+    // O(1), and select scans a few blocks and selects in a 64-bit word with
+    // PDEP when available. The rank index takes 25% of the data size and the
+    // select samples about 6% more. lb0_cache_size and lb1_cache_size are
+    // ignored as the samples already bound the select scan.
+    RANK9_INDEX,
+  };
+
   // The default chunk_size is 32.
   SimpleSuccinctBitVectorIndex()
       : data_(nullptr),
@@ -71,7 +88,7 @@ class SimpleSuccinctBitVectorIndex {
   // pointed by data, so it is caller's responsibility to manage its life time.
   // The 'data' needs to be aligned to 32-bits.
   void Init(const uint8_t* data, int length, size_t lb0_cache_size,
-            size_t lb1_cache_size);
+            size_t lb1_cache_size, IndexType index_type = CHUNK_INDEX);
 
   void Init(const uint8_t* data, int length) { Init(data, length, 0, 0); }
 
@@ -98,15 +115,39 @@ class SimpleSuccinctBitVectorIndex {
   // Returned index is 0-origin.
   int Select1(int n) const;
 
-  int GetNum1Bits() const { return index_.back(); }
-  int GetNum0Bits() const { return 8 * length_ - index_.back(); }
+  int GetNum1Bits() const { return num_1bits_; }
+  int GetNum0Bits() const { return 8 * length_ - num_1bits_; }
 
  private:
+  // The number of bits in a block of RANK9_INDEX, and the sampling rate of
+  // the select positions.
+  static constexpr int kBlockBits = 512;
+  static constexpr int kSelectSampleRate = 512;
+
+  void InitRank9();
+  int Rank9Rank1(int n) const;
+  int Rank9Select0(int n) const;
+  int Rank9Select1(int n) const;
+
+  // Returns the n-th 64-bit word of the data. The last word may be padded
+  // with 0-bits as the length is only aligned to 32 bits.
+  uint64_t LoadWord(int n) const;
+
   // The order of members is optimized to minimize the padding size.
   const uint8_t* data_;
   int length_;
   int chunk_size_;
+  int num_1bits_ = 0;
+  IndexType index_type_ = CHUNK_INDEX;
   std::vector<int> index_;
+  // For RANK9_INDEX. Two words per block: the number of 1-bits before the
+  // block, and the numbers of 1-bits before the 2nd to 8th words relative to
+  // the block, packed in 9 bits each. Ends with a sentinel block.
+  std::vector<uint64_t> rank9_;
+  // For RANK9_INDEX. The block containing the (kSelectSampleRate * i)-th 0-bit
+  // (or 1-bit), followed by the last block as a sentinel.
+  std::vector<int> select0_samples_;
+  std::vector<int> select1_samples_;
   std::vector<const int*> lb0_cache_;
   int lb0_cache_increment_;
   int lb1_cache_increment_;
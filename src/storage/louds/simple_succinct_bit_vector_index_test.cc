@@ -34,6 +34,7 @@
 #include <string>
 #include <utility>
 
+#include "absl/random/random.h"
 #include "testing/gunit.h"
 
 namespace {
@@ -192,4 +193,47 @@ TEST_P(SimpleSuccinctBitVectorIndexTest, Pattern2) {
 }
 INSTANTIATE_TEST_CASE(GenPattern2Test);
 
+class SimpleSuccinctBitVectorIndexRank9Test
+    : public ::testing::TestWithParam<std::pair<int, double>> {};
+
+// RANK9_INDEX must return the same results as CHUNK_INDEX.
+TEST_P(SimpleSuccinctBitVectorIndexRank9Test, SameAsChunkIndex) {
+  const auto [length, density] = GetParam();
+  absl::BitGen gen;
+  std::string data(length, '\0');
+  for (int i = 0; i < length * 8; ++i) {
+    if (absl::Bernoulli(gen, density)) {
+      data[i / 8] |= 1 << (i % 8);
+    }
+  }
+
+  SimpleSuccinctBitVectorIndex expected, actual;
+  expected.Init(reinterpret_cast<const uint8_t *>(data.data()), length, 8, 8);
+  actual.Init(reinterpret_cast<const uint8_t *>(data.data()), length, 0, 0,
+              SimpleSuccinctBitVectorIndex::RANK9_INDEX);
+  ASSERT_EQ(actual.GetNum0Bits(), expected.GetNum0Bits());
+  ASSERT_EQ(actual.GetNum1Bits(), expected.GetNum1Bits());
+
+  for (int i = 0; i <= length * 8; ++i) {
+    ASSERT_EQ(actual.Rank1(i), expected.Rank1(i)) << i;
+    ASSERT_EQ(actual.Rank0(i), expected.Rank0(i)) << i;
+  }
+  for (int i = 1; i <= expected.GetNum0Bits(); ++i) {
+    ASSERT_EQ(actual.Select0(i), expected.Select0(i)) << i;
+  }
+  for (int i = 1; i <= expected.GetNum1Bits(); ++i) {
+    ASSERT_EQ(actual.Select1(i), expected.Select1(i)) << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Rank9, SimpleSuccinctBitVectorIndexRank9Test,
+    ::testing::Values(
+        // Lengths are multiples of 4 bytes, not necessarily of 8 bytes.
+        std::make_pair(4, 0.5), std::make_pair(60, 0.5),
+        std::make_pair(64, 0.5), std::make_pair(68, 0.01),
+        std::make_pair(4096, 0.5), std::make_pair(4100, 0.99),
+        std::make_pair(8192, 0.01), std::make_pair(8196, 0.001),
+        std::make_pair(16384, 0.999)));
+
 }  // namespace
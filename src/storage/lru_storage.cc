@@ -30,13 +30,11 @@
 #include "storage/lru_storage.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <cstdlib>
 #include <cstring>
-#include <ctime>
 #include <ios>
-#include <iterator>
-#include <list>
 #include <memory>
 #include <string>
 #include <utility>
@@ -47,8 +45,10 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "base/bits.h"
@@ -59,6 +59,29 @@
 #include "base/mmap.h"
 #include "base/vlog.h"
 
+// File format:
+//
+//   File header (12 bytes):
+//     uint32_t value_size
+//     uint32_t size (the capacity)
+//     uint32_t seed
+//   Items (size * item_size() bytes):
+//     uint64_t fingerprint
+//     uint32_t last access time (0 for unused items)
+//     char value[value_size]
+//   Index:
+//     uint32_t magic
+//     uint32_t update state (kIndexUpdating while the index is being updated)
+//     uint32_t head (the most recently used item)
+//     uint32_t tail (the least recently used item)
+//     uint32_t used size
+//     uint32_t prev, next: the LRU list links of each item
+//     uint32_t slots[TableSize(size)]: the hash table from fingerprints to the
+//       items.  Each slot is the item index + 1, or 0 for an empty slot.
+//
+// The used items are always stored contiguously from the beginning.  The
+// legacy format has no index; such files are migrated on Open().
+
 namespace mozc {
 namespace storage {
 namespace {
@@ -72,6 +95,37 @@ constexpr size_t kMaxValueSize = 1024;   // 1024 byte
 // * 4 bytes for fingerprint seed
 constexpr size_t kFileHeaderSize = 12;
 
+constexpr uint32_t kIndexMagic = 0x3255524c;  // "LRU2"
+constexpr uint32_t kIndexUpdating = 1;
+
+// Offsets of the fields in the index.
+constexpr size_t kIndexMagicOffset = 0;
+constexpr size_t kIndexStateOffset = 4;
+constexpr size_t kIndexHeadOffset = 8;
+constexpr size_t kIndexTailOffset = 12;
+constexpr size_t kIndexUsedSizeOffset = 16;
+constexpr size_t kIndexHeaderSize = 20;
+
+// The byte length of the links of each item.
+constexpr size_t kLinkSize = 8;
+
+// The hash table has at least twice as many slots as items so that the
+// probing sequences stay short.
+size_t TableSize(size_t size) { return absl::bit_ceil(size * 2); }
+
+size_t IndexSize(size_t size) {
+  return kIndexHeaderSize + kLinkSize * size +
+         sizeof(uint32_t) * TableSize(size);
+}
+
+size_t LegacyFileSize(size_t value_size, size_t size) {
+  return kFileHeaderSize + (value_size + LruStorage::kItemHeaderSize) * size;
+}
+
+size_t FileSize(size_t value_size, size_t size) {
+  return LegacyFileSize(value_size, size) + IndexSize(size);
+}
+
 uint64_t GetFP(const char* ptr) { return LoadUnaligned<uint64_t>(ptr); }
 
 uint32_t GetTimeStamp(const char* ptr) {
@@ -166,23 +220,25 @@ bool LruStorage::CreateStorageFile(const char* filename, size_t value_size,
               static_cast<std::streamsize>(ary.size() * sizeof(ary[0])));
   }
 
+  // The index of an empty LRU.
+  const uint32_t index_header[] = {kIndexMagic, 0, kInvalidIndex,
+                                   kInvalidIndex, 0};
+  static_assert(sizeof(index_header) == kIndexHeaderSize);
+  ofs.write(reinterpret_cast<const char*>(index_header), kIndexHeaderSize);
+  const std::string zeros(IndexSize(size) - kIndexHeaderSize, '\0');
+  ofs.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+
   return true;
 }
 
 // Reopen file after initializing mapped page.
 bool LruStorage::Clear() {
   // Don't need to clear the page if the lru list is empty
-  if (mmap_.empty() || lru_list_.empty()) {
+  if (mmap_.empty() || used_size() == 0) {
     return true;
   }
-  const size_t offset = sizeof(value_size_) + sizeof(size_) + sizeof(seed_);
-  if (offset >= mmap_.size()) {  // should not happen
-    return false;
-  }
-  std::fill(mmap_.begin() + offset, mmap_.end(), 0);
-  lru_list_.clear();
-  lru_map_.clear();
-  Open(mmap_.begin(), mmap_.size());
+  std::fill(begin_, end_, 0);
+  RebuildIndex();
   return true;
 }
 
@@ -247,7 +303,8 @@ bool LruStorage::Merge(const LruStorage& storage) {
     std::fill(new_end, end_, 0);
   }
 
-  return Open(mmap_.begin(), mmap_.size());
+  RebuildIndex();
+  return true;
 }
 
 bool LruStorage::OpenOrCreate(const char* filename, size_t new_value_size,
@@ -318,18 +375,59 @@ bool LruStorage::Open(const char* filename) {
   }
   mmap_ = *std::move(mmap);
 
-  if (mmap_.size() < 8) {
+  if (mmap_.size() < kFileHeaderSize) {
     LOG(ERROR) << "file size is too small";
     return false;
   }
 
+  const char* ptr = mmap_.begin();
+  const size_t value_size = LoadUnalignedAdvance<uint32_t>(ptr);
+  const size_t size = LoadUnalignedAdvance<uint32_t>(ptr);
+  if (value_size <= kMaxValueSize && size <= kMaxLruSize &&
+      mmap_.size() == LegacyFileSize(value_size, size)) {
+    MOZC_VLOG(1) << filename << " is in the legacy format. Migrating.";
+    if (!MigrateLegacyFile(filename)) {
+      return false;
+    }
+  }
+
   filename_ = filename;
   return Open(mmap_.begin(), mmap_.size());
 }
 
+bool LruStorage::MigrateLegacyFile(const char* filename) {
+  std::string contents(mmap_.begin(), mmap_.size());
+  const size_t size = LoadUnaligned<uint32_t>(contents.data() + 4);
+  // Leave the index header zero-filled. Open() sees no magic and rebuilds the
+  // index, so the migration completes even if the process dies after the file
+  // is renamed.
+  contents.append(IndexSize(size), '\0');
+  mmap_.Close();
+
+  const std::string tmp_filename = absl::StrCat(filename, ".tmp");
+  if (absl::Status s = FileUtil::SetContents(tmp_filename, contents); !s.ok()) {
+    LOG(ERROR) << "Cannot write " << tmp_filename << ": " << s;
+    return false;
+  }
+  if (absl::Status s = FileUtil::AtomicRename(tmp_filename, filename);
+      !s.ok()) {
+    LOG(ERROR) << "Cannot rename " << tmp_filename << ": " << s;
+    FileUtil::UnlinkOrLogError(tmp_filename);
+    return false;
+  }
+
+  absl::StatusOr<Mmap> mmap = Mmap::Map(filename, Mmap::READ_WRITE);
+  if (!mmap.ok()) {
+    LOG(ERROR) << "Cannot open " << filename
+               << " with read+write mode: " << mmap.status();
+    return false;
+  }
+  mmap_ = *std::move(mmap);
+  return true;
+}
+
 bool LruStorage::Open(char* ptr, size_t ptr_size) {
   begin_ = ptr;
-  end_ = ptr + ptr_size;
 
   value_size_ = LoadUnalignedAdvance<uint32_t>(begin_);
   size_ = LoadUnalignedAdvance<uint32_t>(begin_);
@@ -350,30 +448,28 @@ bool LruStorage::Open(char* ptr, size_t ptr_size) {
     return false;
   }
 
-  if (mmap_.size() != kFileHeaderSize + item_size() * size_) {
+  if (ptr_size != FileSize(value_size_, size_)) {
     LOG(ERROR) << "LRU file is broken";
     return false;
   }
 
-  std::vector<char*> ary;
-  for (char* begin = begin_; begin < end_; begin += item_size()) {
-    ary.push_back(begin);
-  }
-  std::stable_sort(ary.begin(), ary.end(), CompareByTimeStamp());
+  end_ = begin_ + item_size() * size_;
+  index_ = end_;
+  table_mask_ = TableSize(size_) - 1;
 
-  lru_list_.clear();
-  lru_map_.clear();
-  char* next = nullptr;
-  for (size_t i = 0; i < ary.size(); ++i) {
-    if (GetTimeStamp(ary[i]) != 0) {
-      lru_list_.push_back(ary[i]);
-      lru_map_[GetFP(ary[i])] = std::prev(lru_list_.end());
-    } else if (next == nullptr) {
-      next = ary[i];
-    }
+  // Validates only the header of the index so that opening stays O(1).
+  const uint32_t used_size = LoadIndexField(kIndexUsedSizeOffset);
+  const uint32_t head = LoadIndexField(kIndexHeadOffset);
+  const uint32_t tail = LoadIndexField(kIndexTailOffset);
+  const bool valid_list = (used_size == 0)
+                              ? (head == kInvalidIndex && tail == kInvalidIndex)
+                              : (head < used_size && tail < used_size);
+  if (LoadIndexField(kIndexMagicOffset) != kIndexMagic ||
+      LoadIndexField(kIndexStateOffset) == kIndexUpdating ||
+      used_size > size_ || !valid_list) {
+    MOZC_VLOG(1) << "Rebuilding the LRU index.";
+    RebuildIndex();
   }
-  next_item_ = (next != nullptr) ? next : end_;
-  DCHECK_LE(next_item_, end_);
 
   return true;
 }
@@ -381,20 +477,86 @@ bool LruStorage::Open(char* ptr, size_t ptr_size) {
 void LruStorage::Close() {
   filename_.clear();
   mmap_.Close();
-  lru_list_.clear();
-  lru_map_.clear();
+  begin_ = end_ = index_ = nullptr;
+}
+
+void LruStorage::RebuildIndex() {
+  StoreIndexField(kIndexStateOffset, kIndexUpdating);
+
+  // Moves the used items to the beginning.
+  uint32_t used_size = 0;
+  for (uint32_t i = 0; i < size_; ++i) {
+    if (GetTimeStamp(GetItem(i)) == 0) {
+      continue;
+    }
+    if (i != used_size) {
+      std::copy_n(GetItem(i), item_size(), GetItem(used_size));
+    }
+    ++used_size;
+  }
+  std::fill(GetItem(used_size), end_, 0);
+
+  std::vector<const char*> ary;
+  ary.reserve(used_size);
+  for (uint32_t i = 0; i < used_size; ++i) {
+    ary.push_back(GetItem(i));
+  }
+  std::stable_sort(ary.begin(), ary.end(), CompareByTimeStamp());
+
+  std::fill(index_ + kIndexHeaderSize, index_ + IndexSize(size_), 0);
+  StoreIndexField(kIndexHeadOffset, kInvalidIndex);
+  StoreIndexField(kIndexTailOffset, kInvalidIndex);
+  StoreIndexField(kIndexUsedSizeOffset, used_size);
+  for (const char* item : ary) {
+    const uint32_t index = (item - begin_) / item_size();
+    PushBack(index);
+    const bool inserted = InsertToTable(GetFP(item), index);
+    DCHECK(inserted);
+  }
+
+  StoreIndexField(kIndexMagicOffset, kIndexMagic);
+  StoreIndexField(kIndexStateOffset, 0);
+  index_broken_.store(false, std::memory_order_relaxed);
+}
+
+template <typename Func>
+bool LruStorage::UpdateIndex(Func update) {
+  if (index_broken_.load(std::memory_order_relaxed)) {
+    RebuildIndex();
+  }
+  BeginUpdate();
+  if (!update()) {
+    LOG(WARNING) << "The LRU index is broken. Rebuilding.";
+    RebuildIndex();
+    BeginUpdate();
+    if (!update()) {
+      LOG(DFATAL) << "The rebuilt LRU index is broken.";
+      RebuildIndex();
+      return false;
+    }
+  }
+  EndUpdate();
+  return true;
+}
+
+size_t LruStorage::used_size() const {
+  return index_ == nullptr ? 0 : LoadIndexField(kIndexUsedSizeOffset);
 }
 
 const char* absl_nullable LruStorage::Lookup(const absl::string_view key,
                                              uint32_t* last_access_time) const {
   const uint64_t fp = LegacyFingerprintWithSeed(key, seed_);
-  const auto it = lru_map_.find(fp);
-  if (it == lru_map_.end()) {
+  uint32_t index = kInvalidIndex;
+  if (!Find(fp, &index)) {
+    index_broken_.store(true, std::memory_order_relaxed);
+    index = FindByScan(fp);
+  }
+  if (index == kInvalidIndex) {
     return nullptr;
   }
-  const uint32_t timestamp = GetTimeStamp(*it->second);
-  *last_access_time = timestamp;
-  return GetValue(*it->second);
+  const char* item = GetItem(index);
+  *last_access_time = GetTimeStamp(item);
+  return GetValue(item);
 }
 
 void LruStorage::GetAllValues(std::vector<std::string>* values) const {
@@ -402,143 +564,184 @@ void LruStorage::GetAllValues(std::vector<std::string>* values) const {
   values->clear();
   // Iterate data from the most recently used element to the least recently used
   // element.
-  for (const char* ptr : lru_list_) {
+  const size_t used = used_size();
+  if (used == 0) {
+    return;
+  }
+  values->reserve(used);
+  uint32_t index = LoadIndexField(kIndexHeadOffset);
+  while (index != kInvalidIndex && index < used && values->size() < used) {
     // Default constructor of string is not applicable
     // because value's size() must return value_size_.
-    DCHECK(ptr);
-    values->emplace_back(GetValue(ptr), value_size_);
+    values->emplace_back(GetValue(GetItem(index)), value_size_);
+    index = GetNext(index);
+  }
+  // A valid list ends right after visiting all the items.  An invalid link or
+  // a cycle stops the loop elsewhere.
+  if (index == kInvalidIndex && values->size() == used) {
+    return;
+  }
+
+  // The list is broken.  Orders the items by timestamp as RebuildIndex() does.
+  index_broken_.store(true, std::memory_order_relaxed);
+  std::vector<const char*> ary;
+  ary.reserve(used);
+  for (uint32_t i = 0; i < used; ++i) {
+    ary.push_back(GetItem(i));
+  }
+  std::stable_sort(ary.begin(), ary.end(), CompareByTimeStamp());
+  values->clear();
+  for (const char* item : ary) {
+    values->emplace_back(GetValue(item), value_size_);
   }
 }
 
 bool LruStorage::Touch(const absl::string_view key) {
   const uint64_t fp = LegacyFingerprintWithSeed(key, seed_);
-  auto it = lru_map_.find(fp);
-  if (it == lru_map_.end()) {
+  if (FindOrRebuild(fp) == kInvalidIndex) {
     return false;
   }
-  Update(*it->second);
-  // Move the node pointed to by it->second to the front.
-  lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
-  return true;
+  return UpdateIndex([&] {
+    uint32_t index = kInvalidIndex;
+    if (!Find(fp, &index) || index == kInvalidIndex) {
+      return false;
+    }
+    Update(GetItem(index));
+    return MoveToFront(index);
+  });
 }
 
 bool LruStorage::Insert(const absl::string_view key, const char* value) {
-  if (value == nullptr) {
+  if (value == nullptr || index_ == nullptr) {
     return false;
   }
   const uint64_t fp = LegacyFingerprintWithSeed(key, seed_);
 
-  // If the data corresponding to |key| already exists in LRU, update it.
-  {
-    auto it = lru_map_.find(fp);
-    if (it != lru_map_.end()) {
-      // Overwrite the data pointed to by it->second and move it to the front.
-      Update(*it->second, fp, value, value_size_);
-      lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
-      return true;
+  // If an update stops at a broken link, the items written so far carry the
+  // new timestamp, so the rebuilt index contains them and the retry finds
+  // |fp|.
+  return UpdateIndex([&] {
+    uint32_t index = kInvalidIndex;
+    if (!Find(fp, &index)) {
+      return false;
     }
-  }
-
-  // If the LRU is full or we run out of the mmap region, drop the least
-  // recently used element (actually, the least recently used element is
-  // overwritten with new data).
-  if (lru_map_.size() >= size_ || next_item_ == end_) {
-    auto it = std::prev(lru_list_.end());  // Least recently used data.
-    const uint64_t old_fp = GetFP(*it);
-    lru_map_.erase(old_fp);
-    lru_list_.splice(lru_list_.begin(), lru_list_, it);  // Move to front.
-    Update(*it, fp, value, value_size_);
-    lru_map_[fp] = it;
-    return true;
-  }
-
-  // A new item can be assigned in the mmap region.
-  if (next_item_ < end_) {
-    Update(next_item_, fp, value, value_size_);
-    lru_list_.push_front(next_item_);
-    lru_map_[fp] = lru_list_.begin();
-    // Advance next_item_ for next item.
-    next_item_ += item_size();
-    DCHECK_LE(next_item_, end_);
-    return true;
-  }
-
-  LOG(ERROR) << "Insertion failed because no more mmap region is available.";
-  return false;
+    if (index != kInvalidIndex) {
+      // If the data corresponding to |key| already exists in LRU, overwrite
+      // it and move it to the front.
+      Update(GetItem(index), fp, value, value_size_);
+      return MoveToFront(index);
+    }
+    if (used_size() >= size_) {
+      // If the LRU is full, the least recently used element is overwritten
+      // with new data.
+      index = LoadIndexField(kIndexTailOffset);
+      if (index >= used_size() ||
+          !EraseFromTable(GetFP(GetItem(index)), index)) {
+        return false;
+      }
+      Update(GetItem(index), fp, value, value_size_);
+      return MoveToFront(index) && InsertToTable(fp, index);
+    }
+    // A new item can be assigned in the mmap region.
+    index = used_size();
+    StoreIndexField(kIndexUsedSizeOffset, index + 1);
+    Update(GetItem(index), fp, value, value_size_);
+    return PushFront(index) && InsertToTable(fp, index);
+  });
 }
 
 bool LruStorage::TryInsert(const absl::string_view key, const char* value) {
   const uint64_t fp = LegacyFingerprintWithSeed(key, seed_);
-  auto it = lru_map_.find(fp);
-  if (it != lru_map_.end()) {
-    Update(*it->second, fp, value, value_size_);
-    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  if (FindOrRebuild(fp) == kInvalidIndex) {
+    return true;
   }
+  UpdateIndex([&] {
+    uint32_t index = kInvalidIndex;
+    if (!Find(fp, &index) || index == kInvalidIndex) {
+      return false;
+    }
+    Update(GetItem(index), fp, value, value_size_);
+    return MoveToFront(index);
+  });
   return true;
 }
 
 bool LruStorage::Delete(const absl::string_view key) {
   const uint64_t fp = LegacyFingerprintWithSeed(key, seed_);
-  return Delete(fp);
-}
-
-bool LruStorage::Delete(uint64_t fp) {
-  auto it = lru_map_.find(fp);
-  return (it == lru_map_.end() || Delete(fp, it->second));
-}
-
-bool LruStorage::Delete(std::list<char*>::iterator it) {
-  return (it == lru_list_.end() || Delete(GetFP(*it), it));
+  if (FindOrRebuild(fp) == kInvalidIndex) {
+    return true;
+  }
+  // DeleteAt() checks the links and the table before it moves any item, so
+  // the item is still there when the retry runs.
+  return UpdateIndex([&] {
+    uint32_t index = kInvalidIndex;
+    if (!Find(fp, &index) || index == kInvalidIndex) {
+      return false;
+    }
+    return DeleteAt(index);
+  });
 }
 
-bool LruStorage::Delete(uint64_t fp, std::list<char*>::iterator it) {
-  // Determine the last element in the mmap region.
-  if (next_item_ < begin_ + item_size()) {
-    LOG(ERROR) << "next_item_ points to invalid location (broken?)";
+bool LruStorage::DeleteAt(uint32_t index) {
+  const uint32_t last = used_size() - 1;
+  DCHECK_LE(index, last);
+  if (!Unlink(index) || !EraseFromTable(GetFP(GetItem(index)), index)) {
     return false;
   }
-  next_item_ -= item_size();
-
-  // Backup the location of mmap region to which another element will be moved.
-  char* deleted_item_pos = *it;
 
-  // Erase the LRU structure for (fp, it).
-  lru_map_.erase(fp);
-  lru_list_.erase(it);
-
-  if (next_item_ != deleted_item_pos) {
-    // Move the region for the last element to the deleted location.  Then,
-    // update the LRU structure for the moved element (the pointer to mmap
-    // region in the list node is updated.)
-    std::copy_n(next_item_, item_size(), deleted_item_pos);
-    const uint64_t fp = GetFP(next_item_);
-    *lru_map_[fp] = deleted_item_pos;
+  if (index != last) {
+    // Move the last element to the deleted location.  Then, update the links
+    // and the hash table for the moved element.
+    const uint32_t prev = GetPrev(last);
+    const uint32_t next = GetNext(last);
+    if (!IsValidLink(prev) || !IsValidLink(next) ||
+        !ReplaceInTable(GetFP(GetItem(last)), last, index)) {
+      return false;
+    }
+    std::copy_n(GetItem(last), item_size(), GetItem(index));
+    SetPrev(index, prev);
+    SetNext(index, next);
+    if (prev == kInvalidIndex) {
+      StoreIndexField(kIndexHeadOffset, index);
+    } else {
+      SetNext(prev, index);
+    }
+    if (next == kInvalidIndex) {
+      StoreIndexField(kIndexTailOffset, index);
+    } else {
+      SetPrev(next, index);
+    }
   }
 
-  // Clear the region for the next_item_.
-  std::fill_n(next_item_, item_size(), 0);
-
+  // Clear the region for the last element.
+  std::fill_n(GetItem(last), item_size(), 0);
+  SetPrev(last, 0);
+  SetNext(last, 0);
+  StoreIndexField(kIndexUsedSizeOffset, last);
   return true;
 }
 
 int LruStorage::DeleteElementsBefore(uint32_t timestamp) {
-  if (mmap_.empty() || begin_ >= end_) {
+  if (mmap_.empty() || index_ == nullptr) {
     return 0;
   }
   int num_deleted = 0;
-  while (!lru_list_.empty()) {
-    auto it = std::prev(lru_list_.end());
-    const uint32_t last_access_time = GetTimeStamp(*it);
-    if (last_access_time >= timestamp) {
-      break;
-    }
-    if (Delete(it)) {
+  UpdateIndex([&] {
+    while (used_size() > 0) {
+      const uint32_t index = LoadIndexField(kIndexTailOffset);
+      if (index >= used_size()) {
+        return false;
+      }
+      if (GetTimeStamp(GetItem(index)) >= timestamp) {
+        break;
+      }
+      if (!DeleteAt(index)) {
+        return false;
+      }
       ++num_deleted;
-      continue;
     }
-    LOG(ERROR) << "Deletion failed for an item.  Abort deletion.";
-    break;
-  }
+    return true;
+  });
   return num_deleted;
 }
 
@@ -564,5 +767,225 @@ void LruStorage::Read(size_t i, uint64_t* fp, std::string* value,
   *last_access_time = GetTimeStamp(ptr);
 }
 
+bool LruStorage::Find(uint64_t fp, uint32_t* index) const {
+  *index = kInvalidIndex;
+  if (index_ == nullptr) {
+    return true;
+  }
+  size_t slot = GetHomeSlot(fp);
+  for (size_t i = 0; i <= table_mask_; ++i) {
+    const uint32_t value = GetSlot(slot);
+    if (value == 0) {
+      return true;
+    }
+    if (!IsValidSlot(value)) {
+      return false;
+    }
+    if (GetFP(GetItem(value - 1)) == fp) {
+      *index = value - 1;
+      return true;
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+  // The table always has empty slots.
+  return false;
+}
+
+uint32_t LruStorage::FindOrRebuild(uint64_t fp) {
+  uint32_t index = kInvalidIndex;
+  if (!Find(fp, &index)) {
+    LOG(WARNING) << "The LRU index is broken. Rebuilding.";
+    RebuildIndex();
+    if (!Find(fp, &index)) {
+      LOG(DFATAL) << "The rebuilt LRU index is broken.";
+      return kInvalidIndex;
+    }
+  }
+  return index;
+}
+
+uint32_t LruStorage::FindByScan(uint64_t fp) const {
+  for (uint32_t i = 0; i < used_size(); ++i) {
+    if (GetFP(GetItem(i)) == fp) {
+      return i;
+    }
+  }
+  return kInvalidIndex;
+}
+
+char* LruStorage::GetItem(uint32_t index) const {
+  return begin_ + index * item_size();
+}
+
+uint32_t LruStorage::LoadIndexField(size_t offset) const {
+  return LoadUnaligned<uint32_t>(index_ + offset);
+}
+
+void LruStorage::StoreIndexField(size_t offset, uint32_t value) {
+  StoreUnaligned<uint32_t>(value, index_ + offset);
+}
+
+uint32_t LruStorage::GetPrev(uint32_t index) const {
+  return LoadIndexField(kIndexHeaderSize + kLinkSize * index);
+}
+
+uint32_t LruStorage::GetNext(uint32_t index) const {
+  return LoadIndexField(kIndexHeaderSize + kLinkSize * index + 4);
+}
+
+void LruStorage::SetPrev(uint32_t index, uint32_t prev) {
+  StoreIndexField(kIndexHeaderSize + kLinkSize * index, prev);
+}
+
+void LruStorage::SetNext(uint32_t index, uint32_t next) {
+  StoreIndexField(kIndexHeaderSize + kLinkSize * index + 4, next);
+}
+
+bool LruStorage::Unlink(uint32_t index) {
+  const uint32_t prev = GetPrev(index);
+  const uint32_t next = GetNext(index);
+  if (!IsValidLink(prev) || !IsValidLink(next)) {
+    return false;
+  }
+  if (prev == kInvalidIndex) {
+    StoreIndexField(kIndexHeadOffset, next);
+  } else {
+    SetNext(prev, next);
+  }
+  if (next == kInvalidIndex) {
+    StoreIndexField(kIndexTailOffset, prev);
+  } else {
+    SetPrev(next, prev);
+  }
+  return true;
+}
+
+bool LruStorage::PushFront(uint32_t index) {
+  const uint32_t head = LoadIndexField(kIndexHeadOffset);
+  if (!IsValidLink(head)) {
+    return false;
+  }
+  SetPrev(index, kInvalidIndex);
+  SetNext(index, head);
+  if (head == kInvalidIndex) {
+    StoreIndexField(kIndexTailOffset, index);
+  } else {
+    SetPrev(head, index);
+  }
+  StoreIndexField(kIndexHeadOffset, index);
+  return true;
+}
+
+void LruStorage::PushBack(uint32_t index) {
+  const uint32_t tail = LoadIndexField(kIndexTailOffset);
+  SetPrev(index, tail);
+  SetNext(index, kInvalidIndex);
+  if (tail == kInvalidIndex) {
+    StoreIndexField(kIndexHeadOffset, index);
+  } else {
+    SetNext(tail, index);
+  }
+  StoreIndexField(kIndexTailOffset, index);
+}
+
+bool LruStorage::MoveToFront(uint32_t index) {
+  if (LoadIndexField(kIndexHeadOffset) == index) {
+    return true;
+  }
+  return Unlink(index) && PushFront(index);
+}
+
+uint32_t LruStorage::GetSlot(size_t slot) const {
+  return LoadIndexField(kIndexHeaderSize + kLinkSize * size_ +
+                        sizeof(uint32_t) * slot);
+}
+
+void LruStorage::SetSlot(size_t slot, uint32_t value) {
+  StoreIndexField(
+      kIndexHeaderSize + kLinkSize * size_ + sizeof(uint32_t) * slot, value);
+}
+
+size_t LruStorage::GetHomeSlot(uint64_t fp) const {
+  return static_cast<size_t>(fp ^ (fp >> 32)) & table_mask_;
+}
+
+bool LruStorage::InsertToTable(uint64_t fp, uint32_t index) {
+  size_t slot = GetHomeSlot(fp);
+  for (size_t i = 0; i <= table_mask_; ++i) {
+    if (GetSlot(slot) == 0) {
+      SetSlot(slot, index + 1);
+      return true;
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+  return false;
+}
+
+bool LruStorage::EraseFromTable(uint64_t fp, uint32_t index) {
+  size_t slot = GetHomeSlot(fp);
+  for (size_t i = 0;; ++i) {
+    // The item must be in the table.
+    if (i > table_mask_ || GetSlot(slot) == 0) {
+      return false;
+    }
+    if (GetSlot(slot) == index + 1) {
+      break;
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+
+  // Backward shift deletion: moves the following entries in the same probing
+  // sequence into the hole so that no tombstone is needed.
+  size_t hole = slot;
+  size_t next = (hole + 1) & table_mask_;
+  for (size_t i = 0;; ++i) {
+    if (i > table_mask_) {
+      return false;
+    }
+    const uint32_t value = GetSlot(next);
+    if (value == 0) {
+      break;
+    }
+    if (!IsValidSlot(value)) {
+      return false;
+    }
+    const size_t home = GetHomeSlot(GetFP(GetItem(value - 1)));
+    // Moves the entry if its home slot is not in the cyclic range
+    // (hole, next].
+    const bool in_range = (hole < next) ? (hole < home && home <= next)
+                                        : (hole < home || home <= next);
+    if (!in_range) {
+      SetSlot(hole, value);
+      hole = next;
+    }
+    next = (next + 1) & table_mask_;
+  }
+  SetSlot(hole, 0);
+  return true;
+}
+
+bool LruStorage::ReplaceInTable(uint64_t fp, uint32_t old_index,
+                                uint32_t new_index) {
+  size_t slot = GetHomeSlot(fp);
+  for (size_t i = 0; i <= table_mask_; ++i) {
+    const uint32_t value = GetSlot(slot);
+    if (value == 0) {
+      return false;  // The item must be in the table.
+    }
+    if (value == old_index + 1) {
+      SetSlot(slot, new_index + 1);
+      return true;
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+  return false;
+}
+
+void LruStorage::BeginUpdate() {
+  StoreIndexField(kIndexStateOffset, kIndexUpdating);
+}
+
+void LruStorage::EndUpdate() { StoreIndexField(kIndexStateOffset, 0); }
+
 }  // namespace storage
 }  // namespace mozc
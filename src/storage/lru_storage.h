@@ -32,19 +32,22 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <list>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/base/nullability.h"
-#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "base/mmap.h"
+#include "base/thread.h"
 
 namespace mozc {
 namespace storage {
 
+// LRU storage backed by a memory mapped file. The file holds both the items
+// and the LRU index (a doubly linked list and a hash table of the items), so
+// opening a file is O(1) and no heap memory is allocated per item. See
+// lru_storage.cc for the file format.
 class LruStorage {
  public:
   LruStorage() = default;
@@ -119,7 +122,7 @@ class LruStorage {
   size_t size() const { return size_; }
 
   // Returns the number of items in LRU.
-  size_t used_size() const { return lru_list_.size(); }
+  size_t used_size() const;
 
   // Returns the seed used for fingerprinting.
   uint32_t seed() const { return seed_; }
@@ -128,7 +131,8 @@ class LruStorage {
 
   // Writes one entry at |i| th index.
   // i must be 0 <= i < size.
-  // This data will not update the index of the storage.
+  // This data will not update the index of the storage.  The index is rebuilt
+  // by Merge().
   void Write(size_t i, uint64_t fp, absl::string_view value,
              uint32_t last_access_time);
 
@@ -158,22 +162,86 @@ class LruStorage {
   // Initializes this LRU from memory buffer.
   bool Open(char* ptr, size_t ptr_size);
 
-  // Deletes the element from |fp| or |it|.
-  bool Delete(uint64_t fp);
-  bool Delete(std::list<char*>::iterator it);
-
-  // Actual implementation of Delete() methods.
-  bool Delete(uint64_t fp, std::list<char*>::iterator it);
+  // Rewrites the file in the legacy format, which has no index, into the
+  // current format.
+  bool MigrateLegacyFile(const char* filename);
+
+  // Rebuilds the index from the timestamps of the items.
+  void RebuildIndex();
+
+  // Runs |update|, which returns false if it finds the index broken, between
+  // BeginUpdate() and EndUpdate().  If the index is broken, rebuilds it and
+  // runs |update| again.
+  template <typename Func>
+  bool UpdateIndex(Func update);
+
+  // Sets the index of the item for |fp|, or kInvalidIndex if not found, to
+  // |index|.  Returns false if the index is broken.
+  bool Find(uint64_t fp, uint32_t* index) const;
+
+  // Same as above but rebuilds the index if it is broken.
+  uint32_t FindOrRebuild(uint64_t fp);
+
+  // Returns the index of the item for |fp| by scanning all the items.  Used
+  // only when the index is broken.
+  uint32_t FindByScan(uint64_t fp) const;
+
+  // Deletes the item at |index|.  The last item is moved to |index| to keep
+  // the items contiguous.  Returns false if the index is broken.
+  bool DeleteAt(uint32_t index);
+
+  // Accessors to the items and the index in the mapped region.
+  char* GetItem(uint32_t index) const;
+  uint32_t LoadIndexField(size_t offset) const;
+  void StoreIndexField(size_t offset, uint32_t value);
+  uint32_t GetPrev(uint32_t index) const;
+  uint32_t GetNext(uint32_t index) const;
+  void SetPrev(uint32_t index, uint32_t prev);
+  void SetNext(uint32_t index, uint32_t next);
+
+  // The index is read from the file, so every link and slot is checked
+  // before it is used.  A link is either kInvalidIndex or a used item, and a
+  // slot is either 0 or a used item + 1.
+  bool IsValidLink(uint32_t link) const {
+    return link == kInvalidIndex || link < used_size();
+  }
+  bool IsValidSlot(uint32_t value) const { return value <= used_size(); }
+
+  // Operations on the linked list.  The ones returning bool return false
+  // without modifying the list if they find it broken.
+  bool Unlink(uint32_t index);
+  bool PushFront(uint32_t index);
+  void PushBack(uint32_t index);
+  bool MoveToFront(uint32_t index);
+
+  // Operations on the hash table.  The ones returning bool return false if
+  // they find the table broken.  Probing stops after visiting all the slots.
+  uint32_t GetSlot(size_t slot) const;
+  void SetSlot(size_t slot, uint32_t value);
+  size_t GetHomeSlot(uint64_t fp) const;
+  bool InsertToTable(uint64_t fp, uint32_t index);
+  bool EraseFromTable(uint64_t fp, uint32_t index);
+  bool ReplaceInTable(uint64_t fp, uint32_t old_index, uint32_t new_index);
+
+  // Marks the index as being updated.  If the process dies while the index is
+  // being updated, the index is rebuilt on the next Open().
+  void BeginUpdate();
+  void EndUpdate();
+
+  static constexpr uint32_t kInvalidIndex = 0xFFFFFFFF;
 
   size_t value_size_ = 0;
   size_t size_ = 0;
   uint32_t seed_ = 0;
-  char* next_item_ = nullptr;
-  char* begin_ = nullptr;
-  char* end_ = nullptr;
+  size_t table_mask_ = 0;
+  char* begin_ = nullptr;  // Beginning of the items.
+  char* end_ = nullptr;    // End of the items.
+  char* index_ = nullptr;  // Beginning of the index.
+  // Set when a const method finds the index broken.  The next update rebuilds
+  // the index.  Atomic as const methods may run concurrently under a reader
+  // lock.
+  mutable CopyableAtomic<bool> index_broken_{false};
   std::string filename_;
-  std::list<char*> lru_list_;  // Front is the most recently used data.
-  absl::flat_hash_map<uint64_t, std::list<char*>::iterator> lru_map_;
   Mmap mmap_;
 };
 
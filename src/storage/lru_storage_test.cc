@@ -32,20 +32,29 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/log/check.h"
 #include "absl/random/random.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "base/clock_mock.h"
 #include "base/file/temp_dir.h"
 #include "base/file_util.h"
+#include "base/hash.h"
 #include "base/random.h"
 #include "storage/lru_cache.h"
 #include "testing/gmock.h"
@@ -56,6 +65,8 @@ namespace mozc {
 namespace storage {
 namespace {
 
+using ::testing::ElementsAre;
+
 constexpr uint32_t kSeed = 0x76fef;  // Seed for fingerprint.
 
 void RunTest(LruStorage* storage, uint32_t size) {
@@ -483,5 +494,221 @@ TEST_F(LruStorageTest, DeleteElementsBefore) {
   EXPECT_EQ(values, kExpectedAfterDelete);
 }
 
+
+TEST_F(LruStorageTest, ReopenKeepsLruOrder) {
+  ScopedClockMock clock(absl::FromUnixSeconds(1));
+  clock->AutoAdvance(absl::Seconds(1));
+
+  TempFile file(testing::MakeTempFileOrDie());
+  {
+    LruStorage storage;
+    ASSERT_TRUE(storage.OpenOrCreate(file.path().c_str(), 4, 3, kSeed));
+    EXPECT_TRUE(storage.Insert("1111", "aaaa"));
+    EXPECT_TRUE(storage.Insert("2222", "bbbb"));
+    EXPECT_TRUE(storage.Insert("3333", "cccc"));
+    EXPECT_TRUE(storage.Touch("1111"));
+    EXPECT_TRUE(storage.Insert("4444", "dddd"));  // Evicts "2222".
+  }
+
+  LruStorage storage;
+  ASSERT_TRUE(storage.Open(file.path().c_str()));
+  EXPECT_EQ(storage.used_size(), 3);
+  std::vector<std::string> values;
+  storage.GetAllValues(&values);
+  EXPECT_THAT(values, ElementsAre("dddd", "aaaa", "cccc"));
+  EXPECT_EQ(storage.Lookup("2222"), nullptr);
+  EXPECT_EQ(storage.LookupAsString("3333"), "cccc");
+}
+
+TEST_F(LruStorageTest, MigrateLegacyFormat) {
+  constexpr uint32_t kValueSize = 4;
+  constexpr uint32_t kSize = 4;
+
+  // The legacy format consists of the file header and the items only.  The
+  // items are not sorted by timestamp.
+  std::string contents;
+  auto append_uint32 = [&contents](uint32_t value) {
+    contents.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  auto append_item = [&](absl::string_view key, uint32_t timestamp,
+                         absl::string_view value) {
+    const uint64_t fp = LegacyFingerprintWithSeed(key, kSeed);
+    contents.append(reinterpret_cast<const char*>(&fp), sizeof(fp));
+    append_uint32(timestamp);
+    contents.append(value.data(), value.size());
+  };
+  append_uint32(kValueSize);
+  append_uint32(kSize);
+  append_uint32(kSeed);
+  append_item("1111", 20, "aaaa");
+  append_item("2222", 30, "bbbb");
+  append_item("3333", 10, "cccc");
+  contents.append(LruStorage::kItemHeaderSize + kValueSize, '\0');
+
+  TempFile file(testing::MakeTempFileOrDie());
+  ASSERT_OK(FileUtil::SetContents(file.path(), contents));
+
+  LruStorage storage;
+  ASSERT_TRUE(storage.Open(file.path().c_str()));
+  EXPECT_EQ(storage.size(), kSize);
+  EXPECT_EQ(storage.used_size(), 3);
+  std::vector<std::string> values;
+  storage.GetAllValues(&values);
+  EXPECT_THAT(values, ElementsAre("bbbb", "aaaa", "cccc"));
+  EXPECT_EQ(storage.LookupAsString("1111"), "aaaa");
+  EXPECT_EQ(storage.LookupAsString("2222"), "bbbb");
+  EXPECT_EQ(storage.LookupAsString("3333"), "cccc");
+
+  // The file is rewritten in the current format.
+  absl::StatusOr<std::string> migrated = FileUtil::GetContents(file.path());
+  ASSERT_OK(migrated);
+  EXPECT_GT(migrated->size(), contents.size());
+  EXPECT_EQ(migrated->substr(0, contents.size()), contents);
+}
+
+TEST_F(LruStorageTest, BrokenIndex) {
+  ScopedClockMock clock(absl::FromUnixSeconds(1));
+  clock->AutoAdvance(absl::Seconds(1));
+
+  constexpr uint32_t kValueSize = 4;
+  constexpr uint32_t kSize = 8;
+  // The index follows the file header and the items.  It has a 20-byte header,
+  // then the prev and next links of each item, then the hash table slots.
+  constexpr size_t kIndexOffset =
+      12 + (LruStorage::kItemHeaderSize + kValueSize) * kSize;
+  constexpr size_t kLinksOffset = kIndexOffset + 20;
+  constexpr size_t kSlotsOffset = kLinksOffset + 8 * kSize;
+  constexpr size_t kNumSlots = 2 * kSize;
+
+  TempFile file(testing::MakeTempFileOrDie());
+  {
+    LruStorage storage;
+    ASSERT_TRUE(
+        storage.OpenOrCreate(file.path().c_str(), kValueSize, kSize, kSeed));
+    EXPECT_TRUE(storage.Insert("1111", "aaaa"));
+    EXPECT_TRUE(storage.Insert("2222", "bbbb"));
+    EXPECT_TRUE(storage.Insert("3333", "cccc"));
+    EXPECT_TRUE(storage.Insert("4444", "dddd"));
+  }
+  absl::StatusOr<std::string> contents = FileUtil::GetContents(file.path());
+  ASSERT_OK(contents);
+  ASSERT_EQ(contents->size(), kSlotsOffset + 4 * kNumSlots);
+
+  auto set_words = [](std::string& data, size_t offset, size_t stride,
+                      size_t count, uint32_t value) {
+    for (size_t i = 0; i < count; ++i) {
+      std::memcpy(data.data() + offset + stride * i, &value, sizeof(value));
+    }
+  };
+  struct Corruption {
+    const char* name;
+    size_t offset;
+    size_t stride;
+    size_t count;
+    uint32_t value;
+  };
+  // The update state stays clean in all the cases, so Open() doesn't rebuild
+  // the index.
+  const Corruption kCorruptions[] = {
+      {"prev links out of range", kLinksOffset, 8, kSize, 0x7FFFFFFF},
+      {"next links out of range", kLinksOffset + 4, 8, kSize, 1000},
+      {"next links in a cycle", kLinksOffset + 4, 8, kSize, 0},
+      {"slots out of range", kSlotsOffset, 4, kNumSlots, 0xFFFF},
+      {"no empty slot", kSlotsOffset, 4, kNumSlots, 1},
+  };
+  for (const Corruption& corruption : kCorruptions) {
+    SCOPED_TRACE(corruption.name);
+    std::string broken = *contents;
+    set_words(broken, corruption.offset, corruption.stride, corruption.count,
+              corruption.value);
+    ASSERT_OK(FileUtil::SetContents(file.path(), broken));
+
+    {
+      LruStorage storage;
+      ASSERT_TRUE(storage.Open(file.path().c_str()));
+      EXPECT_EQ(storage.LookupAsString("1111"), "aaaa");
+      EXPECT_EQ(storage.LookupAsString("4444"), "dddd");
+      EXPECT_EQ(storage.Lookup("5555"), nullptr);
+      std::vector<std::string> values;
+      storage.GetAllValues(&values);
+      EXPECT_THAT(values, ElementsAre("dddd", "cccc", "bbbb", "aaaa"));
+    }
+    {
+      LruStorage storage;
+      ASSERT_TRUE(storage.Open(file.path().c_str()));
+      EXPECT_TRUE(storage.Touch("2222"));
+      EXPECT_TRUE(storage.Delete("3333"));
+      EXPECT_TRUE(storage.Insert("5555", "eeee"));
+      std::vector<std::string> values;
+      storage.GetAllValues(&values);
+      EXPECT_THAT(values, ElementsAre("eeee", "bbbb", "dddd", "aaaa"));
+    }
+
+    // The changes are persisted.
+    LruStorage storage;
+    ASSERT_TRUE(storage.Open(file.path().c_str()));
+    EXPECT_EQ(storage.Lookup("3333"), nullptr);
+    EXPECT_EQ(storage.LookupAsString("5555"), "eeee");
+    std::vector<std::string> values;
+    storage.GetAllValues(&values);
+    EXPECT_THAT(values, ElementsAre("eeee", "bbbb", "dddd", "aaaa"));
+  }
+}
+
+TEST_F(LruStorageTest, RandomOperations) {
+  ScopedClockMock clock(absl::FromUnixSeconds(1));
+  clock->AutoAdvance(absl::Seconds(1));
+
+  constexpr size_t kSize = 64;
+  TempFile file(testing::MakeTempFileOrDie());
+  auto storage = std::make_unique<LruStorage>();
+  ASSERT_TRUE(storage->OpenOrCreate(file.path().c_str(), 4, kSize, kSeed));
+
+  // Keys from the most recently used to the least recently used.
+  std::list<std::string> expected;
+  absl::BitGen gen;
+  for (int i = 0; i < 5000; ++i) {
+    const std::string key = absl::StrCat(absl::Uniform(gen, 0, 200));
+    const std::string value = absl::StrFormat("%04d", i % 10000);
+    auto it = absl::c_find(expected, key);
+    switch (absl::Uniform(gen, 0, 4)) {
+      case 0:
+        EXPECT_TRUE(storage->Delete(key));
+        if (it != expected.end()) {
+          expected.erase(it);
+        }
+        break;
+      case 1:
+        if (absl::Uniform(gen, 0, 100) == 0) {
+          // Reopen the file to check the persisted index.
+          storage = std::make_unique<LruStorage>();
+          ASSERT_TRUE(storage->Open(file.path().c_str()));
+        }
+        EXPECT_EQ(storage->Touch(key), it != expected.end());
+        if (it != expected.end()) {
+          expected.splice(expected.begin(), expected, it);
+        }
+        break;
+      default:
+        EXPECT_TRUE(storage->Insert(key, value.data()));
+        if (it != expected.end()) {
+          expected.erase(it);
+        } else if (expected.size() == kSize) {
+          expected.pop_back();
+        }
+        expected.push_front(key);
+        break;
+    }
+    ASSERT_EQ(storage->used_size(), expected.size());
+  }
+
+  for (int i = 0; i < 200; ++i) {
+    const std::string key = absl::StrCat(i);
+    EXPECT_EQ(storage->Lookup(key) != nullptr,
+              absl::c_linear_search(expected, key))
+        << key;
+  }
+}
+
 }  // namespace storage
 }  // namespace mozc
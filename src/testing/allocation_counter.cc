@@ -0,0 +1,151 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "testing/allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif  // _WIN32
+
+namespace {
+
+std::atomic<int64_t> g_num_allocations = 0;
+std::atomic<int64_t> g_num_bytes = 0;
+
+void* CountedAlloc(size_t size) {
+  g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_num_bytes.fetch_add(size, std::memory_order_relaxed);
+  // malloc(0) may return nullptr, which is not allowed for operator new.
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+// Allocates |size| bytes aligned to |alignment|, which is a power of two.
+// Returns nullptr on failure. The memory must be freed by AlignedFree().
+void* CountedAlignedAllocNoThrow(size_t size, std::align_val_t alignment) {
+  g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_num_bytes.fetch_add(size, std::memory_order_relaxed);
+  const size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+  return _aligned_malloc(size == 0 ? 1 : size, align);
+#else   // _WIN32
+  // aligned_alloc() requires the size to be a multiple of the alignment.
+  const size_t rounded = (size + align - 1) / align * align;
+  return std::aligned_alloc(align, rounded == 0 ? align : rounded);
+#endif  // _WIN32
+}
+
+void* CountedAlignedAlloc(size_t size, std::align_val_t alignment) {
+  void* ptr = CountedAlignedAllocNoThrow(size, alignment);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void AlignedFree(void* ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else   // _WIN32
+  std::free(ptr);
+#endif  // _WIN32
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_num_bytes.fetch_add(size, std::memory_order_relaxed);
+  return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+// Over-aligned types are allocated through the overloads below.
+void* operator new(size_t size, std::align_val_t alignment) {
+  return CountedAlignedAlloc(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return CountedAlignedAlloc(size, alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return CountedAlignedAllocNoThrow(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return CountedAlignedAllocNoThrow(size, alignment);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  AlignedFree(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  AlignedFree(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  AlignedFree(ptr);
+}
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  AlignedFree(ptr);
+}
+
+namespace mozc {
+namespace testing {
+
+void AllocationCounter::Reset() {
+  base_allocations_ = g_num_allocations.load(std::memory_order_relaxed);
+  base_bytes_ = g_num_bytes.load(std::memory_order_relaxed);
+}
+
+int64_t AllocationCounter::num_allocations() const {
+  return g_num_allocations.load(std::memory_order_relaxed) - base_allocations_;
+}
+
+int64_t AllocationCounter::num_bytes() const {
+  return g_num_bytes.load(std::memory_order_relaxed) - base_bytes_;
+}
+
+}  // namespace testing
+}  // namespace mozc
@@ -0,0 +1,72 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOZC_TESTING_ALLOCATION_COUNTER_H_
+#define MOZC_TESTING_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace mozc {
+namespace testing {
+
+// Counts heap allocations made through the global operator new. Linking
+// against this library replaces the global operator new/delete of the binary,
+// so it should only be used by tests and benchmarks.
+//
+// Example:
+//
+//   AllocationCounter counter;
+//   DoSomething();
+//   EXPECT_EQ(counter.num_allocations(), 0);
+//
+// The counter is process-wide: allocations made by other threads while the
+// counter is alive are also counted.
+class AllocationCounter {
+ public:
+  AllocationCounter() { Reset(); }
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  // Restarts counting from zero.
+  void Reset();
+
+  // Returns the number of allocations and the total number of requested bytes
+  // since the construction or the last call of Reset().
+  int64_t num_allocations() const;
+  int64_t num_bytes() const;
+
+ private:
+  int64_t base_allocations_ = 0;
+  int64_t base_bytes_ = 0;
+};
+
+}  // namespace testing
+}  // namespace mozc
+
+#endif  // MOZC_TESTING_ALLOCATION_COUNTER_H_
@@ -0,0 +1,97 @@
+// Copyright 2010-2021, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "testing/allocation_counter.h"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "testing/gunit.h"
+
+namespace mozc {
+namespace testing {
+namespace {
+
+TEST(AllocationCounterTest, CountsAllocations) {
+  AllocationCounter counter;
+  EXPECT_EQ(counter.num_allocations(), 0);
+  EXPECT_EQ(counter.num_bytes(), 0);
+
+  auto value = std::make_unique<int64_t>(1);
+  ASSERT_NE(value.get(), nullptr);
+  EXPECT_EQ(counter.num_allocations(), 1);
+  EXPECT_GE(counter.num_bytes(), sizeof(int64_t));
+
+  std::vector<char> buffer;
+  buffer.reserve(100);
+  ASSERT_NE(buffer.data(), nullptr);
+  EXPECT_EQ(counter.num_allocations(), 2);
+  EXPECT_GE(counter.num_bytes(), sizeof(int64_t) + 100);
+
+  counter.Reset();
+  EXPECT_EQ(counter.num_allocations(), 0);
+  EXPECT_EQ(counter.num_bytes(), 0);
+
+  // Deallocation is not counted.
+  value.reset();
+  EXPECT_EQ(counter.num_allocations(), 0);
+}
+
+struct alignas(64) OverAligned {
+  char data[64];
+};
+
+TEST(AllocationCounterTest, CountsAlignedAllocations) {
+  AllocationCounter counter;
+
+  auto value = std::make_unique<OverAligned>();
+  ASSERT_NE(value.get(), nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(value.get()) % alignof(OverAligned),
+            0);
+  EXPECT_EQ(counter.num_allocations(), 1);
+  EXPECT_GE(counter.num_bytes(), sizeof(OverAligned));
+
+  auto array = std::make_unique<OverAligned[]>(3);
+  ASSERT_NE(array.get(), nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(array.get()) % alignof(OverAligned),
+            0);
+  EXPECT_EQ(counter.num_allocations(), 2);
+  EXPECT_GE(counter.num_bytes(), 4 * sizeof(OverAligned));
+
+  OverAligned* nothrow_value = new (std::nothrow) OverAligned();
+  ASSERT_NE(nothrow_value, nullptr);
+  EXPECT_EQ(counter.num_allocations(), 3);
+  delete nothrow_value;
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace mozc